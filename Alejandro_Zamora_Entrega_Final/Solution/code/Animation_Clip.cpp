@@ -0,0 +1,291 @@
+#include "Animation_Clip.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        const float quaternion_range = 0.70710678f;     // Ninguna componente menor supera 1/sqrt(2)
+
+        // Un canal vectorial es constante si no se separa de su valor inicial más que una
+        // fracción despreciable de su magnitud:
+
+        bool is_constant (const glm::vec3 & minimum, const glm::vec3 & maximum)
+        {
+            const glm::vec3 extent    = maximum - minimum;
+            const float     magnitude = std::max ({ 1.f, std::abs (minimum.x), std::abs (minimum.y), std::abs (minimum.z),
+                                                         std::abs (maximum.x), std::abs (maximum.y), std::abs (maximum.z) });
+
+            return std::max ({ extent.x, extent.y, extent.z }) <= 1e-6f * magnitude;
+        }
+
+        uint16_t quantize (float value, float minimum, float step)
+        {
+            if (step <= 0.f) return 0;
+
+            return uint16_t(std::min (std::max (std::round ((value - minimum) / step), 0.f), 65535.f));
+        }
+
+        void quantize (const glm::vec3 & value, const glm::vec3 & minimum, const glm::vec3 & step, uint16_t * words)
+        {
+            words[0] = quantize (value.x, minimum.x, step.x);
+            words[1] = quantize (value.y, minimum.y, step.y);
+            words[2] = quantize (value.z, minimum.z, step.z);
+        }
+
+        glm::vec3 dequantize (const uint16_t * words, const glm::vec3 & minimum, const glm::vec3 & step)
+        {
+            return minimum + step * glm::vec3(float(words[0]), float(words[1]), float(words[2]));
+        }
+
+    }
+
+    Animation_Clip::Animation_Clip() : duration(0.f), sample_rate(default_sample_rate), frame_count(0), frame_stride(0)
+    {
+    }
+
+    void Animation_Clip::compress
+    (
+        const std::string   & clip_name,
+        float                 clip_duration,
+        size_t                joint_count,
+        const Pose_Function & evaluate,
+        float                 clip_sample_rate
+    )
+    {
+        name        = clip_name;
+        duration    = std::max (clip_duration, 0.f);
+        sample_rate = clip_sample_rate > 0.f ? clip_sample_rate : default_sample_rate;
+        frame_count = duration > 0.f ? uint32_t(std::ceil (duration * sample_rate)) + 1 : 1;
+
+        // Se remuestrea la animación original. El último fotograma cae justo al final para que
+        // el bucle cierre con la misma pose con la que empieza:
+
+        std::vector< Joint_Pose > poses(size_t(frame_count) * joint_count);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            evaluate (std::min (float(frame) / sample_rate, duration), poses.data () + size_t(frame) * joint_count);
+        }
+
+        // Se decide qué canales de cada articulación están animados y dónde van en el fotograma:
+
+        tracks.assign (joint_count, Track{});
+        frame_stride = 0;
+
+        for (size_t joint = 0; joint < joint_count; ++joint)
+        {
+            Track            & track = tracks[joint];
+            const Joint_Pose & first = poses[joint];
+
+            glm::vec3 translation_min = first.translation, translation_max = first.translation;
+            glm::vec3 scale_min       = first.scale,       scale_max       = first.scale;
+            bool      rotation_constant = true;
+
+            for (uint32_t frame = 1; frame < frame_count; ++frame)
+            {
+                const Joint_Pose & pose = poses[size_t(frame) * joint_count + joint];
+
+                translation_min = glm::min (translation_min, pose.translation);
+                translation_max = glm::max (translation_max, pose.translation);
+                scale_min       = glm::min (scale_min, pose.scale);
+                scale_max       = glm::max (scale_max, pose.scale);
+
+                if (std::abs (glm::dot (glm::normalize (pose.rotation), glm::normalize (first.rotation))) < 1.f - 1e-6f)
+                {
+                    rotation_constant = false;
+                }
+            }
+
+            track.flags            = 0;
+            track.translation_min  = first.translation;
+            track.translation_step = glm::vec3(0.f);
+            track.rotation         = glm::normalize (first.rotation);
+            track.scale_min        = first.scale;
+            track.scale_step       = glm::vec3(0.f);
+
+            if (!is_constant (translation_min, translation_max))
+            {
+                track.flags             |= ANIMATED_TRANSLATION;
+                track.translation_offset = uint16_t(frame_stride);
+                track.translation_min    = translation_min;
+                track.translation_step   = (translation_max - translation_min) / 65535.f;
+                frame_stride            += 3;
+            }
+
+            if (!rotation_constant)
+            {
+                track.flags          |= ANIMATED_ROTATION;
+                track.rotation_offset = uint16_t(frame_stride);
+                frame_stride         += 3;
+            }
+
+            if (!is_constant (scale_min, scale_max))
+            {
+                track.flags       |= ANIMATED_SCALE;
+                track.scale_offset = uint16_t(frame_stride);
+                track.scale_min    = scale_min;
+                track.scale_step   = (scale_max - scale_min) / 65535.f;
+                frame_stride      += 3;
+            }
+        }
+
+        // Se cuantizan los canales animados de cada fotograma:
+
+        frames.assign (size_t(frame_count) * frame_stride, 0);
+
+        for (uint32_t frame = 0; frame < frame_count; ++frame)
+        {
+            uint16_t * words = frames.data () + size_t(frame) * frame_stride;
+
+            for (size_t joint = 0; joint < joint_count; ++joint)
+            {
+                const Track      & track = tracks[joint];
+                const Joint_Pose & pose  = poses[size_t(frame) * joint_count + joint];
+
+                if (track.flags & ANIMATED_TRANSLATION) quantize (pose.translation, track.translation_min, track.translation_step, words + track.translation_offset);
+                if (track.flags & ANIMATED_ROTATION   ) encode_rotation (pose.rotation, words + track.rotation_offset);
+                if (track.flags & ANIMATED_SCALE      ) quantize (pose.scale, track.scale_min, track.scale_step, words + track.scale_offset);
+            }
+        }
+    }
+
+    void Animation_Clip::sample (float time, Joint_Pose * poses) const
+    {
+        if (frame_count == 0) return;
+
+        // Se localizan los dos fotogramas que rodean al instante pedido:
+
+        if (duration > 0.f)
+        {
+            time = std::fmod (time, duration);
+
+            if (time < 0.f) time += duration;
+        }
+        else
+        {
+            time = 0.f;
+        }
+
+        const float    position = time * sample_rate;
+        const uint32_t frame_a  = std::min (uint32_t(position), frame_count - 1);
+        const uint32_t frame_b  = std::min (frame_a + 1, frame_count - 1);
+        const float    blend    = std::min (std::max (position - float(frame_a), 0.f), 1.f);
+
+        const uint16_t * words_a = frames.data () + size_t(frame_a) * frame_stride;
+        const uint16_t * words_b = frames.data () + size_t(frame_b) * frame_stride;
+
+        for (size_t joint = 0; joint < tracks.size (); ++joint)
+        {
+            const Track & track = tracks[joint];
+            Joint_Pose  & pose  = poses[joint];
+
+            if (track.flags & ANIMATED_TRANSLATION)
+            {
+                pose.translation = glm::mix
+                (
+                    dequantize (words_a + track.translation_offset, track.translation_min, track.translation_step),
+                    dequantize (words_b + track.translation_offset, track.translation_min, track.translation_step),
+                    blend
+                );
+            }
+            else
+            {
+                pose.translation = track.translation_min;
+            }
+
+            if (track.flags & ANIMATED_ROTATION)
+            {
+                // Interpolación lineal normalizada por el camino corto:
+
+                const glm::quat a = decode_rotation (words_a + track.rotation_offset);
+                      glm::quat b = decode_rotation (words_b + track.rotation_offset);
+
+                if (glm::dot (a, b) < 0.f) b = -b;
+
+                pose.rotation = glm::normalize (a * (1.f - blend) + b * blend);
+            }
+            else
+            {
+                pose.rotation = track.rotation;
+            }
+
+            if (track.flags & ANIMATED_SCALE)
+            {
+                pose.scale = glm::mix
+                (
+                    dequantize (words_a + track.scale_offset, track.scale_min, track.scale_step),
+                    dequantize (words_b + track.scale_offset, track.scale_min, track.scale_step),
+                    blend
+                );
+            }
+            else
+            {
+                pose.scale = track.scale_min;
+            }
+        }
+    }
+
+    void Animation_Clip::encode_rotation (const glm::quat & rotation, uint16_t * words)
+    {
+        const glm::quat q = glm::normalize (rotation);
+
+        float components[4] = { q.x, q.y, q.z, q.w };
+
+        // Se omite la componente mayor. Si es negativa se niega el cuaternión (representa la
+        // misma rotación) para que al reconstruirla baste con tomar la raíz positiva:
+
+        unsigned largest = 0;
+
+        for (unsigned i = 1; i < 4; ++i)
+        {
+            if (std::abs (components[i]) > std::abs (components[largest])) largest = i;
+        }
+
+        const float sign = components[largest] < 0.f ? -1.f : 1.f;
+
+        unsigned word = 0;
+
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+
+            const float normalized = (sign * components[i] / quaternion_range) * 0.5f + 0.5f;
+
+            words[word++] = uint16_t(std::min (std::max (std::round (normalized * 32767.f), 0.f), 32767.f));
+        }
+
+        // Los dos bits del índice van en el bit alto de las dos primeras palabras:
+
+        words[0] |= uint16_t((largest & 1) << 15);
+        words[1] |= uint16_t((largest >> 1) << 15);
+    }
+
+    glm::quat Animation_Clip::decode_rotation (const uint16_t * words)
+    {
+        const unsigned largest = (words[0] >> 15) | ((words[1] >> 15) << 1);
+
+        float components[4];
+        float sum = 0.f;
+        unsigned word = 0;
+
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            if (i == largest) continue;
+
+            const float value = (float(words[word++] & 0x7FFF) * (2.f / 32767.f) - 1.f) * quaternion_range;
+
+            components[i] = value;
+            sum          += value * value;
+        }
+
+        components[largest] = std::sqrt (std::max (1.f - sum, 0.f));
+
+        return glm::quat(components[3], components[0], components[1], components[2]);
+    }
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Skeleton.hpp"
+
+namespace udit
+{
+
+    // Animación esquelética comprimida. Al comprimir se remuestrea la animación original a una
+    // frecuencia fija y cada canal (traslación, rotación y escala de cada articulación) se trata
+    // por separado:
+    //
+    //  - Los canales que no cambian se guardan una sola vez fuera de los fotogramas.
+    //  - Las traslaciones y escalas animadas se cuantizan a 16 bits dentro de su rango.
+    //  - Las rotaciones animadas se guardan en 48 bits con las tres componentes menores del
+    //    cuaternión (la mayor se reconstruye porque la norma es 1) y el índice de la omitida.
+    //
+    // Los fotogramas se guardan uno tras otro con todos sus canales animados juntos, por lo que
+    // muestrear una pose sólo lee dos bloques contiguos de memoria.
+
+    class Animation_Clip
+    {
+    public:
+
+        // Evalúa la animación original en un instante dado (en segundos):
+
+        using Pose_Function = std::function< void (float time, Joint_Pose * poses) >;
+
+        static constexpr float default_sample_rate = 30.f;
+
+    private:
+
+        enum
+        {
+            ANIMATED_TRANSLATION = 1,
+            ANIMATED_ROTATION    = 2,
+            ANIMATED_SCALE       = 4
+        };
+
+        // Cómo reconstruir los canales de una articulación. Para los canales animados *_min y
+        // *_step convierten los valores cuantizados; para los constantes *_min es el valor:
+
+        struct Track
+        {
+            uint8_t   flags;
+            uint16_t  translation_offset;           // Posición de cada canal dentro del fotograma
+            uint16_t  rotation_offset;
+            uint16_t  scale_offset;
+            glm::vec3 translation_min;
+            glm::vec3 translation_step;
+            glm::quat rotation;
+            glm::vec3 scale_min;
+            glm::vec3 scale_step;
+        };
+
+        std::string             name;
+        float                   duration;
+        float                   sample_rate;
+        uint32_t                frame_count;
+        uint32_t                frame_stride;       // Palabras de 16 bits por fotograma
+        std::vector< Track    > tracks;
+        std::vector< uint16_t > frames;
+
+    public:
+
+        Animation_Clip();
+
+        void compress
+        (
+            const std::string   & name,
+            float                 duration,
+            size_t                joint_count,
+            const Pose_Function & evaluate,
+            float                 sample_rate = default_sample_rate
+        );
+
+        // Escribe la pose local de todas las articulaciones en el instante dado. La animación se
+        // repite, de modo que se admite cualquier tiempo.
+
+        void sample (float time, Joint_Pose * poses) const;
+
+        const std::string & get_name () const
+        {
+            return name;
+        }
+
+        float get_duration () const
+        {
+            return duration;
+        }
+
+        size_t get_joint_count () const
+        {
+            return tracks.size ();
+        }
+
+        // Memoria que ocuparía la animación remuestreada sin comprimir y la que ocupa:
+
+        size_t get_raw_bytes () const
+        {
+            return size_t(frame_count) * tracks.size () * sizeof(Joint_Pose);
+        }
+
+        size_t get_compressed_bytes () const
+        {
+            return frames.size () * sizeof(uint16_t) + tracks.size () * sizeof(Track);
+        }
+
+    private:
+
+        static void      encode_rotation (const glm::quat & rotation, uint16_t * words);
+        static glm::quat decode_rotation (const uint16_t * words);
+
+    };
+
+}
@@ -0,0 +1,473 @@
+#include "Asset_Loader.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "Progressive_Mesh.hpp"
+
+namespace udit
+{
+
+    Asset_Loader::Asset_Loader(unsigned thread_count)
+    :
+        uploads          (256),
+        pending_count    (0),
+        decoded_bytes    (0),
+        cancelled        (false),
+        streaming_uploads(true),
+        workers          (thread_count)
+    {
+    }
+
+    Asset_Loader::~Asset_Loader()
+    {
+        // Los trabajos que aún no han empezado terminan sin cargar nada y las subidas pendientes
+        // se descartan sin ejecutarlas. Sólo se espera a los que ya están leyendo un archivo. Los
+        // recursos se sueltan aquí porque sus objetos OpenGL sólo se pueden liberar en este hilo:
+
+        cancelled = true;
+
+        pending_count -= streamed_textures.size () + streamed_meshes.size ();
+
+        streamed_textures.clear ();
+        streamed_meshes  .clear ();
+
+        Upload upload;
+
+        while (pending_count > 0)
+        {
+            if (uploads.try_pop (upload))
+            {
+                upload = nullptr;
+                --pending_count;
+            }
+            else
+                std::this_thread::yield ();
+        }
+    }
+
+    std::shared_ptr< Mesh > Asset_Loader::load_mesh (const std::string & mesh_path)
+    {
+        if (Progressive_Mesh::is_progressive (mesh_path)) return stream_mesh (mesh_path);
+
+        auto mesh = std::make_shared< Mesh > ();
+
+        ++pending_count;
+
+        workers.submit
+        (
+            [this, mesh, mesh_path] () mutable
+            {
+                if (cancelled)
+                {
+                    enqueue ([mesh = std::move (mesh)] () { });
+                    return;
+                }
+
+                auto data     = std::make_shared< Mesh::Data > ();
+                bool imported = Mesh::import (mesh_path, *data);
+
+                // La referencia a la malla se mueve al cierre para que, si es la última, se
+                // libere en el hilo de render y no en este:
+
+                enqueue
+                (
+                    [this, mesh = std::move (mesh), data, imported] ()
+                    {
+                        if (imported && mesh.use_count () > 1)
+                        {
+                            if (streaming_uploads)
+                            {
+                                // La subida sigue pendiente hasta copiar la última banda:
+
+                                mesh->begin_upload (data);
+                                streamed_meshes.push_back (mesh);
+                                ++pending_count;
+                                return;
+                            }
+
+                            mesh->upload (*data);
+                        }
+                    }
+                );
+            }
+        );
+
+        return mesh;
+    }
+
+    std::shared_ptr< Mesh > Asset_Loader::stream_mesh (const std::string & mesh_path)
+    {
+        auto mesh = std::make_shared< Mesh > ();
+
+        ++pending_count;
+
+        workers.submit
+        (
+            [this, mesh, mesh_path] () mutable
+            {
+                auto reader = std::make_shared< Progressive_Mesh::Reader > ();
+
+                if (cancelled || !reader->open (mesh_path))
+                {
+                    if (!cancelled) std::cerr << "Error loading mesh: " << mesh_path << std::endl;
+                    enqueue ([mesh = std::move (mesh)] () { });
+                    return;
+                }
+
+                // Cada bloque es una subida más. Se cuentan todas antes de encolar la primera
+                // para que el contador no llegue a cero mientras este hilo sigue leyendo:
+
+                const size_t chunk_count = reader->get_chunk_count ();
+
+                pending_count += chunk_count;
+
+                enqueue
+                (
+                    [mesh, reader] ()
+                    {
+                        if (mesh.use_count () > 1)
+                        {
+                            mesh->begin_streaming
+                            (
+                                reader->get_submeshes         (),
+                                reader->get_material_textures (),
+                                reader->get_vertex_count      (),
+                                reader->get_index_count       (),
+                                reader->get_bounding_center   (),
+                                reader->get_bounding_radius   ()
+                            );
+                        }
+                    }
+                );
+
+                // El bloque más simple se encola en cuanto está decodificado, así que la malla
+                // aparece tras leer una pequeña parte del archivo y se refina en los siguientes
+                // fotogramas. Si un bloque falla no se suben los siguientes, que dependen de él, y
+                // si se cancela la carga se encolan vacíos sólo para soltar la malla:
+
+                bool decoded = true;
+
+                for (size_t c = 0; c < chunk_count; ++c)
+                {
+                    auto chunk = std::make_shared< Mesh::Stream_Chunk > ();
+
+                    if (cancelled) decoded = false;
+
+                    if (decoded && !reader->read_chunk (c, *chunk))
+                    {
+                        std::cerr << "Error decoding mesh chunk " << c << ": " << mesh_path << std::endl;
+                        decoded = false;
+                    }
+
+                    // La última subida se queda con la referencia de este hilo para que la malla
+                    // se libere, si es el caso, en el hilo de render:
+
+                    auto target = c + 1 == chunk_count ? std::move (mesh) : mesh;
+
+                    enqueue
+                    (
+                        [mesh = std::move (target), chunk, decoded] ()
+                        {
+                            if (decoded && mesh.use_count () > 1) mesh->upload_chunk (*chunk);
+                        }
+                    );
+                }
+            }
+        );
+
+        return mesh;
+    }
+
+    std::shared_ptr< Texture > Asset_Loader::load_texture (const std::string & texture_path)
+    {
+        auto texture = std::make_shared< Texture > ();
+
+        ++pending_count;
+
+        workers.submit
+        (
+            [this, texture, texture_path] () mutable
+            {
+                if (cancelled)
+                {
+                    enqueue ([texture = std::move (texture)] () { });
+                    return;
+                }
+
+                // Las texturas cocinadas (.ktx2) se suben con sus bloques y mipmaps tal cual:
+
+                if (Ktx2_File::is_ktx2 (texture_path))
+                {
+                    if (streaming_uploads)
+                    {
+                        stream_compressed (std::move (texture), texture_path);
+                        return;
+                    }
+
+                    std::shared_ptr< Ktx2_File::Image > compressed = Texture::load_compressed (texture_path);
+
+                    enqueue
+                    (
+                        [texture = std::move (texture), compressed] ()
+                        {
+                            if (compressed && texture.use_count () > 1) texture->upload (*compressed);
+                        }
+                    );
+
+                    return;
+                }
+
+                // Los mipmaps se calculan (o se leen de la caché) en el hilo de trabajo:
+
+                upload_texture (std::move (texture), [&texture_path] () { return Texture::load_mipmapped (texture_path); });
+            }
+        );
+
+        return texture;
+    }
+
+    std::shared_ptr< Texture > Asset_Loader::load_texture (Texture_Decoder decoder)
+    {
+        auto texture = std::make_shared< Texture > ();
+
+        ++pending_count;
+
+        workers.submit
+        (
+            [this, texture, decoder] () mutable
+            {
+                upload_texture (std::move (texture), decoder);
+            }
+        );
+
+        return texture;
+    }
+
+    void Asset_Loader::upload_texture (std::shared_ptr< Texture > texture, const Texture_Decoder & decoder)
+    {
+        // Se espera a que el hilo de render suba parte de lo ya decodificado para que cientos
+        // de texturas grandes no se acumulen en memoria:
+
+        while (decoded_bytes > max_decoded_bytes && !cancelled)
+        {
+            std::this_thread::sleep_for (std::chrono::milliseconds(1));
+        }
+
+        if (cancelled)
+        {
+            enqueue ([texture = std::move (texture)] () { });
+            return;
+        }
+
+        std::shared_ptr< Texture::Mip_Chain > mips  = decoder ();
+        const size_t                          bytes = mips ? mips->get_byte_count () : 0;
+
+        decoded_bytes += bytes;
+
+        enqueue
+        (
+            [this, texture = std::move (texture), mips, bytes] ()
+            {
+                if (mips && texture.use_count () > 1)
+                {
+                    if (streaming_uploads)
+                    {
+                        // La subida sigue pendiente hasta copiar la última banda:
+
+                        texture->begin_upload (mips);
+                        streamed_textures.push_back (Streamed_Texture{ texture, bytes });
+                        ++pending_count;
+                        return;
+                    }
+
+                    texture->upload (*mips);
+                }
+
+                decoded_bytes -= bytes;
+            }
+        );
+    }
+
+    void Asset_Loader::stream_compressed (std::shared_ptr< Texture > texture, const std::string & texture_path)
+    {
+        // Sólo se valida el índice de niveles. Los bloques se quedan en la proyección del
+        // archivo, de donde se copian directamente al anillo de subida:
+
+        auto              file = std::make_shared< Mapped_File > ();
+        Ktx2_File::Layout layout;
+
+        if (!file->open (texture_path) || !Ktx2_File::read_layout (file->data (), file->size (), layout))
+        {
+            std::cerr << "Error loading texture: " << texture_path << std::endl;
+            enqueue ([texture = std::move (texture)] () { });
+            return;
+        }
+
+        while (decoded_bytes > max_decoded_bytes && !cancelled)
+        {
+            std::this_thread::sleep_for (std::chrono::milliseconds(1));
+        }
+
+        if (cancelled)
+        {
+            enqueue ([texture = std::move (texture)] () { });
+            return;
+        }
+
+        // Las páginas se leen del disco aquí para que el hilo de render sólo haga la copia:
+
+        file->prefetch (0, file->size ());
+
+        const size_t bytes = file->size ();
+
+        decoded_bytes += bytes;
+
+        enqueue
+        (
+            [this, texture = std::move (texture), file, layout, bytes] ()
+            {
+                if (texture.use_count () > 1)
+                {
+                    if (Texture::is_supported (layout.format))
+                    {
+                        texture->begin_upload (file, layout);
+                        streamed_textures.push_back (Streamed_Texture{ texture, bytes });
+                        ++pending_count;
+                        return;
+                    }
+
+                    // Sin soporte para el formato hay que descomprimir los bloques en la CPU:
+
+                    Ktx2_File::Image image;
+
+                    if (Ktx2_File::read (file->data (), file->size (), image)) texture->upload (image);
+                }
+
+                decoded_bytes -= bytes;
+            }
+        );
+    }
+
+    std::shared_ptr< Material_Array > Asset_Loader::load_materials (const std::vector< std::string > & texture_paths)
+    {
+        auto materials = std::make_shared< Material_Array > ();
+
+        ++pending_count;
+
+        workers.submit
+        (
+            [this, materials, texture_paths] () mutable
+            {
+                if (cancelled)
+                {
+                    enqueue ([materials = std::move (materials)] () { });
+                    return;
+                }
+
+                std::shared_ptr< Material_Array::Layers > layers = Material_Array::load_layers (texture_paths);
+
+                enqueue
+                (
+                    [materials = std::move (materials), layers] ()
+                    {
+                        if (materials.use_count () > 1) materials->upload (*layers);
+                    }
+                );
+            }
+        );
+
+        return materials;
+    }
+
+    void Asset_Loader::enqueue (Upload && upload)
+    {
+        // Si la cola está llena el hilo de trabajo espera a que el hilo de render la vacíe:
+
+        while (!uploads.try_push (std::move (upload)))
+        {
+            std::this_thread::yield ();
+        }
+    }
+
+    size_t Asset_Loader::process_uploads (double budget_in_milliseconds)
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto   start = clock::now ();
+        size_t count = 0;
+        Upload upload;
+
+        auto elapsed = [&start] ()
+        {
+            return std::chrono::duration< double, std::milli > (clock::now () - start).count ();
+        };
+
+        do
+        {
+            if (!uploads.try_pop (upload)) break;
+
+            upload ();
+            upload = nullptr;
+
+            --pending_count;
+            ++count;
+        }
+        while (elapsed () < budget_in_milliseconds);
+
+        // Las texturas se copian por orden, terminando una antes de empezar la siguiente para
+        // que aparezcan cuanto antes. Si el anillo se llena se sigue en el próximo fotograma
+        // en lugar de esperar a la GPU:
+
+        size_t finished = 0;
+
+        for (auto & streamed : streamed_textures)
+        {
+            Texture::Upload_Status status = streamed.texture.use_count () > 1 ? Texture::UPLOAD_PENDING : Texture::UPLOAD_DONE;
+
+            while (status == Texture::UPLOAD_PENDING && (count == 0 || elapsed () < budget_in_milliseconds))
+            {
+                status = streamed.texture->continue_upload (upload_ring);
+
+                if (status != Texture::UPLOAD_STALLED) ++count;
+            }
+
+            if (status != Texture::UPLOAD_DONE) break;
+
+            decoded_bytes -= streamed.bytes;
+            --pending_count;
+            ++finished;
+        }
+
+        streamed_textures.erase (streamed_textures.begin (), streamed_textures.begin () + finished);
+
+        // Las mallas igual, detrás de las texturas:
+
+        finished = 0;
+
+        for (auto & mesh : streamed_meshes)
+        {
+            Mesh::Upload_Status status = mesh.use_count () > 1 ? Mesh::UPLOAD_PENDING : Mesh::UPLOAD_DONE;
+
+            while (status == Mesh::UPLOAD_PENDING && (count == 0 || elapsed () < budget_in_milliseconds))
+            {
+                status = mesh->continue_upload (upload_ring);
+
+                if (status != Mesh::UPLOAD_STALLED) ++count;
+            }
+
+            if (status != Mesh::UPLOAD_DONE) break;
+
+            --pending_count;
+            ++finished;
+        }
+
+        streamed_meshes.erase (streamed_meshes.begin (), streamed_meshes.begin () + finished);
+
+        upload_ring.fence ();
+
+        return count;
+    }
+
+}
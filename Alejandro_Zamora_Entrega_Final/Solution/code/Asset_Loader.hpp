@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Mapped_File.hpp>
+#include <Mpmc_Queue.hpp>
+#include <Thread_Pool.hpp>
+#include <Upload_Ring.hpp>
+
+#include "Material_Array.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    // Carga asíncrona de recursos. Las funciones load_* devuelven al momento un recurso vacío
+    // (la malla no se dibuja y la textura muestra un placeholder) mientras los hilos de trabajo
+    // leen y procesan los archivos. Los datos ya procesados se encolan sin bloqueos y el hilo
+    // de render los sube a la GPU llamando a process_uploads() una vez por fotograma.
+
+    class Asset_Loader
+    {
+    public:
+
+        using Upload          = std::function< void () >;
+        using Texture_Decoder = std::function< std::unique_ptr< Texture::Mip_Chain > () >;
+
+        // Límite de las imágenes ya decodificadas que esperan a subirse. Al pasarlo los hilos
+        // de trabajo esperan antes de decodificar la siguiente:
+
+        static constexpr size_t max_decoded_bytes = size_t(512) << 20;
+
+    private:
+
+        struct Streamed_Texture
+        {
+            std::shared_ptr< Texture > texture;
+            size_t                     bytes;
+        };
+
+        Mpmc_Queue< Upload >  uploads;
+        std::atomic< size_t > pending_count;
+        std::atomic< size_t > decoded_bytes;
+        std::atomic< bool   > cancelled;            // Los trabajos que aún no han empezado no cargan nada
+        Upload_Ring           upload_ring;
+        bool                  streaming_uploads;
+
+        std::vector< Streamed_Texture        > streamed_textures;  // Sólo desde el hilo de render
+        std::vector< std::shared_ptr< Mesh > > streamed_meshes;
+
+        Thread_Pool           workers;              // Se destruye antes que la cola
+
+    public:
+
+        explicit Asset_Loader(unsigned thread_count = 0);
+       ~Asset_Loader();
+
+        Asset_Loader(const Asset_Loader & ) = delete;
+        Asset_Loader & operator = (const Asset_Loader & ) = delete;
+
+    public:
+
+        std::shared_ptr< Mesh    > load_mesh    (const std::string & mesh_path);
+        std::shared_ptr< Texture > load_texture (const std::string & texture_path);
+
+        // Textura cuya imagen produce decoder en un hilo de trabajo (p. ej. una procedural):
+
+        std::shared_ptr< Texture > load_texture (Texture_Decoder decoder);
+
+        // Array con una capa por ruta; hasta que se sube muestra una única capa gris:
+
+        std::shared_ptr< Material_Array > load_materials (const std::vector< std::string > & texture_paths);
+
+        // Ejecuta subidas pendientes hasta agotar el presupuesto de tiempo (al menos una si
+        // hay alguna lista). Las texturas y las mallas se copian por bandas a un anillo de PBOs,
+        // así que un recurso grande se reparte entre varios fotogramas. Devuelve cuántas subidas y bandas
+        // se han ejecutado. Sólo desde el hilo de OpenGL.
+
+        size_t process_uploads (double budget_in_milliseconds);
+
+        // Con false las texturas y las mallas se suben enteras al sacarlas de la cola, como antes
+        // de usar el anillo (sirve para comparar):
+
+        void set_streaming_uploads (bool enabled)
+        {
+            streaming_uploads = enabled;
+        }
+
+        const Upload_Ring & get_upload_ring () const
+        {
+            return upload_ring;
+        }
+
+        size_t get_pending_count () const
+        {
+            return pending_count;
+        }
+
+    private:
+
+        void enqueue (Upload && upload);
+
+        // Decodifica en el hilo de trabajo actual y encola la subida:
+
+        void upload_texture (std::shared_ptr< Texture > texture, const Texture_Decoder & decoder);
+
+        // Sube un .ktx2 por bandas copiando los bloques de la proyección del archivo al anillo:
+
+        void stream_compressed (std::shared_ptr< Texture > texture, const std::string & texture_path);
+
+        // Las mallas progresivas se suben bloque a bloque, del nivel más simple al más detallado:
+
+        std::shared_ptr< Mesh > stream_mesh (const std::string & mesh_path);
+
+    };
+
+}
@@ -0,0 +1,131 @@
+#include "Asset_Registry.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+
+namespace udit
+{
+
+    Asset_Registry::Asset_Registry(Asset_Loader & loader)
+    :
+        loader(loader),
+        hits  (0),
+        misses(0)
+    {
+    }
+
+    std::shared_ptr< Mesh > Asset_Registry::get_mesh (const std::string & mesh_path, uint32_t settings)
+    {
+        return get (meshes, mesh_path, settings, [this] (const std::string & path) { return loader.load_mesh (path); });
+    }
+
+    std::shared_ptr< Texture > Asset_Registry::get_texture (const std::string & texture_path, uint32_t settings)
+    {
+        return get (textures, texture_path, settings, [this] (const std::string & path) { return loader.load_texture (path); });
+    }
+
+    std::shared_ptr< Material_Array > Asset_Registry::get_materials (const std::vector< std::string > & texture_paths)
+    {
+        std::string key;
+
+        for (const auto & path : texture_paths) key += canonicalize (path) + '\n';
+
+        return get (materials, key, 0, [this, &texture_paths] (const std::string & ) { return loader.load_materials (texture_paths); });
+    }
+
+    template< typename ASSET, typename LOAD >
+    std::shared_ptr< ASSET > Asset_Registry::get (Asset_Map< ASSET > & map, const std::string & path, uint32_t settings, LOAD && load)
+    {
+        std::weak_ptr< ASSET > & entry = map[Key{ canonicalize (path), settings }];
+
+        // Si el recurso sigue vivo se comparte. Si nunca se cargó o ya se liberó se vuelve a
+        // cargar a partir de la ruta original:
+
+        std::shared_ptr< ASSET > asset = entry.lock ();
+
+        if (asset)
+        {
+            ++hits;
+        }
+        else
+        {
+            ++misses;
+
+            asset = load (path);
+            entry = asset;
+        }
+
+        return asset;
+    }
+
+    void Asset_Registry::collect ()
+    {
+        auto collect_map = [] (auto & map)
+        {
+            for (auto entry = map.begin (); entry != map.end (); )
+            {
+                if (entry->second.expired ()) entry = map.erase (entry);
+                else                          ++entry;
+            }
+        };
+
+        collect_map (meshes   );
+        collect_map (textures );
+        collect_map (materials);
+    }
+
+    Asset_Registry::Statistics Asset_Registry::get_statistics ()
+    {
+        collect ();
+
+        Statistics statistics{ hits, misses, 0, 0 };
+
+        auto add_resident = [&statistics] (auto & map)
+        {
+            for (auto & entry : map)
+            {
+                if (auto asset = entry.second.lock ())
+                {
+                    statistics.resident_count += 1;
+                    statistics.resident_bytes += asset->get_gpu_bytes ();
+                }
+            }
+        };
+
+        add_resident (meshes   );
+        add_resident (textures );
+        add_resident (materials);
+
+        return statistics;
+    }
+
+    std::string Asset_Registry::canonicalize (const std::string & path)
+    {
+        // Ruta absoluta con los "." y ".." resueltos. En Windows además se unifican los
+        // separadores y las mayúsculas, ya que el sistema de archivos no las distingue:
+
+        #ifdef _WIN32
+
+            char absolute[_MAX_PATH];
+
+            std::string canonical = _fullpath (absolute, path.c_str (), _MAX_PATH) ? absolute : path;
+
+            for (char & character : canonical)
+            {
+                character = character == '\\' ? '/' : char(std::tolower (static_cast< unsigned char >(character)));
+            }
+
+            return canonical;
+
+        #else
+
+            char absolute[PATH_MAX];
+
+            return realpath (path.c_str (), absolute) ? std::string(absolute) : path;
+
+        #endif
+    }
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Asset_Loader.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    // Registro central de mallas, texturas y arrays de materiales. Cada recurso se identifica
+    // por su ruta canónica y por los ajustes de importación, de modo que dos modelos que usan el
+    // mismo archivo comparten una única copia en la GPU. El registro sólo guarda referencias
+    // débiles: cuando el último modelo suelta su shared_ptr el recurso se destruye (y con él sus
+    // objetos de OpenGL) y la entrada se descarta la próxima vez que se consulte.
+    //
+    // Sólo debe usarse desde el hilo de render, igual que el Asset_Loader al que delega.
+
+    class Asset_Registry
+    {
+    public:
+
+        struct Statistics
+        {
+            size_t hits;                            // Peticiones servidas con un recurso ya cargado
+            size_t misses;                          // Peticiones que han lanzado una carga nueva
+            size_t resident_count;                  // Recursos vivos
+            size_t resident_bytes;                  // Memoria de GPU de los recursos vivos
+        };
+
+    private:
+
+        struct Key
+        {
+            std::string path;
+            uint32_t    settings;
+
+            bool operator == (const Key & other) const
+            {
+                return settings == other.settings && path == other.path;
+            }
+        };
+
+        struct Key_Hash
+        {
+            size_t operator () (const Key & key) const
+            {
+                return std::hash< std::string > ()(key.path) ^ (size_t(key.settings) * 0x9E3779B97F4A7C15ull);
+            }
+        };
+
+        template< typename ASSET >
+        using Asset_Map = std::unordered_map< Key, std::weak_ptr< ASSET >, Key_Hash >;
+
+    private:
+
+        Asset_Loader       & loader;
+
+        Asset_Map< Mesh           > meshes;
+        Asset_Map< Texture        > textures;
+        Asset_Map< Material_Array > materials;
+
+        size_t               hits;
+        size_t               misses;
+
+    public:
+
+        explicit Asset_Registry(Asset_Loader & loader);
+
+        Asset_Registry(const Asset_Registry & ) = delete;
+        Asset_Registry & operator = (const Asset_Registry & ) = delete;
+
+    public:
+
+        // settings distingue variantes del mismo archivo importadas con opciones distintas:
+
+        std::shared_ptr< Mesh    > get_mesh    (const std::string & mesh_path,    uint32_t settings = 0);
+        std::shared_ptr< Texture > get_texture (const std::string & texture_path, uint32_t settings = 0);
+
+        // Los arrays de materiales se identifican por la lista completa de rutas de sus capas:
+
+        std::shared_ptr< Material_Array > get_materials (const std::vector< std::string > & texture_paths);
+
+        // Elimina las entradas de recursos que ya se han liberado:
+
+        void collect ();
+
+        Statistics get_statistics ();
+
+        static std::string canonicalize (const std::string & path);
+
+    private:
+
+        template< typename ASSET, typename LOAD >
+        std::shared_ptr< ASSET > get (Asset_Map< ASSET > & map, const std::string & path, uint32_t settings, LOAD && load);
+
+    };
+
+}
@@ -9,46 +9,7 @@ namespace udit
 
     Cone::Cone()
     {
-        float full_circle = 3.14159265f * 2.f;              // un giro completo son 2 * pi radianes (360)
-        unsigned number_of_base_vertices = 10;
-        GLfloat cone_radius = 2.4f;
-
-        base_coordinates.push_back(0);
-        base_coordinates.push_back(0);
-        base_coordinates.push_back(0);
-
-        for (float angle = 0.f, step = full_circle / number_of_base_vertices; angle < full_circle; angle += step)
-        {
-            float x = cos(angle) * cone_radius;
-            float y = 0.f;
-            float z = sin(angle) * cone_radius;
-            // guardar las coordenadas x, y, z en un vec3 y aadirlo a un vector<vec3> en el que se guardan
-            // los vrtices del cono
-
-
-            base_coordinates.push_back(x);
-            base_coordinates.push_back(y);
-            base_coordinates.push_back(z);
-        }
-        base_coordinates.push_back(base_coordinates[3]);
-        base_coordinates.push_back(base_coordinates[4]);
-        base_coordinates.push_back(base_coordinates[5]);
-
-        // Punta del cono
-
-        tip_coordinates.push_back(0);
-        tip_coordinates.push_back(5);
-        tip_coordinates.push_back(0);
-
-        for (unsigned i = 3; i < base_coordinates.size(); i+=3)
-        {
-            tip_coordinates.push_back(base_coordinates[i]);
-            tip_coordinates.push_back(base_coordinates[i+1]);
-            tip_coordinates.push_back(base_coordinates[i+2]);
-        }
-        tip_coordinates.push_back(base_coordinates[3]);
-        tip_coordinates.push_back(base_coordinates[4]);
-        tip_coordinates.push_back(base_coordinates[5]);
+        generate (base_coordinates, tip_coordinates);
 
         // Se generan ndices para los VBOs del cubo:
 
@@ -104,6 +65,53 @@ namespace udit
         glBindVertexArray(0);
     }
 
+    void Cone::generate (vector <GLfloat> & base_coordinates, vector <GLfloat> & tip_coordinates)
+    {
+        base_coordinates.clear ();
+        tip_coordinates .clear ();
+
+        float full_circle = 3.14159265f * 2.f;              // un giro completo son 2 * pi radianes (360)
+        unsigned number_of_base_vertices = 10;
+        GLfloat cone_radius = 2.4f;
+
+        base_coordinates.push_back(0);
+        base_coordinates.push_back(0);
+        base_coordinates.push_back(0);
+
+        for (float angle = 0.f, step = full_circle / number_of_base_vertices; angle < full_circle; angle += step)
+        {
+            float x = cos(angle) * cone_radius;
+            float y = 0.f;
+            float z = sin(angle) * cone_radius;
+            // guardar las coordenadas x, y, z en un vec3 y aadirlo a un vector<vec3> en el que se guardan
+            // los vrtices del cono
+
+
+            base_coordinates.push_back(x);
+            base_coordinates.push_back(y);
+            base_coordinates.push_back(z);
+        }
+        base_coordinates.push_back(base_coordinates[3]);
+        base_coordinates.push_back(base_coordinates[4]);
+        base_coordinates.push_back(base_coordinates[5]);
+
+        // Punta del cono
+
+        tip_coordinates.push_back(0);
+        tip_coordinates.push_back(5);
+        tip_coordinates.push_back(0);
+
+        for (unsigned i = 3; i < base_coordinates.size(); i+=3)
+        {
+            tip_coordinates.push_back(base_coordinates[i]);
+            tip_coordinates.push_back(base_coordinates[i+1]);
+            tip_coordinates.push_back(base_coordinates[i+2]);
+        }
+        tip_coordinates.push_back(base_coordinates[3]);
+        tip_coordinates.push_back(base_coordinates[4]);
+        tip_coordinates.push_back(base_coordinates[5]);
+    }
+
     Cone::~Cone()
     {
         // Se liberan los VBOs y el VAO usados:
@@ -34,6 +34,10 @@
             Cone();
            ~Cone();
 
+            // Coordenadas x, y, z de los abanicos de la base y de la punta, sin usar OpenGL:
+
+            static void generate (vector <GLfloat> & base_coordinates, vector <GLfloat> & tip_coordinates);
+
             void render ();
             void renderWireframe();
         };
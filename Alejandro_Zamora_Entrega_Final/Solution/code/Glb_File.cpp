@@ -0,0 +1,393 @@
+#include "Glb_File.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        constexpr uint32_t glb_magic       = 0x46546C67;       // "glTF"
+        constexpr uint32_t json_chunk_type = 0x4E4F534A;       // "JSON"
+        constexpr uint32_t bin_chunk_type  = 0x004E4942;       // "BIN\0"
+        constexpr int      triangles_mode  = 4;
+
+        inline uint32_t read_u32 (const uint8_t * bytes)
+        {
+            uint32_t value;
+            std::memcpy (&value, bytes, sizeof(value));
+            return value;
+        }
+
+        size_t component_size (GLenum component_type)
+        {
+            switch (component_type)
+            {
+                case GL_BYTE:           case GL_UNSIGNED_BYTE:  return 1;
+                case GL_SHORT:          case GL_UNSIGNED_SHORT: return 2;
+                case GL_UNSIGNED_INT:   case GL_FLOAT:          return 4;
+                default:                                        return 0;
+            }
+        }
+
+        unsigned component_count (const std::string & type)
+        {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2"  ) return 2;
+            if (type == "VEC3"  ) return 3;
+            if (type == "VEC4"  ) return 4;
+            return 0;
+        }
+
+        float read_normalized (const uint8_t * component, GLenum component_type)
+        {
+            switch (component_type)
+            {
+                case GL_UNSIGNED_BYTE:  return float(*component) / 255.f;
+                case GL_UNSIGNED_SHORT: { uint16_t value; std::memcpy (&value, component, 2); return float(value) / 65535.f; }
+                case GL_FLOAT:          { float    value; std::memcpy (&value, component, 4); return value; }
+                default:                return 0.f;
+            }
+        }
+
+        uint32_t read_index (const uint8_t * component, GLenum component_type)
+        {
+            switch (component_type)
+            {
+                case GL_UNSIGNED_BYTE:  return *component;
+                case GL_UNSIGNED_SHORT: { uint16_t value; std::memcpy (&value, component, 2); return value; }
+                default:                return read_u32 (component);
+            }
+        }
+
+    }
+
+    bool Glb_File::is_glb (const std::string & path)
+    {
+        return path.size () >= 4 && path.compare (path.size () - 4, 4, ".glb") == 0;
+    }
+
+    bool Glb_File::parse_accessor
+    (
+        const Json    & document,
+        const uint8_t * binary,
+        size_t          binary_size,
+        const Json    & index,
+        Accessor      & accessor
+    )
+    const
+    {
+        const Json * accessors    = document.find ("accessors"  );
+        const Json * buffer_views = document.find ("bufferViews");
+
+        if (!index.is_number () || !accessors || !buffer_views) return false;
+
+        size_t accessor_index = size_t(index.as_number ());
+
+        if (accessor_index >= accessors->size ()) return false;
+
+        const Json & description = (*accessors)[accessor_index];
+
+        // Los accessors dispersos (sparse) o sin bufferView no se pueden subir directamente:
+
+        const Json * view_index = description.find ("bufferView");
+        const Json * type       = description.find ("type"      );
+
+        if (description.find ("sparse") || !view_index || !type || !type->is_string ()) return false;
+
+        if (size_t(view_index->as_number ()) >= buffer_views->size ()) return false;
+
+        const Json & view = (*buffer_views)[size_t(view_index->as_number ())];
+
+        if (view.get_number ("buffer", 0) != 0) return false;
+
+        accessor.component_type = GLenum(description.get_number ("componentType", 0));
+        accessor.components     = component_count (type->as_string ());
+        accessor.count          = size_t(description.get_number ("count", 0));
+
+        const Json * normalized = description.find ("normalized");
+        accessor.normalized     = normalized && normalized->as_boolean ();
+
+        size_t element_size = component_size (accessor.component_type) * accessor.components;
+
+        if (element_size == 0) return false;
+
+        size_t view_offset     = size_t(view.get_number ("byteOffset", 0));
+        size_t view_length     = size_t(view.get_number ("byteLength", 0));
+        size_t accessor_offset = size_t(description.get_number ("byteOffset", 0));
+
+        accessor.stride = size_t(view.get_number ("byteStride", double(element_size)));
+
+        // El rango completo del accessor debe caber en su bufferView y éste en el chunk binario:
+
+        if (view_offset > binary_size || view_length > binary_size - view_offset) return false;
+        if (accessor.stride < element_size || accessor.stride % component_size (accessor.component_type) != 0) return false;
+        if ((view_offset + accessor_offset) % component_size (accessor.component_type) != 0) return false;
+
+        if (accessor.count > 0)
+        {
+            size_t last_byte = accessor_offset + accessor.stride * (accessor.count - 1) + element_size;
+
+            if (last_byte > view_length) return false;
+        }
+
+        accessor.data = binary + view_offset + accessor_offset;
+
+        return true;
+    }
+
+    bool Glb_File::open (const std::string & path)
+    {
+        primitives.clear ();
+        material_textures.clear ();
+
+        if (!file.open (path)) return false;
+
+        const uint8_t * bytes = file.data ();
+        size_t          size  = file.size ();
+
+        // Cabecera de 12 bytes y chunks JSON y BIN:
+
+        if (size < 20 || read_u32 (bytes) != glb_magic || read_u32 (bytes + 4) != 2) return false;
+
+        size = std::min< size_t > (size, read_u32 (bytes + 8));
+
+        size_t json_length = read_u32 (bytes + 12);
+
+        if (read_u32 (bytes + 16) != json_chunk_type || json_length > size - 20) return false;
+
+        const char * json_begin = reinterpret_cast< const char * >(bytes + 20);
+
+        const uint8_t * binary      = nullptr;
+        size_t          binary_size = 0;
+        size_t          bin_header  = 20 + json_length;
+
+        if (bin_header + 8 <= size && read_u32 (bytes + bin_header + 4) == bin_chunk_type)
+        {
+            binary      = bytes + bin_header + 8;
+            binary_size = std::min< size_t > (read_u32 (bytes + bin_header), size - bin_header - 8);
+        }
+
+        Json document;
+
+        if (!Json::parse (json_begin, json_begin + json_length, document)) return false;
+
+        // Sólo se acepta el búfer embebido en el propio .glb:
+
+        const Json * buffers = document.find ("buffers");
+
+        if (!binary || !buffers || buffers->size () != 1 || (*buffers)[0].find ("uri")) return false;
+
+        const Json * meshes = document.find ("meshes");
+
+        if (!meshes || meshes->size () == 0) return false;
+
+        for (size_t m = 0; m < meshes->size (); ++m)
+        {
+            const Json * mesh_primitives = (*meshes)[m].find ("primitives");
+
+            if (!mesh_primitives) return false;
+
+            for (size_t p = 0; p < mesh_primitives->size (); ++p)
+            {
+                const Json & description = (*mesh_primitives)[p];
+                const Json * attributes  = description.find ("attributes");
+
+                if (description.get_number ("mode", triangles_mode) != triangles_mode) continue;
+
+                if (!attributes || !attributes->find ("POSITION")) return false;
+
+                Primitive primitive;
+
+                if (!parse_accessor (document, binary, binary_size, *attributes->find ("POSITION"), primitive.positions)) return false;
+
+                if (primitive.positions.component_type != GL_FLOAT || primitive.positions.components != 3) return false;
+
+                if (const Json * uvs = attributes->find ("TEXCOORD_0"))
+                {
+                    if (!parse_accessor (document, binary, binary_size, *uvs, primitive.uvs)) return false;
+
+                    if (primitive.uvs.components != 2 || primitive.uvs.count != primitive.positions.count) return false;
+
+                    if (primitive.uvs.component_type != GL_FLOAT && !primitive.uvs.normalized) return false;
+                }
+
+                // Las bases tangentes sólo se usan si vienen completas y en float, como exige glTF.
+                // Si no, se generan al cargar la malla:
+
+                const Json * normals  = attributes->find ("NORMAL" );
+                const Json * tangents = attributes->find ("TANGENT");
+
+                if (normals && tangents)
+                {
+                    Accessor normal_accessor;
+                    Accessor tangent_accessor;
+
+                    if (parse_accessor (document, binary, binary_size, *normals,  normal_accessor )
+                     && parse_accessor (document, binary, binary_size, *tangents, tangent_accessor)
+                     && normal_accessor .component_type == GL_FLOAT && normal_accessor .components == 3 && normal_accessor .count == primitive.positions.count
+                     && tangent_accessor.component_type == GL_FLOAT && tangent_accessor.components == 4 && tangent_accessor.count == primitive.positions.count)
+                    {
+                        primitive.normals  = normal_accessor;
+                        primitive.tangents = tangent_accessor;
+                    }
+                }
+
+                if (const Json * indices = description.find ("indices"))
+                {
+                    if (!parse_accessor (document, binary, binary_size, *indices, primitive.indices)) return false;
+
+                    if (primitive.indices.components != 1 || primitive.indices.count % 3 != 0) return false;
+
+                    GLenum type = primitive.indices.component_type;
+
+                    if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT) return false;
+
+                    // Ningún índice puede salirse de los vértices de la primitiva:
+
+                    for (size_t i = 0; i < primitive.indices.count; ++i)
+                    {
+                        if (read_index (primitive.indices.data + i * primitive.indices.stride, type) >= primitive.positions.count) return false;
+                    }
+                }
+                else
+                if (primitive.positions.count % 3 != 0)
+                {
+                    return false;
+                }
+
+                // glTF obliga a incluir min y max en POSITION; si faltan se calculan:
+
+                const Json & position_accessor = (*document.find ("accessors"))[size_t(attributes->find ("POSITION")->as_number ())];
+                const Json * min_values        = position_accessor.find ("min");
+                const Json * max_values        = position_accessor.find ("max");
+
+                if (min_values && max_values && min_values->size () == 3 && max_values->size () == 3)
+                {
+                    for (unsigned c = 0; c < 3; ++c)
+                    {
+                        primitive.min_corner[c] = float((*min_values)[c].as_number ());
+                        primitive.max_corner[c] = float((*max_values)[c].as_number ());
+                    }
+                }
+                else
+                {
+                    primitive.min_corner = glm::vec3(+INFINITY);
+                    primitive.max_corner = glm::vec3(-INFINITY);
+
+                    for (size_t v = 0; v < primitive.positions.count; ++v)
+                    {
+                        glm::vec3 position;
+                        std::memcpy (&position, primitive.positions.data + v * primitive.positions.stride, sizeof(position));
+
+                        primitive.min_corner = glm::min (primitive.min_corner, position);
+                        primitive.max_corner = glm::max (primitive.max_corner, position);
+                    }
+                }
+
+                primitive.material = unsigned(std::max (description.get_number ("material", 0), 0.0));
+
+                primitives.push_back (primitive);
+            }
+        }
+
+        // Material -> pbrMetallicRoughness.baseColorTexture -> texture -> image -> uri:
+
+        const Json * materials = document.find ("materials");
+        const Json * textures  = document.find ("textures" );
+        const Json * images    = document.find ("images"   );
+
+        const std::string directory = path.substr (0, path.find_last_of ("/\\") + 1);
+
+        for (size_t m = 0; materials && m < materials->size (); ++m)
+        {
+            std::string  texture_path;
+            const Json * pbr        = (*materials)[m].find ("pbrMetallicRoughness");
+            const Json * base_color = pbr ? pbr->find ("baseColorTexture") : nullptr;
+
+            if (base_color && textures && images)
+            {
+                double texture = base_color->get_number ("index", -1);
+
+                if (texture >= 0 && texture < double(textures->size ()))
+                {
+                    double       image = (*textures)[size_t(texture)].get_number ("source", -1);
+                    const Json * uri   = image >= 0 && image < double(images->size ()) ? (*images)[size_t(image)].find ("uri") : nullptr;
+
+                    if (uri && uri->is_string () && uri->as_string ().compare (0, 5, "data:") != 0)
+                    {
+                        texture_path = directory + uri->as_string ();
+                    }
+                }
+            }
+
+            material_textures.push_back (texture_path);
+        }
+
+        return !primitives.empty ();
+    }
+
+    bool Glb_File::is_packed (const Accessor & accessor, GLenum component_type, unsigned components)
+    {
+        return accessor.component_type == component_type
+            && accessor.components     == components
+            && accessor.stride         == component_size (component_type) * components;
+    }
+
+    void Glb_File::read_positions (const Accessor & accessor, glm::vec3 * destination)
+    {
+        for (size_t v = 0; v < accessor.count; ++v)
+        {
+            std::memcpy (destination + v, accessor.data + v * accessor.stride, sizeof(glm::vec3));
+        }
+    }
+
+    void Glb_File::read_uvs (const Accessor & accessor, glm::vec2 * destination)
+    {
+        size_t size = component_size (accessor.component_type);
+
+        for (size_t v = 0; v < accessor.count; ++v)
+        {
+            const uint8_t * element = accessor.data + v * accessor.stride;
+
+            destination[v] = glm::vec2(read_normalized (element, accessor.component_type), 1.f - read_normalized (element + size, accessor.component_type));
+        }
+    }
+
+    void Glb_File::read_tangent_frames (const Primitive & primitive, Tangent_Frame * destination)
+    {
+        // TANGENT guarda en w el signo de la bitangente, igual que Tangent_Frame, pero respecto a
+        // la V de glTF. Al invertir V la bitangente apunta al lado contrario:
+
+        for (size_t v = 0; v < primitive.positions.count; ++v)
+        {
+            glm::vec3 normal;
+            glm::vec4 tangent;
+
+            std::memcpy (&normal,  primitive.normals .data + v * primitive.normals .stride, sizeof(normal ));
+            std::memcpy (&tangent, primitive.tangents.data + v * primitive.tangents.stride, sizeof(tangent));
+
+            destination[v] = Tangent_Space::pack (normal, glm::vec3(tangent), tangent.w < 0.f ? 1.f : -1.f);
+        }
+    }
+
+    void Glb_File::read_indices (const Primitive & primitive, GLuint * destination)
+    {
+        const Accessor & indices = primitive.indices;
+
+        if (!indices.data)
+        {
+            for (size_t i = 0; i < primitive.positions.count; ++i) destination[i] = GLuint(i);
+            return;
+        }
+
+        for (size_t i = 0; i < indices.count; ++i)
+        {
+            destination[i] = read_index (indices.data + i * indices.stride, indices.component_type);
+        }
+    }
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+#include <Json.hpp>
+#include <Mapped_File.hpp>
+
+#include "Tangent_Space.hpp"
+
+namespace udit
+{
+
+    // Lector nativo de glTF 2.0 binario (.glb). El archivo se proyecta en memoria y los
+    // accessors se validan contra el chunk binario, de modo que sus datos se pueden subir a la
+    // GPU directamente desde la proyección sin copias intermedias. Sólo se leen las primitivas
+    // de triángulos con POSITION en float, TEXCOORD_0 opcional, NORMAL y TANGENT opcionales e
+    // índices opcionales; cualquier otra cosa hace que open() falle para que se use Assimp.
+
+    class Glb_File
+    {
+    public:
+
+        struct Accessor
+        {
+            const uint8_t * data           = nullptr;
+            size_t          count          = 0;
+            size_t          stride         = 0;
+            GLenum          component_type = 0;
+            unsigned        components     = 0;
+            bool            normalized     = false;
+        };
+
+        struct Primitive
+        {
+            Accessor  positions;
+            Accessor  uvs;                          // data == nullptr si no hay UVs
+            Accessor  indices;                      // data == nullptr si no está indexada
+            Accessor  normals;                      // Ambos con data == nullptr si no trae
+            Accessor  tangents;                     // bases tangentes válidas
+            glm::vec3 min_corner;
+            glm::vec3 max_corner;
+            unsigned  material = 0;
+
+            size_t get_index_count () const
+            {
+                return indices.data ? indices.count : positions.count;
+            }
+        };
+
+    private:
+
+        Mapped_File              file;
+        std::vector< Primitive > primitives;
+        std::vector< std::string > material_textures;
+
+    public:
+
+        static bool is_glb (const std::string & path);
+
+        bool open (const std::string & path);
+
+        const std::vector< Primitive > & get_primitives () const
+        {
+            return primitives;
+        }
+
+        // Textura baseColor de cada material. Sólo se resuelven las imágenes externas (con uri);
+        // las embebidas en el chunk binario quedan vacías:
+
+        const std::vector< std::string > & get_material_textures () const
+        {
+            return material_textures;
+        }
+
+        // Indica si el accessor tiene exactamente el formato y la disposición que espera el
+        // vertex buffer, en cuyo caso se puede subir tal cual:
+
+        static bool is_packed (const Accessor & accessor, GLenum component_type, unsigned components);
+
+        // Conversión a los formatos del vertex buffer cuando no coinciden. Se puede escribir
+        // directamente en un búfer de OpenGL mapeado. glTF pone el origen de las UV arriba a la
+        // izquierda, así que read_uvs devuelve 1 - v (como Assimp) y las UV se convierten siempre:
+
+        static void read_positions (const Accessor & accessor, glm::vec3 * destination);
+        static void read_uvs       (const Accessor & accessor, glm::vec2 * destination);
+        static void read_indices   (const Primitive & primitive, GLuint * destination);
+
+        // Empaqueta las normales y tangentes del archivo (requiere tangents.data). El signo de
+        // la bitangente se invierte para que corresponda a las UV con V invertida:
+
+        static void read_tangent_frames (const Primitive & primitive, Tangent_Frame * destination);
+
+    private:
+
+        bool parse_accessor (const Json & document, const uint8_t * binary, size_t binary_size, const Json & index, Accessor & accessor) const;
+
+    };
+
+}
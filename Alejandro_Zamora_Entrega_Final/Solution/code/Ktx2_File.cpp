@@ -0,0 +1,259 @@
+#include "Ktx2_File.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <Mapped_File.hpp>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        const uint8_t ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+        constexpr size_t header_size      = 80;        // Identificador, cabecera e índice
+        constexpr size_t level_entry_size = 24;        // byteOffset, byteLength y uncompressedByteLength
+
+        // Enumerantes de VkFormat y de la Khronos Data Format Specification de cada formato:
+
+        struct Format_Description
+        {
+            uint32_t vk_format;
+            uint32_t color_model;
+            uint32_t sample_channels[2];            // Canal de cada muestra de 64 bits (~0u si no hay)
+            GLenum   gl_format;
+        };
+
+        constexpr uint32_t no_channel = ~0u;
+
+        const Format_Description descriptions[] =
+        {
+            { 131, 128, {  0, no_channel }, 0x83F0 },           // BC1_RGB_UNORM, GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+            { 137, 130, { 15,  0         }, 0x83F3 },           // BC3_UNORM,     GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+            { 139, 131, {  0, no_channel }, GL_COMPRESSED_RED_RGTC1 },
+            { 141, 132, {  0,  1         }, GL_COMPRESSED_RG_RGTC2  },
+        };
+
+        inline uint32_t read_u32 (const uint8_t * bytes)
+        {
+            uint32_t value;
+            std::memcpy (&value, bytes, sizeof(value));
+            return value;
+        }
+
+        inline uint64_t read_u64 (const uint8_t * bytes)
+        {
+            uint64_t value;
+            std::memcpy (&value, bytes, sizeof(value));
+            return value;
+        }
+
+        // Descriptor de formato básico (DFD) con una muestra por cada bloque de 8 bytes:
+
+        std::vector< uint32_t > build_dfd (Block_Compression::Format format)
+        {
+            const Format_Description & description = descriptions[format];
+
+            const uint32_t sample_count = description.sample_channels[1] == no_channel ? 1 : 2;
+            const uint32_t block_size   = 24 + 16 * sample_count;
+
+            std::vector< uint32_t > dfd
+            {
+                4 + block_size,                             // dfdTotalSize
+                0,                                          // vendorId y descriptorType (Khronos, básico)
+                2 | block_size << 16,                       // versionNumber y descriptorBlockSize
+                description.color_model | 1 << 8 | 1 << 16, // colorModel, primarios BT.709, transferencia lineal
+                3 | 3 << 8,                                 // Bloques de 4x4x1x1
+                uint32_t(Block_Compression::get_block_bytes (format)),
+                0
+            };
+
+            for (uint32_t sample = 0; sample < sample_count; ++sample)
+            {
+                dfd.push_back (sample * 64 | 63 << 16 | description.sample_channels[sample] << 24);
+                dfd.push_back (0);
+                dfd.push_back (0);
+                dfd.push_back (0xFFFFFFFF);
+            }
+
+            return dfd;
+        }
+
+    }
+
+    bool Ktx2_File::is_ktx2 (const std::string & path)
+    {
+        return path.size () >= 5 && path.compare (path.size () - 5, 5, ".ktx2") == 0;
+    }
+
+    GLenum Ktx2_File::get_gl_format (Format format)
+    {
+        return descriptions[format].gl_format;
+    }
+
+    bool Ktx2_File::write (const std::string & path, const Image & image)
+    {
+        std::ofstream file(path, std::ios::binary);
+
+        if (!file || image.levels.empty ()) return false;
+
+        auto put = [&file] (const auto & value)
+        {
+            file.write (reinterpret_cast< const char * >(&value), sizeof(value));
+        };
+
+        const uint32_t                level_count = uint32_t(image.levels.size ());
+        const std::vector< uint32_t > dfd         = build_dfd (image.format);
+        const size_t                  alignment   = Block_Compression::get_block_bytes (image.format);
+
+        const uint32_t dfd_offset = uint32_t(header_size + level_count * level_entry_size);
+        const uint32_t dfd_length = uint32_t(dfd.size () * sizeof(uint32_t));
+
+        // Los niveles se colocan tras el DFD, del último al primero y alineados al tamaño de
+        // bloque:
+
+        std::vector< uint64_t > offsets(level_count);
+
+        uint64_t offset = dfd_offset + dfd_length;
+
+        for (size_t level = level_count; level-- > 0; )
+        {
+            offset          = (offset + alignment - 1) / alignment * alignment;
+            offsets[level]  = offset;
+            offset         += image.levels[level].size ();
+        }
+
+        file.write (reinterpret_cast< const char * >(ktx2_identifier), sizeof(ktx2_identifier));
+
+        put (descriptions[image.format].vk_format);
+        put (uint32_t(1));                          // typeSize
+        put (uint32_t(image.width ));
+        put (uint32_t(image.height));
+        put (uint32_t(0));                          // pixelDepth
+        put (uint32_t(0));                          // layerCount
+        put (uint32_t(1));                          // faceCount
+        put (level_count);
+        put (uint32_t(0));                          // supercompressionScheme
+
+        put (dfd_offset);
+        put (dfd_length);
+        put (uint32_t(0));                          // kvdByteOffset
+        put (uint32_t(0));                          // kvdByteLength
+        put (uint64_t(0));                          // sgdByteOffset
+        put (uint64_t(0));                          // sgdByteLength
+
+        for (size_t level = 0; level < level_count; ++level)
+        {
+            put (offsets[level]);
+            put (uint64_t(image.levels[level].size ()));
+            put (uint64_t(image.levels[level].size ()));
+        }
+
+        file.write (reinterpret_cast< const char * >(dfd.data ()), std::streamsize(dfd_length));
+
+        uint64_t position = dfd_offset + dfd_length;
+
+        for (size_t level = level_count; level-- > 0; )
+        {
+            for ( ; position < offsets[level]; ++position) file.put (0);
+
+            file.write (reinterpret_cast< const char * >(image.levels[level].data ()), std::streamsize(image.levels[level].size ()));
+
+            position += image.levels[level].size ();
+        }
+
+        return bool(file);
+    }
+
+    bool Ktx2_File::read (const std::string & path, Image & image)
+    {
+        Mapped_File file;
+
+        return file.open (path) && read (file.data (), file.size (), image);
+    }
+
+    bool Ktx2_File::read (const uint8_t * bytes, size_t size, Image & image)
+    {
+        Layout layout;
+
+        if (!read_layout (bytes, size, layout)) return false;
+
+        image.format = layout.format;
+        image.width  = layout.width;
+        image.height = layout.height;
+        image.levels.resize (layout.level_offsets.size ());
+
+        for (size_t level = 0; level < image.levels.size (); ++level)
+        {
+            const uint8_t * begin = bytes + layout.level_offsets[level];
+
+            image.levels[level].assign (begin, begin + layout.level_sizes[level]);
+        }
+
+        return true;
+    }
+
+    bool Ktx2_File::read_layout (const uint8_t * bytes, size_t size, Layout & layout)
+    {
+        if (size < header_size) return false;
+
+        if (std::memcmp (bytes, ktx2_identifier, sizeof(ktx2_identifier)) != 0) return false;
+
+        const uint32_t vk_format     = read_u32 (bytes + 12);
+        const uint32_t width         = read_u32 (bytes + 20);
+        const uint32_t height        = read_u32 (bytes + 24);
+        const uint32_t depth         = read_u32 (bytes + 28);
+        const uint32_t layer_count   = read_u32 (bytes + 32);
+        const uint32_t face_count    = read_u32 (bytes + 36);
+        const uint32_t level_count   = std::max (read_u32 (bytes + 40), 1u);
+        const uint32_t supercompress = read_u32 (bytes + 44);
+
+        if (width == 0 || height == 0 || depth != 0 || layer_count > 1 || face_count != 1 || supercompress != 0) return false;
+
+        if (level_count > 32 || header_size + level_count * level_entry_size > size) return false;
+
+        bool known = false;
+
+        for (unsigned format = 0; format < sizeof(descriptions) / sizeof(descriptions[0]); ++format)
+        {
+            if (descriptions[format].vk_format == vk_format)
+            {
+                layout.format = Format(format);
+                known         = true;
+            }
+        }
+
+        if (!known) return false;
+
+        layout.width  = width;
+        layout.height = height;
+        layout.level_offsets.resize (level_count);
+        layout.level_sizes  .resize (level_count);
+
+        for (size_t level = 0; level < level_count; ++level)
+        {
+            const uint8_t * entry  = bytes + header_size + level * level_entry_size;
+            const uint64_t  offset = read_u64 (entry);
+            const uint64_t  length = read_u64 (entry + 8);
+
+            // Cada nivel tiene que ocupar exactamente los bloques que le corresponden:
+
+            const size_t expected = Block_Compression::get_compressed_size
+            (
+                layout.format,
+                get_level_size (width,  level),
+                get_level_size (height, level)
+            );
+
+            if (length != expected || offset > size || length > size - offset) return false;
+
+            layout.level_offsets[level] = size_t(offset);
+            layout.level_sizes  [level] = size_t(length);
+        }
+
+        return true;
+    }
+
+}
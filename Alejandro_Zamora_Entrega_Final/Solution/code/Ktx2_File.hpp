@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include <Block_Compression.hpp>
+
+namespace udit
+{
+
+    // Lectura y escritura de contenedores KTX2 con texturas 2D comprimidas en BC1, BC3, BC4 o
+    // BC5 y su cadena de mipmaps ya calculada. Sólo se admite una capa, una cara y ningún
+    // esquema de supercompresión; cualquier otra cosa hace que read() falle.
+    //
+    // Los niveles se guardan en el archivo del más pequeño al más grande, como recomienda la
+    // especificación, para que un lector progresivo pueda empezar por los mipmaps bajos.
+
+    class Ktx2_File
+    {
+    public:
+
+        using Format = Block_Compression::Format;
+
+        struct Image
+        {
+            Format                                format;
+            unsigned                              width;
+            unsigned                              height;
+            std::vector< std::vector< uint8_t > > levels;      // Bloques de cada nivel, el 0 primero
+        };
+
+        // Posición de los bloques de cada nivel dentro del archivo. Con ella se pueden copiar
+        // directamente desde la proyección del archivo a la GPU sin pasar por un Image:
+
+        struct Layout
+        {
+            Format                format;
+            unsigned              width;
+            unsigned              height;
+            std::vector< size_t > level_offsets;    // El nivel 0 primero
+            std::vector< size_t > level_sizes;
+        };
+
+    public:
+
+        static bool is_ktx2 (const std::string & path);
+
+        static bool write (const std::string & path, const Image & image);
+        static bool read  (const std::string & path, Image & image);
+        static bool read  (const uint8_t * bytes, size_t size, Image & image);
+
+        // Sólo valida la cabecera y el índice de niveles, sin copiar los bloques:
+
+        static bool read_layout (const uint8_t * bytes, size_t size, Layout & layout);
+
+        // Formato interno de OpenGL de cada formato de bloque. BC1 y BC3 necesitan la extensión
+        // EXT_texture_compression_s3tc; BC4 y BC5 (RGTC) son parte de OpenGL 3.0:
+
+        static GLenum get_gl_format (Format format);
+
+        static unsigned get_level_size (unsigned size, size_t level)
+        {
+            return std::max (size >> level, 1u);
+        }
+
+    };
+
+}
@@ -0,0 +1,487 @@
+#include "Material_Array.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <opengl-recipes.hpp>
+#include <Skyline_Packer.hpp>
+
+namespace udit
+{
+
+    const std::string Material_Array::vertex_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform mat4 model_view_matrix;"
+        "uniform mat4 projection_matrix;"
+        ""
+        "layout (location = 0) in vec3  vertex_coordinates;"
+        "layout (location = 1) in vec2  vertex_texture_uv;"
+        "layout (location = 8) in ivec4 vertex_tangent_frame;"
+        "layout (location = 9) in uint  vertex_material;"
+        ""
+        "uniform sampler2D material_placements;"
+        ""
+        "out vec2  texture_uv;"
+        "out float shade;"
+        "flat out vec4  material_rect;"
+        "flat out float material_layer;"
+        ""
+        "const vec3 light_direction = vec3(0.37, 0.74, 0.56);"
+        ""
+        "vec3 decode_octahedral (vec2 e)"
+        "{"
+        "   vec3  n    = vec3(e, 1.0 - abs (e.x) - abs (e.y));"
+        "   float fold = max (-n.z, 0.0);"
+        "   n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);"
+        "   return normalize (n);"
+        "}"
+        ""
+        "void fetch_material ()"
+        "{"
+        "   int index      = min (int(vertex_material), textureSize (material_placements, 0).x - 1);"
+        "   material_rect  = texelFetch (material_placements, ivec2(index, 0), 0);"
+        "   material_layer = texelFetch (material_placements, ivec2(index, 1), 0).x;"
+        "}"
+        ""
+        "float shade_vertex (mat4 model_view)"
+        "{"
+        "   if (vertex_tangent_frame.z == -32768) return 1.0;"
+        "   vec3 normal = normalize (mat3(model_view) * decode_octahedral (vec2(vertex_tangent_frame.xy) / 32767.0));"
+        "   return 0.35 + 0.65 * max (dot (normal, light_direction), 0.0);"
+        "}"
+        ""
+        "void main()"
+        "{"
+        "   gl_Position = projection_matrix * model_view_matrix * vec4(vertex_coordinates, 1.0);"
+        "   texture_uv  = vertex_texture_uv;"
+        "   shade       = shade_vertex (model_view_matrix);"
+        "   fetch_material ();"
+        "}";
+
+    const std::string Material_Array::instanced_vertex_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform mat4 view_matrix;"
+        "uniform mat4 projection_matrix;"
+        ""
+        "layout (location = 0) in vec3  vertex_coordinates;"
+        "layout (location = 1) in vec2  vertex_texture_uv;"
+        "layout (location = 2) in mat4  instance_model_matrix;"
+        "layout (location = 8) in ivec4 vertex_tangent_frame;"
+        "layout (location = 9) in uint  vertex_material;"
+        ""
+        "uniform sampler2D material_placements;"
+        ""
+        "out vec2  texture_uv;"
+        "out float shade;"
+        "flat out vec4  material_rect;"
+        "flat out float material_layer;"
+        ""
+        "const vec3 light_direction = vec3(0.37, 0.74, 0.56);"
+        ""
+        "vec3 decode_octahedral (vec2 e)"
+        "{"
+        "   vec3  n    = vec3(e, 1.0 - abs (e.x) - abs (e.y));"
+        "   float fold = max (-n.z, 0.0);"
+        "   n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);"
+        "   return normalize (n);"
+        "}"
+        ""
+        "void fetch_material ()"
+        "{"
+        "   int index      = min (int(vertex_material), textureSize (material_placements, 0).x - 1);"
+        "   material_rect  = texelFetch (material_placements, ivec2(index, 0), 0);"
+        "   material_layer = texelFetch (material_placements, ivec2(index, 1), 0).x;"
+        "}"
+        ""
+        "float shade_vertex (mat4 model_view)"
+        "{"
+        "   if (vertex_tangent_frame.z == -32768) return 1.0;"
+        "   vec3 normal = normalize (mat3(model_view) * decode_octahedral (vec2(vertex_tangent_frame.xy) / 32767.0));"
+        "   return 0.35 + 0.65 * max (dot (normal, light_direction), 0.0);"
+        "}"
+        ""
+        "void main()"
+        "{"
+        "   gl_Position = projection_matrix * view_matrix * instance_model_matrix * vec4(vertex_coordinates, 1.0);"
+        "   texture_uv  = vertex_texture_uv;"
+        "   shade       = shade_vertex (view_matrix * instance_model_matrix);"
+        "   fetch_material ();"
+        "}";
+
+    const std::string Material_Array::fragment_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform sampler2DArray materials;"
+        ""
+        "in  vec2  texture_uv;"
+        "in  float shade;"
+        "flat in vec4  material_rect;"
+        "flat in float material_layer;"
+        "out vec4  fragment_color;"
+        ""
+        "void main()"
+        "{"
+        "    vec2 uv    = material_rect.xy + fract (texture_uv) * material_rect.zw;"
+        "    vec3 color = textureGrad (materials, vec3(uv, material_layer), dFdx (texture_uv) * material_rect.zw, dFdy (texture_uv) * material_rect.zw).rgb;"
+        "    fragment_color = vec4(color * shade, 1.0);"
+        "}";
+
+    Material_Array::Material_Array()
+    :
+        texture_id           (0),
+        placements_texture_id(0),
+        layer_count          (0),
+        gpu_bytes            (0)
+    {
+        program_id           = compile_shaders (          vertex_shader_code, fragment_shader_code);
+        instanced_program_id = compile_shaders (instanced_vertex_shader_code, fragment_shader_code);
+
+        // El sampler siempre lee de la unidad 0:
+
+        for (GLuint program : { program_id, instanced_program_id })
+        {
+            glUseProgram (program);
+            glUniform1i  (glGetUniformLocation (program, "materials"          ), 0);
+            glUniform1i  (glGetUniformLocation (program, "material_placements"), 1);
+        }
+
+        Layers placeholder{ 1, 1, 1, Color_Buffer(1, 1), { Placement{ 0, 0.f, 0.f, 1.f, 1.f } }, 1 };
+
+        placeholder.image.set (0, Rgba8888{ 0xFF808080 });
+
+        upload (placeholder);
+    }
+
+    Material_Array::~Material_Array()
+    {
+        if (texture_id           ) glDeleteTextures (1, &texture_id);
+        if (placements_texture_id) glDeleteTextures (1, &placements_texture_id);
+
+        release_program (program_id);
+        release_program (instanced_program_id);
+    }
+
+    std::unique_ptr< Material_Array::Layers > Material_Array::load_layers (const std::vector< std::string > & texture_paths, unsigned max_size)
+    {
+        std::vector< std::unique_ptr< Color_Buffer > > images;
+
+        images.reserve (texture_paths.size ());
+
+        for (const auto & path : texture_paths)
+        {
+            images.push_back (path.empty () ? nullptr : Texture::load_image (path));
+        }
+
+        return pack_layers (images, max_size);
+    }
+
+    std::unique_ptr< Material_Array::Layers > Material_Array::pack_layers (const std::vector< std::unique_ptr< Color_Buffer > > & images, unsigned max_size)
+    {
+        // Los materiales sin imagen comparten un pequeño cuadrado gris:
+
+        Color_Buffer missing(4, 4);
+
+        std::fill_n (missing.colors (), 16, Rgba8888{ 0xFF808080 });
+
+        auto image_of = [&] (size_t material) -> const Color_Buffer &
+        {
+            return images[material] ? *images[material] : missing;
+        };
+
+        const size_t count = std::max< size_t > (images.size (), 1);
+
+        // Las imágenes de más de media capa ocupan una capa entera. El resto se ordena de más
+        // alta a más baja, que es como mejor llena el skyline, y cada una va a la primera capa
+        // compartida en la que cabe:
+
+        struct Packed
+        {
+            size_t               material;
+            size_t               page;
+            Skyline_Packer::Rect rect;
+        };
+
+        struct Plan
+        {
+            unsigned                      size;
+            std::vector< size_t         > large;
+            std::vector< Skyline_Packer > pages;
+            std::vector< Packed         > packed;
+        };
+
+        std::vector< size_t > order(images.size ());
+
+        for (size_t material = 0; material < order.size (); ++material) order[material] = material;
+
+        std::stable_sort
+        (
+            order.begin (), order.end (),
+            [&] (size_t a, size_t b) { return image_of (a).get_height () > image_of (b).get_height (); }
+        );
+
+        auto plan_layers = [&] (unsigned size)
+        {
+            Plan plan{ size, {}, {}, {} };
+
+            for (size_t material : order)
+            {
+                const Color_Buffer & image = image_of (material);
+
+                if (image.get_width () > size / 2 || image.get_height () > size / 2)
+                {
+                    plan.large.push_back (material);
+                    continue;
+                }
+
+                Skyline_Packer::Rect rect;
+                size_t               page = 0;
+
+                while (page < plan.pages.size () && !plan.pages[page].insert (image.get_width (), image.get_height (), rect)) ++page;
+
+                // Con capas muy pequeñas puede que ni con la página vacía quepa el margen:
+
+                if (page == plan.pages.size ())
+                {
+                    plan.pages.push_back (Skyline_Packer(size, size, padding));
+
+                    if (!plan.pages.back ().insert (image.get_width (), image.get_height (), rect))
+                    {
+                        plan.pages.pop_back ();
+                        plan.large.push_back (material);
+                        continue;
+                    }
+                }
+
+                plan.packed.push_back (Packed{ material, page, rect });
+            }
+
+            return plan;
+        };
+
+        // Las capas son cuadradas y miden una potencia de 2. Las imágenes grandes no se reducen
+        // salvo para no pasar de max_size; a partir de ahí se prueba cada tamaño y se queda el
+        // que necesita menos memoria en total:
+
+        unsigned largest = 1;
+
+        for (size_t material = 0; material < images.size (); ++material)
+        {
+            largest = std::max ({ largest, image_of (material).get_width (), image_of (material).get_height () });
+        }
+
+        unsigned smallest = 1;
+
+        while (smallest < std::min (largest, max_size)) smallest *= 2;
+
+        Plan best = plan_layers (smallest);
+
+        for (unsigned size = smallest * 2; size <= max_size; size *= 2)
+        {
+            Plan plan = plan_layers (size);
+
+            auto total = [] (const Plan & plan) { return double(plan.large.size () + plan.pages.size ()) * plan.size * plan.size; };
+
+            if (total (plan) < total (best)) best = std::move (plan);
+        }
+
+        const unsigned                size   = best.size;
+        const std::vector< size_t > & large  = best.large;
+        const auto                  & pages  = best.pages;
+        const auto                  & packed = best.packed;
+
+        const unsigned layer_count = unsigned(std::max< size_t > (large.size () + pages.size (), 1));
+        const size_t   layer_size  = size_t(size) * size;
+
+        auto layers = std::make_unique< Layers > (Layers{ size, size, layer_count, Color_Buffer(size, size * layer_count), {}, 0 });
+
+        layers->placements.assign (count, Placement{ 0, 0.f, 0.f, 1.f, 1.f });
+
+        std::fill_n (layers->image.colors (), layer_size * layer_count, Rgba8888{ 0xFF808080 });
+
+        for (size_t index = 0; index < large.size (); ++index)
+        {
+            resample (image_of (large[index]), size, size, layers->image.colors () + index * layer_size);
+
+            layers->placements[large[index]].layer = unsigned(index);
+            layers->used_texels += layer_size;
+        }
+
+        for (const auto & item : packed)
+        {
+            const unsigned layer_index = unsigned(large.size () + item.page);
+            Color_Buffer   layer       = layers->image.view (0, layer_index * size, size, size);
+
+            blit_padded (image_of (item.material), layer, item.rect.x, item.rect.y);
+
+            layers->placements[item.material] = Placement
+            {
+                layer_index,
+                float(item.rect.x    ) / float(size), float(item.rect.y     ) / float(size),
+                float(item.rect.width) / float(size), float(item.rect.height) / float(size)
+            };
+        }
+
+        for (const auto & page : pages) layers->used_texels += page.get_used_area ();
+
+        return layers;
+    }
+
+    void Material_Array::blit_padded (const Color_Buffer & source, Color_Buffer & layer, unsigned x, unsigned y)
+    {
+        const int width  = int(source.get_width  ());
+        const int height = int(source.get_height ());
+        const int margin = int(padding);
+
+        for (int row = -margin; row < height + margin; ++row)
+        {
+            const Rgba8888 * source_row      = source.row (unsigned((row % height + height) % height));
+            Rgba8888       * destination_row = layer .row (unsigned(int(y) + row)) + x;
+
+            for (int column = -margin; column < width + margin; ++column)
+            {
+                destination_row[column] = source_row[(column % width + width) % width];
+            }
+        }
+    }
+
+    void Material_Array::resample (const Color_Buffer & source, unsigned width, unsigned height, Rgba8888 * destination)
+    {
+        const unsigned source_width  = source.get_width  ();
+        const unsigned source_height = source.get_height ();
+
+        if (source_width == width && source_height == height)
+        {
+            for (unsigned y = 0; y < height; ++y)
+            {
+                std::copy_n (source.row (y), width, destination + size_t(y) * width);
+            }
+
+            return;
+        }
+
+        // Cada píxel de destino promedia varias muestras bilineales repartidas por la zona de la
+        // imagen original que cubre. Al ampliar basta una muestra; al reducir se toman tantas
+        // como píxeles originales caen dentro para que no aparezca aliasing:
+
+        const float    scale_x   = float(source_width ) / float(width );
+        const float    scale_y   = float(source_height) / float(height);
+        const unsigned samples_x = unsigned(std::ceil (scale_x));
+        const unsigned samples_y = unsigned(std::ceil (scale_y));
+        const float    weight    = 1.f / float(samples_x * samples_y);
+
+        auto texel = [&] (int x, int y) -> const Rgba8888 &
+        {
+            x = std::min (std::max (x, 0), int(source_width ) - 1);
+            y = std::min (std::max (y, 0), int(source_height) - 1);
+
+            return source.row (unsigned(y))[x];
+        };
+
+        for (unsigned y = 0; y < height; ++y)
+        {
+            for (unsigned x = 0; x < width; ++x)
+            {
+                float sum[4] = { 0.f, 0.f, 0.f, 0.f };
+
+                for (unsigned sy = 0; sy < samples_y; ++sy)
+                {
+                    for (unsigned sx = 0; sx < samples_x; ++sx)
+                    {
+                        const float u  = (float(x) + (float(sx) + 0.5f) / float(samples_x)) * scale_x - 0.5f;
+                        const float v  = (float(y) + (float(sy) + 0.5f) / float(samples_y)) * scale_y - 0.5f;
+                        const int   x0 = int(std::floor (u));
+                        const int   y0 = int(std::floor (v));
+                        const float fx = u - float(x0);
+                        const float fy = v - float(y0);
+
+                        const Rgba8888 & a = texel (x0,     y0    );
+                        const Rgba8888 & b = texel (x0 + 1, y0    );
+                        const Rgba8888 & c = texel (x0,     y0 + 1);
+                        const Rgba8888 & d = texel (x0 + 1, y0 + 1);
+
+                        for (unsigned k = 0; k < 4; ++k)
+                        {
+                            const float top    = a.components[k] + (b.components[k] - a.components[k]) * fx;
+                            const float bottom = c.components[k] + (d.components[k] - c.components[k]) * fx;
+
+                            sum[k] += top + (bottom - top) * fy;
+                        }
+                    }
+                }
+
+                Rgba8888 & output = destination[size_t(y) * width + x];
+
+                for (unsigned k = 0; k < 4; ++k)
+                {
+                    output.components[k] = uint8_t(std::min (sum[k] * weight + 0.5f, 255.f));
+                }
+            }
+        }
+    }
+
+    void Material_Array::upload (const Layers & layers)
+    {
+        if (!texture_id) glGenTextures (1, &texture_id);
+
+        glBindTexture (GL_TEXTURE_2D_ARRAY, texture_id);
+
+        glTexImage3D
+        (
+            GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8,
+            GLsizei(layers.width), GLsizei(layers.height), GLsizei(layers.count), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, layers.image.colors ()
+        );
+
+        glGenerateMipmap (GL_TEXTURE_2D_ARRAY);
+
+        // Las capas enteras se repiten con el wrap; en las compartidas lo hace el shader con fract:
+
+        glTexParameteri (GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,     GL_REPEAT);
+        glTexParameteri (GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,     GL_REPEAT);
+        glTexParameteri (GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+        glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+
+        // La capa y el rectángulo de cada material se leen en el vertex shader con texelFetch:
+
+        std::vector< float > texels(layers.placements.size () * 8, 0.f);
+
+        for (size_t material = 0, count = layers.placements.size (); material < count; ++material)
+        {
+            const Placement & placement = layers.placements[material];
+
+            texels[material * 4 + 0]           = placement.u;
+            texels[material * 4 + 1]           = placement.v;
+            texels[material * 4 + 2]           = placement.width;
+            texels[material * 4 + 3]           = placement.height;
+            texels[(count + material) * 4 + 0] = float(placement.layer);
+        }
+
+        if (!placements_texture_id) glGenTextures (1, &placements_texture_id);
+
+        glBindTexture   (GL_TEXTURE_2D, placements_texture_id);
+        glTexImage2D    (GL_TEXTURE_2D, 0, GL_RGBA32F, GLsizei(layers.placements.size ()), 2, 0, GL_RGBA, GL_FLOAT, texels.data ());
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,  0);
+        glBindTexture   (GL_TEXTURE_2D, 0);
+
+        layer_count = layers.count;
+        gpu_bytes   = size_t(layers.width) * layers.height * layers.count * sizeof(Rgba8888) * 4 / 3 + texels.size () * sizeof(float);
+    }
+
+    void Material_Array::bind () const
+    {
+        glActiveTexture (GL_TEXTURE1);
+        glBindTexture   (GL_TEXTURE_2D, placements_texture_id);
+        glActiveTexture (GL_TEXTURE0);
+        glBindTexture   (GL_TEXTURE_2D_ARRAY, texture_id);
+    }
+
+}
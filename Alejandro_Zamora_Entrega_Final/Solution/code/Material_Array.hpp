@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    // Texturas de los materiales de un modelo en un GL_TEXTURE_2D_ARRAY. Las capas de un array
+    // tienen que medir lo mismo: las imágenes grandes ocupan una capa entera (remuestreadas a
+    // su tamaño) y las pequeñas se empaquetan juntas en capas compartidas (ver Skyline_Packer).
+    // La malla guarda el material de cada vértice (Mesh::material_attribute) y los shaders leen
+    // de una pequeña textura su capa y su rectángulo dentro de ella, de modo que el modelo
+    // entero se dibuja con un único programa, una única textura y un único multi-draw.
+    //
+    // Los materiales se repiten sobre la superficie, así que las coordenadas no se reescriben
+    // en los vértices sino en el fragment shader: la parte fraccionaria de la UV se lleva al
+    // rectángulo del material. El margen alrededor de cada rectángulo repite la imagen para
+    // que el filtrado bilineal y los primeros mipmaps no mezclen materiales vecinos.
+
+    class Material_Array
+    {
+    public:
+
+        using Color_Buffer = Texture::Color_Buffer;
+
+        // Dónde ha quedado cada material: su capa y su rectángulo en coordenadas de textura:
+
+        struct Placement
+        {
+            unsigned layer;
+            float    u;
+            float    v;
+            float    width;
+            float    height;
+        };
+
+        // Imágenes de todas las capas ya empaquetadas, apiladas en vertical en el orden en que
+        // las espera glTexImage3D (width x height * count):
+
+        struct Layers
+        {
+            unsigned                 width;
+            unsigned                 height;
+            unsigned                 count;
+            Color_Buffer             image;
+            std::vector< Placement > placements;    // Uno por material
+            size_t                   used_texels;   // Texels de las imágenes, sin márgenes ni huecos
+        };
+
+        static constexpr unsigned max_layer_size = 2048;
+        static constexpr unsigned padding        = 8;
+
+    private:
+
+        static const std::string          vertex_shader_code;
+        static const std::string instanced_vertex_shader_code;
+        static const std::string        fragment_shader_code;
+
+        GLuint   texture_id;
+        GLuint   placements_texture_id;             // RGBA32F de count x 2: rectángulo y capa
+        GLuint   program_id;
+        GLuint   instanced_program_id;
+
+        unsigned layer_count;
+        size_t   gpu_bytes;
+
+    public:
+
+        // Crea el array con una única capa gris hasta que se llame a upload():
+
+        Material_Array();
+       ~Material_Array();
+
+        Material_Array(const Material_Array & ) = delete;
+        Material_Array & operator = (const Material_Array & ) = delete;
+
+    public:
+
+        // Carga una imagen por material. Las que no se pueden leer se sustituyen por una capa
+        // gris para que los índices de material sigan siendo válidos. No usa OpenGL, por lo que
+        // se puede llamar desde un hilo de trabajo.
+
+        static std::unique_ptr< Layers > load_layers (const std::vector< std::string > & texture_paths, unsigned max_size = max_layer_size);
+
+        // Reparte las imágenes en capas. Las que son nullptr reciben un rectángulo gris:
+
+        static std::unique_ptr< Layers > pack_layers (const std::vector< std::unique_ptr< Color_Buffer > > & images, unsigned max_size = max_layer_size);
+
+        void upload (const Layers & layers);
+
+        // Enlaza el array a la unidad 0 y los rectángulos de los materiales a la unidad 1:
+
+        void bind () const;
+
+        GLuint   get_texture_id           () const { return texture_id;           }
+        GLuint   get_program_id           () const { return program_id;           }
+        GLuint   get_instanced_program_id () const { return instanced_program_id; }
+        unsigned get_layer_count          () const { return layer_count;          }
+        size_t   get_gpu_bytes            () const { return gpu_bytes;            }
+
+    private:
+
+        static void resample (const Color_Buffer & source, unsigned width, unsigned height, Rgba8888 * destination);
+
+        // Copia source en el rectángulo de la capa y rellena el margen con la imagen repetida:
+
+        static void blit_padded (const Color_Buffer & source, Color_Buffer & layer, unsigned x, unsigned y);
+
+    };
+
+}
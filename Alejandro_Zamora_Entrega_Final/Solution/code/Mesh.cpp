@@ -1,11 +1,172 @@
 ﻿#include "Mesh.hpp"
+#include "Glb_File.hpp"
+#include "Mesh_Codec.hpp"
+#include "Mesh_Simplifier.hpp"
+#include "Obj_File.hpp"
+#include "Progressive_Mesh.hpp"
 
-Mesh::Mesh(const std::string& path)
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+
+namespace
+{
+    // Hilos para analizar archivos .obj y generar bases tangentes durante la importación
+    udit::Thread_Pool& import_pool()
+    {
+        static udit::Thread_Pool pool;
+        return pool;
+    }
+}
+
+Mesh::Mesh() : vbo_ids{}, vao_id(0), bounding_center(0.f), bounding_radius(0.f), uv_density(0.f), lod_pixel_error(1.f), gpu_bytes(0), resident_levels(max_lod_count), streamed_stream(0), streamed_offset(0)
+{
+}
+
+Mesh::Mesh(const std::string& path) : Mesh()
 {
     load_mesh(path);
 }
 
+bool Mesh::is_cooked(const std::string& path)
+{
+    return path.size() >= 6 && path.compare(path.size() - 6, 6, ".umesh") == 0;
+}
+
 void Mesh::load_mesh(const std::string& mesh_file_path)
+{
+    // Las mallas comprimidas se decodifican directamente en los buffers de la GPU, y los .glb
+    // se suben desde el archivo proyectado en memoria. Si el .glb usa algo que el lector
+    // nativo no soporta se recurre a Assimp
+    if (is_cooked(mesh_file_path))
+    {
+        load_cooked(mesh_file_path);
+    }
+    else
+    if (udit::Progressive_Mesh::is_progressive(mesh_file_path))
+    {
+        load_progressive(mesh_file_path);
+    }
+    else
+    if (!udit::Glb_File::is_glb(mesh_file_path) || !load_glb(mesh_file_path))
+    {
+        Data data;
+
+        if (import(mesh_file_path, data))
+        {
+            upload(data);
+        }
+    }
+}
+
+bool Mesh::import(const std::string& mesh_file_path, Data& data)
+{
+    // No toca OpenGL, por lo que se puede llamar desde un hilo de trabajo
+    if (is_cooked(mesh_file_path))
+    {
+        udit::Mesh_Codec::Encoded_Mesh encoded;
+
+        if (!udit::Mesh_Codec::read(mesh_file_path, encoded) || !udit::Mesh_Codec::decode(encoded, data))
+        {
+            std::cerr << "Error loading mesh: " << mesh_file_path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (udit::Progressive_Mesh::is_progressive(mesh_file_path))
+    {
+        if (!udit::Progressive_Mesh::read(mesh_file_path, data))
+        {
+            std::cerr << "Error loading mesh: " << mesh_file_path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (udit::Glb_File::is_glb(mesh_file_path))
+    {
+        udit::Glb_File glb;
+
+        if (glb.open(mesh_file_path))
+        {
+            read_glb(glb, data);
+
+            // Las bases tangentes del archivo se respetan; sólo se generan si falta alguna
+            const auto& primitives = glb.get_primitives();
+
+            if (std::all_of(primitives.begin(), primitives.end(), [](const udit::Glb_File::Primitive& primitive) { return primitive.tangents.data != nullptr; }))
+                data.tangent_frames.resize(data.positions.size());
+            else
+                build_tangent_frames(data);
+
+            for (size_t p = 0; p < primitives.size(); ++p)
+                if (primitives[p].tangents.data && primitives[p].positions.count > 0)
+                    udit::Glb_File::read_tangent_frames(primitives[p], &data.tangent_frames[size_t(data.submeshes[p].base_vertex)]);
+
+            return true;
+        }
+    }
+
+    // Los .obj se analizan en paralelo desde el archivo proyectado en memoria. Si el lector
+    // nativo falla se intenta de nuevo con Assimp
+    if (udit::Obj_File::is_obj(mesh_file_path))
+    {
+        if (udit::Obj_File::read(mesh_file_path, data, import_pool()))
+        {
+            build_lods(mesh_file_path, data);
+            build_tangent_frames(data);
+            return true;
+        }
+    }
+
+    if (!import_with_assimp(mesh_file_path, data)) return false;
+
+    build_lods(mesh_file_path, data);
+    build_tangent_frames(data);
+
+    return true;
+}
+
+void Mesh::read_glb(const udit::Glb_File& glb, Data& data)
+{
+    data = Data{};
+    data.bounding_center = glm::vec3(0.f);
+    data.bounding_radius = 0.f;
+
+    glm::vec3 min_corner(+INFINITY), max_corner(-INFINITY);
+
+    for (const auto& primitive : glb.get_primitives())
+    {
+        const size_t first_vertex = data.positions.size();
+        const size_t first_index  = data.indices.size();
+        const size_t vertex_count = primitive.positions.count;
+
+        data.positions.resize(first_vertex + vertex_count);
+        data.uvs      .resize(first_vertex + vertex_count, glm::vec2(0.f));
+        data.indices  .resize(first_index  + primitive.get_index_count());
+
+        udit::Glb_File::read_positions(primitive.positions, &data.positions[first_vertex]);
+        if (primitive.uvs.data) udit::Glb_File::read_uvs(primitive.uvs, &data.uvs[first_vertex]);
+        udit::Glb_File::read_indices(primitive, &data.indices[first_index]);
+
+        SubMesh sm{ GLint(first_vertex), GLsizei(vertex_count), Lod_Chain{}, std::min(primitive.material, max_material_count - 1) };
+        sm.lods.push_back({ GLuint(first_index), GLsizei(primitive.get_index_count()), 0.f });
+        data.submeshes.push_back(sm);
+
+        min_corner = glm::min(min_corner, primitive.min_corner);
+        max_corner = glm::max(max_corner, primitive.max_corner);
+    }
+
+    data.bounding_center = (min_corner + max_corner) * 0.5f;
+    data.bounding_radius = glm::length(max_corner - min_corner) * 0.5f;
+    data.material_textures = glb.get_material_textures();
+}
+
+bool Mesh::import_with_assimp(const std::string& mesh_file_path, Data& data)
 {
     Assimp::Importer importer;
 
@@ -14,11 +175,58 @@ void Mesh::load_mesh(const std::string& mesh_file_path)
     if (!scene || scene->mNumMeshes == 0)
     {
         std::cerr << "Error loading mesh: " << mesh_file_path << std::endl;
-        return;
+        return false;
     }
 
-    // Limpiar submeshes anteriores si existían
-    submeshes.clear();
+    // Todas las submallas se guardan en los mismos buffers. Cada submalla recuerda dónde
+    // empiezan sus vértices y el rango de índices de cada uno de sus LODs. Los buffers se
+    // dimensionan una sola vez con los totales de la escena y se escriben directamente, sin
+    // memoria temporal por submalla
+    size_t total_vertices = 0;
+    size_t total_indices  = 0;
+    bool   has_bones      = false;
+
+    for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+    {
+        const aiMesh* mesh = scene->mMeshes[m];
+
+        total_vertices += mesh->mNumVertices;
+        has_bones      |= mesh->HasBones();
+
+        for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+            if (mesh->mFaces[i].mNumIndices == 3) total_indices += 3;
+    }
+
+    // Mesh sólo guarda la pose de bind; las mallas animadas se cargan con udit::Skinned_Mesh
+    if (has_bones)
+        std::cout << "  " << mesh_file_path << " has a skeleton, load it with Skinned_Mesh to animate it" << std::endl;
+
+    data.positions.resize(total_vertices);
+    data.uvs      .resize(total_vertices);
+    data.indices  .resize(total_indices);
+    data.submeshes.clear();
+    data.submeshes.reserve(scene->mNumMeshes);
+
+    // Textura difusa de cada material, relativa a la carpeta del modelo. Las texturas
+    // embebidas ("*0", "*1"...) no se extraen y el material se queda sin textura
+    const std::string directory = mesh_file_path.substr(0, mesh_file_path.find_last_of("/\\") + 1);
+
+    data.material_textures.assign(std::min(scene->mNumMaterials, unsigned(max_material_count)), std::string());
+
+    for (unsigned m = 0; m < data.material_textures.size(); ++m)
+    {
+        aiString texture;
+
+        if (scene->mMaterials[m]->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == AI_SUCCESS && texture.C_Str()[0] != '*')
+            data.material_textures[m] = directory + texture.C_Str();
+    }
+
+    glm::vec3* positions = data.positions.data();
+    glm::vec2* uvs       = data.uvs.data();
+    GLuint*    indices   = data.indices.data();
+
+    size_t first_vertex = 0;
+    size_t first_index  = 0;
 
     // Recorrer todas las mallas del modelo
     for (unsigned m = 0; m < scene->mNumMeshes; ++m)
@@ -27,102 +235,876 @@ void Mesh::load_mesh(const std::string& mesh_file_path)
         const size_t vertex_count = mesh->mNumVertices;
 
         // 1️ Copiar posiciones
-        std::vector<glm::vec3> positions(vertex_count);
         for (size_t i = 0; i < vertex_count; ++i)
         {
-            positions[i] = glm::vec3(
+            positions[first_vertex + i] = glm::vec3(
                 mesh->mVertices[i].x,
                 mesh->mVertices[i].y,
                 mesh->mVertices[i].z
             );
         }
 
-        SubMesh sm;
-
-        // 2️ Colores por defecto (gris)
-        std::vector<glm::vec2> uvs(vertex_count, glm::vec2(0.f));
+        // 2️ Coordenadas de textura
         if (mesh->mTextureCoords[0])
         {
             for (size_t i = 0; i < vertex_count; ++i)
-                uvs[i] = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+                uvs[first_vertex + i] = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
         }
-        
-        if (!mesh->mTextureCoords[0])
+        else
         {
+            std::fill(uvs + first_vertex, uvs + first_vertex + vertex_count, glm::vec2(0.f));
             std::cout << "¡Advertencia! UVs no encontradas en mesh " << mesh_file_path << std::endl;
         }
 
-
-        // VBO de UVs
-        glBindBuffer(GL_ARRAY_BUFFER, sm.vbo[COLORS_VBO]); // renombrar a TEXCOORDS_VBO
-        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
-
-
         // 3️ Índices
-        GLsizei index_count = mesh->mNumFaces * 3;
-        std::vector<GLuint> indices;
-        indices.reserve(index_count);
+        GLuint* mesh_indices = indices + first_index;
 
         for (unsigned i = 0; i < mesh->mNumFaces; ++i)
         {
             const aiFace& face = mesh->mFaces[i];
-            assert(face.mNumIndices == 3);
 
-            indices.push_back(face.mIndices[0]);
-            indices.push_back(face.mIndices[1]);
-            indices.push_back(face.mIndices[2]);
+            // SortByPType deja puntos y líneas en sus propias mallas, que no se dibujan como triángulos
+            if (face.mNumIndices != 3) continue;
+
+            *mesh_indices++ = face.mIndices[0];
+            *mesh_indices++ = face.mIndices[1];
+            *mesh_indices++ = face.mIndices[2];
         }
 
-        // 4️ Crear VAO y VBOs
-        sm.index_count = index_count;
-        glGenVertexArrays(1, &sm.vao);
-        glBindVertexArray(sm.vao);
+        const size_t index_count = size_t(mesh_indices - (indices + first_index));
 
-        glGenBuffers(VBO_COUNT, sm.vbo);
+        SubMesh sm;
+        sm.base_vertex  = GLint(first_vertex);
+        sm.vertex_count = GLsizei(vertex_count);
+        sm.lods.push_back({ GLuint(first_index), GLsizei(index_count), 0.f });
+        sm.material     = std::min(mesh->mMaterialIndex, max_material_count - 1);
 
-        // Posiciones
-        glBindBuffer(GL_ARRAY_BUFFER, sm.vbo[COORDINATES_VBO]);
-        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        // Guardar submesh
+        data.submeshes.push_back(sm);
 
-        // Colores
-        glBindBuffer(GL_ARRAY_BUFFER, sm.vbo[COLORS_VBO]); // renombrar
-        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        first_vertex += vertex_count;
+        first_index  += index_count;
+    }
 
+    return true;
+}
 
-        // Índices
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sm.vbo[INDICES_EBO]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+void Mesh::build_lods(const std::string& mesh_file_path, Data& data)
+{
+    // Cada submalla llega con un único LOD. Se genera su cadena de LODs por simplificación con
+    // cuádricas de error y se reconstruye el buffer de índices con todos los niveles. El buffer
+    // se reserva con la cota de cada cadena, así que no se realoja. La memoria temporal del
+    // simplificador sale de una única arena dimensionada para la submalla más grande
+    std::vector<GLuint> indices;
 
-        // Limpiar VAO
-        glBindVertexArray(0);
+    size_t index_capacity = 0;
+    size_t arena_size     = 0;
 
-        // Guardar submesh
+    for (const auto& sm : data.submeshes)
+    {
+        index_capacity += udit::Mesh_Simplifier::get_output_size(size_t(sm.lods.front().index_count), max_lod_count);
+        arena_size      = std::max(arena_size, udit::Mesh_Simplifier::get_arena_size(size_t(sm.vertex_count), size_t(sm.lods.front().index_count)));
+    }
+
+    indices.reserve(index_capacity);
+
+    udit::Linear_Arena arena(arena_size);
+
+    std::vector<udit::Mesh_Simplifier::Lod> lods;
+    lods.reserve(max_lod_count);
+
+    for (auto& sm : data.submeshes)
+    {
+        const Lod source = sm.lods.front();
+
+        udit::Mesh_Simplifier::build_lod_chain
+        (
+            data.positions.data() + sm.base_vertex,
+            data.uvs.data() + sm.base_vertex,
+            size_t(sm.vertex_count),
+            data.indices.data() + source.index_offset,
+            size_t(source.index_count),
+            max_lod_count,
+            arena,
+            indices,
+            lods
+        );
+
+        sm.lods.clear();
+
+        for (const auto& lod : lods)
+            sm.lods.push_back({ GLuint(lod.index_offset), GLsizei(lod.index_count), lod.error });
+    }
+
+    // Si todo ha ido bien la arena no ha necesitado más bloques que el inicial
+    if (arena.get_allocation_count() > 1)
+        std::cout << "  LOD arena grew to " << arena.get_capacity() / 1024 << " KB" << std::endl;
+
+    data.indices.swap(indices);
+
+    const std::vector<glm::vec3>& positions = data.positions;
+
+    // Esfera envolvente para estimar el tamaño proyectado en pantalla
+    glm::vec3 min_corner(+INFINITY), max_corner(-INFINITY);
+    for (const auto& p : positions)
+    {
+        min_corner = glm::min(min_corner, p);
+        max_corner = glm::max(max_corner, p);
+    }
+
+    data.bounding_center = (min_corner + max_corner) * 0.5f;
+    data.bounding_radius = 0.f;
+    for (const auto& p : positions)
+        data.bounding_radius = std::max(data.bounding_radius, glm::length(p - data.bounding_center));
+
+    std::cout << "Loaded " << data.submeshes.size() << " submeshes from " << mesh_file_path << std::endl;
+
+    // Informe de triángulos frente a error por LOD
+    for (size_t s = 0; s < data.submeshes.size(); ++s)
+    {
+        for (size_t l = 0; l < data.submeshes[s].lods.size(); ++l)
+        {
+            const Lod& lod = data.submeshes[s].lods[l];
+
+            std::cout << "  submesh " << s << " LOD " << l
+                      << ": " << std::setw(8) << lod.index_count / 3 << " triangles"
+                      << ", error " << lod.error << std::endl;
+        }
+    }
+}
+
+void Mesh::build_tangent_frames(Data& data)
+{
+    // Las bases se calculan con los triángulos del LOD 0 de cada submalla. Los demás LODs
+    // comparten los mismos vértices y por tanto las mismas bases
+    std::vector<GLuint> corners;
+
+    size_t corner_count = 0;
+    for (const auto& sm : data.submeshes) corner_count += size_t(sm.lods.front().index_count);
+
+    corners.reserve(corner_count);
+
+    for (const auto& sm : data.submeshes)
+    {
+        const Lod& lod = sm.lods.front();
+
+        for (GLsizei i = 0; i < lod.index_count; ++i)
+            corners.push_back(GLuint(sm.base_vertex) + data.indices[lod.index_offset + i]);
+    }
+
+    data.tangent_frames.resize(data.positions.size());
+
+    udit::Tangent_Space::generate(data.positions.data(), data.uvs.data(), data.positions.size(), corners.data(), corners.size(), import_pool(), data.tangent_frames.data());
+}
+
+void Mesh::upload(const Data& data)
+{
+    set_layout(data);
+
+    create_buffers(data.positions.size(), data.indices.size(), data.positions.data(), data.uvs.data(), data.indices.data(),
+                   data.tangent_frames.empty() ? nullptr : data.tangent_frames.data());
+
+    upload_materials(data.positions.size());
+}
+
+void Mesh::begin_upload(std::shared_ptr<const Data> data)
+{
+    set_layout(*data);
+
+    // Se reserva el espacio sin datos y cada llamada a continue_upload copia una banda. Hasta
+    // que se copia la última la malla no se dibuja
+    create_buffers(data->positions.size(), data->indices.size(), nullptr, nullptr, nullptr);
+
+    if (!data->tangent_frames.empty())
+        upload_tangent_frames(data->positions.size(), nullptr);
+
+    upload_materials(data->positions.size());
+
+    resident_levels = 0;
+
+    streamed_data   = std::move(data);
+    streamed_stream = 0;
+    streamed_offset = 0;
+}
+
+Mesh::Upload_Status Mesh::continue_upload(udit::Upload_Ring& ring)
+{
+    if (!streamed_data) return UPLOAD_DONE;
+
+    struct Stream { GLuint buffer; const void* source; size_t size; };
+
+    const Data&  data      = *streamed_data;
+    const Stream streams[] =
+    {
+        { vbo_ids[COORDINATES_VBO],    data.positions.data(),      data.positions.size()      * sizeof(glm::vec3) },
+        { vbo_ids[TEXTURE_UVS_VBO],    data.uvs.data(),            data.uvs.size()            * sizeof(glm::vec2) },
+        { vbo_ids[TANGENT_FRAMES_VBO], data.tangent_frames.data(), data.tangent_frames.size() * sizeof(udit::Tangent_Frame) },
+        { vbo_ids[INDICES_EBO],        data.indices.data(),        data.indices.size()        * sizeof(GLuint) },
+    };
+
+    const size_t stream_count = sizeof(streams) / sizeof(streams[0]);
+
+    while (streamed_stream < stream_count && streamed_offset >= streams[streamed_stream].size)
+    {
+        ++streamed_stream;
+        streamed_offset = 0;
+    }
+
+    if (streamed_stream < stream_count)
+    {
+        const Stream& stream = streams[streamed_stream];
+
+        // Como con las texturas, la banda no ocupa más de una parte del anillo
+        const size_t bytes = std::min(std::min(size_t(upload_band_bytes), ring.get_capacity() / 4), stream.size - streamed_offset);
+
+        size_t   offset;
+        uint8_t* destination = ring.map(bytes, offset);
+
+        if (!destination) return UPLOAD_STALLED;
+
+        std::memcpy(destination, static_cast<const uint8_t*>(stream.source) + streamed_offset, bytes);
+
+        ring.unmap();
+
+        // La copia del PBO al búfer de la malla la hace la GPU. Se usa GL_COPY_WRITE_BUFFER para
+        // no tocar el element buffer enlazado al VAO
+        glBindBuffer(GL_COPY_WRITE_BUFFER, stream.buffer);
+        glCopyBufferSubData(GL_PIXEL_UNPACK_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(offset), GLintptr(streamed_offset), GLsizeiptr(bytes));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        streamed_offset += bytes;
+
+        if (streamed_offset < stream.size || streamed_stream + 1 < stream_count) return UPLOAD_PENDING;
+    }
+
+    resident_levels = max_lod_count;
+
+    streamed_data.reset();
+
+    return UPLOAD_DONE;
+}
+
+void Mesh::set_layout(const Data& data)
+{
+    submeshes         = data.submeshes;
+    material_textures = data.material_textures;
+    bounding_center   = data.bounding_center;
+    bounding_radius   = data.bounding_radius;
+
+    // Densidad media de UV: raíz del cociente entre el área de los triángulos del LOD 0 en la
+    // textura y en el objeto
+    double uv_area    = 0.0;
+    double world_area = 0.0;
+
+    for (const auto& sm : data.submeshes)
+    {
+        const Lod& lod = sm.lods.front();
+
+        for (GLsizei i = 0; i + 2 < lod.index_count && !data.uvs.empty(); i += 3)
+        {
+            const GLuint a = GLuint(sm.base_vertex) + data.indices[lod.index_offset + i    ];
+            const GLuint b = GLuint(sm.base_vertex) + data.indices[lod.index_offset + i + 1];
+            const GLuint c = GLuint(sm.base_vertex) + data.indices[lod.index_offset + i + 2];
+
+            const glm::vec2 uv_ab = data.uvs[b] - data.uvs[a];
+            const glm::vec2 uv_ac = data.uvs[c] - data.uvs[a];
+
+            uv_area    += std::abs(uv_ab.x * uv_ac.y - uv_ab.y * uv_ac.x);
+            world_area += glm::length(glm::cross(data.positions[b] - data.positions[a], data.positions[c] - data.positions[a]));
+        }
+    }
+
+    uv_density = world_area > 0.0 ? float(std::sqrt(uv_area / world_area)) : 0.f;
+}
+
+void Mesh::create_buffers(size_t vertex_count, size_t index_count, const void* positions, const void* uvs, const void* indices, const void* tangent_frames)
+{
+    if (vao_id)
+    {
+        glDeleteVertexArrays(1, &vao_id);
+        glDeleteBuffers(VBO_COUNT, vbo_ids);
+    }
+
+    // 5️ Crear VAO y VBOs compartidos por todas las submallas y LODs
+    glGenVertexArrays(1, &vao_id);
+    glBindVertexArray(vao_id);
+
+    glGenBuffers(VBO_COUNT, vbo_ids);
+
+    gpu_bytes = vertex_count * (sizeof(glm::vec3) + sizeof(glm::vec2)) + index_count * sizeof(GLuint);
+
+    resident_levels = max_lod_count;
+
+    // Posiciones
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[COORDINATES_VBO]);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(glm::vec3), positions, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+    // Coordenadas de textura
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXTURE_UVS_VBO]);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(glm::vec2), uvs, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+
+    // Índices de todos los LODs
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_ids[INDICES_EBO]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+
+    // Limpiar VAO
+    glBindVertexArray(0);
+
+    // Mientras no haya bases tangentes el atributo queda desactivado y el shader lee este valor
+    // constante, que no puede salir de pack() y marca la malla como sin normales
+    glVertexAttribI4i(tangent_frame_attribute, 0, 0, -32768, 0);
+
+    // Igualmente, sin búfer de materiales todos los vértices usan la capa 0
+    glVertexAttribI4ui(material_attribute, 0, 0, 0, 0);
+
+    if (tangent_frames)
+        upload_tangent_frames(vertex_count, static_cast<const udit::Tangent_Frame*>(tangent_frames));
+}
+
+void Mesh::upload_tangent_frames(size_t vertex_count, const udit::Tangent_Frame* tangent_frames)
+{
+    glBindVertexArray(vao_id);
+
+    // Normal y tangente octaédricas: cuatro enteros de 16 bits que el shader decodifica
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TANGENT_FRAMES_VBO]);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(udit::Tangent_Frame), tangent_frames, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(tangent_frame_attribute);
+    glVertexAttribIPointer(tangent_frame_attribute, 4, GL_SHORT, sizeof(udit::Tangent_Frame), (void*)0);
+
+    glBindVertexArray(0);
+
+    gpu_bytes += vertex_count * sizeof(udit::Tangent_Frame);
+}
+
+void Mesh::upload_materials(size_t vertex_count)
+{
+    // Los vértices de cada submalla son contiguos y no se comparten, así que el material se
+    // puede guardar por vértice. Así el shader sabe qué capa leer sin cambiar de estado entre
+    // submallas, lo que permite dibujarlas todas con un único multi-draw
+    bool single_material = std::all_of(submeshes.begin(), submeshes.end(), [](const SubMesh& sm) { return sm.material == 0; });
+
+    if (single_material) return;
+
+    std::vector<GLubyte> materials(vertex_count, 0);
+
+    for (const auto& sm : submeshes)
+    {
+        size_t first = std::min(size_t(sm.base_vertex), vertex_count);
+        size_t last  = std::min(first + size_t(sm.vertex_count), vertex_count);
+
+        std::fill(materials.begin() + first, materials.begin() + last, GLubyte(sm.material));
+    }
+
+    glBindVertexArray(vao_id);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[MATERIALS_VBO]);
+    glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(GLubyte), materials.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(material_attribute);
+    glVertexAttribIPointer(material_attribute, 1, GL_UNSIGNED_BYTE, sizeof(GLubyte), (void*)0);
+
+    glBindVertexArray(0);
+
+    gpu_bytes += vertex_count * sizeof(GLubyte);
+}
+
+bool Mesh::load_cooked(const std::string& cooked_path)
+{
+    udit::Mesh_Codec::Encoded_Mesh encoded;
+
+    if (!udit::Mesh_Codec::read(cooked_path, encoded))
+    {
+        std::cerr << "Error loading mesh: " << cooked_path << std::endl;
+        return false;
+    }
+
+    // Se reserva el espacio en la GPU sin datos y el decodificador escribe los vértices
+    // directamente en los buffers mapeados, sin pasar por vectores intermedios
+    create_buffers(encoded.vertex_count, encoded.index_count, nullptr, nullptr, nullptr);
+    upload_tangent_frames(encoded.vertex_count, nullptr);
+
+    struct Target { GLenum binding; GLuint buffer; udit::Mesh_Codec::Stream stream; size_t size; };
+
+    const Target targets[] =
+    {
+        { GL_ARRAY_BUFFER,         vbo_ids[COORDINATES_VBO],    udit::Mesh_Codec::POSITIONS_STREAM,      encoded.vertex_count * sizeof(glm::vec3) },
+        { GL_ARRAY_BUFFER,         vbo_ids[TEXTURE_UVS_VBO],    udit::Mesh_Codec::TEXTURE_UVS_STREAM,    encoded.vertex_count * sizeof(glm::vec2) },
+        { GL_ARRAY_BUFFER,         vbo_ids[TANGENT_FRAMES_VBO], udit::Mesh_Codec::TANGENT_FRAMES_STREAM, encoded.vertex_count * sizeof(udit::Tangent_Frame) },
+    };
+
+    std::vector<uint8_t> scratch;
+    bool                 decoded = true;
+
+    // El element buffer forma parte del estado del VAO, por lo que se mapea con él activo
+    glBindVertexArray(vao_id);
+
+    for (const auto& target : targets)
+    {
+        if (target.size == 0) continue;
+
+        glBindBuffer(target.binding, target.buffer);
+
+        void* destination = glMapBufferRange(target.binding, 0, target.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        decoded = decoded && destination && udit::Mesh_Codec::decode_stream(encoded, target.stream, destination, scratch);
+
+        glUnmapBuffer(target.binding);
+    }
+
+    // Los índices se decodifican en memoria de CPU para comprobar que no se salen de su
+    // submalla antes de subirlos, ya que un buffer mapeado sólo para escritura no se puede leer
+    std::vector<GLuint> indices(encoded.index_count);
+
+    decoded = decoded && udit::Mesh_Codec::decode_stream(encoded, udit::Mesh_Codec::INDICES_STREAM, indices.data(), scratch)
+                      && udit::Mesh_Codec::check_indices(encoded, indices.data());
+
+    if (decoded && !indices.empty())
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_ids[INDICES_EBO]);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
+    }
+
+    glBindVertexArray(0);
+
+    if (!decoded)
+    {
+        std::cerr << "Error decoding mesh: " << cooked_path << std::endl;
+        glDeleteVertexArrays(1, &vao_id);
+        glDeleteBuffers(VBO_COUNT, vbo_ids);
+        vao_id = 0;
+        return false;
+    }
+
+    submeshes         = encoded.submeshes;
+    material_textures = encoded.material_textures;
+    bounding_center   = encoded.bounding_center;
+    bounding_radius   = encoded.bounding_radius;
+
+    upload_materials(encoded.vertex_count);
+
+    std::cout << "Loaded " << submeshes.size() << " submeshes from " << cooked_path << std::endl;
+
+    return true;
+}
+
+bool Mesh::load_glb(const std::string& glb_path)
+{
+    udit::Glb_File glb;
+
+    if (!glb.open(glb_path)) return false;
+
+    size_t vertex_count = 0;
+    size_t index_count  = 0;
+
+    for (const auto& primitive : glb.get_primitives())
+    {
+        vertex_count += primitive.positions.count;
+        index_count  += primitive.get_index_count();
+    }
+
+    create_buffers(vertex_count, index_count, nullptr, nullptr, nullptr);
+
+    submeshes.clear();
+
+    glm::vec3 min_corner(+INFINITY), max_corner(-INFINITY);
+
+    // Cada rango se sube tal cual desde el archivo proyectado si ya tiene el formato del
+    // buffer. Si no (otro tipo de componente o datos entrelazados) se convierte escribiendo
+    // directamente en el rango mapeado del buffer
+    auto write_range = [](GLenum binding, GLuint buffer, size_t offset, size_t size, const void* packed_source, const auto& convert)
+    {
+        if (size == 0) return;
+
+        glBindBuffer(binding, buffer);
+
+        if (packed_source)
+        {
+            glBufferSubData(binding, offset, size, packed_source);
+        }
+        else
+        {
+            void* destination = glMapBufferRange(binding, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (destination) convert(destination);
+            glUnmapBuffer(binding);
+        }
+    };
+
+    using udit::Glb_File;
+
+    size_t first_vertex = 0;
+    size_t first_index  = 0;
+
+    // Las bases tangentes que trae el archivo sólo se empaquetan. Las que faltan se generan por
+    // primitiva leyendo de la proyección del archivo; sólo los accessors que no tienen ya el
+    // formato que espera el generador se convierten en estos vectores, que se reutilizan. Las
+    // UV se convierten siempre porque hay que invertir V (ver Glb_File::read_uvs), y la misma
+    // copia se sube y se usa para generar las bases
+    std::vector<glm::vec3> converted_positions;
+    std::vector<glm::vec2> converted_uvs;
+    std::vector<GLuint>    converted_corners;
+
+    upload_tangent_frames(vertex_count, nullptr);
+
+    glBindVertexArray(vao_id);
+
+    for (const auto& primitive : glb.get_primitives())
+    {
+        const size_t primitive_vertices = primitive.positions.count;
+        const size_t primitive_indices  = primitive.get_index_count();
+
+        write_range(GL_ARRAY_BUFFER, vbo_ids[COORDINATES_VBO], first_vertex * sizeof(glm::vec3), primitive_vertices * sizeof(glm::vec3),
+            Glb_File::is_packed(primitive.positions, GL_FLOAT, 3) ? primitive.positions.data : nullptr,
+            [&](void* destination) { Glb_File::read_positions(primitive.positions, static_cast<glm::vec3*>(destination)); });
+
+        converted_uvs.assign(primitive_vertices, glm::vec2(0.f));
+        if (primitive.uvs.data) Glb_File::read_uvs(primitive.uvs, converted_uvs.data());
+
+        write_range(GL_ARRAY_BUFFER, vbo_ids[TEXTURE_UVS_VBO], first_vertex * sizeof(glm::vec2), primitive_vertices * sizeof(glm::vec2),
+            converted_uvs.data(), [](void*) {});
+
+        write_range(GL_ELEMENT_ARRAY_BUFFER, vbo_ids[INDICES_EBO], first_index * sizeof(GLuint), primitive_indices * sizeof(GLuint),
+            Glb_File::is_packed(primitive.indices, GL_UNSIGNED_INT, 1) ? primitive.indices.data : nullptr,
+            [&](void* destination) { Glb_File::read_indices(primitive, static_cast<GLuint*>(destination)); });
+
+        write_range(GL_ARRAY_BUFFER, vbo_ids[TANGENT_FRAMES_VBO], first_vertex * sizeof(udit::Tangent_Frame), primitive_vertices * sizeof(udit::Tangent_Frame), nullptr,
+            [&](void* destination)
+            {
+                udit::Tangent_Frame* frames = static_cast<udit::Tangent_Frame*>(destination);
+
+                if (primitive.tangents.data)
+                {
+                    Glb_File::read_tangent_frames(primitive, frames);
+                    return;
+                }
+
+                const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(primitive.positions.data);
+                const GLuint*    corners   = reinterpret_cast<const GLuint*   >(primitive.indices.data);
+
+                if (!Glb_File::is_packed(primitive.positions, GL_FLOAT, 3))
+                {
+                    converted_positions.resize(primitive_vertices);
+                    Glb_File::read_positions(primitive.positions, converted_positions.data());
+                    positions = converted_positions.data();
+                }
+
+                if (!corners || !Glb_File::is_packed(primitive.indices, GL_UNSIGNED_INT, 1))
+                {
+                    converted_corners.resize(primitive_indices);
+                    Glb_File::read_indices(primitive, converted_corners.data());
+                    corners = converted_corners.data();
+                }
+
+                udit::Tangent_Space::generate(positions, converted_uvs.data(), primitive_vertices, corners, primitive_indices, import_pool(), frames);
+            });
+
+        SubMesh sm{ GLint(first_vertex), GLsizei(primitive_vertices), Lod_Chain{}, std::min(primitive.material, max_material_count - 1) };
+        sm.lods.push_back({ GLuint(first_index), GLsizei(primitive_indices), 0.f });
         submeshes.push_back(sm);
+
+        min_corner = glm::min(min_corner, primitive.min_corner);
+        max_corner = glm::max(max_corner, primitive.max_corner);
+
+        first_vertex += primitive_vertices;
+        first_index  += primitive_indices;
     }
 
-    std::cout << "Loaded " << submeshes.size() << " submeshes from " << mesh_file_path << std::endl;
+    glBindVertexArray(0);
+
+    material_textures = glb.get_material_textures();
+    upload_materials(vertex_count);
+
+    bounding_center = (min_corner + max_corner) * 0.5f;
+    bounding_radius = glm::length(max_corner - min_corner) * 0.5f;
+
+    std::cout << "Loaded " << submeshes.size() << " submeshes from " << glb_path << std::endl;
+
+    return true;
 }
 
-void Mesh::render()
+void Mesh::begin_streaming(const std::vector<SubMesh>& streamed_submeshes, const std::vector<std::string>& streamed_material_textures, size_t vertex_count, size_t index_count, const glm::vec3& center, float radius)
 {
-    // Renderizar todos los submeshes
+    // Se reserva el espacio completo sin datos. Hasta que llegue el primer bloque la malla no
+    // se dibuja
+    create_buffers(vertex_count, index_count, nullptr, nullptr, nullptr);
+    upload_tangent_frames(vertex_count, nullptr);
+
+    submeshes         = streamed_submeshes;
+    material_textures = streamed_material_textures;
+    bounding_center   = center;
+    bounding_radius   = radius;
+    uv_density        = 0.f;
+    resident_levels   = 0;
+
+    // Los materiales dependen sólo de las submallas, así que se suben completos desde el principio
+    upload_materials(vertex_count);
+}
+
+void Mesh::upload_chunk(const Stream_Chunk& chunk)
+{
+    if (!vao_id) return;
+
+    // Los vértices nuevos de cada submalla ocupan un rango contiguo de su vertex buffer
+    size_t source = 0;
+
+    for (const auto& range : chunk.ranges)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[COORDINATES_VBO]);
+        glBufferSubData(GL_ARRAY_BUFFER, range.first_vertex * sizeof(glm::vec3), range.vertex_count * sizeof(glm::vec3), &chunk.positions[source]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TEXTURE_UVS_VBO]);
+        glBufferSubData(GL_ARRAY_BUFFER, range.first_vertex * sizeof(glm::vec2), range.vertex_count * sizeof(glm::vec2), &chunk.uvs[source]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[TANGENT_FRAMES_VBO]);
+        glBufferSubData(GL_ARRAY_BUFFER, range.first_vertex * sizeof(udit::Tangent_Frame), range.vertex_count * sizeof(udit::Tangent_Frame), &chunk.tangent_frames[source]);
+
+        source += size_t(range.vertex_count);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Los índices de todo el bloque son contiguos en el element buffer
+    if (!chunk.indices.empty())
+    {
+        glBindVertexArray(vao_id);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, chunk.index_offset * sizeof(GLuint), chunk.indices.size() * sizeof(GLuint), chunk.indices.data());
+        glBindVertexArray(0);
+    }
+
+    ++resident_levels;
+}
+
+bool Mesh::load_progressive(const std::string& progressive_path)
+{
+    udit::Progressive_Mesh::Reader reader;
+
+    if (!reader.open(progressive_path))
+    {
+        std::cerr << "Error loading mesh: " << progressive_path << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    begin_streaming(reader.get_submeshes(), reader.get_material_textures(), reader.get_vertex_count(), reader.get_index_count(), reader.get_bounding_center(), reader.get_bounding_radius());
+
+    Stream_Chunk chunk;
+
+    for (size_t c = 0; c < reader.get_chunk_count(); ++c)
+    {
+        if (!reader.read_chunk(c, chunk))
+        {
+            std::cerr << "Error decoding mesh chunk " << c << ": " << progressive_path << std::endl;
+            break;
+        }
+
+        upload_chunk(chunk);
+
+        if (c == 0)
+        {
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  first chunk (" << chunk.indices.size() / 3 << " triangles) after " << milliseconds << " ms" << std::endl;
+        }
+    }
+
+    std::cout << "Loaded " << submeshes.size() << " submeshes from " << progressive_path << std::endl;
+
+    return resident_levels > 0;
+}
+
+bool Mesh::cook(const std::string& source_path, const std::string& cooked_path)
+{
+    Data data;
+
+    if (!import(source_path, data)) return false;
+
+    udit::Mesh_Codec::optimize(data);
+
+    if (udit::Progressive_Mesh::is_progressive(cooked_path))
+    {
+        if (!udit::Progressive_Mesh::write(cooked_path, data))
+        {
+            std::cerr << "Error writing mesh: " << cooked_path << std::endl;
+            return false;
+        }
+
+        // Informe de lo que hay que leer y decodificar antes de poder dibujar algo
+        udit::Progressive_Mesh::Reader reader;
+
+        if (!reader.open(cooked_path)) return false;
+
+        Stream_Chunk chunk;
+        size_t       total_size = 0;
+
+        for (size_t c = 0; c < reader.get_chunk_count(); ++c) total_size += reader.get_chunk_size(c);
+
+        auto start = std::chrono::steady_clock::now();
+        reader.read_chunk(0, chunk);
+        double first_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t c = 1; c < reader.get_chunk_count(); ++c) reader.read_chunk(c, chunk);
+        double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Cooked " << source_path << " -> " << cooked_path << std::endl
+                  << "  " << reader.get_chunk_count() << " chunks, " << total_size << " bytes" << std::endl
+                  << "  first chunk " << reader.get_chunk_size(0) << " bytes, decoded in " << first_seconds * 1000.0
+                  << " ms of " << total_seconds * 1000.0 << " ms" << std::endl;
+
+        return true;
+    }
+
+    udit::Mesh_Codec::Encoded_Mesh encoded;
+    udit::Mesh_Codec::encode(data, encoded);
+
+    if (!udit::Mesh_Codec::write(cooked_path, encoded))
+    {
+        std::cerr << "Error writing mesh: " << cooked_path << std::endl;
+        return false;
+    }
+
+    // Informe de tamaños y velocidad de decodificación frente a los buffers sin comprimir
+    size_t raw_size     = data.positions.size() * sizeof(glm::vec3) + data.uvs.size() * sizeof(glm::vec2) + data.positions.size() * sizeof(udit::Tangent_Frame) + data.indices.size() * sizeof(GLuint);
+    size_t encoded_size = 0;
+
+    for (const auto& stream : encoded.streams) encoded_size += stream.size();
+
+    Data decoded;
+    auto start = std::chrono::steady_clock::now();
+    udit::Mesh_Codec::decode(encoded, decoded);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Cooked " << source_path << " -> " << cooked_path << std::endl
+              << "  raw "     << raw_size     << " bytes" << std::endl
+              << "  encoded " << encoded_size << " bytes ("
+              << std::fixed << std::setprecision(1) << 100.0 * encoded_size / std::max<size_t>(raw_size, 1) << "%)" << std::endl
+              << "  decode "  << std::setprecision(2) << raw_size / std::max(seconds, 1e-9) / 1e9 << " GB/s" << std::endl
+              << std::defaultfloat;
+
+    return true;
+}
+
+unsigned Mesh::select_lod(const SubMesh& submesh, float pixels_per_unit) const
+{
+    // Se elige el LOD más simple cuyo error proyectado no supere el umbral en píxeles
+    unsigned selected = 0;
+
+    for (unsigned l = 1; l < submesh.lods.size(); ++l)
+    {
+        if (submesh.lods[l].error * pixels_per_unit > lod_pixel_error) break;
+        selected = l;
+    }
+
+    return clamp_lod(submesh, selected);
+}
+
+unsigned Mesh::clamp_lod(const SubMesh& submesh, unsigned lod) const
+{
+    // Mientras una malla progresiva se carga sólo están disponibles sus LODs más simples
+    unsigned lod_count = unsigned(submesh.lods.size());
+    unsigned finest    = lod_count > resident_levels ? lod_count - resident_levels : 0;
+
+    return std::max(std::min(lod, lod_count - 1), finest);
+}
+
+void Mesh::render(const glm::mat4& model_view, const glm::mat4& projection)
+{
+    if (!is_ready()) return;
+
+    float pixels_per_unit = get_pixels_per_unit(model_view, projection);
+
+    for (const auto& sm : submeshes)
+        add_draw(sm, select_lod(sm, pixels_per_unit));
+
+    multi_draw();
+}
+
+float Mesh::get_pixels_per_unit(const glm::mat4& model_view, const glm::mat4& projection) const
+{
+    // Tamaño en píxeles de una unidad del objeto a la distancia de su esfera envolvente
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    float scale = std::max({ glm::length(glm::vec3(model_view[0])),
+                             glm::length(glm::vec3(model_view[1])),
+                             glm::length(glm::vec3(model_view[2])) });
+
+    glm::vec3 center   = glm::vec3(model_view * glm::vec4(bounding_center, 1.f));
+    float     distance = std::max(glm::length(center) - bounding_radius * scale, 1e-3f);
+
+    return scale * projection[1][1] * viewport[3] * 0.5f / distance;
+}
+
+void Mesh::render(unsigned lod_level)
+{
+    if (!is_ready()) return;
+
+    // Renderizar todos los submeshes con un LOD fijo
+    for (const auto& sm : submeshes)
+        add_draw(sm, clamp_lod(sm, lod_level));
+
+    multi_draw();
+}
+
+void Mesh::add_draw(const SubMesh& submesh, unsigned lod_level)
+{
+    const Lod& lod = submesh.lods[lod_level];
+
+    draw_counts       .push_back(lod.index_count);
+    draw_offsets      .push_back((const void*)(lod.index_offset * sizeof(GLuint)));
+    draw_base_vertices.push_back(submesh.base_vertex);
+}
+
+void Mesh::multi_draw()
+{
+    glBindVertexArray(vao_id);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, draw_counts.data(), GL_UNSIGNED_INT, draw_offsets.data(), GLsizei(draw_counts.size()), draw_base_vertices.data());
+    glBindVertexArray(0);
+
+    // Se vacían sin liberar la memoria para el siguiente fotograma
+    draw_counts       .clear();
+    draw_offsets      .clear();
+    draw_base_vertices.clear();
+}
+
+void Mesh::render_instanced(GLuint instance_vbo, GLsizei instance_count, unsigned lod_level)
+{
+    if (!is_ready() || instance_count == 0) return;
+
+    glBindVertexArray(vao_id);
+
+    // La matriz de modelo de cada instancia ocupa los atributos 2 a 5 (una columna por
+    // atributo) y avanza una vez por instancia en lugar de una vez por vértice
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(instance_attribute + column);
+        glVertexAttribPointer(instance_attribute + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(instance_attribute + column, 1);
+    }
+
+    // Una sola llamada por submalla para todas las instancias
     for (const auto& sm : submeshes)
     {
-        glBindVertexArray(sm.vao);
-        glDrawElements(GL_TRIANGLES, sm.index_count, GL_UNSIGNED_INT, 0);
+        const Lod& lod = sm.lods[clamp_lod(sm, lod_level)];
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lod.index_count, GL_UNSIGNED_INT, (void*)(lod.index_offset * sizeof(GLuint)), instance_count, sm.base_vertex);
     }
 
+    // Se desactivan para que el render normal no lea el búfer de instancias
+    for (GLuint column = 0; column < 4; ++column)
+        glDisableVertexAttribArray(instance_attribute + column);
+
     glBindVertexArray(0);
 }
 
 Mesh::~Mesh()
 {
+    // Una malla progresiva puede tener sus buffers sin ningún nivel subido todavía
+    if (vao_id == 0) return;
+
     glDeleteVertexArrays(1, &vao_id);
-    glDeleteBuffers(2, vbo_ids);
-}
\ No newline at end of file
+    glDeleteBuffers(VBO_COUNT, vbo_ids);
+}
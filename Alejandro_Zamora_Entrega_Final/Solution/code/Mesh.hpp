@@ -1,6 +1,7 @@
 #pragma once
 
 #include<string>
+#include <algorithm>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -15,19 +16,119 @@
 #include <vector>
 
 #include <iostream>
+#include <memory>
+
+#include "Tangent_Space.hpp"
+#include <Upload_Ring.hpp>
 
 using std::vector;
 using glm::vec3;
 
+namespace udit { class Glb_File; }
+
 using namespace glm;
 
 class Mesh
 {
+    public:
+
+        // Nivel de detalle de una submalla. Todos los niveles comparten los vértices de la
+        // submalla y sus índices viven en el mismo element buffer, por lo que cambiar de nivel
+        // sólo cambia el rango que se dibuja:
+
+        struct Lod
+        {
+            GLuint  index_offset;
+            GLsizei index_count;
+            float   error;                          // Distancia a la superficie original en unidades del objeto
+        };
+
+        static constexpr unsigned max_lod_count = 5;
+
+        // Lista de LODs de capacidad fija, para que cada submalla no necesite memoria dinámica:
+
+        struct Lod_Chain
+        {
+            Lod      levels[max_lod_count];
+            unsigned count = 0;
+
+            size_t     size () const                 { return count; }
+            bool       empty() const                 { return count == 0; }
+            void       clear()                       { count = 0; }
+            void       push_back(const Lod& lod)     { if (count < max_lod_count) levels[count++] = lod; }
+            Lod&       operator[](size_t i)          { return levels[i]; }
+            const Lod& operator[](size_t i) const    { return levels[i]; }
+            const Lod& front() const                 { return levels[0]; }
+            Lod*       begin()                       { return levels; }
+            Lod*       end()                         { return levels + count; }
+            const Lod* begin() const                 { return levels; }
+            const Lod* end()   const                 { return levels + count; }
+        };
+
+        struct SubMesh
+        {
+            GLint           base_vertex;
+            GLsizei         vertex_count;
+            Lod_Chain       lods;
+            GLuint          material = 0;           // Capa en el array de texturas del modelo
+        };
+
+        // Datos de la malla ya importados en memoria de CPU. Se pueden generar en cualquier
+        // hilo y después se suben a la GPU desde el hilo que tiene el contexto de OpenGL:
+
+        struct Data
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> uvs;
+            std::vector<GLuint>    indices;
+            std::vector<SubMesh>   submeshes;
+            glm::vec3              bounding_center;
+            float                  bounding_radius;
+            std::vector<udit::Tangent_Frame> tangent_frames;   // Vacío si no se han generado
+            std::vector<std::string> material_textures;        // Textura difusa de cada material, vacía si no tiene
+        };
+
+        // Bloque de una malla progresiva: vértices nuevos de varias submallas (rangos contiguos
+        // dentro del vertex buffer) y los índices de un nivel de detalle de cada una:
+
+        struct Vertex_Range
+        {
+            GLint   first_vertex;
+            GLsizei vertex_count;
+        };
+
+        struct Stream_Chunk
+        {
+            std::vector<Vertex_Range> ranges;
+            std::vector<glm::vec3>    positions;
+            std::vector<glm::vec2>    uvs;
+            std::vector<udit::Tangent_Frame> tangent_frames;
+            GLuint                    index_offset;
+            std::vector<GLuint>       indices;
+        };
+
+        static constexpr GLuint   instance_attribute = 2;   // Primera de las 4 columnas de la matriz por instancia
+        static constexpr GLuint   tangent_frame_attribute = 8;  // ivec4 con normal y tangente octaédricas
+        static constexpr GLuint   material_attribute = 9;       // Material de cada vértice (ver Material_Array)
+        static constexpr unsigned max_material_count = 256;     // Mínimo de capas que garantiza OpenGL 3.3
+
+        // Bytes de cada banda que se copia al anillo de subida:
+        static constexpr size_t   upload_band_bytes = 4 << 20;
+
+        enum Upload_Status
+        {
+            UPLOAD_DONE,                        // Ya se han copiado todos los buffers
+            UPLOAD_PENDING,                     // Quedan bandas por copiar
+            UPLOAD_STALLED                      // El anillo está lleno; hay que esperar al siguiente fotograma
+        };
+
     private:
         enum
         {
             COORDINATES_VBO,
-            COLORS_VBO,
+            TEXTURE_UVS_VBO,
+            TANGENT_FRAMES_VBO,
+            MATERIALS_VBO,
             INDICES_EBO,
             VBO_COUNT
         };
@@ -35,20 +136,96 @@ class Mesh
         GLuint  vbo_ids[VBO_COUNT];
         GLuint  vao_id;
 
-        GLsizei number_of_indices;
+        std::vector<SubMesh> submeshes;
+        std::vector<std::string> material_textures;
 
-        struct SubMesh
-        {
-            GLuint vao;
-            GLuint vbo[3];
-            GLsizei index_count;
-        };
+        // Argumentos del multi-draw, se reutilizan entre fotogramas
+        std::vector<GLsizei>      draw_counts;
+        std::vector<const void*>  draw_offsets;
+        std::vector<GLint>        draw_base_vertices;
 
-        std::vector<SubMesh> submeshes;
+        vec3    bounding_center;
+        float   bounding_radius;
+        float   uv_density;                         // Unidades de UV por unidad del objeto, 0 si no se conoce
+
+        float   lod_pixel_error;                    // Error máximo tolerado en píxeles de pantalla
+
+        size_t  gpu_bytes;                          // Memoria ocupada por los buffers en la GPU
+
+        unsigned resident_levels;                   // LODs disponibles empezando por el más simple
+
+        std::shared_ptr<const Data> streamed_data;  // Datos que se están subiendo por bandas
+        unsigned streamed_stream;                   // Búfer que se está copiando
+        size_t   streamed_offset;                   // Bytes ya copiados de ese búfer
 
     public:
+        Mesh();
     	Mesh(const std::string& path);
     	void   load_mesh(const std::string& mesh_file_path);
-        void   render();
+        void   upload(const Data& data);
+
+        // Subida por bandas a través de un Upload_Ring, como las texturas. begin_upload reserva
+        // los buffers y cada llamada a continue_upload copia una banda; la malla no se dibuja
+        // hasta que se copia la última
+        void          begin_upload(std::shared_ptr<const Data> data);
+        Upload_Status continue_upload(udit::Upload_Ring& ring);
+
+        bool   is_ready() const { return vao_id != 0 && resident_levels > 0; }
+
+        // Carga progresiva: se reservan los buffers completos y después cada bloque subido
+        // habilita un nivel de detalle más, empezando por el más simple
+        void   begin_streaming(const std::vector<SubMesh>& submeshes, const std::vector<std::string>& material_textures, size_t vertex_count, size_t index_count, const glm::vec3& center, float radius);
+        void   upload_chunk(const Stream_Chunk& chunk);
+        size_t get_gpu_bytes() const { return gpu_bytes; }
+        const std::vector<std::string>& get_material_textures() const { return material_textures; }
+        static bool import(const std::string& mesh_file_path, Data& data);
+
+        // Sólo la parte de Assimp de import(), sin LODs ni bases tangentes. Es la referencia con
+        // la que se comparan los lectores nativos
+        static bool import_with_assimp(const std::string& mesh_file_path, Data& data);
+
+        // Sólo la parte del lector nativo .glb de import(): vértices, índices y submallas, sin
+        // LODs ni bases tangentes. Es lo que --glb-check compara con import_with_assimp
+        static void read_glb(const udit::Glb_File& glb, Data& data);
+
+        // Sustituye el único LOD de cada submalla por su cadena de LODs. Hace un número fijo de
+        // reservas en el heap, sea cual sea el número de submallas
+        static void build_lods(const std::string& mesh_file_path, Data& data);
+
+        // Genera la base tangente de cada vértice con los triángulos del LOD 0 de cada submalla.
+        // El tiempo que tarda lo mide --tangent-frame-benchmark
+        static void build_tangent_frames(Data& data);
+
+        // Importa un modelo y lo guarda en el formato comprimido .umesh o en el progresivo .pmesh
+        // según la extensión de cooked_path
+        static bool cook(const std::string& source_path, const std::string& cooked_path);
+        // Todas las submallas se dibujan con un único glMultiDrawElementsBaseVertex
+        void   render(const glm::mat4& model_view, const glm::mat4& projection);
+        void   render(unsigned lod = 0);
+
+        // Dibuja instance_count copias leyendo una mat4 por instancia de instance_vbo
+        void   render_instanced(GLuint instance_vbo, GLsizei instance_count, unsigned lod = 0);
+        void   set_lod_pixel_error(float pixels) { lod_pixel_error = pixels; }
+
+        // Píxeles que ocupa una unidad del objeto en la parte de su esfera envolvente más cercana
+        // a la cámara (con el viewport actual)
+        float  get_pixels_per_unit(const glm::mat4& model_view, const glm::mat4& projection) const;
+
+        // Si no se ha podido medir se supone que la textura cubre el objeto una vez
+        float  get_uv_density() const { return uv_density > 0.f ? uv_density : 0.5f / std::max(bounding_radius, 1e-3f); }
         ~Mesh();
+
+    private:
+        unsigned select_lod(const SubMesh& submesh, float pixels_per_unit) const;
+        unsigned clamp_lod(const SubMesh& submesh, unsigned lod) const;
+        bool     load_progressive(const std::string& progressive_path);
+        bool     load_cooked(const std::string& cooked_path);
+        bool     load_glb(const std::string& glb_path);
+        void     set_layout(const Data& data);
+        void     create_buffers(size_t vertex_count, size_t index_count, const void* positions, const void* uvs, const void* indices, const void* tangent_frames = nullptr);
+        void     upload_tangent_frames(size_t vertex_count, const udit::Tangent_Frame* tangent_frames);
+        void     upload_materials(size_t vertex_count);
+        void     add_draw(const SubMesh& submesh, unsigned lod);
+        void     multi_draw();
+        static bool is_cooked(const std::string& path);
 };
\ No newline at end of file
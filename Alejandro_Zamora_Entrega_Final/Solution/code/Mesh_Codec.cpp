@@ -0,0 +1,725 @@
+#include "Mesh_Codec.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define MESH_CODEC_SSE2
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        constexpr uint32_t file_magic   = 0x48534D55;           // "UMSH"
+        constexpr uint32_t file_version = 3;                    // 2: materiales por submalla, 3: bases tangentes
+
+        // Base que se guarda en los vértices de una malla sin bases tangentes. Es el mismo valor
+        // constante que lee el shader cuando no hay búfer de bases, y no puede salir de pack():
+
+        constexpr Tangent_Frame missing_tangent_frame = { { 0, 0 }, { -32768, 0 } };
+
+        inline uint32_t read_u32 (const uint8_t * bytes)
+        {
+            uint32_t value;
+            std::memcpy (&value, bytes, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t zigzag_encode (uint32_t value)
+        {
+            return (value << 1) ^ uint32_t(int32_t(value) >> 31);
+        }
+
+        inline uint32_t zigzag_decode (uint32_t value)
+        {
+            return (value >> 1) ^ (0u - (value & 1));
+        }
+
+        void write_length (std::vector< uint8_t > & output, size_t length)
+        {
+            for ( ; length >= 255; length -= 255) output.push_back (255);
+            output.push_back (uint8_t(length));
+        }
+
+        size_t stream_word_count (const Mesh_Codec::Encoded_Mesh & encoded, Mesh_Codec::Stream stream)
+        {
+            size_t elements = stream == Mesh_Codec::INDICES_STREAM ? encoded.index_count : encoded.vertex_count;
+            return elements * Mesh_Codec::stream_strides[stream];
+        }
+
+    }
+
+    const unsigned Mesh_Codec::stream_strides[STREAM_COUNT] = { 3, 2, 2, 1 };
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    void Mesh_Codec::tipsify (GLuint * indices, size_t index_count, size_t vertex_count, unsigned cache_size)
+    {
+        // Algoritmo Tipsify (Sander, Nehab y Barczak, 2007). Se avanza en abanico alrededor de un
+        // vértice y se elige el siguiente entre los vecinos que probablemente siguen en caché.
+
+        const size_t triangle_count = index_count / 3;
+
+        std::vector< unsigned > live_count  (vertex_count, 0);
+        std::vector< unsigned > offsets     (vertex_count + 1, 0);
+        std::vector< unsigned > adjacency   (index_count);
+
+        for (size_t i = 0; i < index_count; ++i) ++live_count[indices[i]];
+
+        for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] = offsets[v] + live_count[v];
+
+        {
+            std::vector< unsigned > cursor(offsets.begin (), offsets.end () - 1);
+
+            for (size_t i = 0; i < index_count; ++i) adjacency[cursor[indices[i]]++] = unsigned(i / 3);
+        }
+
+        std::vector< unsigned > cache_time (vertex_count, 0);
+        std::vector< bool     > emitted    (triangle_count, false);
+        std::vector< unsigned > dead_ends;
+        std::vector< unsigned > candidates;
+        std::vector< GLuint   > output;
+
+        output.reserve (index_count);
+
+        unsigned time    = cache_size + 1;
+        size_t   cursor  = 0;
+        long     fanning = vertex_count > 0 ? 0 : -1;
+
+        while (fanning >= 0)
+        {
+            candidates.clear ();
+
+            for (unsigned a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+            {
+                unsigned triangle = adjacency[a];
+
+                if (emitted[triangle]) continue;
+
+                for (unsigned corner = 0; corner < 3; ++corner)
+                {
+                    GLuint vertex = indices[triangle * 3 + corner];
+
+                    output    .push_back (vertex);
+                    dead_ends .push_back (vertex);
+                    candidates.push_back (vertex);
+
+                    --live_count[vertex];
+
+                    if (time - cache_time[vertex] > cache_size)
+                    {
+                        cache_time[vertex] = time++;
+                    }
+                }
+
+                emitted[triangle] = true;
+            }
+
+            // Se elige el vecino que seguirá en caché más tiempo:
+
+            long     next          = -1;
+            unsigned best_priority = 0;
+
+            for (unsigned vertex : candidates)
+            {
+                if (live_count[vertex] == 0) continue;
+
+                unsigned priority = 0;
+
+                if (time - cache_time[vertex] + 2 * live_count[vertex] <= cache_size)
+                {
+                    priority = time - cache_time[vertex];
+                }
+
+                if (next < 0 || priority > best_priority)
+                {
+                    next          = vertex;
+                    best_priority = priority;
+                }
+            }
+
+            // Si no hay ninguno se recurre a la pila de callejones sin salida o se busca el
+            // siguiente vértice con triángulos pendientes:
+
+            while (next < 0 && !dead_ends.empty ())
+            {
+                unsigned vertex = dead_ends.back ();
+                dead_ends.pop_back ();
+
+                if (live_count[vertex] > 0) next = vertex;
+            }
+
+            while (next < 0 && cursor < vertex_count)
+            {
+                if (live_count[cursor] > 0) next = long(cursor);
+                ++cursor;
+            }
+
+            fanning = next;
+        }
+
+        std::copy (output.begin (), output.end (), indices);
+    }
+
+    void Mesh_Codec::optimize (Mesh::Data & data)
+    {
+        for (const auto & submesh : data.submeshes)
+        {
+            const size_t first_vertex = size_t(submesh.base_vertex);
+            const size_t vertex_count = size_t(submesh.vertex_count);
+
+            for (const auto & lod : submesh.lods)
+            {
+                tipsify (&data.indices[lod.index_offset], size_t(lod.index_count), vertex_count, 16);
+            }
+
+            // Los vértices se renumeran por orden de primer uso, empezando por el LOD 0, para que
+            // las lecturas de vértices sean lo más secuenciales posible:
+
+            constexpr GLuint unassigned = ~GLuint(0);
+
+            std::vector< GLuint > remap(vertex_count, unassigned);
+            GLuint                next = 0;
+
+            for (const auto & lod : submesh.lods)
+            {
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    GLuint & target = remap[data.indices[lod.index_offset + i]];
+                    if (target == unassigned) target = next++;
+                }
+            }
+
+            for (auto & target : remap)
+            {
+                if (target == unassigned) target = next++;
+            }
+
+            std::vector< glm::vec3 > positions(vertex_count);
+            std::vector< glm::vec2 > uvs      (vertex_count);
+
+            for (size_t v = 0; v < vertex_count; ++v)
+            {
+                positions[remap[v]] = data.positions[first_vertex + v];
+                uvs      [remap[v]] = data.uvs      [first_vertex + v];
+            }
+
+            std::copy (positions.begin (), positions.end (), data.positions.begin () + first_vertex);
+            std::copy (uvs      .begin (), uvs      .end (), data.uvs      .begin () + first_vertex);
+
+            // Las bases tangentes, si las hay, siguen a sus vértices:
+
+            if (!data.tangent_frames.empty ())
+            {
+                std::vector< Tangent_Frame > frames(vertex_count);
+
+                for (size_t v = 0; v < vertex_count; ++v)
+                {
+                    frames[remap[v]] = data.tangent_frames[first_vertex + v];
+                }
+
+                std::copy (frames.begin (), frames.end (), data.tangent_frames.begin () + first_vertex);
+            }
+
+            for (const auto & lod : submesh.lods)
+            {
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    GLuint & index = data.indices[lod.index_offset + i];
+                    index = remap[index];
+                }
+            }
+        }
+    }
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    void Mesh_Codec::filter_stream (const uint32_t * words, size_t count, unsigned stride, std::vector< uint8_t > & planes)
+    {
+        planes.resize (count * 4);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t previous = i >= stride ? words[i - stride] : 0;
+            uint32_t encoded  = zigzag_encode (words[i] - previous);
+
+            planes[i            ] = uint8_t(encoded      );
+            planes[i + count    ] = uint8_t(encoded >>  8);
+            planes[i + count * 2] = uint8_t(encoded >> 16);
+            planes[i + count * 3] = uint8_t(encoded >> 24);
+        }
+    }
+
+    namespace
+    {
+
+        // Reconstruye palabras a partir de los planos de bytes en bloques de 48 palabras (divisible
+        // por las zancadas 1, 2 y 3) para que la suma acumulada por componente no dependa de la fase.
+        // Se guarda el último valor de cada componente para no tener que leer del destino, que
+        // puede ser memoria de la GPU mapeada sólo para escritura.
+
+        template< unsigned STRIDE >
+        void unfilter_words (const uint8_t * planes, size_t count, uint32_t * words)
+        {
+            constexpr size_t block_size = 48;
+
+            uint32_t history[STRIDE] = { };
+            size_t   i = 0;
+
+            const uint8_t * plane0 = planes;
+            const uint8_t * plane1 = planes + count;
+            const uint8_t * plane2 = planes + count * 2;
+            const uint8_t * plane3 = planes + count * 3;
+
+            #ifdef MESH_CODEC_SSE2
+
+                const __m128i one  = _mm_set1_epi32 (1);
+                const __m128i zero = _mm_setzero_si128 ();
+
+                alignas(16) uint32_t deltas[block_size];
+
+                for ( ; i + block_size <= count; i += block_size)
+                {
+                    for (size_t k = 0; k < block_size; k += 16)
+                    {
+                        __m128i b0 = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(plane0 + i + k));
+                        __m128i b1 = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(plane1 + i + k));
+                        __m128i b2 = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(plane2 + i + k));
+                        __m128i b3 = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(plane3 + i + k));
+
+                        // Se entrelazan los planos de bytes para reconstruir palabras de 32 bits:
+
+                        __m128i low_01  = _mm_unpacklo_epi8 (b0, b1);
+                        __m128i high_01 = _mm_unpackhi_epi8 (b0, b1);
+                        __m128i low_23  = _mm_unpacklo_epi8 (b2, b3);
+                        __m128i high_23 = _mm_unpackhi_epi8 (b2, b3);
+
+                        __m128i w[4] =
+                        {
+                            _mm_unpacklo_epi16 (low_01,  low_23 ),
+                            _mm_unpackhi_epi16 (low_01,  low_23 ),
+                            _mm_unpacklo_epi16 (high_01, high_23),
+                            _mm_unpackhi_epi16 (high_01, high_23),
+                        };
+
+                        // Decodificación zigzag: (w >> 1) ^ -(w & 1)
+
+                        for (unsigned j = 0; j < 4; ++j)
+                        {
+                            __m128i sign = _mm_sub_epi32 (zero, _mm_and_si128 (w[j], one));
+                            _mm_store_si128 (reinterpret_cast< __m128i * >(deltas + k + j * 4), _mm_xor_si128 (_mm_srli_epi32 (w[j], 1), sign));
+                        }
+                    }
+
+                    for (size_t v = 0; v < block_size; v += STRIDE)
+                    {
+                        for (unsigned c = 0; c < STRIDE; ++c)
+                        {
+                            history[c]      += deltas[v + c];
+                            words[i + v + c] = history[c];
+                        }
+                    }
+                }
+
+            #endif
+
+            for (unsigned phase = 0; i < count; ++i)
+            {
+                uint32_t encoded = uint32_t(plane0[i]) | uint32_t(plane1[i]) << 8 | uint32_t(plane2[i]) << 16 | uint32_t(plane3[i]) << 24;
+
+                history[phase] += zigzag_decode (encoded);
+                words[i]        = history[phase];
+                phase           = phase + 1 == STRIDE ? 0 : phase + 1;
+            }
+        }
+
+    }
+
+    void Mesh_Codec::unfilter_stream (const uint8_t * planes, size_t count, unsigned stride, uint32_t * words)
+    {
+        switch (stride)
+        {
+            case 1: unfilter_words< 1 > (planes, count, words); break;
+            case 2: unfilter_words< 2 > (planes, count, words); break;
+            case 3: unfilter_words< 3 > (planes, count, words); break;
+        }
+    }
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    void Mesh_Codec::lz_compress (const uint8_t * source, size_t size, std::vector< uint8_t > & output)
+    {
+        // Secuencias al estilo de LZ4: token (longitud de literales en el nibble alto y de la
+        // coincidencia menos 4 en el bajo), literales, desplazamiento de 16 bits y longitudes
+        // extendidas con bytes de 255. La última secuencia sólo lleva literales.
+
+        constexpr unsigned hash_bits    = 16;
+        constexpr size_t   minimum_match = 4;
+        constexpr size_t   maximum_offset = 65535;
+
+        output.clear ();
+        output.reserve (size / 2 + 16);
+
+        std::vector< int64_t > table(size_t(1) << hash_bits, -1);
+
+        const size_t limit  = size > 12 ? size - 12 : 0;
+        size_t       anchor = 0;
+        size_t       i      = 0;
+
+        auto emit = [&] (size_t literal_length, size_t offset, size_t match_length)
+        {
+            size_t extra_match = match_length >= minimum_match ? match_length - minimum_match : 0;
+
+            output.push_back (uint8_t(std::min< size_t > (literal_length, 15) << 4 | std::min< size_t > (extra_match, 15)));
+
+            if (literal_length >= 15) write_length (output, literal_length - 15);
+
+            output.insert (output.end (), source + anchor, source + anchor + literal_length);
+
+            if (match_length == 0) return;
+
+            output.push_back (uint8_t(offset     ));
+            output.push_back (uint8_t(offset >> 8));
+
+            if (extra_match >= 15) write_length (output, extra_match - 15);
+        };
+
+        while (i < limit)
+        {
+            uint32_t sequence  = read_u32 (source + i);
+            uint32_t hash      = (sequence * 2654435761u) >> (32 - hash_bits);
+            int64_t  candidate = table[hash];
+
+            table[hash] = int64_t(i);
+
+            if (candidate >= 0 && i - size_t(candidate) <= maximum_offset && read_u32 (source + candidate) == sequence)
+            {
+                size_t match = minimum_match;
+
+                while (i + match < size - 5 && source[candidate + match] == source[i + match]) ++match;
+
+                emit (i - anchor, i - size_t(candidate), match);
+
+                i     += match;
+                anchor = i;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        emit (size - anchor, 0, 0);
+    }
+
+    bool Mesh_Codec::lz_decompress (const uint8_t * source, size_t size, uint8_t * destination, size_t destination_size)
+    {
+        const uint8_t * input      = source;
+        const uint8_t * input_end  = source + size;
+        uint8_t       * output     = destination;
+        uint8_t       * output_end = destination + destination_size;
+
+        auto read_length = [&] (size_t & length) -> bool
+        {
+            uint8_t byte;
+
+            do
+            {
+                if (input == input_end) return false;
+                byte    = *input++;
+                length += byte;
+            }
+            while (byte == 255);
+
+            return true;
+        };
+
+        while (input < input_end)
+        {
+            uint8_t token          = *input++;
+            size_t  literal_length = token >> 4;
+
+            if (literal_length == 15 && !read_length (literal_length)) return false;
+
+            if (size_t(input_end  - input ) < literal_length) return false;
+            if (size_t(output_end - output) < literal_length) return false;
+
+            // Las secuencias cortas lejos de los extremos se copian con un tamaño fijo, que el
+            // compilador convierte en un único movimiento de 16 bytes:
+
+            if (literal_length <= 16 && input_end - input >= 16 && output_end - output >= 16)
+                std::memcpy (output, input, 16);
+            else
+                std::memcpy (output, input, literal_length);
+
+            input  += literal_length;
+            output += literal_length;
+
+            if (input == input_end) break;
+
+            if (input_end - input < 2) return false;
+
+            size_t offset = size_t(input[0]) | size_t(input[1]) << 8;
+            input += 2;
+
+            if (offset == 0 || offset > size_t(output - destination)) return false;
+
+            size_t match_length = token & 15;
+
+            if (match_length == 15 && !read_length (match_length)) return false;
+
+            match_length += 4;
+
+            if (size_t(output_end - output) < match_length) return false;
+
+            const uint8_t * match = output - offset;
+
+            if (offset >= 16 && match_length <= 16 && output_end - output >= 16)
+            {
+                std::memcpy (output, match, 16);
+                output += match_length;
+            }
+            else
+            if (offset >= match_length)
+            {
+                std::memcpy (output, match, match_length);
+                output += match_length;
+            }
+            else
+            {
+                // Coincidencia solapada (p. ej. repeticiones de un mismo byte):
+
+                for (size_t k = 0; k < match_length; ++k) *output++ = match[k];
+            }
+        }
+
+        return output == output_end;
+    }
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    void Mesh_Codec::encode (const Mesh::Data & data, Encoded_Mesh & encoded)
+    {
+        encoded.submeshes         = data.submeshes;
+        encoded.material_textures = data.material_textures;
+        encoded.bounding_center = data.bounding_center;
+        encoded.bounding_radius = data.bounding_radius;
+        encoded.vertex_count    = uint32_t(data.positions.size ());
+        encoded.index_count     = uint32_t(data.indices  .size ());
+
+        std::vector< Tangent_Frame > missing_frames;
+
+        const Tangent_Frame * tangent_frames = data.tangent_frames.data ();
+
+        if (data.tangent_frames.size () != data.positions.size ())
+        {
+            missing_frames.assign (data.positions.size (), missing_tangent_frame);
+            tangent_frames = missing_frames.data ();
+        }
+
+        const uint32_t * words[STREAM_COUNT] =
+        {
+            reinterpret_cast< const uint32_t * >(data.positions.data ()),
+            reinterpret_cast< const uint32_t * >(data.uvs      .data ()),
+            reinterpret_cast< const uint32_t * >(tangent_frames),
+            reinterpret_cast< const uint32_t * >(data.indices  .data ()),
+        };
+
+        std::vector< uint8_t > planes;
+
+        for (unsigned s = 0; s < STREAM_COUNT; ++s)
+        {
+            filter_stream (words[s], stream_word_count (encoded, Stream(s)), stream_strides[s], planes);
+            lz_compress   (planes.data (), planes.size (), encoded.streams[s]);
+        }
+    }
+
+    bool Mesh_Codec::decode_stream
+    (
+        const Encoded_Mesh     & encoded,
+        Stream                   stream,
+        void                   * destination,
+        std::vector< uint8_t > & scratch
+    )
+    {
+        size_t word_count = stream_word_count (encoded, stream);
+
+        scratch.resize (word_count * 4);
+
+        const auto & bytes = encoded.streams[stream];
+
+        if (!lz_decompress (bytes.data (), bytes.size (), scratch.data (), scratch.size ())) return false;
+
+        unfilter_stream (scratch.data (), word_count, stream_strides[stream], static_cast< uint32_t * >(destination));
+
+        return true;
+    }
+
+    bool Mesh_Codec::decode (const Encoded_Mesh & encoded, Mesh::Data & data)
+    {
+        data.submeshes         = encoded.submeshes;
+        data.material_textures = encoded.material_textures;
+        data.bounding_center = encoded.bounding_center;
+        data.bounding_radius = encoded.bounding_radius;
+
+        data.positions     .resize (encoded.vertex_count);
+        data.uvs           .resize (encoded.vertex_count);
+        data.tangent_frames.resize (encoded.vertex_count);
+        data.indices       .resize (encoded.index_count );
+
+        std::vector< uint8_t > scratch;
+
+        return decode_stream (encoded, POSITIONS_STREAM,      data.positions     .data (), scratch)
+            && decode_stream (encoded, TEXTURE_UVS_STREAM,    data.uvs           .data (), scratch)
+            && decode_stream (encoded, TANGENT_FRAMES_STREAM, data.tangent_frames.data (), scratch)
+            && decode_stream (encoded, INDICES_STREAM,        data.indices       .data (), scratch)
+            && check_indices (encoded, data.indices.data ());
+    }
+
+    bool Mesh_Codec::check_indices (const Encoded_Mesh & encoded, const GLuint * indices)
+    {
+        for (const auto & submesh : encoded.submeshes)
+        {
+            const GLuint vertex_count = GLuint(submesh.vertex_count);
+
+            for (const auto & lod : submesh.lods)
+            {
+                const GLuint * range = indices + lod.index_offset;
+
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    if (range[i] >= vertex_count) return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    bool Mesh_Codec::write (const std::string & path, const Encoded_Mesh & encoded)
+    {
+        std::ofstream file(path, std::ios::binary);
+
+        if (!file) return false;
+
+        auto put = [&file] (const auto & value)
+        {
+            file.write (reinterpret_cast< const char * >(&value), sizeof(value));
+        };
+
+        put (file_magic);
+        put (file_version);
+        put (uint32_t(encoded.submeshes.size ()));
+        put (encoded.vertex_count);
+        put (encoded.index_count);
+        put (encoded.bounding_center);
+        put (encoded.bounding_radius);
+
+        for (const auto & submesh : encoded.submeshes)
+        {
+            put (submesh.base_vertex);
+            put (submesh.vertex_count);
+            put (submesh.material);
+            put (uint32_t(submesh.lods.size ()));
+
+            for (const auto & lod : submesh.lods) put (lod);
+        }
+
+        put (uint32_t(encoded.material_textures.size ()));
+
+        for (const auto & texture : encoded.material_textures)
+        {
+            put (uint32_t(texture.size ()));
+            file.write (texture.data (), std::streamsize(texture.size ()));
+        }
+
+        for (const auto & stream : encoded.streams)
+        {
+            put (uint32_t(stream.size ()));
+            file.write (reinterpret_cast< const char * >(stream.data ()), std::streamsize(stream.size ()));
+        }
+
+        return bool(file);
+    }
+
+    bool Mesh_Codec::read (const std::string & path, Encoded_Mesh & encoded)
+    {
+        std::ifstream file(path, std::ios::binary);
+
+        if (!file) return false;
+
+        auto get = [&file] (auto & value) -> bool
+        {
+            return bool(file.read (reinterpret_cast< char * >(&value), sizeof(value)));
+        };
+
+        uint32_t magic = 0, version = 0, submesh_count = 0;
+
+        if (!get (magic) || magic != file_magic || !get (version) || version != file_version) return false;
+
+        if (!get (submesh_count)
+         || !get (encoded.vertex_count)
+         || !get (encoded.index_count)
+         || !get (encoded.bounding_center)
+         || !get (encoded.bounding_radius)) return false;
+
+        encoded.submeshes.resize (submesh_count);
+
+        for (auto & submesh : encoded.submeshes)
+        {
+            uint32_t lod_count = 0;
+
+            if (!get (submesh.base_vertex) || !get (submesh.vertex_count) || !get (submesh.material) || !get (lod_count)) return false;
+
+            if (lod_count == 0 || lod_count > Mesh::max_lod_count || submesh.material >= Mesh::max_material_count) return false;
+
+            if (submesh.base_vertex < 0 || submesh.vertex_count < 0 || size_t(submesh.base_vertex) + size_t(submesh.vertex_count) > encoded.vertex_count) return false;
+
+            submesh.lods.count = lod_count;
+
+            for (auto & lod : submesh.lods)
+            {
+                if (!get (lod)) return false;
+
+                if (lod.index_count < 0 || size_t(lod.index_offset) + size_t(lod.index_count) > encoded.index_count) return false;
+            }
+        }
+
+        uint32_t material_count = 0;
+
+        if (!get (material_count) || material_count > Mesh::max_material_count) return false;
+
+        encoded.material_textures.resize (material_count);
+
+        for (auto & texture : encoded.material_textures)
+        {
+            uint32_t length = 0;
+
+            if (!get (length) || length > 4096) return false;
+
+            texture.resize (length);
+
+            if (!file.read (&texture[0], length)) return false;
+        }
+
+        for (auto & stream : encoded.streams)
+        {
+            uint32_t size = 0;
+
+            if (!get (size)) return false;
+
+            stream.resize (size);
+
+            if (!file.read (reinterpret_cast< char * >(stream.data ()), size)) return false;
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.hpp"
+
+namespace udit
+{
+
+    // Formato comprimido de mallas (.umesh) para distribuir la geometría ya procesada.
+    //
+    // Antes de codificar se reordenan los triángulos para aprovechar la caché de vértices
+    // (Tipsify) y los vértices por orden de primer uso. Después cada flujo (posiciones, UVs,
+    // bases tangentes e índices) se trata como una secuencia de palabras de 32 bits: se codifica la diferencia
+    // con la misma componente del vértice anterior en zigzag, se separan los bytes en cuatro
+    // planos y el resultado se comprime con un LZ orientado a bytes.
+    //
+    // El decodificador deshace el LZ en un búfer temporal y el filtro (planos + zigzag, con
+    // SSE2 cuando está disponible) escribe directamente en el destino, que puede ser un búfer
+    // de OpenGL mapeado.
+
+    class Mesh_Codec
+    {
+    public:
+
+        enum Stream
+        {
+            POSITIONS_STREAM,
+            TEXTURE_UVS_STREAM,
+            TANGENT_FRAMES_STREAM,                              // Tangent_Frame de 8 bytes
+            INDICES_STREAM,
+            STREAM_COUNT
+        };
+
+        static const unsigned stream_strides[STREAM_COUNT];     // Palabras de 32 bits por elemento
+
+        // Contenido de un archivo .umesh con los flujos aún comprimidos:
+
+        struct Encoded_Mesh
+        {
+            std::vector< Mesh::SubMesh > submeshes;
+            std::vector< std::string >   material_textures;
+            glm::vec3                    bounding_center;
+            float                        bounding_radius;
+            uint32_t                     vertex_count;
+            uint32_t                     index_count;
+            std::vector< uint8_t >       streams[STREAM_COUNT];
+        };
+
+    public:
+
+        // Reordena triángulos y vértices de cada submalla para la caché de vértices del hardware:
+
+        static void optimize (Mesh::Data & data);
+
+        // Si data no trae bases tangentes se guarda en su lugar el valor que marca la malla
+        // como sin normales:
+
+        static void encode (const Mesh::Data & data, Encoded_Mesh & encoded);
+
+        // Decodifica un flujo completo en destination, que debe tener espacio para
+        // elementos * stride palabras. scratch se reutiliza entre llamadas para evitar reservas.
+
+        static bool decode_stream
+        (
+            const Encoded_Mesh     & encoded,
+            Stream                   stream,
+            void                   * destination,
+            std::vector< uint8_t > & scratch
+        );
+
+        static bool decode (const Encoded_Mesh & encoded, Mesh::Data & data);
+
+        // Comprueba que los índices de cada LOD caen dentro de los vértices de su submalla. read()
+        // sólo valida los rangos, así que hay que llamarla después de decodificar los índices:
+
+        static bool check_indices (const Encoded_Mesh & encoded, const GLuint * indices);
+
+        static bool write (const std::string & path, const Encoded_Mesh & encoded);
+        static bool read  (const std::string & path, Encoded_Mesh & encoded);
+
+        // Byte LZ genérico usado por el formato (similar a LZ4):
+
+        static void lz_compress   (const uint8_t * source, size_t size, std::vector< uint8_t > & output);
+        static bool lz_decompress (const uint8_t * source, size_t size, uint8_t * destination, size_t destination_size);
+
+    private:
+
+        static void tipsify          (GLuint * indices, size_t index_count, size_t vertex_count, unsigned cache_size);
+        static void filter_stream    (const uint32_t * words, size_t count, unsigned stride, std::vector< uint8_t > & planes);
+        static void unfilter_stream  (const uint8_t  * planes, size_t count, unsigned stride, uint32_t * words);
+
+    };
+
+}
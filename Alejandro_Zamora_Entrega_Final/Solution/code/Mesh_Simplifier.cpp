@@ -0,0 +1,531 @@
+#include "Mesh_Simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using glm::vec2;
+using glm::vec3;
+
+namespace udit
+{
+
+    namespace
+    {
+        constexpr unsigned no_vertex = ~0u;
+
+        // Entradas de la cola por índice. Al llenarla sólo quedan dos por índice como mucho (una
+        // por sentido de cada arista), así que siempre se libera al menos la mitad:
+
+        constexpr size_t queue_entries_per_index = 4;
+    }
+
+    size_t Mesh_Simplifier::get_arena_size (size_t vertex_count, size_t index_count)
+    {
+        // Estructuras permanentes más las temporales de lock_seams_and_borders (order,
+        // canonical, edges y border), con margen para la alineación de cada una:
+
+        return index_count       * sizeof(GLuint)
+             + index_count / 3   * sizeof(uint8_t)
+             + (vertex_count + 1)* sizeof(unsigned)
+             + index_count       * sizeof(unsigned)
+             + vertex_count      * sizeof(unsigned) * 2
+             + vertex_count      * sizeof(Quadric)
+             + vertex_count      * sizeof(uint8_t) * 2
+             + vertex_count      * sizeof(unsigned) * 2
+             + index_count       * sizeof(uint64_t)
+             + vertex_count      * sizeof(uint8_t)
+             + index_count       * sizeof(Collapse) * queue_entries_per_index
+             + 16 * alignof(Quadric);
+    }
+
+    size_t Mesh_Simplifier::get_output_size (size_t index_count, unsigned max_lod_count)
+    {
+        // Mismos cortes que build_lod_chain. Cada nivel que se acepta tiene como mucho 9/10 de
+        // los índices del anterior, así que la serie se acota con ese factor (unas 4,1 veces el
+        // nivel 0 con cinco niveles), no con la mitad que se pide al simplificador:
+
+        size_t total = index_count;
+
+        if (max_lod_count < 2 || index_count / 3 < minimum_triangle_count * 2) return total;
+
+        for (size_t level = 1, previous = index_count; level < max_lod_count; ++level)
+        {
+            if (previous / 6 * 3 / 3 < minimum_triangle_count) break;
+
+            previous  = previous * 9 / 10;
+            total    += previous;
+        }
+
+        return total;
+    }
+
+    Mesh_Simplifier::Mesh_Simplifier
+    (
+        const vec3   * positions,
+        const vec2   * uvs,
+        size_t         vertex_count,
+        const GLuint * indices,
+        size_t         index_count,
+        Linear_Arena & arena
+    )
+    :
+        positions           (positions),
+        uvs                 (uvs),
+        vertex_count        (vertex_count),
+        triangle_count      (index_count / 3),
+        triangles           (arena.allocate< GLuint   > (index_count)),
+        triangle_alive      (arena.allocate< uint8_t  > (index_count / 3)),
+        adjacency_offsets   (arena.allocate< unsigned > (vertex_count + 1)),
+        adjacency           (arena.allocate< unsigned > (index_count)),
+        next_merged         (arena.allocate< unsigned > (vertex_count)),
+        last_merged         (arena.allocate< unsigned > (vertex_count)),
+        quadrics            (arena.allocate< Quadric  > (vertex_count)),
+        locked              (arena.allocate< uint8_t  > (vertex_count)),
+        vertex_alive        (arena.allocate< uint8_t  > (vertex_count)),
+        queue               (arena.allocate< Collapse > (index_count * queue_entries_per_index)),
+        queue_size          (0),
+        queue_capacity      (index_count * queue_entries_per_index),
+        alive_triangle_count(index_count / 3),
+        max_error           (0.f)
+    {
+        std::copy (indices, indices + index_count, triangles);
+
+        std::fill (triangle_alive, triangle_alive + triangle_count, uint8_t(1));
+        std::fill (quadrics,       quadrics       + vertex_count,   Quadric{});
+        std::fill (locked,         locked         + vertex_count,   uint8_t(0));
+        std::fill (vertex_alive,   vertex_alive   + vertex_count,   uint8_t(1));
+        std::fill (next_merged,    next_merged    + vertex_count,   no_vertex);
+
+        std::iota (last_merged, last_merged + vertex_count, 0u);
+
+        // Adyacencia vértice -> triángulos en formato CSR (cuenta, suma prefija y reparto):
+
+        std::fill (adjacency_offsets, adjacency_offsets + vertex_count + 1, 0u);
+
+        for (size_t i = 0; i < index_count; ++i) ++adjacency_offsets[triangles[i] + 1];
+
+        for (size_t v = 0; v < vertex_count; ++v) adjacency_offsets[v + 1] += adjacency_offsets[v];
+
+        for (unsigned t = 0; t < triangle_count; ++t)
+        {
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                adjacency[adjacency_offsets[triangles[t * 3 + corner]]++] = t;
+            }
+        }
+
+        for (size_t v = vertex_count; v > 0; --v) adjacency_offsets[v] = adjacency_offsets[v - 1];
+
+        adjacency_offsets[0] = 0;
+
+        // El peso de las UVs se escala con el tamaño de la malla para que el error de atributo
+        // sea comparable con el error geométrico:
+
+        vec3 min_corner(+INFINITY), max_corner(-INFINITY);
+
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            min_corner = glm::min(min_corner, positions[i]);
+            max_corner = glm::max(max_corner, positions[i]);
+        }
+
+        float extent = vertex_count > 0 ? glm::length(max_corner - min_corner) : 0.f;
+
+        uv_weight = 0.25f * extent * extent;
+
+        lock_seams_and_borders (arena);
+        compute_quadrics       ();
+        fill_queue             ();
+    }
+
+    template< typename FUNCTION >
+    void Mesh_Simplifier::for_each_triangle (unsigned vertex, FUNCTION && function) const
+    {
+        // Recorre los triángulos del vértice y los de todos los vértices colapsados sobre él:
+
+        for (unsigned v = vertex; v != no_vertex; v = next_merged[v])
+        {
+            for (unsigned i = adjacency_offsets[v]; i < adjacency_offsets[v + 1]; ++i)
+            {
+                if (triangle_alive[adjacency[i]] && !function (adjacency[i])) return;
+            }
+        }
+    }
+
+    void Mesh_Simplifier::lock_seams_and_borders (Linear_Arena & arena)
+    {
+        // Se agrupan los vértices que comparten posición. Como Assimp ya ha unido los vértices
+        // idénticos, dos vértices en la misma posición implican una costura de UVs:
+
+        unsigned * order = arena.allocate< unsigned > (vertex_count);
+        std::iota (order, order + vertex_count, 0u);
+
+        auto position_less = [this] (unsigned a, unsigned b)
+        {
+            const vec3 & pa = positions[a];
+            const vec3 & pb = positions[b];
+            if (pa.x != pb.x) return pa.x < pb.x;
+            if (pa.y != pb.y) return pa.y < pb.y;
+            return pa.z < pb.z;
+        };
+
+        std::sort (order, order + vertex_count, position_less);
+
+        unsigned * canonical = arena.allocate< unsigned > (vertex_count);
+
+        for (size_t i = 0, group_start = 0; i < vertex_count; ++i)
+        {
+            if (i > 0 && position_less (order[i - 1], order[i])) group_start = i;
+
+            canonical[order[i]] = order[group_start];
+
+            if (group_start != i)
+            {
+                locked[order[i]] = locked[order[group_start]] = 1;
+            }
+        }
+
+        // Las aristas que sólo pertenecen a un triángulo son bordes abiertos y también se
+        // bloquean. Cada arista se guarda en 64 bits con el vértice menor en la parte alta:
+
+        const size_t edge_count = triangle_count * 3;
+        uint64_t   * edges      = arena.allocate< uint64_t > (edge_count);
+
+        for (size_t t = 0; t < triangle_count; ++t)
+        {
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                uint64_t a = canonical[triangles[t * 3 + corner]];
+                uint64_t b = canonical[triangles[t * 3 + (corner + 1) % 3]];
+                edges[t * 3 + corner] = std::min (a, b) << 32 | std::max (a, b);
+            }
+        }
+
+        std::sort (edges, edges + edge_count);
+
+        uint8_t * border = arena.allocate< uint8_t > (vertex_count);
+        std::fill (border, border + vertex_count, uint8_t(0));
+
+        for (size_t i = 0; i < edge_count; )
+        {
+            size_t j = i + 1;
+            while (j < edge_count && edges[j] == edges[i]) ++j;
+
+            if (j - i == 1)
+            {
+                border[edges[i] >> 32        ] = 1;
+                border[edges[i] & 0xFFFFFFFFu] = 1;
+            }
+
+            i = j;
+        }
+
+        for (size_t v = 0; v < vertex_count; ++v)
+        {
+            if (border[canonical[v]]) locked[v] = 1;
+        }
+    }
+
+    void Mesh_Simplifier::compute_quadrics ()
+    {
+        for (size_t t = 0; t < triangle_count * 3; t += 3)
+        {
+            const vec3 & p0 = positions[triangles[t + 0]];
+            const vec3 & p1 = positions[triangles[t + 1]];
+            const vec3 & p2 = positions[triangles[t + 2]];
+
+            vec3  normal = glm::cross (p1 - p0, p2 - p0);
+            float length = glm::length (normal);
+
+            if (length == 0.f) continue;
+
+            // Cuádrica del plano del triángulo ponderada por su área:
+
+            double area = length * 0.5;
+            double a = normal.x / length;
+            double b = normal.y / length;
+            double c = normal.z / length;
+            double d = -(a * p0.x + b * p0.y + c * p0.z);
+
+            Quadric plane
+            {
+                a * a * area, a * b * area, a * c * area, a * d * area,
+                b * b * area, b * c * area, b * d * area,
+                c * c * area, c * d * area,
+                d * d * area,
+                area
+            };
+
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                Quadric & q = quadrics[triangles[t + corner]];
+
+                q.a2 += plane.a2; q.ab += plane.ab; q.ac += plane.ac; q.ad += plane.ad;
+                q.b2 += plane.b2; q.bc += plane.bc; q.bd += plane.bd;
+                q.c2 += plane.c2; q.cd += plane.cd;
+                q.d2 += plane.d2;
+                q.area += plane.area;
+            }
+        }
+    }
+
+    double Mesh_Simplifier::quadric_error (unsigned from, unsigned to) const
+    {
+        const Quadric & q0 = quadrics[from];
+        const Quadric & q1 = quadrics[to  ];
+        const vec3    & p  = positions[to ];
+
+        double x = p.x, y = p.y, z = p.z;
+
+        double error =
+              (q0.a2 + q1.a2) * x * x + 2 * (q0.ab + q1.ab) * x * y + 2 * (q0.ac + q1.ac) * x * z + 2 * (q0.ad + q1.ad) * x
+            + (q0.b2 + q1.b2) * y * y + 2 * (q0.bc + q1.bc) * y * z + 2 * (q0.bd + q1.bd) * y
+            + (q0.c2 + q1.c2) * z * z + 2 * (q0.cd + q1.cd) * z
+            + (q0.d2 + q1.d2);
+
+        return std::max (error, 0.0);
+    }
+
+    float Mesh_Simplifier::collapse_cost (unsigned from, unsigned to) const
+    {
+        // Penalización por la diferencia de UVs entre los dos extremos de la arista:
+
+        vec2 uv_delta = uvs[from] - uvs[to];
+
+        return float(quadric_error (from, to)) + uv_weight * glm::dot (uv_delta, uv_delta);
+    }
+
+    void Mesh_Simplifier::fill_queue ()
+    {
+        // Un colapso por sentido de cada arista de los triángulos vivos (dos si la arista es de
+        // dos triángulos), con el coste actual. Las entradas anteriores se descartan:
+
+        queue_size = 0;
+
+        for (unsigned v = 0; v < vertex_count; ++v)
+        {
+            if (!vertex_alive[v] || locked[v]) continue;
+
+            for_each_triangle (v, [this, v] (unsigned t)
+            {
+                for (unsigned corner = 0; corner < 3; ++corner)
+                {
+                    unsigned other = triangles[t * 3 + corner];
+
+                    if (other != v) queue[queue_size++] = { collapse_cost (v, other), v, other };
+                }
+
+                return true;
+            });
+        }
+
+        std::make_heap (queue, queue + queue_size);
+    }
+
+    void Mesh_Simplifier::push (const Collapse & collapse)
+    {
+        // La cola llena se rehace con las aristas actuales, que ya incluyen este colapso con
+        // su coste al día, en lugar de crecer:
+
+        if (queue_size == queue_capacity)
+        {
+            fill_queue ();
+            return;
+        }
+
+        queue[queue_size++] = collapse;
+        std::push_heap (queue, queue + queue_size);
+    }
+
+    void Mesh_Simplifier::push_collapses (unsigned vertex)
+    {
+        for_each_triangle (vertex, [this, vertex] (unsigned t)
+        {
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                unsigned other = triangles[t * 3 + corner];
+
+                if (other == vertex) continue;
+
+                if (!locked[vertex]) push ({ collapse_cost (vertex, other), vertex, other });
+                if (!locked[other ]) push ({ collapse_cost (other, vertex), other, vertex });
+            }
+
+            return true;
+        });
+    }
+
+    bool Mesh_Simplifier::flips_triangles (unsigned from, unsigned to) const
+    {
+        bool adjacent = false;
+        bool flips    = false;
+
+        for_each_triangle (from, [&] (unsigned t)
+        {
+            const GLuint * corners = &triangles[t * 3];
+
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+            {
+                adjacent = true;
+                return true;
+            }
+
+            vec3 before[3], after[3];
+
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                before[corner] = positions[corners[corner]];
+                after [corner] = positions[corners[corner] == from ? to : corners[corner]];
+            }
+
+            vec3 normal_before = glm::cross (before[1] - before[0], before[2] - before[0]);
+            vec3 normal_after  = glm::cross (after [1] - after [0], after [2] - after [0]);
+
+            flips = glm::dot (normal_before, normal_after) <= 0.f;
+
+            return !flips;
+        });
+
+        // Si los vértices ya no comparten ningún triángulo la arista ha desaparecido:
+
+        return flips || !adjacent;
+    }
+
+    void Mesh_Simplifier::collapse (unsigned from, unsigned to)
+    {
+        Quadric & q0 = quadrics[from];
+        Quadric & q1 = quadrics[to  ];
+
+        q1.a2 += q0.a2; q1.ab += q0.ab; q1.ac += q0.ac; q1.ad += q0.ad;
+        q1.b2 += q0.b2; q1.bc += q0.bc; q1.bd += q0.bd;
+        q1.c2 += q0.c2; q1.cd += q0.cd;
+        q1.d2 += q0.d2;
+        q1.area += q0.area;
+
+        for_each_triangle (from, [this, from, to] (unsigned t)
+        {
+            GLuint * corners = &triangles[t * 3];
+
+            if (corners[0] == to || corners[1] == to || corners[2] == to)
+            {
+                triangle_alive[t] = 0;
+                --alive_triangle_count;
+                return true;
+            }
+
+            for (unsigned corner = 0; corner < 3; ++corner)
+            {
+                if (corners[corner] == from) corners[corner] = to;
+            }
+
+            return true;
+        });
+
+        // Los triángulos de from ahora usan to, así que su cadena se engancha a la de to:
+
+        vertex_alive[from] = 0;
+
+        next_merged[last_merged[to]] = from;
+        last_merged[to]              = last_merged[from];
+
+        push_collapses (to);
+    }
+
+    float Mesh_Simplifier::simplify (size_t target_index_count)
+    {
+        while (alive_triangle_count * 3 > target_index_count && queue_size > 0)
+        {
+            std::pop_heap (queue, queue + queue_size);
+            Collapse candidate = queue[--queue_size];
+
+            if (!vertex_alive[candidate.from] || !vertex_alive[candidate.to]) continue;
+
+            // Las cuádricas pueden haber cambiado desde que se encoló el colapso. Si el coste ha
+            // subido se vuelve a encolar con el valor actual:
+
+            float cost = collapse_cost (candidate.from, candidate.to);
+
+            if (cost > candidate.cost * 1.0001f + 1e-12f)
+            {
+                push ({ cost, candidate.from, candidate.to });
+                continue;
+            }
+
+            if (flips_triangles (candidate.from, candidate.to)) continue;
+
+            // El coste mezcla área y UVs, así que no es una distancia. Dividiendo la cuádrica
+            // entre el área acumulada queda el cuadrado de la distancia media a los planos:
+
+            double area     = quadrics[candidate.from].area + quadrics[candidate.to].area;
+            float  distance = area > 0.0 ? float(std::sqrt (quadric_error (candidate.from, candidate.to) / area)) : 0.f;
+
+            collapse (candidate.from, candidate.to);
+
+            max_error = std::max (max_error, distance);
+        }
+
+        return max_error;
+    }
+
+    void Mesh_Simplifier::copy_indices (GLuint * destination) const
+    {
+        for (size_t t = 0; t < triangle_count; ++t)
+        {
+            if (triangle_alive[t])
+            {
+                destination = std::copy (&triangles[t * 3], &triangles[t * 3] + 3, destination);
+            }
+        }
+    }
+
+    void Mesh_Simplifier::build_lod_chain
+    (
+        const vec3            * positions,
+        const vec2            * uvs,
+        size_t                  vertex_count,
+        const GLuint          * indices,
+        size_t                  index_count,
+        unsigned                max_lod_count,
+        Linear_Arena          & arena,
+        std::vector< GLuint > & output,
+        std::vector< Lod    > & lods
+    )
+    {
+        lods.clear ();
+        lods.push_back ({ output.size (), index_count, 0.f });
+
+        output.insert (output.end (), indices, indices + index_count);
+
+        if (max_lod_count < 2 || index_count / 3 < minimum_triangle_count * 2) return;
+
+        arena.reset ();
+
+        {
+            Mesh_Simplifier simplifier(positions, uvs, vertex_count, indices, index_count, arena);
+
+            while (lods.size () < max_lod_count)
+            {
+                size_t previous_count = lods.back ().index_count;
+                size_t target_count   = previous_count / 6 * 3;
+
+                if (target_count / 3 < minimum_triangle_count) break;
+
+                float error = simplifier.simplify (target_count);
+
+                // Si el simplificador se ha quedado sin colapsos válidos no merece la pena otro nivel:
+
+                if (simplifier.get_index_count () > previous_count * 9 / 10) break;
+
+                lods.push_back ({ output.size (), simplifier.get_index_count (), error });
+
+                output.resize (output.size () + simplifier.get_index_count ());
+
+                simplifier.copy_indices (&output[lods.back ().index_offset]);
+            }
+        }
+
+        arena.reset ();
+    }
+
+}
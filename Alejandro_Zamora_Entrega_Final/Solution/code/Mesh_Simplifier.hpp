@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+#include <Linear_Arena.hpp>
+
+namespace udit
+{
+
+    // Simplificador por colapso de aristas guiado por cuádricas de error (Garland-Heckbert).
+    // Los vértices se colapsan siempre sobre otro vértice existente, de modo que todos los
+    // niveles de detalle pueden compartir el mismo vertex buffer y sólo cambian los índices.
+    // Los vértices de costura de UVs y los de borde se bloquean para no deformar el mapeado.
+    //
+    // Todas las estructuras se toman de una Linear_Arena, de modo que simplificar muchas
+    // submallas seguidas no genera tráfico en el heap. La adyacencia es fija (formato CSR) y al
+    // colapsar un vértice su lista se encadena a la del vértice destino. La cola de colapsos
+    // también tiene capacidad fija: cuando se llena se reconstruye sólo con las aristas vivas.
+
+    class Mesh_Simplifier
+    {
+    public:
+
+        struct Lod
+        {
+            size_t index_offset;                    // Posición de sus índices en el búfer de salida
+            size_t index_count;
+            float  error;                           // Distancia máxima a los planos originales, en unidades del objeto
+        };
+
+        static constexpr size_t minimum_triangle_count = 32;
+
+    private:
+
+        struct Quadric
+        {
+            double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+            double area;                            // Suma de las áreas que ponderan los planos
+        };
+
+        struct Collapse
+        {
+            float    cost;
+            unsigned from;
+            unsigned to;
+
+            bool operator < (const Collapse & other) const
+            {
+                return cost > other.cost;           // Cola de prioridad de mínimos
+            }
+        };
+
+    private:
+
+        const glm::vec3 * positions;
+        const glm::vec2 * uvs;
+        size_t            vertex_count;
+        size_t            triangle_count;
+
+        GLuint          * triangles;
+        uint8_t         * triangle_alive;
+        unsigned        * adjacency_offsets;        // Triángulos de cada vértice en adjacency
+        unsigned        * adjacency;
+        unsigned        * next_merged;              // Cadena de vértices colapsados sobre cada vértice
+        unsigned        * last_merged;
+        Quadric         * quadrics;
+        uint8_t         * locked;
+        uint8_t         * vertex_alive;
+
+        Collapse        * queue;                    // Montículo con las entradas obsoletas que aún no se han sacado
+        size_t            queue_size;
+        size_t            queue_capacity;
+
+        size_t alive_triangle_count;
+        float  uv_weight;
+        float  max_error;
+
+    public:
+
+        Mesh_Simplifier
+        (
+            const glm::vec3 * positions,
+            const glm::vec2 * uvs,
+            size_t            vertex_count,
+            const GLuint    * indices,
+            size_t            index_count,
+            Linear_Arena    & arena
+        );
+
+        // Memoria que toma de la arena un simplificador con esas dimensiones:
+
+        static size_t get_arena_size (size_t vertex_count, size_t index_count);
+
+        // Máximo de índices que build_lod_chain añade a output para una submalla de
+        // index_count índices:
+
+        static size_t get_output_size (size_t index_count, unsigned max_lod_count);
+
+        // Colapsa aristas hasta que queden target_index_count índices o menos (o hasta que no
+        // quede ningún colapso válido). Devuelve el error máximo hasta el momento: la distancia
+        // cuadrática media (ponderada por área) de los vértices colapsados a los planos originales.
+
+        float simplify (size_t target_index_count);
+
+        // Copia los índices de los triángulos que quedan (get_index_count() en total):
+
+        void copy_indices (GLuint * destination) const;
+
+        size_t get_index_count () const
+        {
+            return alive_triangle_count * 3;
+        }
+
+        // Genera una cadena de LODs reduciendo a la mitad el número de triángulos en cada nivel.
+        // El nivel 0 es siempre la malla original con error 0. Los índices de todos los niveles
+        // se añaden a output y lods se sustituye por sus rangos; ambos se pueden reutilizar
+        // entre submallas. La arena se rebobina antes de retornar.
+
+        static void build_lod_chain
+        (
+            const glm::vec3       * positions,
+            const glm::vec2       * uvs,
+            size_t                  vertex_count,
+            const GLuint          * indices,
+            size_t                  index_count,
+            unsigned                max_lod_count,
+            Linear_Arena          & arena,
+            std::vector< GLuint > & output,
+            std::vector< Lod    > & lods
+        );
+
+    private:
+
+        template< typename FUNCTION >
+        void  for_each_triangle      (unsigned vertex, FUNCTION && function) const;
+
+        void  lock_seams_and_borders (Linear_Arena & arena);
+        void  compute_quadrics       ();
+        void  fill_queue             ();
+        void  push                   (const Collapse & collapse);
+        void  push_collapses         (unsigned vertex);
+        double quadric_error         (unsigned from, unsigned to) const;
+        float collapse_cost          (unsigned from, unsigned to) const;
+        bool  flips_triangles        (unsigned from, unsigned to) const;
+        void  collapse               (unsigned from, unsigned to);
+
+    };
+
+}
@@ -1,25 +1,153 @@
 #include "Model.hpp"
 
+#include <algorithm>
+
 using namespace udit;
 
-Model::Model(const std::string& tex_file_path, const std::string& mesh_file_path): texture(tex_file_path), mesh(mesh_file_path)
+Model::Model(const std::string& tex_file_path, const std::string& mesh_file_path)
+    : mesh(std::make_shared<Mesh>(mesh_file_path)), instance_vbo(0), instance_capacity(0), registry(nullptr), texture_path(tex_file_path), streamer(nullptr), texture(std::make_shared<Texture>(tex_file_path))
 {
 }
 
-void Model::render(const glm::mat4& model_view, const glm::mat4& projection)
+// La malla y la textura se comparten con los demás modelos que usan los mismos archivos. Si
+// aún no estaban cargadas se cargan en segundo plano y aparecen en cuanto el loader las sube
+Model::Model(Asset_Registry& registry, const std::string& tex_file_path, const std::string& mesh_file_path)
+    : mesh(registry.get_mesh(mesh_file_path)), instance_vbo(0), instance_capacity(0), registry(&registry), texture_path(tex_file_path), streamer(nullptr), texture(registry.get_texture(tex_file_path))
+{
+}
+
+void Model::set_streamer(Texture_Streamer& texture_streamer)
+{
+    streamer = &texture_streamer;
+    streamer->track(texture);
+}
+
+void Model::update_materials()
+{
+    if (materials || !mesh->is_ready()) return;
+
+    const std::vector<std::string>& material_textures = mesh->get_material_textures();
+
+    if (std::all_of(material_textures.begin(), material_textures.end(), [](const std::string& path) { return path.empty(); }))
+        return;
+
+    // Una capa por material. Los que no tienen textura usan la del modelo
+    std::vector<std::string> layers(material_textures);
+
+    for (auto& path : layers)
+        if (path.empty()) path = texture_path;
+
+    if (registry)
+    {
+        materials = registry->get_materials(layers);
+    }
+    else
+    {
+        materials = std::make_shared<Material_Array>();
+        materials->upload(*Material_Array::load_layers(layers));
+    }
+}
+
+GLuint Model::bind_program(bool instanced)
 {
-    glUseProgram(texture.program_id);
+    update_materials();
 
-    // Activar textura
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture.GetTexId());
-    glUniform1i(glGetUniformLocation(texture.program_id, "sampler"), 0);
+
+    // Con materiales todas las submallas leen del mismo array, así que no hay que cambiar de
+    // textura entre ellas
+    if (materials)
+    {
+        GLuint program_id = instanced ? materials->get_instanced_program_id() : materials->get_program_id();
+
+        glUseProgram(program_id);
+        materials->bind();
+
+        return program_id;
+    }
+
+    GLuint program_id = instanced ? texture->instanced_program_id : texture->program_id;
+
+    glUseProgram(program_id);
+    glBindTexture(GL_TEXTURE_2D, texture->GetTexId());
+
+    return program_id;
+}
+
+void Model::render(const glm::mat4& model_view, const glm::mat4& projection)
+{
+    // Activar programa y textura
+    GLuint program_id = bind_program(false);
 
     // Enviar matrices al shader
-    glUniformMatrix4fv(glGetUniformLocation(texture.program_id, "model_view_matrix"), 1, GL_FALSE, glm::value_ptr(model_view));
-    glUniformMatrix4fv(glGetUniformLocation(texture.program_id, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "model_view_matrix"), 1, GL_FALSE, glm::value_ptr(model_view));
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    // Se pide el mipmap que corresponde al tamaño en pantalla
+    if (streamer && !materials && is_ready())
+        streamer->request(*texture, mesh->get_uv_density(), mesh->get_pixels_per_unit(model_view, projection));
 
-    // Renderizar la malla
-    mesh.render();
+    // Renderizar la malla con un único multi-draw
+    mesh->render(model_view, projection);
+}
+
+Model::~Model()
+{
+    if (instance_vbo) glDeleteBuffers(1, &instance_vbo);
 }
 
+void Model::render_instanced(const Instance_Transform* transforms, size_t count, const glm::mat4& view, const glm::mat4& projection, unsigned lod)
+{
+    if (!is_ready() || count == 0) return;
+
+    if (!instance_vbo) glGenBuffers(1, &instance_vbo);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+
+    // El búfer sólo se reserva de nuevo cuando crece. Cada frame se invalida al mapearlo, de modo
+    // que el driver puede entregar memoria nueva sin esperar a que la GPU termine con la anterior
+    if (count > instance_capacity)
+    {
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+        instance_capacity = count;
+    }
+
+    void* matrices = glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    if (!matrices) return;
+
+    // Las matrices se componen directamente en la memoria del búfer, sin copia intermedia
+    compose_transforms(transforms, count, static_cast<glm::mat4*>(matrices));
+
+    if (!glUnmapBuffer(GL_ARRAY_BUFFER)) return;
+
+    // Todas las copias comparten la textura, así que se pide el mipmap de la más cercana
+    if (streamer && !materials)
+    {
+        size_t nearest   = 0;
+        float  nearest_q = -1.f;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float distance = glm::length(glm::vec3(view * glm::vec4(transforms[i].position, 1.f)));
+            const float q        = transforms[i].scale / std::max(distance, 1e-3f);
+
+            if (q > nearest_q)
+            {
+                nearest   = i;
+                nearest_q = q;
+            }
+        }
+
+        glm::mat4 model_view = glm::scale(glm::translate(view, transforms[nearest].position), glm::vec3(transforms[nearest].scale));
+
+        streamer->request(*texture, mesh->get_uv_density(), mesh->get_pixels_per_unit(model_view, projection));
+    }
+
+    GLuint program_id = bind_program(true);
+
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "view_matrix"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    mesh->render_instanced(instance_vbo, GLsizei(count), lod);
+}
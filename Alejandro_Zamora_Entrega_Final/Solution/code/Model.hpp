@@ -1,17 +1,48 @@
+#pragma once
 
+#include <memory>
 #include <string>
 
+#include "Asset_Registry.hpp"
+#include "Material_Array.hpp"
 #include "Mesh.hpp"
 #include "Texture.hpp"
+#include "Texture_Streamer.hpp"
+#include <Transform_Batch.hpp>
 
 using namespace udit;
 
 class Model
 {
 private:
-	Mesh mesh;
+	std::shared_ptr<Mesh> mesh;
+	GLuint instance_vbo;				// Matrices de modelo por instancia, se rellena cada frame
+	size_t instance_capacity;
+	Asset_Registry* registry;			// Nulo si el modelo carga sus recursos por su cuenta
+	std::string texture_path;			// Capa para los materiales sin textura propia
+	std::shared_ptr<Material_Array> materials;	// Sólo si la malla tiene materiales con textura
+	Texture_Streamer* streamer;			// Nulo si la textura está siempre entera en la GPU
+
+	// Crea el array de materiales la primera vez que la malla está lista
+	void update_materials();
+
+	// Activa el programa y la textura (o el array de materiales) y devuelve el programa
+	GLuint bind_program(bool instanced);
 public:
-	Texture texture;
+	std::shared_ptr<Texture> texture;
 	void render(	const glm::mat4& model_view, const glm::mat4& projection);
 	Model(const std::string& tex_file_path, const std::string& mesh_file_path);
+	Model(Asset_Registry& registry, const std::string& tex_file_path, const std::string& mesh_file_path);
+	bool is_ready() const { return mesh->is_ready(); }
+	const std::shared_ptr<Mesh>& get_mesh() const { return mesh; }
+
+	// Los mipmaps de la textura se cargan y descargan según el tamaño con que se dibuja
+	void set_streamer(Texture_Streamer& texture_streamer);
+
+	// Dibuja una copia por transformación con una sola llamada por submalla
+	void render_instanced(const Instance_Transform* transforms, size_t count, const glm::mat4& view, const glm::mat4& projection, unsigned lod = 0);
+
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+	~Model();
 };
\ No newline at end of file
@@ -0,0 +1,835 @@
+#include "Obj_File.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+
+#include <Mapped_File.hpp>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        // Referencia a un vértice o UV tal y como aparece en el archivo. Las referencias
+        // negativas son relativas al número de elementos leídos hasta esa línea, que en un
+        // trozo sólo se conoce localmente, así que se guardan relativas al inicio del trozo:
+
+        struct Reference
+        {
+            int64_t value;
+            bool    chunk_relative;
+        };
+
+        struct Corner
+        {
+            Reference position;
+            Reference uv;                           // value < 0 y no relativa si no hay UV
+        };
+
+        // Línea o, g o usemtl, que puede empezar una submalla nueva antes del triángulo dado
+        // (contado desde el inicio del trozo):
+
+        struct Event
+        {
+            enum Type { OBJECT, GROUP, MATERIAL };
+
+            Type        type;
+            size_t      triangle;
+            std::string name;
+        };
+
+        // Submalla en construcción, con sus triángulos contiguos en el archivo. object es el
+        // objeto al que la asigna Assimp, que decide el orden de salida:
+
+        struct Run
+        {
+            uint32_t object;
+            uint32_t material;
+            size_t   first_triangle;
+            size_t   end_triangle;
+        };
+
+        struct Chunk
+        {
+            const char                 * begin;
+            const char                 * end;
+            std::vector< glm::vec3 >     positions;
+            std::vector< glm::vec2 >     uvs;
+            std::vector< Corner >        corners;   // Ya triangulados, tres por triángulo
+            std::vector< Event >         events;
+            std::vector< std::string >   material_libraries;
+            bool                         failed = false;
+        };
+
+        constexpr uint32_t missing_uv = std::numeric_limits< uint32_t >::max ();
+
+        inline bool is_space (char character)
+        {
+            return character == ' ' || character == '\t' || character == '\r';
+        }
+
+        inline const char * skip_spaces (const char * current, const char * end)
+        {
+            while (current < end && is_space (*current)) ++current;
+            return current;
+        }
+
+        // Conversión rápida de texto a float. Acumula hasta 19 dígitos significativos en un
+        // entero y, si caben en la mantisa de un double y la potencia de 10 es exacta (como en
+        // el método de Clinger), el producto o cociente en doble precisión está bien redondeado.
+        // Pasarlo después a float sólo puede dar un resultado distinto del correcto si el double
+        // cae justo en el punto medio entre dos floats; en ese caso, y en los demás que se salen
+        // del camino rápido, se recurre a strtof:
+
+        const char * parse_float (const char * current, const char * end, float & value)
+        {
+            static const double powers_of_10[] =
+            {
+                1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            const char * start    = current;
+            bool         negative = false;
+
+            if (current < end && (*current == '-' || *current == '+')) negative = *current++ == '-';
+
+            uint64_t mantissa = 0;
+            int      exponent = 0;
+            int      digits   = 0;
+            bool     any      = false;
+
+            for ( ; current < end && unsigned(*current - '0') < 10; ++current, any = true)
+            {
+                if (digits < 19) { mantissa = mantissa * 10 + unsigned(*current - '0'); if (mantissa) ++digits; }
+                else             { ++exponent; }
+            }
+
+            if (current < end && *current == '.')
+            {
+                for (++current; current < end && unsigned(*current - '0') < 10; ++current, any = true)
+                {
+                    if (digits < 19) { mantissa = mantissa * 10 + unsigned(*current - '0'); --exponent; if (mantissa) ++digits; }
+                }
+            }
+
+            if (any && current < end && (*current == 'e' || *current == 'E'))
+            {
+                const char * exponent_start = ++current;
+                bool         exponent_negative = false;
+                int          exponent_value    = 0;
+
+                if (current < end && (*current == '-' || *current == '+')) exponent_negative = *current++ == '-';
+
+                if (current < end && unsigned(*current - '0') < 10)
+                {
+                    for ( ; current < end && unsigned(*current - '0') < 10; ++current)
+                    {
+                        if (exponent_value < 10000) exponent_value = exponent_value * 10 + (*current - '0');
+                    }
+
+                    exponent += exponent_negative ? -exponent_value : exponent_value;
+                }
+                else
+                {
+                    current = exponent_start - 1;
+                }
+            }
+
+            if (!any) return nullptr;
+
+            if (mantissa == 0)
+            {
+                value = negative ? -0.f : 0.f;
+                return current;
+            }
+
+            if (mantissa <= uint64_t(1) << 53 && exponent >= -22 && exponent <= 22)
+            {
+                const double result = exponent < 0 ? double(mantissa) / powers_of_10[-exponent] : double(mantissa) * powers_of_10[exponent];
+
+                // Los 29 bits de la mantisa del double que no caben en la del float no pueden
+                // ser exactamente un medio (fuera del rango normal de float no se comprueba):
+
+                uint64_t bits;
+                std::memcpy (&bits, &result, sizeof(bits));
+
+                if (result >= double(std::numeric_limits< float >::min ()) && result <= double(std::numeric_limits< float >::max ())
+                 && (bits & 0x1FFFFFFF) != 0x10000000)
+                {
+                    value = float(negative ? -result : result);
+                    return current;
+                }
+            }
+
+            // strtof necesita la cadena terminada en un carácter nulo:
+
+            const size_t length = size_t(current - start);
+            char         buffer[64];
+
+            if (length < sizeof(buffer))
+            {
+                std::memcpy (buffer, start, length);
+                buffer[length] = 0;
+
+                value = std::strtof (buffer, nullptr);
+            }
+            else
+            {
+                value = std::strtof (std::string(start, current).c_str (), nullptr);
+            }
+
+            return current;
+        }
+
+        const char * parse_integer (const char * current, const char * end, int64_t & value)
+        {
+            bool negative = false;
+
+            if (current < end && (*current == '-' || *current == '+')) negative = *current++ == '-';
+
+            if (current == end || unsigned(*current - '0') >= 10) return nullptr;
+
+            value = 0;
+
+            for ( ; current < end && unsigned(*current - '0') < 10; ++current) value = value * 10 + (*current - '0');
+
+            if (negative) value = -value;
+
+            return current;
+        }
+
+        Reference make_reference (int64_t value, size_t local_count)
+        {
+            // Los índices OBJ empiezan en 1; los negativos cuentan hacia atrás desde el último:
+
+            return value < 0 ? Reference{ int64_t(local_count) + value, true } : Reference{ value - 1, false };
+        }
+
+        void parse_chunk (Chunk & chunk)
+        {
+            const char * current = chunk.begin;
+            const char * end     = chunk.end;
+
+            std::vector< Corner > face;
+
+            while (current < end)
+            {
+                const char * line_end = static_cast< const char * >(std::memchr (current, '\n', size_t(end - current)));
+
+                if (!line_end) line_end = end;
+
+                const char * c = skip_spaces (current, line_end);
+
+                current = line_end + 1;
+
+                if (c + 1 >= line_end) continue;
+
+                if (c[0] == 'v' && is_space (c[1]))
+                {
+                    glm::vec3 position(0.f);
+
+                    c = skip_spaces (c + 2, line_end);
+
+                    for (unsigned i = 0; i < 3 && c; ++i) c = parse_float (skip_spaces (c, line_end), line_end, position[i]);
+
+                    if (!c) { chunk.failed = true; return; }
+
+                    chunk.positions.push_back (position);
+                }
+                else
+                if (c[0] == 'v' && c[1] == 't' && c + 2 < line_end && is_space (c[2]))
+                {
+                    glm::vec2 uv(0.f);
+
+                    c = skip_spaces (c + 3, line_end);
+
+                    // La segunda coordenada es opcional en el formato:
+
+                    c = parse_float (c, line_end, uv.x);
+
+                    if (!c) { chunk.failed = true; return; }
+
+                    c = skip_spaces (c, line_end);
+
+                    if (c < line_end && *c != '#') parse_float (c, line_end, uv.y);
+
+                    chunk.uvs.push_back (uv);
+                }
+                else
+                if (c[0] == 'f' && is_space (c[1]))
+                {
+                    face.clear ();
+
+                    for (c = skip_spaces (c + 2, line_end); c < line_end && *c != '#'; c = skip_spaces (c, line_end))
+                    {
+                        int64_t position_index, uv_index;
+
+                        if (!(c = parse_integer (c, line_end, position_index))) { chunk.failed = true; return; }
+
+                        Corner corner{ make_reference (position_index, chunk.positions.size ()), { -1, false } };
+
+                        if (c < line_end && *c == '/')
+                        {
+                            ++c;
+
+                            if (c < line_end && *c != '/')
+                            {
+                                if (!(c = parse_integer (c, line_end, uv_index))) { chunk.failed = true; return; }
+
+                                corner.uv = make_reference (uv_index, chunk.uvs.size ());
+                            }
+
+                            // La normal (si la hay) no se usa:
+
+                            if (c < line_end && *c == '/')
+                            {
+                                ++c;
+                                while (c < line_end && !is_space (*c)) ++c;
+                            }
+                        }
+
+                        face.push_back (corner);
+                    }
+
+                    // Los polígonos se triangulan en abanico:
+
+                    for (size_t i = 2; i < face.size (); ++i)
+                    {
+                        chunk.corners.push_back (face[0    ]);
+                        chunk.corners.push_back (face[i - 1]);
+                        chunk.corners.push_back (face[i    ]);
+                    }
+                }
+                else
+                if ((c[0] == 'o' || c[0] == 'g') && is_space (c[1]))
+                {
+                    const char * name_begin = skip_spaces (c + 2, line_end);
+                    const char * name_end   = line_end;
+
+                    while (name_end > name_begin && is_space (name_end[-1])) --name_end;
+
+                    if (name_end > name_begin)
+                    {
+                        chunk.events.push_back ({ c[0] == 'o' ? Event::OBJECT : Event::GROUP, chunk.corners.size () / 3, std::string(name_begin, name_end) });
+                    }
+                }
+                else
+                if (line_end - c > 7 && std::strncmp (c, "usemtl", 6) == 0 && is_space (c[6]))
+                {
+                    const char * name_begin = skip_spaces (c + 7, line_end);
+                    const char * name_end   = line_end;
+
+                    while (name_end > name_begin && is_space (name_end[-1])) --name_end;
+
+                    if (name_end > name_begin)
+                    {
+                        chunk.events.push_back ({ Event::MATERIAL, chunk.corners.size () / 3, std::string(name_begin, name_end) });
+                    }
+                }
+                else
+                if (line_end - c > 7 && std::strncmp (c, "mtllib", 6) == 0 && is_space (c[6]))
+                {
+                    const char * name_begin = skip_spaces (c + 7, line_end);
+                    const char * name_end   = line_end;
+
+                    while (name_end > name_begin && is_space (name_end[-1])) --name_end;
+
+                    chunk.material_libraries.emplace_back (name_begin, name_end);
+                }
+            }
+        }
+
+        inline uint64_t mix_key (uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xFF51AFD7ED558CCDull;
+            key ^= key >> 33;
+            return key;
+        }
+
+        // Asigna a cada esquina la primera esquina con la misma clave dentro de su submalla
+        // (groups), de modo que todas las submallas se unen en una sola pasada. Cada fragmento
+        // de la tabla hash lo construye un hilo distinto:
+
+        void weld_vertices
+        (
+            const std::vector< uint64_t > & keys,
+            const std::vector< uint32_t > & groups,
+            std::vector< uint32_t >       & first_corner,
+            Thread_Pool                   & thread_pool
+        )
+        {
+            constexpr unsigned shard_bits  = 5;
+            constexpr unsigned shard_count = 1u << shard_bits;
+
+            first_corner.resize (keys.size ());
+
+            // Primero se calcula el hash de cada clave una sola vez:
+
+            std::vector< uint64_t > hashes(keys.size ());
+
+            thread_pool.parallel_for (keys.size (), [&] (size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i) hashes[i] = mix_key (keys[i] + groups[i] * 0x9E3779B97F4A7C15ull);
+            });
+
+            // Se reparten las esquinas por fragmento con una ordenación por cuentas, que mantiene
+            // el orden original dentro de cada fragmento:
+
+            std::vector< size_t   > shard_start(shard_count + 1, 0);
+            std::vector< uint32_t > members    (keys.size ());
+
+            for (uint64_t hash : hashes) ++shard_start[(hash >> (64 - shard_bits)) + 1];
+
+            for (unsigned shard = 0; shard < shard_count; ++shard) shard_start[shard + 1] += shard_start[shard];
+
+            {
+                std::vector< size_t > cursor(shard_start.begin (), shard_start.end () - 1);
+
+                for (size_t i = 0; i < keys.size (); ++i) members[cursor[hashes[i] >> (64 - shard_bits)]++] = uint32_t(i);
+            }
+
+            thread_pool.parallel_for (shard_count, [&] (size_t shard_begin, size_t shard_end)
+            {
+                // Las tablas se reservan una vez para el fragmento más grande del bloque:
+
+                size_t largest_shard = 0;
+
+                for (size_t shard = shard_begin; shard < shard_end; ++shard)
+                {
+                    largest_shard = std::max (largest_shard, shard_start[shard + 1] - shard_start[shard]);
+                }
+
+                size_t largest_capacity = 16;
+                while (largest_capacity < largest_shard * 2) largest_capacity <<= 1;
+
+                std::vector< uint64_t > table_keys;
+                std::vector< uint32_t > table_values;
+
+                table_keys  .reserve (largest_capacity);
+                table_values.reserve (largest_capacity);
+
+                for (size_t shard = shard_begin; shard < shard_end; ++shard)
+                {
+                    const uint32_t * shard_members = members.data () + shard_start[shard    ];
+                    const size_t     member_count  = shard_start[shard + 1] - shard_start[shard];
+
+                    size_t capacity = 16;
+                    while (capacity < member_count * 2) capacity <<= 1;
+
+                    table_keys  .assign (capacity, 0);
+                    table_values.assign (capacity, std::numeric_limits< uint32_t >::max ());
+
+                    // Direccionamiento abierto con sondeo lineal. Los miembros se recorren en
+                    // orden, así que el primero que entra es la primera aparición:
+
+                    for (size_t m = 0; m < member_count; ++m)
+                    {
+                        const uint32_t i = shard_members[m];
+
+                        size_t slot = size_t(hashes[i]) & (capacity - 1);
+
+                        while (table_values[slot] != std::numeric_limits< uint32_t >::max () && (table_keys[slot] != keys[i] || groups[table_values[slot]] != groups[i]))
+                        {
+                            slot = (slot + 1) & (capacity - 1);
+                        }
+
+                        if (table_values[slot] == std::numeric_limits< uint32_t >::max ())
+                        {
+                            table_keys  [slot] = keys[i];
+                            table_values[slot] = i;
+                        }
+
+                        first_corner[i] = table_values[slot];
+                    }
+                }
+            });
+        }
+
+        std::string trim (const std::string & text)
+        {
+            const size_t first = text.find_first_not_of (" \t\r");
+            const size_t last  = text.find_last_not_of  (" \t\r");
+
+            return first == std::string::npos ? std::string() : text.substr (first, last - first + 1);
+        }
+
+        // Lee de una biblioteca .mtl la textura difusa (map_Kd) de cada material. Las opciones
+        // del mapa (-s, -o, -bm...) se descartan y se toma la última palabra como archivo:
+
+        void read_material_library (const std::string & path, std::unordered_map< std::string, std::string > & diffuse_maps)
+        {
+            std::ifstream file(path);
+            std::string   line;
+            std::string   material;
+
+            const std::string directory = path.substr (0, path.find_last_of ("/\\") + 1);
+
+            while (std::getline (file, line))
+            {
+                line = trim (line);
+
+                if (line.compare (0, 7, "newmtl ") == 0)
+                {
+                    material = trim (line.substr (7));
+                }
+                else
+                if (line.compare (0, 7, "map_Kd ") == 0)
+                {
+                    std::string map = trim (line.substr (7));
+
+                    if (map[0] == '-') map = map.substr (map.find_last_of (" \t") + 1);
+
+                    diffuse_maps[material] = directory + map;
+                }
+            }
+        }
+
+    }
+
+    bool Obj_File::is_obj (const std::string & path)
+    {
+        return path.size () >= 4 && path.compare (path.size () - 4, 4, ".obj") == 0;
+    }
+
+    bool Obj_File::read (const std::string & path, Mesh::Data & data, Thread_Pool & thread_pool)
+    {
+        Mapped_File file(path);
+
+        if (!file.is_open ()) return false;
+
+        const char * text = reinterpret_cast< const char * >(file.data ());
+        const size_t size = file.size ();
+
+        // 1. Se divide el archivo en trozos que empiezan justo después de un salto de línea:
+
+        const size_t minimum_chunk_size = 1 << 20;
+        const size_t chunk_count        = std::max< size_t > (1, std::min< size_t > ((thread_pool.get_thread_count () + 1) * 4, size / minimum_chunk_size));
+
+        std::vector< Chunk > chunks(chunk_count);
+
+        const char * chunk_begin = text;
+
+        for (size_t i = 0; i < chunk_count; ++i)
+        {
+            const char * chunk_end = i + 1 == chunk_count ? text + size : text + size * (i + 1) / chunk_count;
+
+            if (chunk_end < chunk_begin) chunk_end = chunk_begin;
+
+            const char * newline = static_cast< const char * >(std::memchr (chunk_end, '\n', size_t(text + size - chunk_end)));
+
+            chunk_end = i + 1 == chunk_count || !newline ? text + size : newline + 1;
+
+            chunks[i].begin = chunk_begin;
+            chunks[i].end   = chunk_end;
+
+            chunk_begin = chunk_end;
+        }
+
+        // 2. Se analizan los trozos en paralelo:
+
+        thread_pool.parallel_for (chunk_count, [&chunks] (size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i) parse_chunk (chunks[i]);
+        });
+
+        // 3. Se resuelven los índices con los totales acumulados de los trozos anteriores:
+
+        std::vector< size_t > position_prefix(chunk_count + 1, 0);
+        std::vector< size_t > uv_prefix      (chunk_count + 1, 0);
+        std::vector< size_t > triangle_prefix(chunk_count + 1, 0);
+
+        for (size_t i = 0; i < chunk_count; ++i)
+        {
+            if (chunks[i].failed) return false;
+
+            position_prefix[i + 1] = position_prefix[i] + chunks[i].positions.size ();
+            uv_prefix      [i + 1] = uv_prefix      [i] + chunks[i].uvs      .size ();
+            triangle_prefix[i + 1] = triangle_prefix[i] + chunks[i].corners  .size () / 3;
+        }
+
+        const size_t position_count = position_prefix.back ();
+        const size_t uv_count       = uv_prefix      .back ();
+        const size_t triangle_count = triangle_prefix.back ();
+
+        if (triangle_count == 0 || position_count >= missing_uv || uv_count >= missing_uv) return false;
+
+        std::vector< glm::vec3 > positions(position_count);
+        std::vector< glm::vec2 > uvs      (uv_count);
+        std::vector< uint64_t  > keys     (triangle_count * 3);
+        bool                     out_of_range = false;
+
+        thread_pool.parallel_for (chunk_count, [&] (size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Chunk & chunk = chunks[i];
+
+                std::copy (chunk.positions.begin (), chunk.positions.end (), positions.begin () + position_prefix[i]);
+                std::copy (chunk.uvs      .begin (), chunk.uvs      .end (), uvs      .begin () + uv_prefix      [i]);
+
+                uint64_t * chunk_keys = &keys[triangle_prefix[i] * 3];
+
+                for (size_t c = 0; c < chunk.corners.size (); ++c)
+                {
+                    const Corner & corner = chunk.corners[c];
+
+                    int64_t position = corner.position.value + (corner.position.chunk_relative ? int64_t(position_prefix[i]) : 0);
+                    int64_t uv       = corner.uv      .value + (corner.uv      .chunk_relative ? int64_t(uv_prefix      [i]) : 0);
+
+                    bool has_uv = corner.uv.chunk_relative || corner.uv.value >= 0;
+
+                    if (position < 0 || size_t(position) >= position_count || (has_uv && (uv < 0 || size_t(uv) >= uv_count)))
+                    {
+                        out_of_range = true;
+                        return;
+                    }
+
+                    chunk_keys[c] = uint64_t(position) << 32 | (has_uv ? uint32_t(uv) : missing_uv);
+                }
+            }
+        });
+
+        if (out_of_range) return false;
+
+        // 4. Se reparten los triángulos en submallas con las reglas del lector OBJ de Assimp:
+        // cada objeto nuevo (o con un nombre que no se ha visto, o g distinto del grupo activo)
+        // empieza una submalla con el material activo, y usemtl empieza otra si cambia el
+        // material de una que ya tiene triángulos. Así los triángulos de cada submalla son
+        // contiguos en el archivo. Assimp las emite agrupadas por objeto, en el orden en que se
+        // crearon los objetos:
+
+        // Cada evento crea como mucho una submalla y un objeto, así que todo se reserva de una
+        // vez con el número de eventos. Los nombres de objeto se buscan en una tabla con
+        // direccionamiento abierto en lugar de un unordered_map, que reservaría un nodo por
+        // objeto:
+
+        size_t event_count = 0;
+
+        for (const auto & chunk : chunks) event_count += chunk.events.size ();
+
+        size_t object_capacity = 16;
+        while (object_capacity < event_count * 2) object_capacity <<= 1;
+
+        struct Object_Slot
+        {
+            const std::string * name;
+            uint32_t            id;
+        };
+
+        const std::string              default_object_name("defaultobject");
+        const std::hash< std::string > hash_name{};
+        std::vector< Object_Slot >     object_slots(object_capacity, Object_Slot{ nullptr, 0 });
+        std::vector< Run >             runs;
+
+        runs.reserve (event_count + 1);
+
+        auto find_object_slot = [&] (const std::string & name) -> Object_Slot &
+        {
+            size_t slot = hash_name (name) & (object_capacity - 1);
+
+            while (object_slots[slot].name && *object_slots[slot].name != name) slot = (slot + 1) & (object_capacity - 1);
+
+            return object_slots[slot];
+        };
+
+        std::vector< std::string >                  material_names   { std::string() };
+        std::unordered_map< std::string, uint32_t > material_ids     { { std::string(), 0u } };
+        std::string                                 active_group;
+        uint32_t                                    object_count     = 0;
+        uint32_t                                    current_object   = 0;
+        uint32_t                                    current_material = 0;
+        bool                                        has_object       = false;
+
+        auto create_object = [&] (const std::string & name)
+        {
+            Object_Slot & slot = find_object_slot (name);
+
+            if (!slot.name) slot = Object_Slot{ &name, object_count };
+
+            current_object = object_count++;
+            runs.push_back ({ current_object, current_material, 0, 0 });
+            has_object = true;
+        };
+
+        for (size_t i = 0; i < chunk_count; ++i)
+        {
+            const Chunk & chunk = chunks[i];
+            size_t        next  = triangle_prefix[i];
+
+            for (size_t e = 0; e <= chunk.events.size (); ++e)
+            {
+                const size_t until = triangle_prefix[i] + (e < chunk.events.size () ? chunk.events[e].triangle : chunk.corners.size () / 3);
+
+                // Los triángulos van siempre a la última submalla creada. Si aún no hay ningún
+                // objeto, Assimp crea uno por defecto:
+
+                if (until > next)
+                {
+                    if (!has_object) create_object (default_object_name);
+
+                    Run & run = runs.back ();
+
+                    if (run.first_triangle == run.end_triangle) run.first_triangle = next;
+
+                    run.end_triangle = next = until;
+                }
+
+                if (e == chunk.events.size ()) break;
+
+                const Event & event = chunk.events[e];
+
+                if (event.type == Event::OBJECT)
+                {
+                    // Un objeto que ya existe vuelve a ser el activo, pero la submalla no cambia
+                    // hasta el siguiente usemtl:
+
+                    const Object_Slot & found = find_object_slot (event.name);
+
+                    if (!found.name) create_object (event.name);
+                    else             current_object = found.id;
+                }
+                else
+                if (event.type == Event::GROUP)
+                {
+                    if (event.name != active_group) create_object (event.name);
+
+                    active_group = event.name;
+                }
+                else
+                {
+                    auto inserted = material_ids.emplace (event.name, uint32_t(material_names.size ()));
+
+                    if (inserted.second) material_names.push_back (event.name);
+
+                    if (inserted.first->second == current_material) continue;
+
+                    current_material = inserted.first->second;
+
+                    if (!has_object) continue;
+
+                    if (runs.back ().first_triangle != runs.back ().end_triangle)
+                    {
+                        runs.push_back ({ current_object, current_material, 0, 0 });
+                    }
+                    else
+                    {
+                        runs.back ().material = current_material;
+                    }
+                }
+            }
+        }
+
+        std::stable_sort (runs.begin (), runs.end (), [] (const Run & a, const Run & b) { return a.object < b.object; });
+
+        // Texturas difusas de los materiales, resueltas respecto a la carpeta del archivo. El
+        // material 0 (triángulos antes del primer usemtl) no tiene ninguna:
+
+        std::unordered_map< std::string, std::string > diffuse_maps;
+
+        const std::string directory = path.substr (0, path.find_last_of ("/\\") + 1);
+
+        for (const auto & chunk : chunks)
+        {
+            for (const auto & library : chunk.material_libraries) read_material_library (directory + library, diffuse_maps);
+        }
+
+        data.material_textures.assign (material_names.size (), std::string());
+
+        for (size_t m = 1; m < material_names.size (); ++m)
+        {
+            auto map = diffuse_maps.find (material_names[m]);
+
+            if (map != diffuse_maps.end ()) data.material_textures[m] = map->second;
+        }
+
+        data.positions.clear ();
+        data.uvs      .clear ();
+        data.indices  .clear ();
+        data.submeshes.clear ();
+
+        // 5. Se ordenan las claves por submalla y se unen los vértices idénticos de cada una
+        // en una sola pasada. Se numeran por orden de primera aparición dentro de su submalla:
+
+        size_t corner_count = 0;
+
+        for (const Run & run : runs) corner_count += (run.end_triangle - run.first_triangle) * 3;
+
+        std::vector< uint64_t > run_keys;
+        std::vector< uint32_t > run_of_corner;
+        std::vector< uint32_t > first_corner;
+
+        run_keys     .reserve (corner_count);
+        run_of_corner.reserve (corner_count);
+
+        for (size_t r = 0; r < runs.size (); ++r)
+        {
+            run_keys     .insert (run_keys.end (), keys.begin () + runs[r].first_triangle * 3, keys.begin () + runs[r].end_triangle * 3);
+            run_of_corner.resize (run_keys.size (), uint32_t(r));
+        }
+
+        weld_vertices (run_keys, run_of_corner, first_corner, thread_pool);
+
+        size_t vertex_total = 0;
+
+        for (size_t c = 0; c < corner_count; ++c) vertex_total += first_corner[c] == c;
+
+        data.positions.resize (vertex_total);
+        data.uvs      .resize (vertex_total);
+        data.indices  .resize (corner_count);
+        data.submeshes.reserve (runs.size ());
+
+        std::vector< uint32_t > vertex_of_corner(corner_count);
+
+        size_t corner = 0;
+        size_t vertex = 0;
+
+        for (const Run & run : runs)
+        {
+            if (run.first_triangle == run.end_triangle) continue;
+
+            const size_t first_vertex = vertex;
+            const size_t first_index  = corner;
+            const size_t end_corner   = corner + (run.end_triangle - run.first_triangle) * 3;
+
+            for ( ; corner < end_corner; ++corner)
+            {
+                if (first_corner[corner] == corner)
+                {
+                    uint64_t key = run_keys[corner];
+                    uint32_t uv  = uint32_t(key);
+
+                    data.positions[vertex] = positions[key >> 32];
+                    data.uvs      [vertex] = uv == missing_uv ? glm::vec2(0.f) : uvs[uv];
+
+                    vertex_of_corner[corner] = uint32_t(vertex++ - first_vertex);
+                }
+                else
+                {
+                    vertex_of_corner[corner] = vertex_of_corner[first_corner[corner]];
+                }
+
+                data.indices[corner] = vertex_of_corner[corner];
+            }
+
+            Mesh::SubMesh submesh;
+            submesh.base_vertex  = GLint  (first_vertex);
+            submesh.vertex_count = GLsizei(vertex - first_vertex);
+            submesh.lods.push_back ({ GLuint(first_index), GLsizei(end_corner - first_index), 0.f });
+            submesh.material     = std::min (run.material, Mesh::max_material_count - 1);
+
+            data.submeshes.push_back (submesh);
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include <Thread_Pool.hpp>
+
+#include "Mesh.hpp"
+
+namespace udit
+{
+
+    // Lector de archivos Wavefront OBJ en paralelo. El archivo se proyecta en memoria y se
+    // divide en trozos que empiezan y acaban en un salto de línea; cada trozo se analiza en un
+    // hilo con un conversor de números en coma flotante propio (bien redondeado). Después se
+    // resuelven los índices (también los relativos), se reparten los triángulos en submallas
+    // por objeto (o, g) y material (usemtl) con las mismas reglas que Assimp y se unen los
+    // vértices con la misma pareja posición/UV mediante una tabla hash repartida en fragmentos
+    // que se construyen en paralelo.
+    //
+    // Produce submallas con un único LOD, cada una con su índice de material, y la ruta de la
+    // textura difusa de cada material (map_Kd de las bibliotecas mtllib). Devuelve false si el
+    // archivo no se puede leer o tiene índices fuera de rango.
+
+    class Obj_File
+    {
+    public:
+
+        static bool is_obj (const std::string & path);
+
+        static bool read (const std::string & path, Mesh::Data & data, Thread_Pool & thread_pool);
+
+    };
+
+}
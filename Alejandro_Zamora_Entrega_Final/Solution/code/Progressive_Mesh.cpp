@@ -0,0 +1,428 @@
+#include "Progressive_Mesh.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        constexpr uint32_t file_magic   = 0x48534D50;           // "PMSH"
+        constexpr uint32_t file_version = 3;                    // 2: materiales por submalla, 3: bases tangentes
+
+        // Número de bloques: tantos como LODs tenga la submalla que más tiene:
+
+        size_t count_chunks (const std::vector< Mesh::SubMesh > & submeshes)
+        {
+            size_t chunk_count = 0;
+
+            for (const auto & submesh : submeshes) chunk_count = std::max (chunk_count, submesh.lods.size ());
+
+            return chunk_count;
+        }
+
+    }
+
+    bool Progressive_Mesh::is_progressive (const std::string & path)
+    {
+        return path.size () >= 6 && path.compare (path.size () - 6, 6, ".pmesh") == 0;
+    }
+
+    bool Progressive_Mesh::write (const std::string & path, const Mesh::Data & source)
+    {
+        Mesh::Data data = source;
+
+        // 1. Se renumeran los vértices de cada submalla por orden de primer uso, empezando por
+        //    el LOD más simple. level_ends[s][l] es el número de vértices que necesitan los
+        //    niveles l y más simples:
+
+        std::vector< std::vector< uint32_t > > level_ends(data.submeshes.size ());
+
+        for (size_t s = 0; s < data.submeshes.size (); ++s)
+        {
+            const Mesh::SubMesh & submesh      = data.submeshes[s];
+            const size_t          first_vertex = size_t(submesh.base_vertex);
+            const size_t          vertex_count = size_t(submesh.vertex_count);
+
+            constexpr GLuint unassigned = ~GLuint(0);
+
+            std::vector< GLuint > remap(vertex_count, unassigned);
+            GLuint                next = 0;
+
+            level_ends[s].resize (submesh.lods.size ());
+
+            for (size_t level = submesh.lods.size (); level-- > 0; )
+            {
+                const Mesh::Lod & lod = submesh.lods[level];
+
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    GLuint & target = remap[data.indices[lod.index_offset + i]];
+                    if (target == unassigned) target = next++;
+                }
+
+                level_ends[s][level] = next;
+            }
+
+            // Los vértices que no usa ningún triángulo van con el LOD 0:
+
+            for (auto & target : remap)
+            {
+                if (target == unassigned) target = next++;
+            }
+
+            if (!level_ends[s].empty ()) level_ends[s][0] = next;
+
+            std::vector< glm::vec3 > positions(vertex_count);
+            std::vector< glm::vec2 > uvs      (vertex_count);
+
+            for (size_t v = 0; v < vertex_count; ++v)
+            {
+                positions[remap[v]] = data.positions[first_vertex + v];
+                uvs      [remap[v]] = data.uvs      [first_vertex + v];
+            }
+
+            std::copy (positions.begin (), positions.end (), data.positions.begin () + first_vertex);
+            std::copy (uvs      .begin (), uvs      .end (), data.uvs      .begin () + first_vertex);
+
+            // Las bases tangentes, si las hay, siguen a sus vértices:
+
+            if (!data.tangent_frames.empty ())
+            {
+                std::vector< Tangent_Frame > frames(vertex_count);
+
+                for (size_t v = 0; v < vertex_count; ++v) frames[remap[v]] = data.tangent_frames[first_vertex + v];
+
+                std::copy (frames.begin (), frames.end (), data.tangent_frames.begin () + first_vertex);
+            }
+
+            for (const auto & lod : submesh.lods)
+            {
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    GLuint & index = data.indices[lod.index_offset + i];
+                    index = remap[index];
+                }
+            }
+        }
+
+        // 2. Se monta cada bloque. Los índices se recolocan para que los de un mismo bloque
+        //    queden contiguos en el element buffer y se suban con una sola llamada:
+
+        const size_t chunk_count = count_chunks (data.submeshes);
+
+        std::vector< Mesh::SubMesh >                    submeshes = data.submeshes;
+        std::vector< Mesh_Codec::Encoded_Mesh >         encoded  (chunk_count);
+        std::vector< std::vector< Mesh::Vertex_Range > > ranges   (chunk_count);
+        std::vector< uint32_t >                          index_offsets(chunk_count);
+
+        GLuint index_offset = 0;
+
+        for (size_t c = 0; c < chunk_count; ++c)
+        {
+            Mesh::Data chunk;
+
+            index_offsets[c] = index_offset;
+
+            for (size_t s = 0; s < data.submeshes.size (); ++s)
+            {
+                const Mesh::SubMesh & submesh = data.submeshes[s];
+                const size_t          levels  = submesh.lods.size ();
+
+                if (c >= levels) continue;
+
+                const size_t    level        = levels - 1 - c;
+                const Mesh::Lod lod          = submesh.lods[level];
+                const uint32_t  vertex_begin = level + 1 < levels ? level_ends[s][level + 1] : 0;
+                const uint32_t  vertex_end   = level_ends[s][level];
+                const size_t    first_vertex = size_t(submesh.base_vertex);
+
+                if (vertex_end > vertex_begin)
+                {
+                    ranges[c].push_back ({ GLint(first_vertex + vertex_begin), GLsizei(vertex_end - vertex_begin) });
+
+                    chunk.positions.insert (chunk.positions.end (), data.positions.begin () + first_vertex + vertex_begin, data.positions.begin () + first_vertex + vertex_end);
+                    chunk.uvs      .insert (chunk.uvs      .end (), data.uvs      .begin () + first_vertex + vertex_begin, data.uvs      .begin () + first_vertex + vertex_end);
+
+                    if (!data.tangent_frames.empty ())
+                    {
+                        chunk.tangent_frames.insert (chunk.tangent_frames.end (), data.tangent_frames.begin () + first_vertex + vertex_begin, data.tangent_frames.begin () + first_vertex + vertex_end);
+                    }
+                }
+
+                chunk.indices.insert (chunk.indices.end (), data.indices.begin () + lod.index_offset, data.indices.begin () + lod.index_offset + lod.index_count);
+
+                submeshes[s].lods[level].index_offset = index_offset;
+
+                index_offset += GLuint(lod.index_count);
+            }
+
+            Mesh_Codec::encode (chunk, encoded[c]);
+        }
+
+        // 3. Cabecera, tabla de bloques y contenido de cada bloque:
+
+        std::ofstream file(path, std::ios::binary);
+
+        if (!file) return false;
+
+        auto put = [&file] (const auto & value)
+        {
+            file.write (reinterpret_cast< const char * >(&value), sizeof(value));
+        };
+
+        put (file_magic);
+        put (file_version);
+        put (uint32_t(submeshes.size ()));
+        put (uint32_t(data.positions.size ()));
+        put (uint32_t(data.indices  .size ()));
+        put (data.bounding_center);
+        put (data.bounding_radius);
+        put (uint32_t(chunk_count));
+
+        for (const auto & submesh : submeshes)
+        {
+            put (submesh.base_vertex);
+            put (submesh.vertex_count);
+            put (submesh.material);
+            put (uint32_t(submesh.lods.size ()));
+
+            for (const auto & lod : submesh.lods) put (lod);
+        }
+
+        put (uint32_t(data.material_textures.size ()));
+
+        for (const auto & texture : data.material_textures)
+        {
+            put (uint32_t(texture.size ()));
+            file.write (texture.data (), std::streamsize(texture.size ()));
+        }
+
+        for (size_t c = 0; c < chunk_count; ++c)
+        {
+            put (uint32_t(ranges[c].size ()));
+            put (encoded[c].vertex_count);
+            put (index_offsets[c]);
+            put (encoded[c].index_count);
+
+            for (const auto & stream : encoded[c].streams) put (uint32_t(stream.size ()));
+
+            for (const auto & range : ranges[c]) put (range);
+        }
+
+        for (const auto & chunk : encoded)
+        {
+            for (const auto & stream : chunk.streams)
+            {
+                file.write (reinterpret_cast< const char * >(stream.data ()), std::streamsize(stream.size ()));
+            }
+        }
+
+        return bool(file);
+    }
+
+    bool Progressive_Mesh::read (const std::string & path, Mesh::Data & data)
+    {
+        Reader reader;
+
+        if (!reader.open (path)) return false;
+
+        data.submeshes         = reader.get_submeshes ();
+        data.material_textures = reader.get_material_textures ();
+        data.bounding_center = reader.get_bounding_center ();
+        data.bounding_radius = reader.get_bounding_radius ();
+
+        data.positions     .resize (reader.get_vertex_count ());
+        data.uvs           .resize (reader.get_vertex_count ());
+        data.tangent_frames.resize (reader.get_vertex_count ());
+        data.indices       .resize (reader.get_index_count  ());
+
+        Mesh::Stream_Chunk chunk;
+
+        for (size_t c = 0; c < reader.get_chunk_count (); ++c)
+        {
+            if (!reader.read_chunk (c, chunk)) return false;
+
+            size_t source = 0;
+
+            for (const auto & range : chunk.ranges)
+            {
+                std::copy_n (chunk.positions.begin () + source, range.vertex_count, data.positions.begin () + range.first_vertex);
+                std::copy_n (chunk.uvs      .begin () + source, range.vertex_count, data.uvs      .begin () + range.first_vertex);
+                std::copy_n (chunk.tangent_frames.begin () + source, range.vertex_count, data.tangent_frames.begin () + range.first_vertex);
+
+                source += size_t(range.vertex_count);
+            }
+
+            std::copy (chunk.indices.begin (), chunk.indices.end (), data.indices.begin () + chunk.index_offset);
+        }
+
+        return true;
+    }
+
+    // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+
+    bool Progressive_Mesh::Reader::open (const std::string & path)
+    {
+        if (!file.open (path)) return false;
+
+        const uint8_t * bytes  = file.data ();
+        const size_t    size   = file.size ();
+        size_t          offset = 0;
+
+        auto get = [&] (auto & value) -> bool
+        {
+            if (size - offset < sizeof(value)) return false;
+            std::memcpy (&value, bytes + offset, sizeof(value));
+            offset += sizeof(value);
+            return true;
+        };
+
+        uint32_t magic = 0, version = 0, submesh_count = 0, chunk_count = 0;
+
+        if (!get (magic) || magic != file_magic || !get (version) || version != file_version) return false;
+
+        if (!get (submesh_count)
+         || !get (vertex_count)
+         || !get (index_count)
+         || !get (bounding_center)
+         || !get (bounding_radius)
+         || !get (chunk_count)) return false;
+
+        if (submesh_count > size || chunk_count == 0 || chunk_count > Mesh::max_lod_count) return false;
+
+        submeshes.resize (submesh_count);
+
+        for (auto & submesh : submeshes)
+        {
+            uint32_t lod_count = 0;
+
+            if (!get (submesh.base_vertex) || !get (submesh.vertex_count) || !get (submesh.material) || !get (lod_count)) return false;
+
+            if (lod_count == 0 || lod_count > chunk_count || submesh.material >= Mesh::max_material_count) return false;
+
+            if (submesh.base_vertex < 0 || submesh.vertex_count < 0 || size_t(submesh.base_vertex) + size_t(submesh.vertex_count) > vertex_count) return false;
+
+            submesh.lods.count = lod_count;
+
+            for (auto & lod : submesh.lods)
+            {
+                if (!get (lod)) return false;
+
+                if (lod.index_count < 0 || size_t(lod.index_offset) + size_t(lod.index_count) > index_count) return false;
+            }
+        }
+
+        uint32_t material_count = 0;
+
+        if (!get (material_count) || material_count > Mesh::max_material_count) return false;
+
+        material_textures.resize (material_count);
+
+        for (auto & texture : material_textures)
+        {
+            uint32_t length = 0;
+
+            if (!get (length) || length > size - offset) return false;
+
+            texture.assign (reinterpret_cast< const char * >(bytes + offset), length);
+
+            offset += length;
+        }
+
+        chunks.resize (chunk_count);
+
+        for (auto & chunk : chunks)
+        {
+            if (!get (chunk.range_count)
+             || !get (chunk.vertex_count)
+             || !get (chunk.index_offset)
+             || !get (chunk.index_count)
+             || !get (chunk.stream_sizes)) return false;
+
+            if (size_t(chunk.index_offset) + chunk.index_count > index_count) return false;
+
+            chunk.range_offset = offset;
+
+            // Los rangos deben caber en el vertex buffer y sumar los vértices del bloque:
+
+            size_t range_total = 0;
+
+            for (uint32_t r = 0; r < chunk.range_count; ++r)
+            {
+                Mesh::Vertex_Range range;
+
+                if (!get (range)) return false;
+
+                if (range.first_vertex < 0 || range.vertex_count < 0 || size_t(range.first_vertex) + size_t(range.vertex_count) > vertex_count) return false;
+
+                range_total += size_t(range.vertex_count);
+            }
+
+            if (range_total != chunk.vertex_count) return false;
+        }
+
+        for (auto & chunk : chunks)
+        {
+            chunk.payload_offset = offset;
+
+            for (uint32_t stream_size : chunk.stream_sizes)
+            {
+                if (size - offset < stream_size) return false;
+                offset += stream_size;
+            }
+        }
+
+        return true;
+    }
+
+    size_t Progressive_Mesh::Reader::get_chunk_size (size_t index) const
+    {
+        const Chunk & chunk = chunks[index];
+
+        size_t size = 0;
+
+        for (uint32_t stream_size : chunk.stream_sizes) size += stream_size;
+
+        return size;
+    }
+
+    bool Progressive_Mesh::Reader::read_chunk (size_t index, Mesh::Stream_Chunk & chunk) const
+    {
+        const Chunk & entry = chunks[index];
+
+        Mesh_Codec::Encoded_Mesh encoded;
+
+        encoded.vertex_count = entry.vertex_count;
+        encoded.index_count  = entry.index_count;
+
+        const uint8_t * payload = file.data () + entry.payload_offset;
+
+        for (unsigned s = 0; s < Mesh_Codec::STREAM_COUNT; ++s)
+        {
+            encoded.streams[s].assign (payload, payload + entry.stream_sizes[s]);
+            payload += entry.stream_sizes[s];
+        }
+
+        chunk.ranges.resize (entry.range_count);
+
+        std::memcpy (chunk.ranges.data (), file.data () + entry.range_offset, entry.range_count * sizeof(Mesh::Vertex_Range));
+
+        chunk.positions     .resize (entry.vertex_count);
+        chunk.uvs           .resize (entry.vertex_count);
+        chunk.tangent_frames.resize (entry.vertex_count);
+        chunk.indices       .resize (entry.index_count );
+        chunk.index_offset = entry.index_offset;
+
+        std::vector< uint8_t > scratch;
+
+        return Mesh_Codec::decode_stream (encoded, Mesh_Codec::POSITIONS_STREAM,      chunk.positions     .data (), scratch)
+            && Mesh_Codec::decode_stream (encoded, Mesh_Codec::TEXTURE_UVS_STREAM,    chunk.uvs           .data (), scratch)
+            && Mesh_Codec::decode_stream (encoded, Mesh_Codec::TANGENT_FRAMES_STREAM, chunk.tangent_frames.data (), scratch)
+            && Mesh_Codec::decode_stream (encoded, Mesh_Codec::INDICES_STREAM,        chunk.indices       .data (), scratch);
+    }
+
+}
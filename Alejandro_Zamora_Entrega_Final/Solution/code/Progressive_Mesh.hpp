@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Mapped_File.hpp>
+
+#include "Mesh.hpp"
+#include "Mesh_Codec.hpp"
+
+namespace udit
+{
+
+    // Formato de malla progresivo (.pmesh). Los vértices de cada submalla se reordenan para
+    // que primero vayan los que usa su LOD más simple, después los que añade el siguiente, y
+    // así hasta el LOD 0. El archivo se divide en bloques: el bloque 0 contiene el LOD más
+    // simple de todas las submallas, el bloque 1 el siguiente, etc. Cada bloque trae sólo los
+    // vértices nuevos (con sus bases tangentes) y los índices de su nivel, comprimidos con
+    // Mesh_Codec.
+    //
+    // Tras leer la cabecera se pueden reservar los buffers completos en la GPU; al subir el
+    // bloque 0 la malla ya se puede dibujar (con poco detalle) y cada bloque posterior
+    // habilita un nivel de detalle más.
+
+    class Progressive_Mesh
+    {
+    public:
+
+        class Reader
+        {
+        private:
+
+            struct Chunk
+            {
+                size_t   payload_offset;            // Posición de los flujos en el archivo
+                uint32_t range_count;
+                size_t   range_offset;              // Posición de los rangos de vértices
+                uint32_t vertex_count;
+                uint32_t index_offset;
+                uint32_t index_count;
+                uint32_t stream_sizes[Mesh_Codec::STREAM_COUNT];
+            };
+
+            Mapped_File                  file;
+            std::vector< Mesh::SubMesh > submeshes;
+            std::vector< std::string >   material_textures;
+            std::vector< Chunk >         chunks;
+            uint32_t                     vertex_count;
+            uint32_t                     index_count;
+            glm::vec3                    bounding_center;
+            float                        bounding_radius;
+
+        public:
+
+            bool open (const std::string & path);
+
+            const std::vector< Mesh::SubMesh > & get_submeshes () const { return submeshes;       }
+            const std::vector< std::string   > & get_material_textures () const { return material_textures; }
+            size_t                               get_chunk_count () const { return chunks.size ();  }
+            uint32_t                             get_vertex_count () const { return vertex_count;   }
+            uint32_t                             get_index_count  () const { return index_count;    }
+            const glm::vec3                    & get_bounding_center () const { return bounding_center; }
+            float                                get_bounding_radius () const { return bounding_radius; }
+
+            // Bytes comprimidos del bloque, para medir cuánto hay que leer antes de ver algo:
+
+            size_t get_chunk_size (size_t index) const;
+
+            // Se puede llamar desde cualquier hilo; no toca OpenGL:
+
+            bool read_chunk (size_t index, Mesh::Stream_Chunk & chunk) const;
+
+        };
+
+    public:
+
+        static bool is_progressive (const std::string & path);
+
+        // Reordena una copia de los datos y la guarda por bloques. Las submallas deben traer
+        // ya su cadena de LODs:
+
+        static bool write (const std::string & path, const Mesh::Data & data);
+
+        // Lee todos los bloques y reconstruye los datos completos:
+
+        static bool read  (const std::string & path, Mesh::Data & data);
+
+    };
+
+}
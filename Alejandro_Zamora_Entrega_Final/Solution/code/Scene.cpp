@@ -4,6 +4,9 @@
 
 #include "Scene.hpp"
 
+#include <cmath>
+#include <iostream>
+
 #include <glm.hpp>                          // vec3, vec4, mat4, etc.
 #include <gtc/matrix_transform.hpp>         // translate, rotate, scale, perspective
 #include <gtc/type_ptr.hpp>                 // value_ptr
@@ -29,9 +32,11 @@ namespace udit
         "uniform float     max_height;"
         "uniform float     line_color;"
         "out float         intensity;"
+        "out vec2          texture_uv;"
         ""
         "void main()"
         "{"
+        "   texture_uv   = vertex_uv;"
         "   float sample = texture (sampler, vertex_uv).r;"
         "   intensity    = line_color * (sample * 0.75 + 0.25);"
         "   float height = sample * max_height;"
@@ -83,13 +88,41 @@ namespace udit
         "    fragment_color = vec4(front_color, frag_opacity);"
         "}";
 
+    // Se compila dos veces: normal, para dibujar el terreno con el color de la textura virtual,
+    // y con FEEDBACK, para escribir la página que necesita cada píxel:
+
+    const string Scene::fragment_shader_virtual_code =
+
+        "in  float intensity;"
+        "in  vec2  texture_uv;"
+        "out vec4  fragment_color;"
+        ""
+        "void main()"
+        "{"
+        "\n#ifdef FEEDBACK\n"
+        "    fragment_color = vt_request (texture_uv);"
+        "\n#else\n"
+        "    fragment_color = vec4(vt_sample (texture_uv) * intensity, 1.0);"
+        "\n#endif\n"
+        "}";
+
     const string Scene::texture_path = "../../../shared/assets/height-map.png";
 
+    const string Scene::cooked_texture_path = "../../../shared/assets/height-map.ktx2";
+
     const string Scene::model_path = "../../../shared/assets/lighthouse.obj";
 
     const string Scene::texture_uvs = "../../../shared/assets/uv-checker.png";
 
-    Scene::Scene(int width, int height) : terrain(10.f, 10.f, 50, 50), angle  (0.f), cone(), lighthouse(texture_uvs,model_path)
+    const string Scene::character_path = "../../../shared/assets/character.fbx";
+
+    const string Scene::virtual_texture_path = "../../../shared/assets/terrain-color.vtex";
+
+    const double Scene::upload_budget_ms = 2.0;
+
+    const float  Scene::animation_step = 1.f / 60.f;
+
+    Scene::Scene(int width, int height) : terrain(10.f, 10.f, 50, 50), angle  (0.f), cone(), registry(loader), lighthouse(registry, texture_uvs, model_path)
     {
         // Se compilan y se activan los shaders:
 
@@ -111,12 +144,49 @@ namespace udit
 
         glUniform1f (glGetUniformLocation (program_id, "max_height"), 5.f);
 
-        // Se carga la textura y se envía a la GPU:
+        // Se carga la textura y se envía a la GPU. Si se ha cocinado el height map en BC4 se
+        // suben sus bloques y mipmaps tal cual, con la mitad de memoria que en R8:
+
+        Ktx2_File::Image cooked_height_map;
 
-        texture_id = create_texture_2d< Monochrome8 > (texture_path);
+        if (Ktx2_File::read (cooked_texture_path, cooked_height_map) && cooked_height_map.format == Block_Compression::BC4)
+        {
+            texture_id = Texture::create_texture_2d (cooked_height_map);
+        }
+        else
+        {
+            texture_id = create_texture_2d< Monochrome8 > (texture_path);
+        }
 
         there_is_texture = texture_id > 0;
 
+        // La textura del faro se carga sólo hasta el mipmap que se ve:
+
+        lighthouse.set_streamer (texture_streamer);
+
+        // Si se ha cocinado una textura de color para el terreno se pinta con ella:
+
+        auto colors = make_unique< Virtual_Texture > ();
+
+        if (colors->open (virtual_texture_path))
+        {
+            const string fragment_code = "#version 330\n" + Virtual_Texture::shader_code + fragment_shader_virtual_code;
+
+            program_id_virtual  = compile_shaders (vertex_shader_code, fragment_code);
+            program_id_feedback = compile_shaders (vertex_shader_code, fragment_code, "#define FEEDBACK");
+
+            terrain_colors = std::move (colors);
+        }
+        else
+        {
+            program_id_virtual  = 0;
+            program_id_feedback = 0;
+        }
+
+        // Se carga el cielo decodificando sus seis caras en paralelo:
+
+        sky = make_unique< Skybox > (Skybox::default_face_paths, &animation_workers);
+
         // Se establece la configuración básica:
 
         glEnable     (GL_CULL_FACE );
@@ -131,7 +201,13 @@ namespace udit
 
     Scene::~Scene()
     {
-        glDeleteProgram(program_id);
+        release_program(program_id);
+        release_program(program_id_2);
+        if (terrain_colors)
+        {
+            release_program(program_id_virtual);
+            release_program(program_id_feedback);
+        }
         if (there_is_texture)
             glDeleteTextures(1, &texture_id);
 
@@ -141,6 +217,28 @@ namespace udit
         
     void Scene::update ()
     {
+        // Se suben a la GPU los recursos que ya han terminado de cargarse en segundo plano:
+
+        loader.process_uploads (upload_budget_ms);
+
+        // Se ajustan los mipmaps residentes a lo que se dibujó en el fotograma anterior:
+
+        texture_streamer.update ();
+
+        // Se piden y se suben las páginas de la textura virtual que vio el fotograma anterior:
+
+        if (terrain_colors)
+        {
+            terrain_colors->update ();
+        }
+
+        // Se avanzan las animaciones de los personajes:
+
+        if (crowd)
+        {
+            crowd->update (animation_step);
+        }
+
         angle += .005f;
     }
 
@@ -158,7 +256,27 @@ namespace udit
 
         glm::mat4 normal_matrix = glm::transpose(glm::inverse(model_view_matrix));
 
-        // 3️ Render terreno (shader 1)
+        // 3️ Retroalimentación de la textura virtual (a baja resolución, sólo el terreno)
+        if (terrain_colors)
+        {
+            terrain_colors->begin_feedback();
+
+            glUseProgram(program_id_feedback);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            glUniform1i(glGetUniformLocation(program_id_feedback, "sampler"), 0);
+            glUniform1f(glGetUniformLocation(program_id_feedback, "max_height"), 5.f);
+            glUniform1f(glGetUniformLocation(program_id_feedback, "line_color"), 1.f);
+            glUniformMatrix4fv(glGetUniformLocation(program_id_feedback, "model_view_matrix"), 1, GL_FALSE, glm::value_ptr(model_view_matrix));
+            glUniformMatrix4fv(glGetUniformLocation(program_id_feedback, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
+            terrain_colors->bind(program_id_feedback, 1);
+
+            terrain.render();
+
+            terrain_colors->end_feedback();
+        }
+
+        // 4️ Render terreno (shader 1)
         glUseProgram(program_id);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture_id); // texture del heightmap
@@ -173,8 +291,25 @@ namespace udit
         // Color
         glUniform1f(glGetUniformLocation(program_id, "line_color"), 1.0f);
 
-        // Render terreno
-        terrain.render();
+        // Render terreno, con el color de la textura virtual si la hay
+        if (terrain_colors)
+        {
+            glUseProgram(program_id_virtual);
+            glUniform1i(glGetUniformLocation(program_id_virtual, "sampler"), 0);
+            glUniform1f(glGetUniformLocation(program_id_virtual, "max_height"), 5.f);
+            glUniform1f(glGetUniformLocation(program_id_virtual, "line_color"), 1.f);
+            glUniformMatrix4fv(glGetUniformLocation(program_id_virtual, "model_view_matrix"), 1, GL_FALSE, glm::value_ptr(model_view_matrix));
+            glUniformMatrix4fv(glGetUniformLocation(program_id_virtual, "projection_matrix"), 1, GL_FALSE, glm::value_ptr(projection_matrix));
+            terrain_colors->bind(program_id_virtual, 1);
+
+            terrain.render();
+
+            glUseProgram(program_id);
+        }
+        else
+        {
+            terrain.render();
+        }
 
         // Color
         glUniform1f(glGetUniformLocation(program_id, "line_color"), 0.f);
@@ -193,6 +328,16 @@ namespace udit
 
         lighthouse.render(model_view, projection_matrix);
 
+        // Copias instanciadas (una llamada por submalla para todas ellas)
+        lighthouse.render_instanced(coast_instances.data(), coast_instances.size(), model_view_matrix, projection_matrix);
+
+        // Personajes animados
+        if (crowd) crowd->render(model_view_matrix, projection_matrix);
+
+        // Cielo, después de lo opaco para que sólo se sombreen los píxeles que quedan al fondo y
+        // antes del cono, que es transparente
+        sky->render(model_view_matrix, projection_matrix);
+
         glm::mat4 cone_view_matrix(1.f);
 
         cone_view_matrix = glm::rotate(cone_view_matrix, glm::radians(90.f), glm::vec3(1.f, 0.f, 0.f)); // rotación (cada frame) 
@@ -216,6 +361,58 @@ namespace udit
 
     }
 
+    void Scene::set_instance_count (size_t count)
+    {
+        coast_instances.resize (count);
+
+        // Se colocan en anillos concéntricos alrededor del terreno con giros y escalas variados:
+
+        const float golden_angle = 2.39996323f;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            float radius  = 7.f + 0.02f * std::sqrt (float(i));
+            float theta   = golden_angle * float(i);
+            float heading = 0.5f * theta;
+
+            Instance_Transform & instance = coast_instances[i];
+
+            instance.position = glm::vec3(radius * std::cos (theta), 0.f, radius * std::sin (theta));
+            instance.scale    = 0.03f + 0.02f * float(i % 7) / 6.f;
+            instance.rotation = glm::vec4(0.f, std::sin (heading), 0.f, std::cos (heading));
+        }
+    }
+
+    void Scene::set_crowd (size_t count, Skinned_Crowd::Backend backend)
+    {
+        if (!crowd)
+        {
+            // Si no está el modelo animado se usa un personaje procedural para poder probar:
+
+            Skinned_Mesh::Data data;
+
+            if (!Skinned_Mesh::import (character_path, data))
+            {
+                cout << "Using the procedural test character" << endl;
+
+                Skinned_Mesh::build_test_character (data);
+            }
+
+            auto character = make_shared< Skinned_Mesh > ();
+
+            character->upload (std::move (data));
+
+            crowd = make_unique< Skinned_Crowd > (character, registry.get_texture (texture_uvs), animation_workers);
+        }
+
+        // Cada personaje se escala para que su esfera envolvente mida medio metro de diámetro:
+
+        const float scale = 0.25f / std::max (crowd->get_mesh ().get_data ().bounding_radius, 1e-3f);
+
+        crowd->set_backend         (backend);
+        crowd->set_character_count (count, 0.6f, scale);
+    }
+
     void Scene::resize (int width, int height)
     {
         glm::mat4 projection_matrix = glm::perspective (20.f, GLfloat(width) / height, 1.f, 500.f);
@@ -223,6 +420,11 @@ namespace udit
         glUniformMatrix4fv (projection_matrix_id, 1, GL_FALSE, glm::value_ptr(projection_matrix));
 
         glViewport (0, 0, width, height);
+
+        if (terrain_colors)
+        {
+            terrain_colors->resize (unsigned(width), unsigned(height));
+        }
     }
 
 }
@@ -8,16 +8,25 @@
     #include <Color.hpp>
     #include <Color_Buffer.hpp>
     #include <glad/gl.h>
+    #include <memory>
     #include <string>
+    #include <vector>
     #include "Terrain.hpp"
     #include "Cone.hpp"
     #include "Model.hpp"
+    #include "Asset_Loader.hpp"
+    #include "Asset_Registry.hpp"
+    #include "Skinned_Crowd.hpp"
+    #include "Skybox.hpp"
+    #include "Virtual_Texture.hpp"
 
     namespace udit
     {
 
         class Scene
         {
+            friend class Software_Scene;            // Dibuja lo mismo con los mismos recursos
+
         private:
 
             typedef Color_Buffer< Monochrome8 > Color_Buffer;
@@ -28,12 +37,20 @@
             static const  std::string   fragment_shader_code;
             static const  std::string   vertex_shader_cone_code;
             static const  std::string   fragment_shader_cone_code;
+            static const  std::string   fragment_shader_virtual_code;
             static const  std::string   texture_uvs;
             static const  std::string   texture_path;
+            static const  std::string   cooked_texture_path;       // height map en BC4, opcional
             static const  std::string   model_path;
+            static const  std::string   character_path;
+            static const  std::string   virtual_texture_path;      // color del terreno (.vtex), opcional
+            static const  double        upload_budget_ms;
+            static const  float         animation_step;
 
             GLuint  program_id;
             GLuint  program_id_2;
+            GLuint  program_id_virtual;             // Terreno con color de la textura virtual
+            GLuint  program_id_feedback;            // Páginas que necesita cada píxel del terreno
 
             GLuint  texture_id;
             bool    there_is_texture;
@@ -45,8 +62,19 @@
 
             Terrain terrain;
             Cone    cone; 
+            Asset_Loader   loader;                  // Deben construirse antes que los modelos que cargan
+            Asset_Registry registry;
+            Texture_Streamer texture_streamer;      // Mipmaps de las texturas de los modelos
             Model    lighthouse;
 
+            std::vector< Instance_Transform > coast_instances;     // Copias instanciadas del faro
+
+            Thread_Pool                      animation_workers;     // Debe construirse antes que crowd y sky
+            std::unique_ptr< Skinned_Crowd > crowd;                 // Personajes animados, se crea al pedirlos
+
+            std::unique_ptr< Virtual_Texture > terrain_colors;      // Sólo si existe el .vtex
+            std::unique_ptr< Skybox          > sky;
+
             float   angle;
 
         public:
@@ -58,6 +86,27 @@
             void render ();
             void resize (int  width, int height);
 
+            // Reparte count copias del faro por la costa que se dibujan con instancing:
+
+            void set_instance_count (size_t count);
+
+            bool is_ready () const { return lighthouse.is_ready (); }
+
+            // Coloca count personajes animados que se deforman con el backend indicado. La malla
+            // animada se carga la primera vez que se llama:
+
+            void set_crowd (size_t count, Skinned_Crowd::Backend backend);
+
+            const Skinned_Crowd * get_crowd () const { return crowd.get (); }
+
+            const Skybox * get_skybox () const { return sky.get (); }
+
+            // Memoria de vídeo máxima para los mipmaps de las texturas de los modelos:
+
+            void set_texture_budget (size_t bytes) { texture_streamer.set_budget (bytes); }
+
+            const Texture_Streamer & get_texture_streamer () const { return texture_streamer; }
+
         };
 
     }
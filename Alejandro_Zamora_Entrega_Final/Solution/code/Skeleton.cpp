@@ -0,0 +1,69 @@
+#include "Skeleton.hpp"
+
+namespace udit
+{
+
+    int Skeleton::add_joint (const Joint & joint)
+    {
+        if (joints.size () >= max_joint_count || joint.parent >= int(joints.size ()))
+        {
+            return -1;
+        }
+
+        joints.push_back (joint);
+
+        return int(joints.size ()) - 1;
+    }
+
+    int Skeleton::find_joint (const std::string & name) const
+    {
+        for (size_t i = 0; i < joints.size (); ++i)
+        {
+            if (joints[i].name == name) return int(i);
+        }
+
+        return -1;
+    }
+
+    glm::mat4 Skeleton::compose (const Joint_Pose & pose)
+    {
+        glm::mat4 matrix = glm::mat4_cast (pose.rotation);
+
+        matrix[0] *= pose.scale.x;
+        matrix[1] *= pose.scale.y;
+        matrix[2] *= pose.scale.z;
+        matrix[3]  = glm::vec4(pose.translation, 1.f);
+
+        return matrix;
+    }
+
+    void Skeleton::compute_palette
+    (
+        const Joint_Pose * local_poses,
+        const glm::mat4  & model,
+        glm::mat4        * globals,
+        Skin_Matrix      * palette
+    ) const
+    {
+        for (size_t i = 0; i < joints.size (); ++i)
+        {
+            const Joint & joint = joints[i];
+
+            // El padre ya está calculado porque siempre aparece antes. La matriz de modelo se
+            // aplica en las raíces para que la paleta lleve los vértices al espacio del mundo:
+
+            const glm::mat4 & parent = joint.parent < 0 ? model : globals[joint.parent];
+
+            globals[i] = parent * compose (local_poses[i]);
+
+            // La paleta se guarda por filas, que es una traspuesta de las columnas de glm:
+
+            const glm::mat4 skin = glm::transpose (globals[i] * joint.inverse_bind);
+
+            palette[i].rows[0] = skin[0];
+            palette[i].rows[1] = skin[1];
+            palette[i].rows[2] = skin[2];
+        }
+    }
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include <Skinning_Batch.hpp>
+
+namespace udit
+{
+
+    // Transformación local de una articulación respecto a su padre:
+
+    struct Joint_Pose
+    {
+        glm::vec3 translation;
+        glm::quat rotation;
+        glm::vec3 scale;
+    };
+
+    // Jerarquía de articulaciones de una malla animada. Los padres se guardan siempre antes que
+    // sus hijos, de modo que las transformaciones globales se obtienen en un único recorrido.
+    // Los índices caben en 8 bits para poder empaquetarlos en los vértices.
+
+    class Skeleton
+    {
+    public:
+
+        static constexpr size_t max_joint_count = 256;
+
+        struct Joint
+        {
+            std::string name;
+            int         parent;                     // -1 en las raíces
+            glm::mat4   inverse_bind;               // Del espacio de la malla al de la articulación
+            Joint_Pose  bind_pose;
+        };
+
+    private:
+
+        std::vector< Joint > joints;
+
+    public:
+
+        // Devuelve el índice de la nueva articulación o -1 si no cabe o su padre no existe aún:
+
+        int add_joint (const Joint & joint);
+
+        int find_joint (const std::string & name) const;
+
+        size_t get_joint_count () const
+        {
+            return joints.size ();
+        }
+
+        const Joint & get_joint (size_t index) const
+        {
+            return joints[index];
+        }
+
+        // Calcula la paleta de una pose: para cada articulación model * global * inverse_bind.
+        // globals es memoria temporal con espacio para get_joint_count() matrices.
+
+        void compute_palette
+        (
+            const Joint_Pose * local_poses,
+            const glm::mat4  & model,
+            glm::mat4        * globals,
+            Skin_Matrix      * palette
+        ) const;
+
+        static glm::mat4 compose (const Joint_Pose & pose);
+
+    };
+
+}
@@ -0,0 +1,389 @@
+#include "Skinned_Crowd.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <gtc/type_ptr.hpp>
+
+#include <opengl-recipes.hpp>
+
+namespace udit
+{
+
+    const std::string Skinned_Crowd::gpu_vertex_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform mat4          view_matrix;"
+        "uniform mat4          projection_matrix;"
+        "uniform samplerBuffer palette;"
+        "uniform int           joint_count;"
+        ""
+        "layout (location = 0) in vec3  vertex_coordinates;"
+        "layout (location = 1) in vec2  vertex_texture_uv;"
+        "layout (location = 6) in uvec4 vertex_joints;"
+        "layout (location = 7) in vec4  vertex_weights;"
+        ""
+        "out vec2 texture_uv;"
+        ""
+        "void main()"
+        "{"
+        "   int  first = gl_InstanceID * joint_count;"
+        "   vec4 row0  = vec4(0.0);"
+        "   vec4 row1  = vec4(0.0);"
+        "   vec4 row2  = vec4(0.0);"
+        ""
+        "   for (int i = 0; i < 4; ++i)"
+        "   {"
+        "       int texel = (first + int(vertex_joints[i])) * 3;"
+        "       row0 += vertex_weights[i] * texelFetch (palette, texel + 0);"
+        "       row1 += vertex_weights[i] * texelFetch (palette, texel + 1);"
+        "       row2 += vertex_weights[i] * texelFetch (palette, texel + 2);"
+        "   }"
+        ""
+        "   vec4 position = vec4(vertex_coordinates, 1.0);"
+        "   vec3 world    = vec3(dot (row0, position), dot (row1, position), dot (row2, position));"
+        ""
+        "   gl_Position = projection_matrix * view_matrix * vec4(world, 1.0);"
+        "   texture_uv  = vertex_texture_uv;"
+        "}";
+
+    const std::string Skinned_Crowd::cpu_vertex_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform mat4 view_matrix;"
+        "uniform mat4 projection_matrix;"
+        ""
+        "layout (location = 0) in vec3 vertex_coordinates;"
+        "layout (location = 1) in vec2 vertex_texture_uv;"
+        ""
+        "out vec2 texture_uv;"
+        ""
+        "void main()"
+        "{"
+        "   gl_Position = projection_matrix * view_matrix * vec4(vertex_coordinates, 1.0);"
+        "   texture_uv  = vertex_texture_uv;"
+        "}";
+
+    const std::string Skinned_Crowd::fragment_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform sampler2D sampler2d;"
+        ""
+        "in  vec2 texture_uv;"
+        "out vec4 fragment_color;"
+        ""
+        "void main()"
+        "{"
+        "    fragment_color = vec4(texture (sampler2d, texture_uv.st).rgb, 1.0);"
+        "}";
+
+    namespace
+    {
+
+        // Memoria temporal de cada hilo para evaluar poses sin reservar en cada fotograma:
+
+        struct Pose_Scratch
+        {
+            std::vector< Joint_Pose  > poses;
+            std::vector< glm::mat4   > globals;
+            std::vector< Skin_Matrix > palette;
+        };
+
+        Pose_Scratch & get_scratch (size_t joint_count)
+        {
+            thread_local Pose_Scratch scratch;
+
+            if (scratch.poses.size () < joint_count)
+            {
+                scratch.poses  .resize (joint_count);
+                scratch.globals.resize (joint_count);
+                scratch.palette.resize (joint_count);
+            }
+
+            return scratch;
+        }
+
+        // Avanza la animación de un personaje y calcula su paleta en el espacio del mundo:
+
+        void animate
+        (
+            Skinned_Crowd::Character   & character,
+            float                        seconds,
+            const Skinned_Mesh::Data   & data,
+            Pose_Scratch               & scratch,
+            Skin_Matrix                * palette
+        )
+        {
+            const Skeleton & skeleton = data.skeleton;
+
+            if (data.clips.empty ())
+            {
+                for (size_t j = 0; j < skeleton.get_joint_count (); ++j)
+                {
+                    scratch.poses[j] = skeleton.get_joint (j).bind_pose;
+                }
+            }
+            else
+            {
+                const Animation_Clip & clip = data.clips[character.clip % data.clips.size ()];
+
+                character.time += seconds * character.speed;
+
+                if (clip.get_duration () > 0.f) character.time = std::fmod (character.time, clip.get_duration ());
+
+                clip.sample (character.time, scratch.poses.data ());
+            }
+
+            glm::mat4 model;
+
+            compose_transforms_scalar (&character.transform, 1, &model);
+
+            skeleton.compute_palette (scratch.poses.data (), model, scratch.globals.data (), palette);
+        }
+
+    }
+
+    Skinned_Crowd::Skinned_Crowd(std::shared_ptr< Skinned_Mesh > mesh, std::shared_ptr< Texture > texture, Thread_Pool & workers)
+    :
+        mesh                     (mesh),
+        texture                  (texture),
+        workers                  (workers),
+        backend                  (GPU_SKINNING),
+        palette_buffer           (0),
+        palette_texture          (0),
+        palette_capacity         (0),
+        skinned_vbo              (0),
+        skinned_vao              (0),
+        skinned_capacity         (0),
+        max_texture_buffer_texels(0),
+        animation_milliseconds   (0.0)
+    {
+        gpu_program_id = compile_shaders (gpu_vertex_shader_code, fragment_shader_code);
+        cpu_program_id = compile_shaders (cpu_vertex_shader_code, fragment_shader_code);
+
+        // El texture buffer apunta siempre al mismo búfer aunque éste se redimensione:
+
+        glGenBuffers  (1, &palette_buffer);
+        glGenTextures (1, &palette_texture);
+
+        glBindBuffer  (GL_TEXTURE_BUFFER, palette_buffer);
+        glBufferData  (GL_TEXTURE_BUFFER, sizeof(Skin_Matrix), nullptr, GL_STREAM_DRAW);
+        glBindTexture (GL_TEXTURE_BUFFER, palette_texture);
+        glTexBuffer   (GL_TEXTURE_BUFFER, GL_RGBA32F, palette_buffer);
+        glBindTexture (GL_TEXTURE_BUFFER, 0);
+        glBindBuffer  (GL_TEXTURE_BUFFER, 0);
+
+        glGetIntegerv (GL_MAX_TEXTURE_BUFFER_SIZE, &max_texture_buffer_texels);
+
+        glGenBuffers  (1, &skinned_vbo);
+    }
+
+    Skinned_Crowd::~Skinned_Crowd()
+    {
+        if (skinned_vao) glDeleteVertexArrays (1, &skinned_vao);
+
+        glDeleteBuffers  (1, &skinned_vbo);
+        glDeleteTextures (1, &palette_texture);
+        glDeleteBuffers  (1, &palette_buffer);
+        release_program  (cpu_program_id);
+        release_program  (gpu_program_id);
+    }
+
+    void Skinned_Crowd::set_character_count (size_t count, float spacing, float scale)
+    {
+        const size_t clip_count   = std::max (mesh->get_data ().clips.size (), size_t(1));
+        const size_t side         = size_t(std::ceil (std::sqrt (double(count))));
+        const float  offset       = (float(side) - 1.f) * 0.5f;
+        const float  golden_angle = 2.39996323f;
+
+        characters.resize (count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Character & character = characters[i];
+
+            const float heading = 0.5f * golden_angle * float(i);
+
+            character.transform.position = glm::vec3((float(i % side) - offset) * spacing, 0.f, (float(i / side) - offset) * spacing);
+            character.transform.scale    = scale;
+            character.transform.rotation = glm::vec4(0.f, std::sin (heading), 0.f, std::cos (heading));
+            character.clip               = unsigned(i % clip_count);
+            character.time               = 0.37f * float(i);
+            character.speed              = 0.8f + 0.1f * float(i % 5);
+        }
+    }
+
+    size_t Skinned_Crowd::get_max_gpu_characters () const
+    {
+        const size_t joint_count = std::max (mesh->get_data ().skeleton.get_joint_count (), size_t(1));
+
+        return size_t(max_texture_buffer_texels) / (joint_count * 3);
+    }
+
+    size_t Skinned_Crowd::get_drawn_count () const
+    {
+        return backend == GPU_SKINNING ? std::min (characters.size (), get_max_gpu_characters ()) : characters.size ();
+    }
+
+    void Skinned_Crowd::update (float seconds)
+    {
+        auto start = std::chrono::steady_clock::now ();
+
+        const Skinned_Mesh::Data & data         = mesh->get_data ();
+        const size_t               joint_count  = data.skeleton.get_joint_count ();
+        const size_t               vertex_count = data.positions.size ();
+        const size_t               count        = get_drawn_count ();
+
+        if (!mesh->is_ready () || count == 0 || joint_count == 0) return;
+
+        if (backend == GPU_SKINNING)
+        {
+            // Las paletas se escriben directamente en el texture buffer. Al invalidarlo el driver
+            // no tiene que esperar a que la GPU termine de leer las del fotograma anterior:
+
+            const size_t matrix_count = count * joint_count;
+
+            glBindBuffer (GL_TEXTURE_BUFFER, palette_buffer);
+
+            if (matrix_count > palette_capacity)
+            {
+                glBufferData (GL_TEXTURE_BUFFER, matrix_count * sizeof(Skin_Matrix), nullptr, GL_STREAM_DRAW);
+                palette_capacity = matrix_count;
+            }
+
+            Skin_Matrix * palettes = static_cast< Skin_Matrix * >
+            (
+                glMapBufferRange (GL_TEXTURE_BUFFER, 0, matrix_count * sizeof(Skin_Matrix), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+            );
+
+            if (palettes)
+            {
+                workers.parallel_for (count, [&] (size_t begin, size_t end)
+                {
+                    Pose_Scratch & scratch = get_scratch (joint_count);
+
+                    for (size_t c = begin; c < end; ++c)
+                    {
+                        animate (characters[c], seconds, data, scratch, palettes + c * joint_count);
+                    }
+                });
+
+                glUnmapBuffer (GL_TEXTURE_BUFFER);
+            }
+
+            glBindBuffer (GL_TEXTURE_BUFFER, 0);
+        }
+        else
+        {
+            if (!skinned_vao) skinned_vao = mesh->create_vertex_array (skinned_vbo);
+
+            // Cada personaje calcula su paleta en memoria local (cabe en la caché) y deforma
+            // sus vértices escribiéndolos en su tramo del búfer mapeado:
+
+            const size_t skinned_count = count * vertex_count;
+
+            glBindBuffer (GL_ARRAY_BUFFER, skinned_vbo);
+
+            if (skinned_count > skinned_capacity)
+            {
+                glBufferData (GL_ARRAY_BUFFER, skinned_count * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+                skinned_capacity = skinned_count;
+            }
+
+            glm::vec4 * positions = static_cast< glm::vec4 * >
+            (
+                glMapBufferRange (GL_ARRAY_BUFFER, 0, skinned_count * sizeof(glm::vec4), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+            );
+
+            if (positions)
+            {
+                workers.parallel_for (count, [&] (size_t begin, size_t end)
+                {
+                    Pose_Scratch & scratch = get_scratch (joint_count);
+
+                    for (size_t c = begin; c < end; ++c)
+                    {
+                        animate (characters[c], seconds, data, scratch, scratch.palette.data ());
+
+                        skin_positions (data.positions.data (), data.weights.data (), vertex_count, scratch.palette.data (), positions + c * vertex_count);
+                    }
+                });
+
+                glUnmapBuffer (GL_ARRAY_BUFFER);
+            }
+
+            glBindBuffer (GL_ARRAY_BUFFER, 0);
+        }
+
+        animation_milliseconds = std::chrono::duration< double, std::milli > (std::chrono::steady_clock::now () - start).count ();
+    }
+
+    void Skinned_Crowd::render (const glm::mat4 & view, const glm::mat4 & projection)
+    {
+        const size_t count = get_drawn_count ();
+
+        if (!mesh->is_ready () || count == 0) return;
+
+        const Skinned_Mesh::Data & data = mesh->get_data ();
+
+        const GLuint program_id = backend == GPU_SKINNING ? gpu_program_id : cpu_program_id;
+
+        glUseProgram (program_id);
+
+        glActiveTexture (GL_TEXTURE0);
+        glBindTexture   (GL_TEXTURE_2D, texture->GetTexId ());
+
+        glUniform1i        (glGetUniformLocation (program_id, "sampler2d"), 0);
+        glUniformMatrix4fv (glGetUniformLocation (program_id, "view_matrix"      ), 1, GL_FALSE, glm::value_ptr (view      ));
+        glUniformMatrix4fv (glGetUniformLocation (program_id, "projection_matrix"), 1, GL_FALSE, glm::value_ptr (projection));
+
+        if (backend == GPU_SKINNING)
+        {
+            glActiveTexture (GL_TEXTURE1);
+            glBindTexture   (GL_TEXTURE_BUFFER, palette_texture);
+
+            glUniform1i (glGetUniformLocation (program_id, "palette"    ), 1);
+            glUniform1i (glGetUniformLocation (program_id, "joint_count"), GLint(data.skeleton.get_joint_count ()));
+
+            mesh->render_instanced (GLsizei(count));
+
+            glBindTexture   (GL_TEXTURE_BUFFER, 0);
+            glActiveTexture (GL_TEXTURE0);
+        }
+        else
+        if (skinned_vao)
+        {
+            // Una llamada por submalla para todos los personajes; cada uno empieza en su tramo
+            // del búfer de posiciones deformadas:
+
+            const size_t vertex_count = data.positions.size ();
+
+            draw_counts       .resize (count);
+            draw_offsets      .resize (count);
+            draw_base_vertices.resize (count);
+
+            glBindVertexArray (skinned_vao);
+
+            for (const auto & submesh : data.submeshes)
+            {
+                const Mesh::Lod & lod = submesh.lods.front ();
+
+                for (size_t c = 0; c < count; ++c)
+                {
+                    draw_counts       [c] = lod.index_count;
+                    draw_offsets      [c] = (const void *)(lod.index_offset * sizeof(GLuint));
+                    draw_base_vertices[c] = GLint(c * vertex_count) + submesh.base_vertex;
+                }
+
+                glMultiDrawElementsBaseVertex (GL_TRIANGLES, draw_counts.data (), GL_UNSIGNED_INT, draw_offsets.data (), GLsizei(count), draw_base_vertices.data ());
+            }
+
+            glBindVertexArray (0);
+        }
+    }
+
+}
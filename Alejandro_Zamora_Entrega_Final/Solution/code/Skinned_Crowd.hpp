@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+#include <Thread_Pool.hpp>
+#include <Transform_Batch.hpp>
+
+#include "Skinned_Mesh.hpp"
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    // Grupo de personajes que comparten una malla animada. Cada fotograma se muestrea la pose
+    // de cada personaje y se calcula su paleta de matrices en paralelo. Después la deformación
+    // se hace de una de dos formas:
+    //
+    //  - CPU_SKINNING: los hilos de trabajo deforman los vértices con SSE y escriben las
+    //    posiciones ya en el espacio del mundo en un búfer mapeado. Se dibuja con un
+    //    glMultiDrawElementsBaseVertex por submalla.
+    //  - GPU_SKINNING: las paletas de todos los personajes se escriben en un texture buffer y
+    //    el vertex shader mezcla las matrices. Se dibuja con un draw instanciado por submalla.
+
+    class Skinned_Crowd
+    {
+    public:
+
+        enum Backend
+        {
+            CPU_SKINNING,
+            GPU_SKINNING
+        };
+
+        struct Character
+        {
+            Instance_Transform transform;
+            unsigned           clip;
+            float              time;                // Segundos dentro de su animación
+            float              speed;
+        };
+
+    private:
+
+        static const std::string gpu_vertex_shader_code;
+        static const std::string cpu_vertex_shader_code;
+        static const std::string fragment_shader_code;
+
+        std::shared_ptr< Skinned_Mesh > mesh;
+        std::shared_ptr< Texture      > texture;
+        Thread_Pool                   & workers;
+
+        Backend                  backend;
+        std::vector< Character > characters;
+
+        GLuint  gpu_program_id;
+        GLuint  cpu_program_id;
+
+        GLuint  palette_buffer;                     // Paletas de todos los personajes (GPU_SKINNING)
+        GLuint  palette_texture;
+        size_t  palette_capacity;
+
+        GLuint  skinned_vbo;                        // Posiciones deformadas (CPU_SKINNING)
+        GLuint  skinned_vao;
+        size_t  skinned_capacity;
+
+        GLint   max_texture_buffer_texels;
+
+        std::vector< GLsizei      > draw_counts;    // Argumentos del multi-draw, se reutilizan
+        std::vector< const void * > draw_offsets;
+        std::vector< GLint        > draw_base_vertices;
+
+        double  animation_milliseconds;
+
+    public:
+
+        Skinned_Crowd(std::shared_ptr< Skinned_Mesh > mesh, std::shared_ptr< Texture > texture, Thread_Pool & workers);
+       ~Skinned_Crowd();
+
+        Skinned_Crowd(const Skinned_Crowd & ) = delete;
+        Skinned_Crowd & operator = (const Skinned_Crowd & ) = delete;
+
+    public:
+
+        void    set_backend (Backend new_backend) { backend = new_backend; }
+        Backend get_backend () const              { return backend;        }
+
+        const Skinned_Mesh & get_mesh () const
+        {
+            return *mesh;
+        }
+
+        // Coloca count personajes en una rejilla centrada en el origen, con animaciones y
+        // fases distintas para que no se muevan al unísono:
+
+        void set_character_count (size_t count, float spacing, float scale);
+
+        size_t get_character_count () const
+        {
+            return characters.size ();
+        }
+
+        std::vector< Character > & get_characters ()
+        {
+            return characters;
+        }
+
+        // Máximo de personajes que caben en el texture buffer de las paletas:
+
+        size_t get_max_gpu_characters () const;
+
+        // Avanza las animaciones y rellena los búferes del backend activo. Usa OpenGL, por lo
+        // que se llama desde el hilo de render; el trabajo pesado se reparte entre workers.
+
+        void update (float seconds);
+
+        void render (const glm::mat4 & view, const glm::mat4 & projection);
+
+        // Tiempo que tardó la última llamada a update() (muestreo, paletas y skinning):
+
+        double get_animation_milliseconds () const
+        {
+            return animation_milliseconds;
+        }
+
+    private:
+
+        size_t get_drawn_count () const;
+
+    };
+
+}
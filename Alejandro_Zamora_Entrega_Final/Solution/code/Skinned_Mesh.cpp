@@ -0,0 +1,626 @@
+#include "Skinned_Mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <set>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <gtc/type_ptr.hpp>
+
+namespace udit
+{
+
+    namespace
+    {
+
+        // Assimp guarda las matrices por filas y glm por columnas:
+
+        glm::mat4 to_glm (const aiMatrix4x4 & matrix)
+        {
+            return glm::transpose (glm::make_mat4 (&matrix.a1));
+        }
+
+        Joint_Pose decompose (const aiMatrix4x4 & matrix)
+        {
+            aiVector3D   scale, translation;
+            aiQuaternion rotation;
+
+            matrix.Decompose (scale, rotation, translation);
+
+            return
+            {
+                glm::vec3(translation.x, translation.y, translation.z),
+                glm::quat(rotation.w, rotation.x, rotation.y, rotation.z),
+                glm::vec3(scale.x, scale.y, scale.z)
+            };
+        }
+
+        // Las articulaciones son los nodos que son huesos de alguna malla y todos sus antepasados
+        // (aunque no deformen vértices, su animación mueve a los hijos):
+
+        bool find_joint_nodes (const aiNode * node, const std::map< std::string, aiMatrix4x4 > & offsets, std::set< const aiNode * > & joint_nodes)
+        {
+            bool is_joint = offsets.count (node->mName.C_Str ()) > 0;
+
+            for (unsigned i = 0; i < node->mNumChildren; ++i)
+            {
+                if (find_joint_nodes (node->mChildren[i], offsets, joint_nodes)) is_joint = true;
+            }
+
+            if (is_joint) joint_nodes.insert (node);
+
+            return is_joint;
+        }
+
+        // Se añaden en preorden, de modo que cada padre queda antes que sus hijos:
+
+        bool add_joints
+        (
+            const aiNode                               * node,
+            int                                          parent,
+            const glm::mat4                            & parent_global,
+            const std::set< const aiNode * >           & joint_nodes,
+            const std::map< std::string, aiMatrix4x4 > & offsets,
+            Skeleton                                   & skeleton
+        )
+        {
+            if (joint_nodes.count (node) == 0) return true;
+
+            const glm::mat4 global = parent_global * to_glm (node->mTransformation);
+
+            Skeleton::Joint joint;
+
+            joint.name      = node->mName.C_Str ();
+            joint.parent    = parent;
+            joint.bind_pose = decompose (node->mTransformation);
+
+            // Los nodos que no son huesos no deforman vértices propios; su inversa de bind deja
+            // en su sitio a los vértices sin pesos, que se asignan a la raíz:
+
+            auto bone = offsets.find (joint.name);
+
+            joint.inverse_bind = bone != offsets.end () ? to_glm (bone->second) : glm::inverse (global);
+
+            const int index = skeleton.add_joint (joint);
+
+            if (index < 0) return false;
+
+            for (unsigned i = 0; i < node->mNumChildren; ++i)
+            {
+                if (!add_joints (node->mChildren[i], index, global, joint_nodes, offsets, skeleton)) return false;
+            }
+
+            return true;
+        }
+
+        // Claves de animación: se busca la última anterior al instante y se mezcla con la siguiente.
+
+        template< typename KEY >
+        unsigned find_key (const KEY * keys, unsigned count, double ticks, float & blend)
+        {
+            const KEY * next = std::upper_bound (keys, keys + count, ticks, [] (double time, const KEY & key) { return time < key.mTime; });
+
+            if (next == keys || next == keys + count)
+            {
+                blend = 0.f;
+
+                return next == keys ? 0 : count - 1;
+            }
+
+            const unsigned key  = unsigned(next - keys) - 1;
+            const double   span = next->mTime - keys[key].mTime;
+
+            blend = span > 0.0 ? float((ticks - keys[key].mTime) / span) : 0.f;
+
+            return key;
+        }
+
+        glm::vec3 interpolate (const aiVectorKey * keys, unsigned count, double ticks, const glm::vec3 & fallback)
+        {
+            if (count == 0) return fallback;
+
+            float          blend;
+            const unsigned key = find_key (keys, count, ticks, blend);
+            const aiVector3D & a = keys[key].mValue;
+            const aiVector3D & b = keys[std::min (key + 1, count - 1)].mValue;
+
+            return glm::mix (glm::vec3(a.x, a.y, a.z), glm::vec3(b.x, b.y, b.z), blend);
+        }
+
+        glm::quat interpolate (const aiQuatKey * keys, unsigned count, double ticks, const glm::quat & fallback)
+        {
+            if (count == 0) return fallback;
+
+            float          blend;
+            const unsigned key = find_key (keys, count, ticks, blend);
+
+            aiQuaternion rotation;
+            aiQuaternion::Interpolate (rotation, keys[key].mValue, keys[std::min (key + 1, count - 1)].mValue, blend);
+
+            return glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+        }
+
+        // Ordena las influencias de mayor a menor, las normaliza y las cuantiza a unorm8 de modo
+        // que sumen exactamente 255. El error de redondeo se lleva la más pesada:
+
+        Skin_Weights pack_weights (const unsigned * joints, const float * weights)
+        {
+            unsigned order[4] = { 0, 1, 2, 3 };
+
+            std::sort (order, order + 4, [weights] (unsigned a, unsigned b) { return weights[a] > weights[b]; });
+
+            const float total = weights[0] + weights[1] + weights[2] + weights[3];
+
+            Skin_Weights packed{};
+
+            if (total <= 0.f)
+            {
+                packed.weights[0] = 255;
+
+                return packed;
+            }
+
+            int sum = 0;
+
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                packed.joints [i] = uint8_t(joints[order[i]]);
+                packed.weights[i] = uint8_t(std::lround (weights[order[i]] / total * 255.f));
+                sum              += packed.weights[i];
+            }
+
+            packed.weights[0] = uint8_t(int(packed.weights[0]) + 255 - sum);
+
+            return packed;
+        }
+
+        void compute_bounding_sphere (Skinned_Mesh::Data & data)
+        {
+            glm::vec3 min_corner(+INFINITY), max_corner(-INFINITY);
+
+            for (const auto & p : data.positions)
+            {
+                min_corner = glm::min (min_corner, p);
+                max_corner = glm::max (max_corner, p);
+            }
+
+            data.bounding_center = (min_corner + max_corner) * 0.5f;
+            data.bounding_radius = 0.f;
+
+            for (const auto & p : data.positions)
+            {
+                data.bounding_radius = std::max (data.bounding_radius, glm::length (p - data.bounding_center));
+            }
+        }
+
+    }
+
+    Skinned_Mesh::Skinned_Mesh() : vbo_ids{}, vao_id(0)
+    {
+    }
+
+    Skinned_Mesh::Skinned_Mesh(const std::string & path) : Skinned_Mesh()
+    {
+        Data imported;
+
+        if (import (path, imported))
+        {
+            upload (std::move (imported));
+        }
+    }
+
+    Skinned_Mesh::~Skinned_Mesh()
+    {
+        if (!vao_id) return;
+
+        glDeleteVertexArrays (1, &vao_id);
+        glDeleteBuffers      (VBO_COUNT, vbo_ids);
+    }
+
+    bool Skinned_Mesh::import (const std::string & path, Data & data)
+    {
+        // LimitBoneWeights deja como mucho cuatro influencias por vértice, las que caben en Skin_Weights:
+
+        Assimp::Importer importer;
+
+        const aiScene * scene = importer.ReadFile
+        (
+            path,
+            aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType | aiProcess_LimitBoneWeights
+        );
+
+        if (!scene || !scene->mRootNode || scene->mNumMeshes == 0)
+        {
+            std::cerr << "Error loading skinned mesh: " << path << std::endl;
+            return false;
+        }
+
+        // Matrices inversas de bind de todos los huesos de todas las mallas, por nombre:
+
+        std::map< std::string, aiMatrix4x4 > offsets;
+
+        for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+        {
+            const aiMesh * mesh = scene->mMeshes[m];
+
+            for (unsigned b = 0; b < mesh->mNumBones; ++b)
+            {
+                offsets.emplace (mesh->mBones[b]->mName.C_Str (), mesh->mBones[b]->mOffsetMatrix);
+            }
+        }
+
+        if (offsets.empty ())
+        {
+            std::cerr << "Mesh has no skeleton: " << path << std::endl;
+            return false;
+        }
+
+        data = Data{};
+
+        std::set< const aiNode * > joint_nodes;
+
+        find_joint_nodes (scene->mRootNode, offsets, joint_nodes);
+
+        if (!add_joints (scene->mRootNode, -1, glm::mat4(1.f), joint_nodes, offsets, data.skeleton))
+        {
+            std::cerr << "Skeleton has more than " << Skeleton::max_joint_count << " joints: " << path << std::endl;
+            return false;
+        }
+
+        // Geometría de todas las submallas en los mismos buffers, como en Mesh::import:
+
+        size_t total_vertices = 0;
+        size_t total_indices  = 0;
+
+        for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+        {
+            const aiMesh * mesh = scene->mMeshes[m];
+
+            total_vertices += mesh->mNumVertices;
+
+            for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+            {
+                if (mesh->mFaces[i].mNumIndices == 3) total_indices += 3;
+            }
+        }
+
+        data.positions.resize (total_vertices);
+        data.uvs      .resize (total_vertices, glm::vec2(0.f));
+        data.weights  .resize (total_vertices);
+        data.indices  .resize (total_indices );
+        data.submeshes.reserve (scene->mNumMeshes);
+
+        std::vector< unsigned > influence_joints;
+        std::vector< float    > influence_weights;
+
+        size_t first_vertex = 0;
+        size_t first_index  = 0;
+
+        for (unsigned m = 0; m < scene->mNumMeshes; ++m)
+        {
+            const aiMesh * mesh         = scene->mMeshes[m];
+            const size_t   vertex_count = mesh->mNumVertices;
+
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                data.positions[first_vertex + i] = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            }
+
+            if (mesh->mTextureCoords[0])
+            {
+                for (size_t i = 0; i < vertex_count; ++i)
+                {
+                    data.uvs[first_vertex + i] = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+                }
+            }
+
+            GLuint * indices = data.indices.data () + first_index;
+
+            for (unsigned i = 0; i < mesh->mNumFaces; ++i)
+            {
+                const aiFace & face = mesh->mFaces[i];
+
+                if (face.mNumIndices != 3) continue;
+
+                *indices++ = face.mIndices[0];
+                *indices++ = face.mIndices[1];
+                *indices++ = face.mIndices[2];
+            }
+
+            const size_t index_count = size_t(indices - (data.indices.data () + first_index));
+
+            // Se reparten las influencias de cada hueso entre sus vértices. Si alguno tuviese
+            // más de cuatro se quedan las cuatro más pesadas:
+
+            influence_joints .assign (vertex_count * 4, 0);
+            influence_weights.assign (vertex_count * 4, 0.f);
+
+            for (unsigned b = 0; b < mesh->mNumBones; ++b)
+            {
+                const aiBone * bone  = mesh->mBones[b];
+                const int      joint = data.skeleton.find_joint (bone->mName.C_Str ());
+
+                for (unsigned w = 0; w < bone->mNumWeights; ++w)
+                {
+                    const aiVertexWeight & weight = bone->mWeights[w];
+
+                    if (weight.mVertexId >= vertex_count) continue;
+
+                    float    * weights = influence_weights.data () + size_t(weight.mVertexId) * 4;
+                    unsigned * joints  = influence_joints .data () + size_t(weight.mVertexId) * 4;
+                    float    * lightest = std::min_element (weights, weights + 4);
+
+                    if (weight.mWeight > *lightest)
+                    {
+                        joints[lightest - weights] = unsigned(joint);
+                       *lightest                   = weight.mWeight;
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < vertex_count; ++i)
+            {
+                data.weights[first_vertex + i] = pack_weights (influence_joints.data () + i * 4, influence_weights.data () + i * 4);
+            }
+
+            Mesh::SubMesh submesh;
+
+            submesh.base_vertex  = GLint  (first_vertex);
+            submesh.vertex_count = GLsizei(vertex_count);
+            submesh.lods.push_back ({ GLuint(first_index), GLsizei(index_count), 0.f });
+
+            data.submeshes.push_back (submesh);
+
+            first_vertex += vertex_count;
+            first_index  += index_count;
+        }
+
+        data.indices.resize (first_index);
+
+        // Cada animación se remuestrea y se comprime. Las articulaciones sin canal mantienen su
+        // pose de bind:
+
+        const Skeleton & skeleton    = data.skeleton;
+        const size_t     joint_count = skeleton.get_joint_count ();
+
+        for (unsigned a = 0; a < scene->mNumAnimations; ++a)
+        {
+            const aiAnimation * animation        = scene->mAnimations[a];
+            const double        ticks_per_second = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+
+            std::vector< const aiNodeAnim * > channels(joint_count, nullptr);
+
+            for (unsigned c = 0; c < animation->mNumChannels; ++c)
+            {
+                const int joint = skeleton.find_joint (animation->mChannels[c]->mNodeName.C_Str ());
+
+                if (joint >= 0) channels[joint] = animation->mChannels[c];
+            }
+
+            auto evaluate = [&skeleton, &channels, ticks_per_second] (float time, Joint_Pose * poses)
+            {
+                const double ticks = double(time) * ticks_per_second;
+
+                for (size_t j = 0; j < channels.size (); ++j)
+                {
+                    const Joint_Pose & bind    = skeleton.get_joint (j).bind_pose;
+                    const aiNodeAnim * channel = channels[j];
+
+                    if (!channel)
+                    {
+                        poses[j] = bind;
+                        continue;
+                    }
+
+                    poses[j].translation = interpolate (channel->mPositionKeys, channel->mNumPositionKeys, ticks, bind.translation);
+                    poses[j].rotation    = interpolate (channel->mRotationKeys, channel->mNumRotationKeys, ticks, bind.rotation);
+                    poses[j].scale       = interpolate (channel->mScalingKeys,  channel->mNumScalingKeys,  ticks, bind.scale);
+                }
+            };
+
+            const std::string name = animation->mName.length > 0 ? animation->mName.C_Str () : "clip " + std::to_string (a);
+
+            data.clips.emplace_back ();
+            data.clips.back ().compress (name, float(animation->mDuration / ticks_per_second), joint_count, evaluate);
+        }
+
+        compute_bounding_sphere (data);
+
+        std::cout << "Loaded skinned mesh " << path << ": " << total_vertices << " vertices, "
+                  << joint_count << " joints, " << data.clips.size () << " clips" << std::endl;
+
+        for (const auto & clip : data.clips)
+        {
+            std::cout << "  clip " << clip.get_name () << ": " << clip.get_duration () << " s, "
+                      << clip.get_raw_bytes () / 1024 << " KB -> " << clip.get_compressed_bytes () / 1024 << " KB" << std::endl;
+        }
+
+        return true;
+    }
+
+    void Skinned_Mesh::build_test_character (Data & data)
+    {
+        constexpr unsigned joint_count = 16;
+        constexpr unsigned rings       = 128;
+        constexpr unsigned slices      = 32;
+        constexpr float    height      = 2.f;
+        constexpr float    radius      = 0.15f;
+        constexpr float    duration    = 2.f;
+        constexpr float    two_pi      = 6.28318531f;
+
+        const float segment = height / joint_count;
+
+        data = Data{};
+
+        // Cadena de articulaciones a lo largo del eje Y:
+
+        for (unsigned j = 0; j < joint_count; ++j)
+        {
+            Skeleton::Joint joint;
+
+            joint.name         = "joint " + std::to_string (j);
+            joint.parent       = int(j) - 1;
+            joint.bind_pose    = { glm::vec3(0.f, j == 0 ? 0.f : segment, 0.f), glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(1.f) };
+            joint.inverse_bind = glm::translate (glm::mat4(1.f), glm::vec3(0.f, -segment * float(j), 0.f));
+
+            data.skeleton.add_joint (joint);
+        }
+
+        // Cilindro que se estrecha hacia la punta. Cada anillo se reparte entre las dos
+        // articulaciones más cercanas para que las curvas sean suaves:
+
+        for (unsigned r = 0; r <= rings; ++r)
+        {
+            const float y     = height * float(r) / rings;
+            const float ring  = radius * (1.f - 0.7f * float(r) / rings);
+            const float along = std::min (y / segment, float(joint_count) - 0.5f);
+            const float lower = std::floor (along - 0.5f);
+            const float blend = along - 0.5f - lower;
+
+            unsigned joints [4] = { unsigned(std::max (lower, 0.f)), std::min (unsigned(std::max (lower + 1.f, 0.f)), joint_count - 1), 0, 0 };
+            float    weights[4] = { 1.f - blend, blend, 0.f, 0.f };
+
+            const Skin_Weights packed = pack_weights (joints, weights);
+
+            for (unsigned s = 0; s <= slices; ++s)
+            {
+                const float theta = two_pi * float(s) / slices;
+
+                data.positions.push_back (glm::vec3(ring * std::cos (theta), y, ring * std::sin (theta)));
+                data.uvs      .push_back (glm::vec2(float(s) / slices, float(r) / rings));
+                data.weights  .push_back (packed);
+            }
+        }
+
+        for (unsigned r = 0; r < rings; ++r)
+        {
+            for (unsigned s = 0; s < slices; ++s)
+            {
+                const GLuint a = r * (slices + 1) + s;
+                const GLuint b = a + 1;
+                const GLuint c = a + slices + 1;
+                const GLuint d = c + 1;
+
+                data.indices.insert (data.indices.end (), { a, c, b, b, c, d });
+            }
+        }
+
+        Mesh::SubMesh submesh;
+
+        submesh.base_vertex  = 0;
+        submesh.vertex_count = GLsizei(data.positions.size ());
+        submesh.lods.push_back ({ 0, GLsizei(data.indices.size ()), 0.f });
+
+        data.submeshes.push_back (submesh);
+
+        // Onda que recorre el tentáculo. La raíz, las traslaciones y las escalas no cambian, por
+        // lo que el compresor sólo guarda rotaciones:
+
+        const Skeleton & skeleton = data.skeleton;
+
+        data.clips.emplace_back ();
+        data.clips.back ().compress ("wave", duration, joint_count, [&skeleton] (float time, Joint_Pose * poses)
+        {
+            for (unsigned j = 0; j < joint_count; ++j)
+            {
+                poses[j] = skeleton.get_joint (j).bind_pose;
+
+                if (j == 0) continue;
+
+                const float phase = two_pi * time / duration - 0.5f * float(j);
+
+                poses[j].rotation = glm::angleAxis (0.35f * std::sin (phase), glm::vec3(0.f, 0.f, 1.f))
+                                  * glm::angleAxis (0.20f * std::cos (phase), glm::vec3(1.f, 0.f, 0.f));
+            }
+        });
+
+        compute_bounding_sphere (data);
+    }
+
+    void Skinned_Mesh::upload (Data && imported)
+    {
+        data = std::move (imported);
+
+        if (vao_id)
+        {
+            glDeleteVertexArrays (1, &vao_id);
+            glDeleteBuffers      (VBO_COUNT, vbo_ids);
+        }
+
+        glGenVertexArrays (1, &vao_id);
+        glBindVertexArray (vao_id);
+
+        glGenBuffers (VBO_COUNT, vbo_ids);
+
+        // Posiciones y UVs en la pose de bind:
+
+        glBindBuffer (GL_ARRAY_BUFFER, vbo_ids[COORDINATES_VBO]);
+        glBufferData (GL_ARRAY_BUFFER, data.positions.size () * sizeof(glm::vec3), data.positions.data (), GL_STATIC_DRAW);
+        glEnableVertexAttribArray (0);
+        glVertexAttribPointer (0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+
+        glBindBuffer (GL_ARRAY_BUFFER, vbo_ids[TEXTURE_UVS_VBO]);
+        glBufferData (GL_ARRAY_BUFFER, data.uvs.size () * sizeof(glm::vec2), data.uvs.data (), GL_STATIC_DRAW);
+        glEnableVertexAttribArray (1);
+        glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+
+        // Los índices de articulación llegan al shader como enteros y los pesos normalizados:
+
+        glBindBuffer (GL_ARRAY_BUFFER, vbo_ids[WEIGHTS_VBO]);
+        glBufferData (GL_ARRAY_BUFFER, data.weights.size () * sizeof(Skin_Weights), data.weights.data (), GL_STATIC_DRAW);
+        glEnableVertexAttribArray (joints_attribute);
+        glVertexAttribIPointer (joints_attribute, 4, GL_UNSIGNED_BYTE, sizeof(Skin_Weights), (void *)offsetof(Skin_Weights, joints));
+        glEnableVertexAttribArray (weights_attribute);
+        glVertexAttribPointer (weights_attribute, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Skin_Weights), (void *)offsetof(Skin_Weights, weights));
+
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, vbo_ids[INDICES_EBO]);
+        glBufferData (GL_ELEMENT_ARRAY_BUFFER, data.indices.size () * sizeof(GLuint), data.indices.data (), GL_STATIC_DRAW);
+
+        glBindVertexArray (0);
+    }
+
+    void Skinned_Mesh::render_instanced (GLsizei instance_count) const
+    {
+        if (!is_ready () || instance_count == 0) return;
+
+        glBindVertexArray (vao_id);
+
+        for (const auto & submesh : data.submeshes)
+        {
+            const Mesh::Lod & lod = submesh.lods.front ();
+
+            glDrawElementsInstancedBaseVertex (GL_TRIANGLES, lod.index_count, GL_UNSIGNED_INT, (void *)(lod.index_offset * sizeof(GLuint)), instance_count, submesh.base_vertex);
+        }
+
+        glBindVertexArray (0);
+    }
+
+    GLuint Skinned_Mesh::create_vertex_array (GLuint position_vbo) const
+    {
+        GLuint vertex_array = 0;
+
+        glGenVertexArrays (1, &vertex_array);
+        glBindVertexArray (vertex_array);
+
+        glBindBuffer (GL_ARRAY_BUFFER, position_vbo);
+        glEnableVertexAttribArray (0);
+        glVertexAttribPointer (0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+
+        glBindBuffer (GL_ARRAY_BUFFER, vbo_ids[TEXTURE_UVS_VBO]);
+        glEnableVertexAttribArray (1);
+        glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, vbo_ids[INDICES_EBO]);
+
+        glBindVertexArray (0);
+
+        return vertex_array;
+    }
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+#include <Skinning_Batch.hpp>
+
+#include "Animation_Clip.hpp"
+#include "Mesh.hpp"
+#include "Skeleton.hpp"
+
+namespace udit
+{
+
+    // Malla animada por esqueleto. Además de posiciones, UVs e índices cada vértice guarda sus
+    // cuatro influencias empaquetadas en 8 bytes (Skin_Weights). La malla conserva en memoria
+    // de CPU los datos importados porque el skinning por CPU y el muestreo de animaciones los
+    // necesitan cada fotograma. No tiene LODs: cada submalla usa sólo su primer nivel.
+
+    class Skinned_Mesh
+    {
+    public:
+
+        static constexpr GLuint joints_attribute  = 6;         // uvec4 con los índices de articulación
+        static constexpr GLuint weights_attribute = 7;         // vec4 con los pesos normalizados
+
+        struct Data
+        {
+            std::vector< glm::vec3      > positions;
+            std::vector< glm::vec2      > uvs;
+            std::vector< Skin_Weights   > weights;
+            std::vector< GLuint         > indices;
+            std::vector< Mesh::SubMesh  > submeshes;
+            Skeleton                      skeleton;
+            std::vector< Animation_Clip > clips;
+            glm::vec3                     bounding_center;
+            float                         bounding_radius;
+        };
+
+    private:
+
+        enum
+        {
+            COORDINATES_VBO,
+            TEXTURE_UVS_VBO,
+            WEIGHTS_VBO,
+            INDICES_EBO,
+            VBO_COUNT
+        };
+
+        Data    data;
+        GLuint  vbo_ids[VBO_COUNT];
+        GLuint  vao_id;
+
+    public:
+
+        Skinned_Mesh();
+        explicit Skinned_Mesh(const std::string & path);
+       ~Skinned_Mesh();
+
+        Skinned_Mesh(const Skinned_Mesh & ) = delete;
+        Skinned_Mesh & operator = (const Skinned_Mesh & ) = delete;
+
+    public:
+
+        // Importa malla, esqueleto, pesos y animaciones con Assimp. No toca OpenGL. Falla si el
+        // modelo no tiene huesos o tiene más articulaciones de las que caben en 8 bits.
+
+        static bool import (const std::string & path, Data & data);
+
+        // Tentáculo procedural de 16 articulaciones con una animación en bucle, para pruebas y
+        // benchmarks cuando no hay un modelo animado a mano:
+
+        static void build_test_character (Data & data);
+
+        void upload (Data && data);
+
+        bool is_ready () const
+        {
+            return vao_id != 0;
+        }
+
+        const Data & get_data () const
+        {
+            return data;
+        }
+
+        // Dibuja instance_count copias con un solo draw call por submalla. El vertex shader
+        // elige la paleta de cada copia con gl_InstanceID.
+
+        void render_instanced (GLsizei instance_count) const;
+
+        // Crea un VAO que comparte UVs e índices con la malla pero lee las posiciones (un vec4
+        // por vértice) de otro búfer, como el que rellena el skinning por CPU. Lo borra quien
+        // lo pide.
+
+        GLuint create_vertex_array (GLuint position_vbo) const;
+
+    };
+
+}
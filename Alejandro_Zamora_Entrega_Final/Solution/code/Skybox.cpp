@@ -0,0 +1,194 @@
+#include "Skybox.hpp"
+
+#include <chrono>
+
+#include <gtc/type_ptr.hpp>
+
+#include <opengl-recipes.hpp>
+
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    const std::vector< std::string > Skybox::default_face_paths =
+    {
+        "../../../shared/assets/sky-cube-map-0.png",
+        "../../../shared/assets/sky-cube-map-1.png",
+        "../../../shared/assets/sky-cube-map-2.png",
+        "../../../shared/assets/sky-cube-map-3.png",
+        "../../../shared/assets/sky-cube-map-4.png",
+        "../../../shared/assets/sky-cube-map-5.png"
+    };
+
+    const std::string Skybox::vertex_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform mat4 view_projection_matrix;"
+        ""
+        "layout (location = 0) in vec3 vertex_coordinates;"
+        ""
+        "out vec3 direction;"
+        ""
+        "void main()"
+        "{"
+        "   direction   = vertex_coordinates;"
+        "   gl_Position = (view_projection_matrix * vec4(vertex_coordinates, 1.0)).xyww;"      // z / w = 1
+        "}";
+
+    // No escribe gl_FragDepth ni usa discard para que el test de profundidad se haga antes de
+    // sombrear:
+
+    const std::string Skybox::fragment_shader_code =
+
+        "#version 330\n"
+        ""
+        "uniform samplerCube sky;"
+        ""
+        "in  vec3 direction;"
+        "out vec4 fragment_color;"
+        ""
+        "void main()"
+        "{"
+        "   fragment_color = vec4(texture (sky, direction).rgb, 1.0);"
+        "}";
+
+    Skybox::Skybox(const std::vector< std::string > & face_paths, Thread_Pool * workers)
+    :
+        texture_id       (0),
+        query_pending    { false, false },
+        query_index      (0),
+        face_size        (0),
+        shaded_fragments (0)
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto start = clock::now ();
+
+        std::vector< std::unique_ptr< Texture::Color_Buffer > > faces = Texture::load_images (face_paths, workers);
+
+        texture_id = Texture::create_texture_cube (faces);
+
+        load_milliseconds = std::chrono::duration< double, std::milli > (clock::now () - start).count ();
+
+        if (texture_id) face_size = faces[0]->get_width ();
+
+        // Cubo unitario visto desde dentro:
+
+        static const GLfloat corners[] =
+        {
+            -1.f, -1.f, -1.f,   +1.f, -1.f, -1.f,   +1.f, +1.f, -1.f,   -1.f, +1.f, -1.f,
+            -1.f, -1.f, +1.f,   +1.f, -1.f, +1.f,   +1.f, +1.f, +1.f,   -1.f, +1.f, +1.f
+        };
+
+        static const GLubyte indices[] =
+        {
+            0, 2, 1,   0, 3, 2,         // -Z
+            4, 5, 6,   4, 6, 7,         // +Z
+            0, 1, 5,   0, 5, 4,         // -Y
+            3, 6, 2,   3, 7, 6,         // +Y
+            0, 4, 7,   0, 7, 3,         // -X
+            1, 2, 6,   1, 6, 5          // +X
+        };
+
+        program_id = compile_shaders (vertex_shader_code, fragment_shader_code);
+
+        glGenVertexArrays (1, &vao_id);
+        glGenBuffers      (2, vbo_ids);
+        glGenQueries      (2, query_ids);
+
+        glBindVertexArray (vao_id);
+
+        glBindBuffer (GL_ARRAY_BUFFER, vbo_ids[0]);
+        glBufferData (GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+        glEnableVertexAttribArray (0);
+        glVertexAttribPointer     (0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, vbo_ids[1]);
+        glBufferData (GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+        glBindVertexArray (0);
+    }
+
+    Skybox::~Skybox()
+    {
+        glDeleteQueries      (2, query_ids);
+        glDeleteBuffers      (2, vbo_ids);
+        glDeleteVertexArrays (1, &vao_id);
+
+        if (texture_id) glDeleteTextures (1, &texture_id);
+
+        release_program (program_id);
+    }
+
+    void Skybox::render (const glm::mat4 & view_matrix, const glm::mat4 & projection_matrix)
+    {
+        if (!texture_id) return;
+
+        // Se recoge sin esperar el recuento de la consulta anterior que use este mismo objeto:
+
+        if (query_pending[query_index])
+        {
+            GLuint available = GL_FALSE;
+
+            glGetQueryObjectuiv (query_ids[query_index], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (available)
+            {
+                GLuint64 samples = 0;
+
+                glGetQueryObjectui64v (query_ids[query_index], GL_QUERY_RESULT, &samples);
+
+                shaded_fragments           = samples;
+                query_pending[query_index] = false;
+            }
+        }
+
+        const glm::mat4 view_projection_matrix = projection_matrix * glm::mat4(glm::mat3(view_matrix));
+
+        GLboolean cull_face_enabled = glIsEnabled (GL_CULL_FACE);
+        GLboolean blend_enabled     = glIsEnabled (GL_BLEND);
+
+        glDisable   (GL_CULL_FACE);
+        glDisable   (GL_BLEND);
+        glDepthFunc (GL_LEQUAL);
+        glDepthMask (GL_FALSE);
+
+        glUseProgram       (program_id);
+        glUniformMatrix4fv (glGetUniformLocation (program_id, "view_projection_matrix"), 1, GL_FALSE, glm::value_ptr (view_projection_matrix));
+        glUniform1i        (glGetUniformLocation (program_id, "sky"), 0);
+
+        glActiveTexture   (GL_TEXTURE0);
+        glBindTexture     (GL_TEXTURE_CUBE_MAP, texture_id);
+        glBindVertexArray (vao_id);
+
+        // Si la consulta anterior de este objeto aún no ha terminado se dibuja sin contar:
+
+        const bool counting = !query_pending[query_index];
+
+        if (counting) glBeginQuery (GL_SAMPLES_PASSED, query_ids[query_index]);
+
+        glDrawElements (GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+
+        if (counting)
+        {
+            glEndQuery (GL_SAMPLES_PASSED);
+
+            query_pending[query_index] = true;
+        }
+
+        query_index ^= 1;
+
+        glBindVertexArray (0);
+        glBindTexture     (GL_TEXTURE_CUBE_MAP, 0);
+
+        glDepthMask (GL_TRUE);
+        glDepthFunc (GL_LESS);
+
+        if (cull_face_enabled) glEnable (GL_CULL_FACE);
+        if (blend_enabled    ) glEnable (GL_BLEND);
+    }
+
+}
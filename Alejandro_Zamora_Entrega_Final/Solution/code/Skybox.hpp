@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+namespace udit
+{
+
+    class Thread_Pool;
+
+    // Cielo dibujado con un cube map. Las seis caras se decodifican a la vez y se suben como una
+    // única textura GL_TEXTURE_CUBE_MAP.
+    //
+    // Se dibuja después de la geometría opaca con la profundidad fijada a 1 en el vertex shader
+    // y GL_LEQUAL, así que el test de profundidad temprano descarta los píxeles ya cubiertos y
+    // sólo se sombrean los que quedan al fondo. Una consulta GL_SAMPLES_PASSED cuenta esos
+    // fragmentos; su resultado se lee un par de fotogramas después para no bloquear.
+
+    class Skybox
+    {
+    public:
+
+        static const std::vector< std::string > default_face_paths;
+
+    private:
+
+        static const std::string vertex_shader_code;
+        static const std::string fragment_shader_code;
+
+        GLuint   program_id;
+        GLuint   texture_id;
+        GLuint   vao_id;
+        GLuint   vbo_ids[2];
+        GLuint   query_ids[2];
+        bool     query_pending[2];
+        unsigned query_index;
+
+        unsigned face_size;
+        double   load_milliseconds;                 // Decodificación de las caras y subida
+        uint64_t shaded_fragments;                  // Del último fotograma con resultado disponible
+
+    public:
+
+        // Sin hilos de trabajo las caras se decodifican una tras otra:
+
+        Skybox(const std::vector< std::string > & face_paths = default_face_paths, Thread_Pool * workers = nullptr);
+       ~Skybox();
+
+        Skybox(const Skybox & ) = delete;
+        Skybox & operator = (const Skybox & ) = delete;
+
+    public:
+
+        bool is_loaded () const
+        {
+            return texture_id != 0;
+        }
+
+        // Sólo se usa la rotación de view_matrix: el cielo está siempre a la misma distancia.
+
+        void render (const glm::mat4 & view_matrix, const glm::mat4 & projection_matrix);
+
+        unsigned get_face_size () const
+        {
+            return face_size;
+        }
+
+        double get_load_milliseconds () const
+        {
+            return load_milliseconds;
+        }
+
+        uint64_t get_shaded_fragments () const
+        {
+            return shaded_fragments;
+        }
+
+    };
+
+}
@@ -0,0 +1,308 @@
+#include "Software_Scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <gtc/matrix_transform.hpp>         // translate, rotate, scale, perspective
+
+#include <opengl-recipes.hpp>
+#include <Thread_Pool.hpp>
+
+#include "Cone.hpp"
+#include "Scene.hpp"
+#include "Tangent_Space.hpp"
+#include "Terrain.hpp"
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    namespace
+    {
+
+        using Draw = Software_Rasterizer::Draw;
+
+        // Mismos valores que Scene:
+
+        const float     max_height      = 5.f;
+        const glm::vec3 light_direction = glm::vec3(0.37f, 0.74f, 0.56f);
+
+        // Ejecuta function (i) para i en [0, count), repartido entre los hilos si los hay:
+
+        template< typename FUNCTION >
+        void for_each_vertex (size_t count, Thread_Pool * workers, const FUNCTION & function)
+        {
+            auto range = [&function] (size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i) function (i);
+            };
+
+            if (workers)
+                workers->parallel_for (count, range);
+            else
+                range (0, count);
+        }
+
+        // texture (sampler, uv).r en el vertex shader del terreno: GL_LINEAR sobre el nivel 0
+        // con GL_CLAMP_TO_EDGE:
+
+        float sample_height (const Color_Buffer< Monochrome8 > & image, const glm::vec2 & uv)
+        {
+            const int   width  = int(image.get_width  ());
+            const int   height = int(image.get_height ());
+
+            const float x  = uv.x * float(width ) - 0.5f;
+            const float y  = uv.y * float(height) - 0.5f;
+            const float fx = x - std::floor (x);
+            const float fy = y - std::floor (y);
+
+            const int x0 = std::min (std::max (int(std::floor (x)),     0), width  - 1);
+            const int y0 = std::min (std::max (int(std::floor (y)),     0), height - 1);
+            const int x1 = std::min (std::max (int(std::floor (x)) + 1, 0), width  - 1);
+            const int y1 = std::min (std::max (int(std::floor (y)) + 1, 0), height - 1);
+
+            const float top    = float(image.row (unsigned(y0))[x0]) * (1.f - fx) + float(image.row (unsigned(y0))[x1]) * fx;
+            const float bottom = float(image.row (unsigned(y1))[x0]) * (1.f - fx) + float(image.row (unsigned(y1))[x1]) * fx;
+
+            return (top * (1.f - fy) + bottom * fy) * (1.f / 255.f);
+        }
+
+        // Los fragment shaders reciben en varyings lo que su vertex shader pasaba como "out":
+
+        glm::vec4 terrain_shader (const glm::vec4 & varyings, float, const void *)
+        {
+            const float intensity = varyings.x;
+
+            return glm::vec4(intensity, intensity, intensity, 1.f);
+        }
+
+        glm::vec4 cone_shader (const glm::vec4 & varyings, float, const void *)
+        {
+            return varyings;                        // front_color y frag_opacity
+        }
+
+        glm::vec4 lighthouse_shader (const glm::vec4 & varyings, float lod, const void * uniforms)
+        {
+            const auto * mips = static_cast< const Software_Rasterizer::Mip_Chain * >(uniforms);
+
+            // Sin textura se ve el placeholder gris de Texture:
+
+            const glm::vec3 color = mips ? glm::vec3(Software_Rasterizer::sample_trilinear (*mips, glm::vec2(varyings), lod)) : glm::vec3(128.f / 255.f);
+
+            return glm::vec4(color * varyings.z, 1.f);
+        }
+
+        // Índices de un GL_TRIANGLE_FAN como lista de triángulos:
+
+        std::vector< uint32_t > fan_indices (size_t vertex_count)
+        {
+            std::vector< uint32_t > indices;
+
+            for (uint32_t i = 1; i + 1 < vertex_count; ++i)
+            {
+                indices.push_back (0);
+                indices.push_back (i);
+                indices.push_back (i + 1);
+            }
+
+            return indices;
+        }
+
+    }
+
+    Software_Scene::Software_Scene(unsigned width, unsigned height)
+    :
+        rasterizer(width, height),
+        angle     (0.f)
+    {
+        // Terreno, con la misma resolución que el de Scene:
+
+        std::vector< float   > coordinates;
+        std::vector< float   > uvs;
+        std::vector< GLsizei > indices;
+
+        Terrain::generate (10.f, 10.f, 50, 50, coordinates, uvs, indices);
+
+        for (size_t i = 0; i + 1 < coordinates.size (); i += 2)
+        {
+            terrain_xz .push_back (glm::vec2(coordinates[i], coordinates[i + 1]));
+            terrain_uvs.push_back (glm::vec2(uvs        [i], uvs        [i + 1]));
+        }
+
+        terrain_indices.assign (indices.begin (), indices.end ());
+
+        height_map = load_image< Monochrome8 > (Scene::texture_path);
+
+        if (!height_map) std::cerr << "Error loading height map: " << Scene::texture_path << std::endl;
+
+        // Cono:
+
+        std::vector< GLfloat > base;
+        std::vector< GLfloat > tip;
+
+        Cone::generate (base, tip);
+
+        for (size_t i = 0; i + 2 < base.size (); i += 3) cone_base.push_back (glm::vec3(base[i], base[i + 1], base[i + 2]));
+        for (size_t i = 0; i + 2 < tip .size (); i += 3) cone_tip .push_back (glm::vec3(tip [i], tip [i + 1], tip [i + 2]));
+
+        cone_base_indices = fan_indices (cone_base.size ());
+        cone_tip_indices  = fan_indices (cone_tip .size ());
+
+        // Faro. Se dibuja el nivel de detalle más alto de cada submalla:
+
+        if (Mesh::import (Scene::model_path, lighthouse))
+        {
+            for (const auto & submesh : lighthouse.submeshes)
+            {
+                if (submesh.lods.empty ()) continue;
+
+                const Mesh::Lod & lod = submesh.lods.front ();
+
+                for (GLsizei i = 0; i < lod.index_count; ++i)
+                {
+                    lighthouse_indices.push_back (uint32_t(lighthouse.indices[lod.index_offset + i] + submesh.base_vertex));
+                }
+            }
+
+            if (lighthouse.uvs.size () < lighthouse.positions.size ()) lighthouse.uvs.resize (lighthouse.positions.size (), glm::vec2(0.f));
+
+            lighthouse_texture = Texture::load_mipmapped (Scene::texture_uvs);
+        }
+    }
+
+    void Software_Scene::update ()
+    {
+        angle += .005f;
+    }
+
+    void Software_Scene::render (Thread_Pool * workers)
+    {
+        rasterizer.clear (glm::vec4(0.1f, 0.1f, 0.1f, 1.f));
+
+        // Las mismas matrices que Scene::render():
+
+        glm::mat4 model_view_matrix(1.f);
+        model_view_matrix = glm::translate (model_view_matrix, glm::vec3(0.f, -5.f, -20.f));
+        model_view_matrix = glm::rotate    (model_view_matrix, angle, glm::vec3(0.f, 1.f, 0.f));
+
+        const glm::mat4 projection_matrix = glm::perspective (glm::radians (45.f), 1.f, 10.f, 500.f);
+
+        draw_terrain (model_view_matrix, projection_matrix, workers);
+
+        if (has_lighthouse ())
+        {
+            glm::mat4 lighthouse_matrix(1.f);
+            lighthouse_matrix = glm::translate (lighthouse_matrix, glm::vec3(0.f, 1.9f, 0.f));
+            lighthouse_matrix = glm::scale     (lighthouse_matrix, glm::vec3(0.05f));
+
+            draw_lighthouse (model_view_matrix * lighthouse_matrix, projection_matrix, workers);
+        }
+
+        // El cono es translúcido, así que va el último:
+
+        glm::mat4 cone_matrix(1.f);
+        cone_matrix = glm::rotate    (cone_matrix, glm::radians (90.f), glm::vec3(1.f, 0.f, 0.f));
+        cone_matrix = glm::rotate    (cone_matrix, -angle * 2, glm::vec3(0.f, 0.f, 1.f));
+        cone_matrix = glm::translate (cone_matrix, glm::vec3(0.f, -5.f, -5.f));
+
+        draw_cone (model_view_matrix * cone_matrix, projection_matrix);
+
+        rasterizer.flush (workers);
+    }
+
+    void Software_Scene::draw_terrain (const glm::mat4 & model_view, const glm::mat4 & projection, Thread_Pool * workers)
+    {
+        const glm::mat4 transform = projection * model_view;
+
+        vertices.resize (terrain_xz.size ());
+
+        // Vertex shader del terreno: la altura sale del height map.
+
+        for_each_vertex
+        (
+            vertices.size (), workers,
+            [this, &transform] (size_t i)
+            {
+                const float sample = height_map ? sample_height (*height_map, terrain_uvs[i]) : 0.f;
+
+                vertices[i].position = transform * glm::vec4(terrain_xz[i].x, sample * max_height, terrain_xz[i].y, 1.f);
+                vertices[i].varyings = glm::vec4(sample * 0.75f + 0.25f, 0.f, 0.f, 0.f);
+            }
+        );
+
+        // Terrain::render() con glFrontFace (GL_CCW):
+
+        rasterizer.draw (Draw{ vertices.data (), terrain_indices.data (), terrain_indices.size (), Software_Rasterizer::TRIANGLES, Software_Rasterizer::CULL_CW, false, terrain_shader, nullptr, glm::vec2(0.f) });
+
+        // Terrain::renderWireframe() con line_color = 0, es decir, líneas negras:
+
+        for (auto & vertex : vertices) vertex.varyings = glm::vec4(0.f);
+
+        rasterizer.draw (Draw{ vertices.data (), terrain_indices.data (), terrain_indices.size (), Software_Rasterizer::LINES, Software_Rasterizer::CULL_NONE, false, terrain_shader, nullptr, glm::vec2(0.f) });
+    }
+
+    void Software_Scene::draw_lighthouse (const glm::mat4 & model_view, const glm::mat4 & projection, Thread_Pool * workers)
+    {
+        const glm::mat4 transform   = projection * model_view;
+        const glm::mat3 normal_part = glm::mat3(model_view);
+
+        vertices.resize (lighthouse.positions.size ());
+
+        // Vertex shader de Texture: UV y sombreado por vértice con la normal octaédrica.
+
+        for_each_vertex
+        (
+            vertices.size (), workers,
+            [this, &transform, &normal_part] (size_t i)
+            {
+                float shade = 1.f;
+
+                if (i < lighthouse.tangent_frames.size () && lighthouse.tangent_frames[i].tangent[0] != -32768)
+                {
+                    glm::vec3 normal, tangent;
+                    float     sign;
+
+                    Tangent_Space::unpack (lighthouse.tangent_frames[i], normal, tangent, sign);
+
+                    shade = 0.35f + 0.65f * std::max (glm::dot (glm::normalize (normal_part * normal), light_direction), 0.f);
+                }
+
+                vertices[i].position = transform * glm::vec4(lighthouse.positions[i], 1.f);
+                vertices[i].varyings = glm::vec4(lighthouse.uvs[i], shade, 0.f);
+            }
+        );
+
+        const glm::vec2 texture_size = lighthouse_texture
+            ? glm::vec2(lighthouse_texture->get_level (0).get_width (), lighthouse_texture->get_level (0).get_height ())
+            : glm::vec2(0.f);
+
+        rasterizer.draw (Draw{ vertices.data (), lighthouse_indices.data (), lighthouse_indices.size (), Software_Rasterizer::TRIANGLES, Software_Rasterizer::CULL_CW, false, lighthouse_shader, lighthouse_texture.get (), texture_size });
+    }
+
+    void Software_Scene::draw_cone (const glm::mat4 & model_view, const glm::mat4 & projection)
+    {
+        const glm::mat4 transform = projection * model_view;
+
+        // Cone::render() con opacity = 0.8 y Cone::renderWireframe() con opacity = 1. La base se
+        // dibuja con glFrontFace (GL_CCW) y la punta con glFrontFace (GL_CW):
+
+        for (bool wireframe : { false, true })
+        {
+            const glm::vec4 color(1.f, 1.f, 1.f, wireframe ? 1.f : 0.8f);
+
+            vertices.clear ();
+
+            for (const auto & position : cone_base) vertices.push_back (Vertex{ transform * glm::vec4(position, 1.f), color });
+
+            rasterizer.draw (Draw{ vertices.data (), cone_base_indices.data (), cone_base_indices.size (), Software_Rasterizer::TRIANGLES, Software_Rasterizer::CULL_CW, wireframe, cone_shader, nullptr, glm::vec2(0.f) });
+
+            vertices.clear ();
+
+            for (const auto & position : cone_tip) vertices.push_back (Vertex{ transform * glm::vec4(position, 1.f), color });
+
+            rasterizer.draw (Draw{ vertices.data (), cone_tip_indices.data (), cone_tip_indices.size (), Software_Rasterizer::TRIANGLES, Software_Rasterizer::CULL_CCW, wireframe, cone_shader, nullptr, glm::vec2(0.f) });
+        }
+    }
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Color.hpp>
+#include <Color_Buffer.hpp>
+#include <Software_Rasterizer.hpp>
+
+#include "Mesh.hpp"
+
+namespace udit
+{
+
+    class Thread_Pool;
+
+    // La misma escena que Scene (terreno con el height map, faros texturizados y cono
+    // translúcido) dibujada con Software_Rasterizer en lugar de OpenGL, con los mismos
+    // recursos, matrices, culling y sombreado. No reproduce el cielo, la textura virtual ni los
+    // personajes animados.
+
+    class Software_Scene
+    {
+    public:
+
+        using Vertex = Software_Rasterizer::Vertex;
+
+    private:
+
+        Software_Rasterizer rasterizer;
+
+        std::unique_ptr< Color_Buffer< Monochrome8 > > height_map;
+
+        std::vector< glm::vec2 >  terrain_xz;
+        std::vector< glm::vec2 >  terrain_uvs;
+        std::vector< uint32_t  >  terrain_indices;
+
+        std::vector< glm::vec3 >  cone_base;
+        std::vector< glm::vec3 >  cone_tip;
+        std::vector< uint32_t  >  cone_base_indices;    // Los abanicos pasados a listas de triángulos
+        std::vector< uint32_t  >  cone_tip_indices;
+
+        Mesh::Data                lighthouse;
+        std::vector< uint32_t  >  lighthouse_indices;   // LOD 0 de cada submalla, con base_vertex sumado
+        std::unique_ptr< Software_Rasterizer::Mip_Chain > lighthouse_texture;
+
+        std::vector< Vertex >     vertices;             // Resultado del "vertex shader" de cada draw
+
+        float angle;
+
+    public:
+
+        Software_Scene(unsigned width, unsigned height);
+
+        void update ();
+
+        // Con workers se transforman los vértices y se rasterizan las casillas en paralelo:
+
+        void render (Thread_Pool * workers = nullptr);
+
+        void resize (unsigned width, unsigned height)
+        {
+            rasterizer.resize (width, height);
+        }
+
+        bool has_height_map () const { return bool(height_map); }
+        bool has_lighthouse () const { return !lighthouse_indices.empty (); }
+
+        const Software_Rasterizer & get_rasterizer () const
+        {
+            return rasterizer;
+        }
+
+    private:
+
+        void draw_terrain    (const glm::mat4 & model_view, const glm::mat4 & projection, Thread_Pool * workers);
+        void draw_lighthouse (const glm::mat4 & model_view, const glm::mat4 & projection, Thread_Pool * workers);
+        void draw_cone       (const glm::mat4 & model_view, const glm::mat4 & projection);
+
+    };
+
+}
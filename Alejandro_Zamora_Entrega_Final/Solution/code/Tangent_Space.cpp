@@ -0,0 +1,408 @@
+#include "Tangent_Space.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define TANGENT_SPACE_SSE
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        const float pi = 3.14159265f;
+
+        glm::vec2 encode_octahedral (const glm::vec3 & vector)
+        {
+            const glm::vec3 n = vector / (std::abs (vector.x) + std::abs (vector.y) + std::abs (vector.z));
+
+            if (n.z >= 0.f) return glm::vec2(n.x, n.y);
+
+            // El hemisferio inferior se pliega sobre las esquinas del cuadrado:
+
+            return glm::vec2
+            (
+                (1.f - std::abs (n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+                (1.f - std::abs (n.x)) * (n.y >= 0.f ? 1.f : -1.f)
+            );
+        }
+
+        glm::vec3 decode_octahedral (const glm::vec2 & encoded)
+        {
+            glm::vec3 n(encoded.x, encoded.y, 1.f - std::abs (encoded.x) - std::abs (encoded.y));
+
+            const float fold = std::max (-n.z, 0.f);
+
+            n.x += n.x >= 0.f ? -fold : fold;
+            n.y += n.y >= 0.f ? -fold : fold;
+
+            return glm::normalize (n);
+        }
+
+        int16_t to_snorm16 (float value)
+        {
+            return int16_t(std::lround (std::min (std::max (value, -1.f), 1.f) * 32767.f));
+        }
+
+        glm::vec3 any_perpendicular (const glm::vec3 & normal)
+        {
+            return glm::normalize (glm::cross (normal, std::abs (normal.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f)));
+        }
+
+        float corner_angle (const glm::vec3 & a, const glm::vec3 & b)
+        {
+            const float lengths = glm::length (a) * glm::length (b);
+
+            return lengths > 0.f ? std::acos (std::min (std::max (glm::dot (a, b) / lengths, -1.f), 1.f)) : 0.f;
+        }
+
+        #ifdef TANGENT_SPACE_SSE
+
+            inline __m128 dot3 (__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+            {
+                return _mm_add_ps (_mm_add_ps (_mm_mul_ps (ax, bx), _mm_mul_ps (ay, by)), _mm_mul_ps (az, bz));
+            }
+
+            // acos de Abramowitz y Stegun (error menor que 7e-5 radianes), suficiente para pesos:
+
+            inline __m128 acos_ps (__m128 x)
+            {
+                const __m128 sign_mask = _mm_set1_ps (-0.f);
+                const __m128 negative  = _mm_cmplt_ps (x, _mm_setzero_ps ());
+                const __m128 a         = _mm_min_ps (_mm_andnot_ps (sign_mask, x), _mm_set1_ps (1.f));
+
+                __m128 polynomial = _mm_set1_ps (-0.0187293f);
+
+                polynomial = _mm_add_ps (_mm_mul_ps (polynomial, a), _mm_set1_ps ( 0.0742610f));
+                polynomial = _mm_add_ps (_mm_mul_ps (polynomial, a), _mm_set1_ps (-0.2121144f));
+                polynomial = _mm_add_ps (_mm_mul_ps (polynomial, a), _mm_set1_ps ( 1.5707288f));
+
+                const __m128 positive = _mm_mul_ps (_mm_sqrt_ps (_mm_sub_ps (_mm_set1_ps (1.f), a)), polynomial);
+
+                // acos(-x) = pi - acos(x):
+
+                return _mm_or_ps (_mm_and_ps (negative, _mm_sub_ps (_mm_set1_ps (pi), positive)), _mm_andnot_ps (negative, positive));
+            }
+
+            // Normaliza tres componentes; los vectores nulos se quedan a cero:
+
+            inline void normalize3 (__m128 & x, __m128 & y, __m128 & z)
+            {
+                const __m128 length_squared = dot3 (x, y, z, x, y, z);
+                const __m128 valid          = _mm_cmpgt_ps (length_squared, _mm_set1_ps (1e-30f));
+                const __m128 inverse        = _mm_and_ps (valid, _mm_div_ps (_mm_set1_ps (1.f), _mm_sqrt_ps (_mm_max_ps (length_squared, _mm_set1_ps (1e-30f)))));
+
+                x = _mm_mul_ps (x, inverse);
+                y = _mm_mul_ps (y, inverse);
+                z = _mm_mul_ps (z, inverse);
+            }
+
+        #endif
+
+    }
+
+    Tangent_Frame Tangent_Space::pack (const glm::vec3 & normal, const glm::vec3 & tangent, float sign)
+    {
+        const glm::vec2 n = encode_octahedral (normal);
+        const glm::vec2 t = encode_octahedral (tangent);
+
+        Tangent_Frame frame;
+
+        frame.normal [0] = to_snorm16 (n.x);
+        frame.normal [1] = to_snorm16 (n.y);
+        frame.tangent[0] = to_snorm16 (t.x);
+        frame.tangent[1] = int16_t((to_snorm16 (t.y) & ~1) | (sign < 0.f ? 1 : 0));
+
+        return frame;
+    }
+
+    void Tangent_Space::unpack (const Tangent_Frame & frame, glm::vec3 & normal, glm::vec3 & tangent, float & sign)
+    {
+        normal  = decode_octahedral (glm::vec2(frame.normal [0], frame.normal [1]) / 32767.f);
+        tangent = decode_octahedral (glm::vec2(frame.tangent[0], frame.tangent[1]) / 32767.f);
+        sign    = (frame.tangent[1] & 1) ? -1.f : 1.f;
+    }
+
+    void Tangent_Space::compute_faces (const glm::vec3 * positions, const glm::vec2 * uvs, const GLuint * corners, size_t begin, size_t end, Face * faces)
+    {
+        size_t triangle = begin;
+
+        #ifdef TANGENT_SPACE_SSE
+
+            for ( ; triangle + 4 <= end; triangle += 4)
+            {
+                // Se reúnen los datos de cuatro triángulos en formato SoA:
+
+                float p[3][3][4], t[3][2][4];
+
+                for (unsigned k = 0; k < 4; ++k)
+                {
+                    for (unsigned corner = 0; corner < 3; ++corner)
+                    {
+                        const GLuint vertex = corners[(triangle + k) * 3 + corner];
+
+                        p[corner][0][k] = positions[vertex].x;
+                        p[corner][1][k] = positions[vertex].y;
+                        p[corner][2][k] = positions[vertex].z;
+                        t[corner][0][k] = uvs[vertex].x;
+                        t[corner][1][k] = uvs[vertex].y;
+                    }
+                }
+
+                const __m128 p0x = _mm_loadu_ps (p[0][0]), p0y = _mm_loadu_ps (p[0][1]), p0z = _mm_loadu_ps (p[0][2]);
+
+                __m128 d1x = _mm_sub_ps (_mm_loadu_ps (p[1][0]), p0x), d1y = _mm_sub_ps (_mm_loadu_ps (p[1][1]), p0y), d1z = _mm_sub_ps (_mm_loadu_ps (p[1][2]), p0z);
+                __m128 d2x = _mm_sub_ps (_mm_loadu_ps (p[2][0]), p0x), d2y = _mm_sub_ps (_mm_loadu_ps (p[2][1]), p0y), d2z = _mm_sub_ps (_mm_loadu_ps (p[2][2]), p0z);
+
+                const __m128 s1x = _mm_sub_ps (_mm_loadu_ps (t[1][0]), _mm_loadu_ps (t[0][0]));
+                const __m128 s1y = _mm_sub_ps (_mm_loadu_ps (t[1][1]), _mm_loadu_ps (t[0][1]));
+                const __m128 s2x = _mm_sub_ps (_mm_loadu_ps (t[2][0]), _mm_loadu_ps (t[0][0]));
+                const __m128 s2y = _mm_sub_ps (_mm_loadu_ps (t[2][1]), _mm_loadu_ps (t[0][1]));
+
+                // Normal de la cara:
+
+                __m128 nx = _mm_sub_ps (_mm_mul_ps (d1y, d2z), _mm_mul_ps (d1z, d2y));
+                __m128 ny = _mm_sub_ps (_mm_mul_ps (d1z, d2x), _mm_mul_ps (d1x, d2z));
+                __m128 nz = _mm_sub_ps (_mm_mul_ps (d1x, d2y), _mm_mul_ps (d1y, d2x));
+
+                normalize3 (nx, ny, nz);
+
+                // Tangente (d1 * s2.y - d2 * s1.y) con el signo del área en el espacio de las UVs:
+
+                const __m128 area = _mm_sub_ps (_mm_mul_ps (s1x, s2y), _mm_mul_ps (s1y, s2x));
+                const __m128 sign = _mm_or_ps (_mm_and_ps (_mm_cmplt_ps (area, _mm_setzero_ps ()), _mm_set1_ps (-0.f)), _mm_set1_ps (1.f));
+
+                __m128 tx = _mm_mul_ps (sign, _mm_sub_ps (_mm_mul_ps (d1x, s2y), _mm_mul_ps (d2x, s1y)));
+                __m128 ty = _mm_mul_ps (sign, _mm_sub_ps (_mm_mul_ps (d1y, s2y), _mm_mul_ps (d2y, s1y)));
+                __m128 tz = _mm_mul_ps (sign, _mm_sub_ps (_mm_mul_ps (d1z, s2y), _mm_mul_ps (d2z, s1y)));
+
+                normalize3 (tx, ty, tz);
+
+                // Ángulos de las esquinas 0 y 1; el tercero es lo que falta hasta pi:
+
+                __m128 ex = _mm_sub_ps (d2x, d1x), ey = _mm_sub_ps (d2y, d1y), ez = _mm_sub_ps (d2z, d1z);
+
+                normalize3 (d1x, d1y, d1z);
+                normalize3 (d2x, d2y, d2z);
+                normalize3 (ex , ey , ez );
+
+                const __m128 angle0 = acos_ps (dot3 (d1x, d1y, d1z, d2x, d2y, d2z));
+                const __m128 angle1 = acos_ps (_mm_sub_ps (_mm_setzero_ps (), dot3 (d1x, d1y, d1z, ex, ey, ez)));
+                const __m128 angle2 = _mm_max_ps (_mm_sub_ps (_mm_sub_ps (_mm_set1_ps (pi), angle0), angle1), _mm_setzero_ps ());
+
+                float out[10][4];
+
+                _mm_storeu_ps (out[0], nx); _mm_storeu_ps (out[1], ny); _mm_storeu_ps (out[2], nz);
+                _mm_storeu_ps (out[3], tx); _mm_storeu_ps (out[4], ty); _mm_storeu_ps (out[5], tz);
+                _mm_storeu_ps (out[6], sign);
+                _mm_storeu_ps (out[7], angle0); _mm_storeu_ps (out[8], angle1); _mm_storeu_ps (out[9], angle2);
+
+                for (unsigned k = 0; k < 4; ++k)
+                {
+                    Face & face = faces[triangle + k];
+
+                    face.normal    = glm::vec3(out[0][k], out[1][k], out[2][k]);
+                    face.tangent   = glm::vec3(out[3][k], out[4][k], out[5][k]);
+                    face.sign      = out[6][k];
+                    face.angles[0] = out[7][k];
+                    face.angles[1] = out[8][k];
+                    face.angles[2] = out[9][k];
+                }
+            }
+
+        #endif
+
+        for ( ; triangle < end; ++triangle)
+        {
+            const GLuint * vertex = corners + triangle * 3;
+
+            const glm::vec3 d1 = positions[vertex[1]] - positions[vertex[0]];
+            const glm::vec3 d2 = positions[vertex[2]] - positions[vertex[0]];
+            const glm::vec2 s1 = uvs[vertex[1]] - uvs[vertex[0]];
+            const glm::vec2 s2 = uvs[vertex[2]] - uvs[vertex[0]];
+
+            const glm::vec3 normal  = glm::cross (d1, d2);
+            const float     sign    = s1.x * s2.y - s1.y * s2.x < 0.f ? -1.f : 1.f;
+            const glm::vec3 tangent = sign * (d1 * s2.y - d2 * s1.y);
+
+            Face & face = faces[triangle];
+
+            face.normal    = glm::length (normal ) > 0.f ? glm::normalize (normal ) : glm::vec3(0.f);
+            face.tangent   = glm::length (tangent) > 0.f ? glm::normalize (tangent) : glm::vec3(0.f);
+            face.sign      = sign;
+            face.angles[0] = corner_angle (d1, d2);
+            face.angles[1] = corner_angle (-d1, d2 - d1);
+            face.angles[2] = std::max (pi - face.angles[0] - face.angles[1], 0.f);
+        }
+    }
+
+    void Tangent_Space::generate
+    (
+        const glm::vec3 * positions,
+        const glm::vec2 * uvs,
+        size_t            vertex_count,
+        const GLuint    * corners,
+        size_t            corner_count,
+        Thread_Pool     & workers,
+        Tangent_Frame   * frames
+    )
+    {
+        const size_t triangle_count = corner_count / 3;
+
+        // Fase 1: datos de cada triángulo.
+
+        std::vector< Face > faces(triangle_count);
+
+        workers.parallel_for (triangle_count, [&] (size_t begin, size_t end)
+        {
+            compute_faces (positions, uvs, corners, begin, end, faces.data ());
+        });
+
+        // Esquinas de cada vértice ordenadas por counting sort (formato CSR):
+
+        std::vector< uint32_t > offsets(vertex_count + 1, 0);
+
+        for (size_t corner = 0; corner < triangle_count * 3; ++corner)
+        {
+            offsets[corners[corner] + 1]++;
+        }
+
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+
+        std::vector< uint32_t > vertex_corners(triangle_count * 3);
+        std::vector< uint32_t > cursor(offsets.begin (), offsets.end () - 1);
+
+        for (size_t corner = 0; corner < triangle_count * 3; ++corner)
+        {
+            vertex_corners[cursor[corners[corner]]++] = uint32_t(corner);
+        }
+
+        // Fase 2: cada vértice acumula las normales de sus caras ponderadas por ángulo:
+
+        std::vector< glm::vec3 > face_normals(vertex_count);
+
+        workers.parallel_for (vertex_count, [&] (size_t begin, size_t end)
+        {
+            for (size_t vertex = begin; vertex < end; ++vertex)
+            {
+                glm::vec3 normal(0.f);
+
+                for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+                {
+                    const uint32_t corner = vertex_corners[i];
+                    const Face   & face   = faces[corner / 3];
+
+                    normal += face.angles[corner % 3] * face.normal;
+                }
+
+                face_normals[vertex] = normal;
+            }
+        });
+
+        // Los vértices que sólo se separan por una costura de UVs comparten posición. Se agrupan
+        // con una tabla hash para que la costura no se note en la iluminación:
+
+        const uint32_t none = ~uint32_t(0);
+
+        std::vector< uint32_t > same_position(vertex_count, none);      // Siguiente vértice del grupo
+        std::vector< uint32_t > group        (vertex_count);            // Primer vértice del grupo
+
+        {
+            size_t table_size = 1;
+
+            while (table_size < vertex_count * 2) table_size <<= 1;
+
+            std::vector< uint32_t > table(table_size, none);
+
+            for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+            {
+                const uint32_t * bits = reinterpret_cast< const uint32_t * >(&positions[vertex]);
+
+                size_t slot = size_t((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u)) & (table_size - 1);
+
+                while (table[slot] != none && positions[table[slot]] != positions[vertex])
+                {
+                    slot = (slot + 1) & (table_size - 1);
+                }
+
+                if (table[slot] == none)
+                {
+                    table[slot]   = uint32_t(vertex);
+                    group[vertex] = uint32_t(vertex);
+                }
+                else
+                {
+                    const uint32_t first = table[slot];
+
+                    group        [vertex] = first;
+                    same_position[vertex] = same_position[first];
+                    same_position[first ] = uint32_t(vertex);
+                }
+            }
+        }
+
+        // Fase 3: normal final (sumando las del grupo que no formen una arista viva de más de 60
+        // grados) y tangentes proyectadas sobre ella:
+
+        const float crease_cosine = 0.5f;
+
+        workers.parallel_for (vertex_count, [&] (size_t begin, size_t end)
+        {
+            for (size_t vertex = begin; vertex < end; ++vertex)
+            {
+                const uint32_t   first = offsets[vertex];
+                const uint32_t   last  = offsets[vertex + 1];
+                const glm::vec3 & own  = face_normals[vertex];
+
+                glm::vec3 normal(0.f);
+
+                for (uint32_t other = group[vertex]; other != none; other = same_position[other])
+                {
+                    const glm::vec3 & candidate = face_normals[other];
+
+                    if (other == vertex || glm::dot (own, candidate) > crease_cosine * glm::length (own) * glm::length (candidate))
+                    {
+                        normal += candidate;
+                    }
+                }
+
+                const float normal_length = glm::length (normal);
+
+                normal = normal_length > 1e-20f ? normal / normal_length : glm::vec3(0.f, 0.f, 1.f);
+
+                glm::vec3 tangent(0.f);
+                float     orientation = 0.f;
+
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    const uint32_t    corner    = vertex_corners[i];
+                    const Face      & face      = faces[corner / 3];
+                    const float       weight    = face.angles[corner % 3];
+                    const glm::vec3   projected = face.tangent - normal * glm::dot (normal, face.tangent);
+                    const float       length    = glm::length (projected);
+
+                    if (length > 1e-20f) tangent += projected * (weight / length);
+
+                    orientation += weight * face.sign;
+                }
+
+                tangent -= normal * glm::dot (normal, tangent);
+
+                const float tangent_length = glm::length (tangent);
+
+                tangent = tangent_length > 1e-20f ? tangent / tangent_length : any_perpendicular (normal);
+
+                frames[vertex] = pack (normal, tangent, orientation < 0.f ? -1.f : 1.f);
+            }
+        });
+    }
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+#include <glm.hpp>
+
+#include <Thread_Pool.hpp>
+
+namespace udit
+{
+
+    // Base tangente de un vértice en 8 bytes: normal y tangente en codificación octaédrica con
+    // dos snorm16 cada una. El bit bajo de tangent[1] guarda el signo de la bitangente (1 si es
+    // negativo), que se reconstruye como sign * cross(normal, tangent).
+
+    struct Tangent_Frame
+    {
+        int16_t normal [2];
+        int16_t tangent[2];
+    };
+
+    // Generador de normales y tangentes compatible con las reglas de MikkTSpace: la tangente de
+    // cada esquina sale de las derivadas de las UVs del triángulo, se proyecta sobre la normal
+    // del vértice y se pondera por el ángulo de la esquina; el signo de la bitangente sigue la
+    // orientación del triángulo en el espacio de las UVs. Las normales también se ponderan por
+    // ángulo y se suavizan entre los vértices con la misma posición (costuras de UVs) salvo en
+    // aristas vivas de más de 60 grados. No se parten vértices: la malla ya llega soldada por
+    // posición y UV.
+    //
+    // Se trabaja por fases en paralelo: primero los datos de cada triángulo (con SSE, cuatro
+    // triángulos a la vez) y después cada vértice recoge los de sus esquinas, de modo que no hay
+    // escrituras compartidas entre hilos.
+
+    class Tangent_Space
+    {
+    public:
+
+        // corners son índices absolutos de vértice, tres por triángulo. Los vértices que no usa
+        // ningún triángulo reciben una base arbitraria.
+
+        static void generate
+        (
+            const glm::vec3 * positions,
+            const glm::vec2 * uvs,
+            size_t            vertex_count,
+            const GLuint    * corners,
+            size_t            corner_count,
+            Thread_Pool     & workers,
+            Tangent_Frame   * frames
+        );
+
+        static Tangent_Frame pack   (const glm::vec3 & normal, const glm::vec3 & tangent, float sign);
+        static void          unpack (const Tangent_Frame & frame, glm::vec3 & normal, glm::vec3 & tangent, float & sign);
+
+    private:
+
+        struct Face
+        {
+            glm::vec3 normal;                       // Unitaria
+            glm::vec3 tangent;                      // Dirección de la tangente sin ortogonalizar
+            float     sign;                         // Orientación en el espacio de las UVs
+            float     angles[3];                    // Ángulo de cada esquina
+        };
+
+        static void compute_faces (const glm::vec3 * positions, const glm::vec2 * uvs, const GLuint * corners, size_t begin, size_t end, Face * faces);
+
+    };
+
+}
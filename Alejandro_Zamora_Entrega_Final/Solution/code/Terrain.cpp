@@ -15,52 +15,15 @@ namespace udit
     {
         number_of_vertices = x_slices * z_slices;
 
-        vector< half > coordinates(number_of_vertices * 2);     // Sólo es necesario guardar las coordenadas X y Z
-        vector< half > texture_uvs(number_of_vertices * 2);
-        
-        for (unsigned z = 0; z < z_slices - 1; ++z)
-        {
-            for (unsigned x = 0; x < x_slices - 1; ++x)
-            {
-                unsigned i = z * x_slices + x;
-
-                indices.push_back(i + x_slices);
-                indices.push_back(i + 1);
-                indices.push_back(i);
-
-                indices.push_back(i + x_slices + 1);
-                indices.push_back(i + 1);
-                indices.push_back(i + x_slices);
-            }
-        }
+        vector< float > float_coordinates;
+        vector< float > float_uvs;
 
+        generate (width, depth, x_slices, z_slices, float_coordinates, float_uvs, indices);
 
+        // En la GPU basta con media precisión:
 
-        float x = -width * .5f;
-        float z = -depth * .5f;
-        float u =  0.f;
-        float v =  0.f;
-
-        float x_step = width / float(x_slices);
-        float z_step = depth / float(z_slices);
-        float u_step =   1.f / float(x_slices);
-        float v_step =   1.f / float(z_slices);
-
-        int   coordinate_index = 0;
-
-        for (unsigned j = 0; j < z_slices; ++j, z += z_step, v += v_step)
-        {
-            for (unsigned i = 0; i < x_slices; ++i, coordinate_index += 2, x += x_step, u += u_step)
-            {
-                coordinates[coordinate_index + 0] = half(x);
-                coordinates[coordinate_index + 1] = half(z);
-                texture_uvs[coordinate_index + 0] = half(u);
-                texture_uvs[coordinate_index + 1] = half(v);
-            }
-
-            x = -width * .5f;                              // Se invierte el sentido para hacer un zigzag
-            u = 0;
-        }
+        vector< half > coordinates(float_coordinates.begin (), float_coordinates.end ());     // Sólo es necesario guardar las coordenadas X y Z
+        vector< half > texture_uvs(float_uvs        .begin (), float_uvs        .end ());
 
         // Se crean el VAO y los VBOs:
 
@@ -97,6 +60,64 @@ namespace udit
         glDeleteBuffers      (VBO_COUNT, vbo_ids);
     }
 
+    void Terrain::generate
+    (
+        float              width,
+        float              depth,
+        unsigned           x_slices,
+        unsigned           z_slices,
+        vector< float   > & coordinates,
+        vector< float   > & texture_uvs,
+        vector< GLsizei > & indices
+    )
+    {
+        coordinates.assign (size_t(x_slices) * z_slices * 2, 0.f);
+        texture_uvs.assign (size_t(x_slices) * z_slices * 2, 0.f);
+        indices    .clear  ();
+
+        for (unsigned z = 0; z < z_slices - 1; ++z)
+        {
+            for (unsigned x = 0; x < x_slices - 1; ++x)
+            {
+                unsigned i = z * x_slices + x;
+
+                indices.push_back(i + x_slices);
+                indices.push_back(i + 1);
+                indices.push_back(i);
+
+                indices.push_back(i + x_slices + 1);
+                indices.push_back(i + 1);
+                indices.push_back(i + x_slices);
+            }
+        }
+
+        float x = -width * .5f;
+        float z = -depth * .5f;
+        float u =  0.f;
+        float v =  0.f;
+
+        float x_step = width / float(x_slices);
+        float z_step = depth / float(z_slices);
+        float u_step =   1.f / float(x_slices);
+        float v_step =   1.f / float(z_slices);
+
+        int   coordinate_index = 0;
+
+        for (unsigned j = 0; j < z_slices; ++j, z += z_step, v += v_step)
+        {
+            for (unsigned i = 0; i < x_slices; ++i, coordinate_index += 2, x += x_step, u += u_step)
+            {
+                coordinates[coordinate_index + 0] = x;
+                coordinates[coordinate_index + 1] = z;
+                texture_uvs[coordinate_index + 0] = u;
+                texture_uvs[coordinate_index + 1] = v;
+            }
+
+            x = -width * .5f;                              // Se invierte el sentido para hacer un zigzag
+            u = 0;
+        }
+    }
+
     void Terrain::render ()
     {
         // Se selecciona el VAO que contiene los datos del objeto y se dibujan sus vértices
@@ -41,6 +41,20 @@
             Terrain(float width, float depth, unsigned x_slices, unsigned z_slices);
            ~Terrain();
 
+            // Genera la malla en memoria de CPU (coordenadas X y Z, UVs e índices de triángulos)
+            // sin usar OpenGL, para quien la dibuje de otra forma:
+
+            static void generate
+            (
+                float              width,
+                float              depth,
+                unsigned           x_slices,
+                unsigned           z_slices,
+                vector< float   > & coordinates,
+                vector< float   > & texture_uvs,
+                vector< GLsizei > & indices
+            );
+
         public:
 
             void render ();
@@ -1,7 +1,36 @@
 #include"Texture.hpp"
 
+#include <cstring>
+#include <iostream>
+#include <Image_File.hpp>
+#include <Thread_Pool.hpp>
+
 using namespace udit;
 
+namespace
+{
+    // BC1 y BC3 dependen de EXT_texture_compression_s3tc, que no es parte del ncleo de OpenGL:
+    bool is_s3tc_supported()
+    {
+        static const bool supported = []
+        {
+            GLint extension_count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+            for (GLint i = 0; i < extension_count; ++i)
+            {
+                const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+
+                if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) return true;
+            }
+
+            return false;
+        }();
+
+        return supported;
+    }
+}
+
 const std::string Texture::vertex_shader_code =
 
 "#version 330\n"
@@ -9,15 +38,74 @@ const std::string Texture::vertex_shader_code =
 "uniform mat4 model_view_matrix;"
 "uniform mat4 projection_matrix;"
 ""
-"layout (location = 0) in vec3 vertex_coordinates;"
-"layout (location = 1) in vec2 vertex_texture_uv;"
+"layout (location = 0) in vec3  vertex_coordinates;"
+"layout (location = 1) in vec2  vertex_texture_uv;"
+"layout (location = 8) in ivec4 vertex_tangent_frame;"
+""
+"out vec2  texture_uv;"
+"out float shade;"
+""
+"const vec3 light_direction = vec3(0.37, 0.74, 0.56);"
 ""
-"out vec2 texture_uv;"
+"vec3 decode_octahedral (vec2 e)"
+"{"
+"   vec3  n    = vec3(e, 1.0 - abs (e.x) - abs (e.y));"
+"   float fold = max (-n.z, 0.0);"
+"   n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);"
+"   return normalize (n);"
+"}"
+""
+"float shade_vertex (mat4 model_view)"
+"{"
+"   if (vertex_tangent_frame.z == -32768) return 1.0;"
+"   vec3 normal = normalize (mat3(model_view) * decode_octahedral (vec2(vertex_tangent_frame.xy) / 32767.0));"
+"   return 0.35 + 0.65 * max (dot (normal, light_direction), 0.0);"
+"}"
 ""
 "void main()"
 "{"
 "   gl_Position = projection_matrix * model_view_matrix * vec4(vertex_coordinates, 1.0);"
 "   texture_uv  = vertex_texture_uv;"
+"   shade       = shade_vertex (model_view_matrix);"
+"}";
+
+const std::string Texture::instanced_vertex_shader_code =
+
+"#version 330\n"
+""
+"uniform mat4 view_matrix;"
+"uniform mat4 projection_matrix;"
+""
+"layout (location = 0) in vec3  vertex_coordinates;"
+"layout (location = 1) in vec2  vertex_texture_uv;"
+"layout (location = 2) in mat4  instance_model_matrix;"
+"layout (location = 8) in ivec4 vertex_tangent_frame;"
+""
+"out vec2  texture_uv;"
+"out float shade;"
+""
+"const vec3 light_direction = vec3(0.37, 0.74, 0.56);"
+""
+"vec3 decode_octahedral (vec2 e)"
+"{"
+"   vec3  n    = vec3(e, 1.0 - abs (e.x) - abs (e.y));"
+"   float fold = max (-n.z, 0.0);"
+"   n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);"
+"   return normalize (n);"
+"}"
+""
+"float shade_vertex (mat4 model_view)"
+"{"
+"   if (vertex_tangent_frame.z == -32768) return 1.0;"
+"   vec3 normal = normalize (mat3(model_view) * decode_octahedral (vec2(vertex_tangent_frame.xy) / 32767.0));"
+"   return 0.35 + 0.65 * max (dot (normal, light_direction), 0.0);"
+"}"
+""
+"void main()"
+"{"
+"   gl_Position = projection_matrix * view_matrix * instance_model_matrix * vec4(vertex_coordinates, 1.0);"
+"   texture_uv  = vertex_texture_uv;"
+"   shade       = shade_vertex (view_matrix * instance_model_matrix);"
 "}";
 
 const std::string Texture::fragment_shader_code =
@@ -26,28 +114,34 @@ const std::string Texture::fragment_shader_code =
 ""
 "uniform sampler2D sampler2d;"
 ""
-"in  vec2 texture_uv;"
-"out vec4 fragment_color;"
+"in  vec2  texture_uv;"
+"in  float shade;"
+"out vec4  fragment_color;"
 ""
 "void main()"
 "{"
-"    fragment_color = vec4(texture (sampler2d, texture_uv.st).rgb, 1.0);"
+"    fragment_color = vec4(texture (sampler2d, texture_uv.st).rgb * shade, 1.0);"
 "}";
 
-Texture::Texture(const std::string& tex_file_path) : angle(0.0f), depth(-5.0f), speed(-0.2f)
+Texture::Texture() : texture_id(0), there_is_texture(false), gpu_bytes(0), loaded(false), keep_mips(false), base_level(0), streamed_texture_id(0), streamed_level(0), streamed_row(0), angle(0.0f), depth(-5.0f), speed(-0.2f)
 {
     program_id = compile_shaders();
 
+    instanced_program_id = udit::compile_shaders(instanced_vertex_shader_code, fragment_shader_code);
+
     glUseProgram(program_id);
 
     model_view_matrix_id = glGetUniformLocation(program_id, "model_view_matrix");
     projection_matrix_id = glGetUniformLocation(program_id, "projection_matrix");
 
-    // Se carga la textura y se enva a la GPU:
+    // Se crea un placeholder gris hasta que llegue la imagen definitiva:
 
-    texture_id = create_texture_2d(tex_file_path);
+    Color_Buffer placeholder(1, 1);
+    placeholder.set(0, Rgba8888{ 0xFF808080 });
 
-    there_is_texture = texture_id > 0;
+    upload(placeholder);
+
+    loaded = false;
 
     // Se establece la configuracin bsica:
 
@@ -56,39 +150,483 @@ Texture::Texture(const std::string& tex_file_path) : angle(0.0f), depth(-5.0f),
     glClearColor(0.1f, 0.1f, 0.1f, 1.f);
 }
 
+Texture::Texture(const std::string& tex_file_path) : Texture()
+{
+    // Se carga la textura y se enva a la GPU:
+
+    if (Ktx2_File::is_ktx2(tex_file_path))
+    {
+        auto compressed = load_compressed(tex_file_path);
+
+        if (compressed) upload(*compressed);
+
+        return;
+    }
+
+    auto mips = load_mipmapped(tex_file_path);
+
+    if (mips) upload(*mips);
+}
+
+void Texture::upload(const Color_Buffer& image)
+{
+    Mip_Chain mips{ Color_Buffer(image) };
+
+    mips.build(mip_filter, mip_srgb);
+
+    upload(mips);
+}
+
+void Texture::upload(const Mip_Chain& mips)
+{
+    if (there_is_texture)
+        glDeleteTextures(1, &texture_id);
+
+    texture_id = create_texture_2d(mips);
+
+    there_is_texture = texture_id > 0;
+
+    gpu_bytes = there_is_texture ? mips.get_byte_count() : 0;
+
+    resident_mips.reset();
+    base_level = 0;
+
+    loaded = there_is_texture;
+}
+
+void Texture::begin_upload(std::shared_ptr< const Mip_Chain > mips)
+{
+    if (streamed_texture_id)
+        glDeleteTextures(1, &streamed_texture_id);
+
+    // Se reserva la memoria de todos los niveles sin datos; las bandas se copian despus con
+    // glTexSubImage2D desde el anillo:
+
+    glGenTextures(1, &streamed_texture_id);
+    glBindTexture(GL_TEXTURE_2D, streamed_texture_id);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    for (size_t level = 0; level < mips->get_level_count(); ++level)
+    {
+        const Color_Buffer& image = mips->get_level(level);
+
+        glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA8, image.get_width(), image.get_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(mips->get_level_count()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    streamed_mips  = std::move(mips);
+    streamed_file.reset();
+    streamed_level = 0;
+    streamed_row   = 0;
+}
+
+void Texture::begin_upload(std::shared_ptr< const Mapped_File > file, const Ktx2_File::Layout& layout)
+{
+    if (streamed_texture_id)
+        glDeleteTextures(1, &streamed_texture_id);
+
+    glGenTextures(1, &streamed_texture_id);
+    glBindTexture(GL_TEXTURE_2D, streamed_texture_id);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    for (size_t level = 0; level < layout.level_sizes.size(); ++level)
+    {
+        glCompressedTexImage2D
+        (
+            GL_TEXTURE_2D, GLint(level), Ktx2_File::get_gl_format(layout.format),
+            Ktx2_File::get_level_size(layout.width, level), Ktx2_File::get_level_size(layout.height, level), 0,
+            GLsizei(layout.level_sizes[level]), nullptr
+        );
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(layout.level_sizes.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    streamed_mips.reset();
+    streamed_file   = std::move(file);
+    streamed_layout = layout;
+    streamed_level  = 0;
+    streamed_row    = 0;
+}
+
+Texture::Upload_Status Texture::continue_upload(Upload_Ring& ring)
+{
+    if (streamed_file) return continue_file_upload(ring);
+
+    if (!streamed_mips) return UPLOAD_DONE;
+
+    const Color_Buffer& image     = streamed_mips->get_level(streamed_level);
+    const unsigned      width     = image.get_width();
+    const size_t        row_bytes = size_t(width) * sizeof(Rgba8888);
+
+    // La banda no puede ocupar ms de una parte del anillo para que siempre quepan varias:
+
+    const size_t   band_bytes = std::min(size_t(upload_band_bytes), ring.get_capacity() / 4);
+    const unsigned rows       = std::max(std::min(unsigned(band_bytes / row_bytes), image.get_height() - streamed_row), 1u);
+
+    size_t   offset;
+    uint8_t* destination = ring.map(rows * row_bytes, offset);
+
+    if (!destination) return UPLOAD_STALLED;
+
+    if (image.is_contiguous())
+        std::memcpy(destination, image.row(streamed_row), rows * row_bytes);
+    else
+        for (unsigned row = 0; row < rows; ++row)
+            std::memcpy(destination + row * row_bytes, image.row(streamed_row + row), row_bytes);
+
+    ring.unmap();
+
+    // Con el PBO enlazado, el puntero de glTexSubImage2D es la posicin dentro del bfer y la
+    // copia a la textura la hace la GPU sin bloquear este hilo:
+
+    glBindTexture(GL_TEXTURE_2D, streamed_texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, GLint(streamed_level), 0, GLint(streamed_row), width, rows, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast< const void* >(offset));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    streamed_row += rows;
+
+    if (streamed_row < image.get_height()) return UPLOAD_PENDING;
+
+    streamed_row = 0;
+
+    if (++streamed_level < streamed_mips->get_level_count()) return UPLOAD_PENDING;
+
+    finish_upload(streamed_mips->get_byte_count());
+
+    if (keep_mips)
+        resident_mips = std::move(streamed_mips);
+
+    streamed_mips.reset();
+
+    return UPLOAD_DONE;
+}
+
+Texture::Upload_Status Texture::continue_file_upload(Upload_Ring& ring)
+{
+    const size_t   level       = streamed_level;
+    const unsigned width       = Ktx2_File::get_level_size(streamed_layout.width,  level);
+    const unsigned height      = Ktx2_File::get_level_size(streamed_layout.height, level);
+    const size_t   row_bytes   = size_t((width + 3) / 4) * Block_Compression::get_block_bytes(streamed_layout.format);
+    const unsigned block_rows  = (height + 3) / 4;
+
+    // Las bandas son filas enteras de bloques de 4x4, que es lo que admite glCompressedTexSubImage2D:
+
+    const size_t   band_bytes  = std::min(size_t(upload_band_bytes), ring.get_capacity() / 4);
+    const unsigned rows        = std::max(std::min(unsigned(band_bytes / row_bytes), block_rows - streamed_row), 1u);
+
+    size_t   offset;
+    uint8_t* destination = ring.map(rows * row_bytes, offset);
+
+    if (!destination) return UPLOAD_STALLED;
+
+    // nica copia en la CPU: de la proyeccin del archivo al anillo. El Asset_Loader ya ha
+    // ledo las pginas en un hilo de trabajo, as que aqu no se espera al disco:
+
+    std::memcpy(destination, streamed_file->data() + streamed_layout.level_offsets[level] + streamed_row * row_bytes, rows * row_bytes);
+
+    ring.unmap();
+
+    const unsigned y = streamed_row * 4;
+
+    glBindTexture(GL_TEXTURE_2D, streamed_texture_id);
+    glCompressedTexSubImage2D
+    (
+        GL_TEXTURE_2D, GLint(level), 0, GLint(y), width, std::min(rows * 4, height - y),
+        Ktx2_File::get_gl_format(streamed_layout.format), GLsizei(rows * row_bytes), reinterpret_cast< const void* >(offset)
+    );
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    streamed_row += rows;
+
+    if (streamed_row < block_rows) return UPLOAD_PENDING;
+
+    streamed_row = 0;
+
+    if (++streamed_level < streamed_layout.level_sizes.size()) return UPLOAD_PENDING;
+
+    size_t bytes = 0;
+
+    for (size_t size : streamed_layout.level_sizes)
+        bytes += size;
+
+    finish_upload(bytes);
+
+    resident_mips.reset();
+    streamed_file.reset();
+
+    return UPLOAD_DONE;
+}
+
+void Texture::finish_upload(size_t bytes)
+{
+    // Terminada la cadena, la textura nueva sustituye al placeholder:
+
+    if (there_is_texture)
+        glDeleteTextures(1, &texture_id);
+
+    texture_id          = streamed_texture_id;
+    streamed_texture_id = 0;
+    there_is_texture    = true;
+    loaded              = true;
+    gpu_bytes           = bytes;
+    base_level          = 0;
+}
+
+void Texture::set_base_level(unsigned level)
+{
+    if (!resident_mips || !there_is_texture) return;
+
+    level = std::min(level, unsigned(resident_mips->get_level_count()) - 1);
+
+    if (level == base_level) return;
+
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (level < base_level)
+    {
+        // Se suben los niveles que faltan antes de dejar que la GPU los muestree:
+
+        for (unsigned l = level; l < base_level; ++l)
+        {
+            const Color_Buffer& image = resident_mips->get_level(l);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(image.get_pitch()));
+            glTexImage2D(GL_TEXTURE_2D, GLint(l), GL_RGBA8, image.get_width(), image.get_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.colors());
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, GLint(level));
+    }
+    else
+    {
+        // Primero se deja de muestrear los niveles y despus se libera su memoria. Los niveles
+        // por debajo de la base no cuentan para que la textura est completa:
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, GLint(level));
+
+        for (unsigned l = base_level; l < level; ++l)
+            glTexImage2D(GL_TEXTURE_2D, GLint(l), GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    base_level = level;
+    gpu_bytes  = 0;
+
+    for (size_t l = level; l < resident_mips->get_level_count(); ++l)
+        gpu_bytes += size_t(resident_mips->get_level(l).get_width()) * resident_mips->get_level(l).get_height() * sizeof(Rgba8888);
+}
+
+void Texture::upload(const Ktx2_File::Image& image)
+{
+    if (there_is_texture)
+        glDeleteTextures(1, &texture_id);
+
+    texture_id = create_texture_2d(image);
+
+    there_is_texture = texture_id > 0;
+
+    resident_mips.reset();
+    base_level = 0;
+
+    // Los niveles ocupan en la GPU lo mismo que en el archivo, salvo si hubo que descomprimirlos:
+
+    gpu_bytes = 0;
+
+    for (size_t level = 0; there_is_texture && level < image.levels.size(); ++level)
+    {
+        gpu_bytes += is_supported(image.format)
+                   ? image.levels[level].size()
+                   : size_t(Ktx2_File::get_level_size(image.width, level)) * Ktx2_File::get_level_size(image.height, level) * sizeof(Rgba8888);
+    }
+
+    loaded = there_is_texture;
+}
+
 GLuint Texture::create_texture_2d(const std::string& texture_path)
 {
     auto image = load_image(texture_path);
 
-    if (image)
+    if (!image) return 0;
+
+    // La imagen decodificada pasa a ser el nivel 0 de la cadena sin copiarse:
+
+    Mip_Chain mips(std::move(*image));
+
+    mips.build(mip_filter, mip_srgb);
+
+    return create_texture_2d(mips);
+}
+
+GLuint Texture::create_texture_2d(const Color_Buffer& image)
+{
+    // Los mipmaps se calculan en la CPU con un filtro mejor que el del driver:
+
+    Mip_Chain mips{ Color_Buffer(image) };
+
+    mips.build(mip_filter, mip_srgb);
+
+    return create_texture_2d(mips);
+}
+
+GLuint Texture::create_texture_2d(const Mip_Chain& mips)
+{
+    // Se habilitan las texturas, se genera un id para un bfer de textura,
+    // se selecciona el bfer de textura creado y se configuran algunos de
+    // sus parmetros:
+
+    GLuint texture_id;
+
+    glEnable(GL_TEXTURE_2D);
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    // Se sube cada nivel de la cadena ya calculada en lugar de llamar a glGenerateMipmap. Con
+    // GL_UNPACK_ROW_LENGTH el driver lee tambin imgenes cuyas filas estn separadas:
+
+    for (size_t level = 0; level < mips.get_level_count(); ++level)
     {
-        // Se habilitan las texturas, se genera un id para un bfer de textura,
-        // se selecciona el bfer de textura creado y se configuran algunos de
-        // sus parmetros:
+        const Color_Buffer& image = mips.get_level(level);
 
-        GLuint texture_id;
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(image.get_pitch()));
+        glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA, image.get_width(), image.get_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.colors());
+    }
 
-        glEnable(GL_TEXTURE_2D);
-        glGenTextures(1, &texture_id);
-        glBindTexture(GL_TEXTURE_2D, texture_id);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
-        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, image->get_width(), image->get_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image->colors() );
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(mips.get_level_count()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-        glGenerateMipmap(GL_TEXTURE_2D);
+    return texture_id;
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+GLuint Texture::create_texture_cube(const std::vector< std::unique_ptr<Color_Buffer> >& faces)
+{
+    if (faces.size() != 6 || !faces[0] || faces[0]->get_width() != faces[0]->get_height()) return 0;
 
-        return texture_id;
+    for (const auto& face : faces)
+    {
+        if (!face || face->get_width() != faces[0]->get_width() || face->get_height() != faces[0]->get_height()) return 0;
+    }
+
+    GLuint texture_id;
+
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+
+    // Las caras se suben a la vez a la misma textura. Al verse siempre a un tamao parecido al
+    // suyo no necesitan mipmaps:
+
+    for (GLenum face = 0; face < 6; ++face)
+    {
+        const Color_Buffer& image = *faces[face];
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(image.get_pitch()));
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, image.get_width(), image.get_height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.colors());
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    return texture_id;
+}
+
+GLuint Texture::create_texture_2d(const Ktx2_File::Image& image)
+{
+    GLuint texture_id;
+
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    // Los mipmaps vienen calculados en el archivo, as que se sube cada nivel tal cual y no
+    // hace falta llamar a glGenerateMipmap:
+
+    const bool compressed = is_supported(image.format);
+
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        const unsigned width  = Ktx2_File::get_level_size(image.width,  level);
+        const unsigned height = Ktx2_File::get_level_size(image.height, level);
+
+        if (compressed)
+        {
+            glCompressedTexImage2D
+            (
+                GL_TEXTURE_2D, GLint(level), Ktx2_File::get_gl_format(image.format), width, height, 0,
+                GLsizei(image.levels[level].size()), image.levels[level].data()
+            );
+        }
+        else
+        {
+            Color_Buffer decoded(width, height);
+
+            Block_Compression::decode(image.format, image.levels[level].data(), width, height, decoded.colors());
+
+            glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.colors());
+        }
     }
 
-    return -1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(image.levels.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    return texture_id;
+}
+
+bool Texture::is_supported(Block_Compression::Format format)
+{
+    return format == Block_Compression::BC4 || format == Block_Compression::BC5 || is_s3tc_supported();
 }
 
 std::unique_ptr< Texture::Color_Buffer > Texture::load_image(const std::string& image_path)
 {
+    // Las imgenes cocinadas (.qoi o .raw) se decodifican sin pasar por SOIL2, a la velocidad
+    // de la copia de memoria en lugar de la de inflate:
+
+    if (Image_File::is_fast(image_path))
+    {
+        unsigned  width  = 0;
+        unsigned  height = 0;
+        uint8_t*  pixels = Image_File::load(image_path, width, height, 4);
+
+        if (!pixels) return nullptr;
+
+        return std::make_unique< Color_Buffer >
+        (
+            reinterpret_cast<Rgba8888*>(pixels),
+            width,
+            height,
+            width,
+            [](Rgba8888* pixels) { Image_File::free_pixels(reinterpret_cast<uint8_t*>(pixels)); }
+        );
+    }
+
     // Se carga la imagen del archivo usando SOIL2:
 
     int image_width = 0;
@@ -104,87 +642,122 @@ std::unique_ptr< Texture::Color_Buffer > Texture::load_image(const std::string&
         SOIL_LOAD_RGBA              // Indica que nos devuelva los pixels en formato RGB32
     );                              // al margen del formato usado en el archivo
 
-    // Si loaded_pixels no es nullptr, la imagen se ha podido cargar correctamente:
+    // Si loaded_pixels no es nullptr, la imagen se ha podido cargar correctamente. El bfer
+    // adopta la memoria de SOIL2 sin copiarla y la libera al destruirse:
 
     if (loaded_pixels)
     {
-        auto image = std::make_unique< Color_Buffer >(image_width, image_height);
-
-        // Se copian los bytes de un buffer a otro directamente:
-
-        std::copy_n
+        return std::make_unique< Color_Buffer >
         (
-            loaded_pixels,
-            size_t(image_width) * size_t(image_height) * sizeof(Color_Buffer::Color),
-            reinterpret_cast<uint8_t*>(image->colors())
+            reinterpret_cast<Rgba8888*>(loaded_pixels),
+            unsigned(image_width),
+            unsigned(image_height),
+            unsigned(image_width),
+            [](Rgba8888* pixels) { SOIL_free_image_data(reinterpret_cast<uint8_t*>(pixels)); }
         );
+    }
+
+    return nullptr;
+}
 
-        // Se libera la memoria que reserv SOIL2 para cargar la imagen:
+std::vector< std::unique_ptr< Texture::Color_Buffer > > Texture::load_images(const std::vector<std::string>& image_paths, Thread_Pool* workers)
+{
+    std::vector< std::unique_ptr< Color_Buffer > > images(image_paths.size());
 
-        SOIL_free_image_data(loaded_pixels);
+    // Cada imagen se decodifica en su propio bloque, as que el tiempo total es el de la ms
+    // lenta en lugar de la suma de todas:
 
-        return image;
-    }
+    auto decode = [&image_paths, &images](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            images[i] = load_image(image_paths[i]);
 
-    return nullptr;
+            if (!images[i]) std::cerr << "Error loading image: " << image_paths[i] << std::endl;
+        }
+    };
+
+    if (workers)
+        workers->parallel_for(image_paths.size(), decode);
+    else
+        decode(0, image_paths.size());
+
+    return images;
 }
 
-GLuint Texture::compile_shaders()
+std::unique_ptr< Ktx2_File::Image > Texture::load_compressed(const std::string& ktx2_path)
 {
-    GLint succeeded = GL_FALSE;
+    auto image = std::make_unique< Ktx2_File::Image >();
 
-    // Se crean objetos para los shaders:
+    if (!Ktx2_File::read(ktx2_path, *image))
+    {
+        std::cerr << "Error loading texture: " << ktx2_path << std::endl;
+        return nullptr;
+    }
 
-    GLuint   vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+    return image;
+}
 
-    // Se carga el cdigo de los shaders:
+std::unique_ptr< Texture::Mip_Chain > Texture::load_mipmapped(const std::string& image_path)
+{
+    auto image = load_image(image_path);
 
-    const char* vertex_shaders_code[] = { vertex_shader_code.c_str() };
-    const char* fragment_shaders_code[] = { fragment_shader_code.c_str() };
-    const GLint    vertex_shaders_size[] = { (GLint)vertex_shader_code.size() };
-    const GLint  fragment_shaders_size[] = { (GLint)fragment_shader_code.size() };
+    if (!image) return nullptr;
 
-    glShaderSource(vertex_shader_id, 1, vertex_shaders_code, vertex_shaders_size);
-    glShaderSource(fragment_shader_id, 1, fragment_shaders_code, fragment_shaders_size);
+    auto mips = std::make_unique< Mip_Chain >(std::move(*image));
 
-    // Se compilan los shaders:
+    // La clave depende del contenido de la imagen, as que la cach se invalida sola si
+    // cambia el archivo original:
 
-    glCompileShader(vertex_shader_id);
-    glCompileShader(fragment_shader_id);
+    const std::string cache_path = image_path + ".mips";
+    const uint64_t    key        = mips->get_cache_key(mip_filter, mip_srgb);
 
-    // Se comprueba que si la compilacin ha tenido xito:
+    if (!mips->read_cache(cache_path, key))
+    {
+        mips->build(mip_filter, mip_srgb);
+        mips->write_cache(cache_path, key);
+    }
 
-    glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &succeeded);
-    if (!succeeded) show_compilation_error(vertex_shader_id);
+    return mips;
+}
 
-    glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &succeeded);
-    if (!succeeded) show_compilation_error(fragment_shader_id);
+bool Texture::cook(const std::string& source_path, const std::string& cooked_path, Block_Compression::Format format, Thread_Pool* workers)
+{
+    std::unique_ptr< Color_Buffer > image = load_image(source_path);
 
-    // Se crea un objeto para un programa:
+    if (!image)
+    {
+        std::cerr << "Error loading image: " << source_path << std::endl;
+        return false;
+    }
 
-    GLuint program_id = glCreateProgram();
+    Ktx2_File::Image cooked{ format, image->get_width(), image->get_height(), {} };
 
-    // Se cargan los shaders compilados en el programa:
+    // Se comprimen todos los niveles hasta llegar a 1x1, de modo que al cargar no haya que
+    // generar ningn mipmap. Los formatos de uno y dos canales guardan datos, no colores, y
+    // se filtran sin correccin gamma:
 
-    glAttachShader(program_id, vertex_shader_id);
-    glAttachShader(program_id, fragment_shader_id);
+    Mip_Chain mips(std::move(*image));
 
-    // Se linkan los shaders:
+    mips.build(mip_filter, format == Block_Compression::BC1 || format == Block_Compression::BC3, workers);
 
-    glLinkProgram(program_id);
+    for (size_t level = 0; level < mips.get_level_count(); ++level)
+    {
+        const Color_Buffer& source = mips.get_level(level);
 
-    // Se comprueba si el linkage ha tenido xito:
+        cooked.levels.emplace_back(Block_Compression::get_compressed_size(format, source.get_width(), source.get_height()));
 
-    glGetProgramiv(program_id, GL_LINK_STATUS, &succeeded);
-    if (!succeeded) show_linkage_error(program_id);
+        Block_Compression::encode(format, source.colors(), source.get_width(), source.get_height(), cooked.levels.back().data(), workers);
+    }
 
-    // Se liberan los shaders compilados una vez se han linkado:
+    return Ktx2_File::write(cooked_path, cooked);
+}
 
-    glDeleteShader(vertex_shader_id);
-    glDeleteShader(fragment_shader_id);
+GLuint Texture::compile_shaders()
+{
+    // Todas las texturas comparten el mismo programa, que slo se compila la primera vez:
 
-    return program_id;
+    return udit::compile_shaders(vertex_shader_code, fragment_shader_code);
 }
 
 GLuint Texture::GetTexId()
@@ -197,6 +770,10 @@ Texture::~Texture()
     if (there_is_texture)
         glDeleteTextures(1, &texture_id);
 
-    glDeleteProgram(program_id);
+    if (streamed_texture_id)
+        glDeleteTextures(1, &streamed_texture_id);
+
+    release_program(program_id);
+    release_program(instanced_program_id);
 }
 
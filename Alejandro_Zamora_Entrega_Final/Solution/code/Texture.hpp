@@ -4,24 +4,61 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <SOIL2.h>
 #include <glad/gl.h>
 #include <Color.hpp>
 #include <Color_Buffer.hpp>
+#include <Mapped_File.hpp>
+#include <Mip_Chain.hpp>
+#include <Upload_Ring.hpp>
 #include "opengl-recipes.hpp"
+#include "Ktx2_File.hpp"
 
 namespace udit
 {
+    class Thread_Pool;
+
     class Texture
     {
-    private:
+    public:
         using Color_Buffer = Color_Buffer<Rgba8888>;
+        using Mip_Chain    = Mip_Chain<Rgba8888>;
+
+        // Las imgenes de color estn en sRGB, as que sus mipmaps se filtran en luz lineal:
+        static constexpr Mip_Filter::Filter mip_filter = Mip_Filter::KAISER;
+        static constexpr bool               mip_srgb   = true;
+
+        // Bytes de cada banda de filas que se copia al anillo de subida:
+        static constexpr size_t upload_band_bytes = 4 << 20;
+
+        enum Upload_Status
+        {
+            UPLOAD_DONE,                        // Ya se ha subido la cadena entera
+            UPLOAD_PENDING,                     // Quedan bandas por copiar
+            UPLOAD_STALLED                      // El anillo est lleno; hay que esperar al siguiente fotograma
+        };
+
+    private:
 
         static const std::string   vertex_shader_code;
         static const std::string fragment_shader_code;
+        static const std::string instanced_vertex_shader_code;
 
         GLuint texture_id;
         bool   there_is_texture;
+        size_t gpu_bytes;                       // Imagen ms su cadena de mipmaps
+        bool   loaded;                          // false mientras se muestra el placeholder
+
+        std::shared_ptr< const Mip_Chain > streamed_mips;      // Cadena que se est subiendo por bandas
+        std::shared_ptr< const Mip_Chain > resident_mips;      // Se conserva para volver a subir niveles
+        std::shared_ptr< const Mapped_File > streamed_file;    // .ktx2 que se sube directamente desde el archivo
+        Ktx2_File::Layout streamed_layout;
+        bool     keep_mips;
+        unsigned base_level;                    // Primer nivel residente en la GPU
+        GLuint streamed_texture_id;
+        size_t streamed_level;
+        unsigned streamed_row;
 
         GLint  model_view_matrix_id;
         GLint  projection_matrix_id;
@@ -32,15 +69,76 @@ namespace udit
 
     public:
         GLuint GetTexId();
+        size_t get_gpu_bytes() const { return gpu_bytes; }
+        bool   is_loaded() const { return loaded; }
+        unsigned get_base_level() const { return base_level; }
+        const Mip_Chain* get_mips() const { return resident_mips.get(); }
         GLuint program_id;
+        GLuint instanced_program_id;            // Lee la matriz de modelo de un atributo por instancia
         GLuint compile_shaders();
         GLuint create_texture_2d(const std::string& texture_path);
+        GLuint create_texture_2d(const Color_Buffer& image);
+
+        // Sube cada nivel de la cadena sin llamar a glGenerateMipmap:
+        static GLuint create_texture_2d(const Mip_Chain& mips);
+
+        // Sube los bloques comprimidos de todos los niveles sin generar mipmaps. Si el driver
+        // no soporta S3TC los niveles BC1/BC3 se descomprimen en la CPU:
+        static GLuint create_texture_2d(const Ktx2_File::Image& image);
 
+        // Sube seis caras cuadradas del mismo tamao (+X, -X, +Y, -Y, +Z, -Z) como un cube map.
+        // Devuelve 0 si falta alguna o no coinciden sus tamaos:
+        static GLuint create_texture_cube(const std::vector< std::unique_ptr<Color_Buffer> >& faces);
+
+        // Sustituye el contenido actual (p. ej. el placeholder) por la imagen dada:
+        void   upload(const Color_Buffer& image);
+        void   upload(const Mip_Chain& mips);
+        void   upload(const Ktx2_File::Image& image);
+
+        // Subida por bandas a travs de un Upload_Ring. begin_upload reserva todos los niveles
+        // en una textura nueva y cada llamada a continue_upload copia una banda de filas; el
+        // placeholder se sigue usando hasta que se completa la cadena:
+        void          begin_upload(std::shared_ptr< const Mip_Chain > mips);
+        Upload_Status continue_upload(Upload_Ring& ring);
+
+        // Lo mismo con los bloques de un .ktx2: cada banda se copia de la proyeccin del archivo
+        // al anillo, sin pasar por un Ktx2_File::Image ni por la copia del driver. Requiere que
+        // is_supported(layout.format) sea cierto:
+        void          begin_upload(std::shared_ptr< const Mapped_File > file, const Ktx2_File::Layout& layout);
+
+        // Con keep_mips la cadena que llega por begin_upload se conserva en memoria de CPU y
+        // set_base_level puede descargar los niveles mayores que level (limitando
+        // GL_TEXTURE_BASE_LEVEL y liberando su memoria) o volver a subirlos:
+        void   set_mip_streaming(bool enabled) { keep_mips = enabled; }
+        void   set_base_level(unsigned level);
+
+        // Crea la textura con un placeholder gris de 1x1 hasta que se llame a upload():
+        Texture();
         Texture(const std::string& tex_file_path);
         ~Texture();
 
+        // No usan OpenGL, por lo que se pueden llamar desde un hilo de trabajo:
+        static std::unique_ptr<Color_Buffer> load_image(const std::string& image_path);
+        static std::unique_ptr<Ktx2_File::Image> load_compressed(const std::string& ktx2_path);
+
+        // Decodifica varias imgenes a la vez, una por hilo. Las que no se cargan quedan a nullptr:
+        static std::vector< std::unique_ptr<Color_Buffer> > load_images(const std::vector<std::string>& image_paths, Thread_Pool* workers);
+
+        // Carga la imagen con sus mipmaps, que se leen de image_path + ".mips" si la cach
+        // corresponde a la imagen actual o se calculan y se guardan en ella si no:
+        static std::unique_ptr<Mip_Chain> load_mipmapped(const std::string& image_path);
+
+        // Convierte una imagen en un .ktx2 comprimido con su cadena de mipmaps:
+        static bool cook(const std::string& source_path, const std::string& cooked_path, Block_Compression::Format format, Thread_Pool* workers = nullptr);
+
+        // Indica si el contexto actual acepta los bloques del formato sin descomprimirlos:
+        static bool is_supported(Block_Compression::Format format);
+
     private:
-        std::unique_ptr<Color_Buffer> load_image(const std::string& image_path);
+        Upload_Status continue_file_upload(Upload_Ring& ring);
+
+        // Sustituye el placeholder por la textura que se ha terminado de subir por bandas:
+        void          finish_upload(size_t bytes);
     };
 }
 
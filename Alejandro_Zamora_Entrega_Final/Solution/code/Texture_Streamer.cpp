@@ -0,0 +1,97 @@
+#include "Texture_Streamer.hpp"
+
+namespace udit
+{
+
+    Texture_Streamer::Texture_Streamer(size_t budget_bytes)
+    :
+        residency(budget_bytes)
+    {
+    }
+
+    void Texture_Streamer::track (const std::shared_ptr< Texture > & texture)
+    {
+        Tracked & tracked = textures[texture.get ()];
+
+        if (!tracked.texture.expired ()) return;
+
+        // Puede quedar la entrada de una textura ya destruida que tenía la misma dirección:
+
+        if (tracked.handle != Mip_Residency::no_handle) residency.remove (tracked.handle);
+
+        tracked.texture = texture;
+        tracked.handle  = Mip_Residency::no_handle;
+
+        texture->set_mip_streaming (true);
+    }
+
+    void Texture_Streamer::request (const Texture & texture, float uv_density, float pixels_per_unit)
+    {
+        auto found = textures.find (&texture);
+
+        if (found == textures.end () || found->second.handle == Mip_Residency::no_handle || found->second.texture.expired ()) return;
+
+        const Texture::Mip_Chain & mips = *texture.get_mips ();
+
+        residency.request
+        (
+            found->second.handle,
+            Mip_Residency::estimate_level (mips.get_level (0).get_width (), mips.get_level (0).get_height (), uv_density, pixels_per_unit)
+        );
+    }
+
+    void Texture_Streamer::update ()
+    {
+        // Se dan de baja las texturas destruidas y de alta las que ya han terminado de subirse:
+
+        for (auto iterator = textures.begin (); iterator != textures.end (); )
+        {
+            Tracked & tracked = iterator->second;
+
+            std::shared_ptr< Texture > texture = tracked.texture.lock ();
+
+            if (!texture)
+            {
+                if (tracked.handle != Mip_Residency::no_handle) residency.remove (tracked.handle);
+
+                iterator = textures.erase (iterator);
+                continue;
+            }
+
+            if (tracked.handle == Mip_Residency::no_handle && texture->get_mips ())
+            {
+                const Texture::Mip_Chain & mips = *texture->get_mips ();
+
+                tracked.handle = residency.add
+                (
+                    mips.get_level (0).get_width (),
+                    mips.get_level (0).get_height (),
+                    unsigned(mips.get_level_count ()),
+                    texture->get_base_level ()
+                );
+            }
+
+            ++iterator;
+        }
+
+        residency.update (max_load_bytes);
+
+        // set_base_level no hace nada con las que no han cambiado:
+
+        if (!residency.get_changes ().empty ())
+        {
+            for (auto & entry : textures)
+            {
+                std::shared_ptr< Texture > texture = entry.second.texture.lock ();
+
+                if (texture && entry.second.handle != Mip_Residency::no_handle)
+                {
+                    texture->set_base_level (residency.get_resident_level (entry.second.handle));
+                }
+            }
+        }
+
+        residency.begin_frame ();
+    }
+
+}
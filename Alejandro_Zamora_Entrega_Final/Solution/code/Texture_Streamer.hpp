@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include <Mip_Residency.hpp>
+
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    // Streaming de mipmaps de las texturas de los modelos dentro de un presupuesto de memoria
+    // de vídeo. Cada textura registrada conserva su cadena de mipmaps en memoria de CPU y, ya
+    // subida, se da de alta en un Mip_Residency. Al dibujar, cada modelo pide el nivel que
+    // necesita según el tamaño en pantalla de su malla y la densidad de sus UV; en update() se
+    // bajan o suben los niveles de cada textura con GL_TEXTURE_BASE_LEVEL.
+    //
+    // Sólo debe usarse desde el hilo de render.
+
+    class Texture_Streamer
+    {
+    public:
+
+        static constexpr size_t default_budget_bytes = size_t(256) << 20;
+        static constexpr size_t max_load_bytes       = size_t(  8) << 20;       // Por fotograma
+
+    private:
+
+        struct Tracked
+        {
+            std::weak_ptr< Texture > texture;
+            Mip_Residency::Handle    handle = Mip_Residency::no_handle;     // Hasta que termina de subirse
+        };
+
+        Mip_Residency residency;
+
+        std::unordered_map< const Texture *, Tracked > textures;
+
+    public:
+
+        explicit Texture_Streamer(size_t budget_bytes = default_budget_bytes);
+
+        Texture_Streamer(const Texture_Streamer & ) = delete;
+        Texture_Streamer & operator = (const Texture_Streamer & ) = delete;
+
+    public:
+
+        // Debe llamarse antes de que termine de subirse la textura para que conserve su cadena:
+
+        void track (const std::shared_ptr< Texture > & texture);
+
+        void request (const Texture & texture, float uv_density, float pixels_per_unit);
+
+        // Aplica lo pedido en el fotograma anterior y empieza a acumular el siguiente:
+
+        void update ();
+
+        void set_budget (size_t bytes)
+        {
+            residency.set_budget (bytes);
+        }
+
+        const Mip_Residency & get_residency () const
+        {
+            return residency;
+        }
+
+    };
+
+}
@@ -0,0 +1,478 @@
+#include "Virtual_Texture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "Texture.hpp"
+
+namespace udit
+{
+
+    const std::string Virtual_Texture::shader_code =
+
+        "uniform sampler2D vt_indirection;"
+        "uniform sampler2D vt_cache;"
+        "uniform vec2      vt_size;"
+        "uniform float     vt_max_level;"
+        "uniform int       vt_level_offsets[16];"
+        "uniform float     vt_cache_size;"
+        ""
+        "const float vt_page_size = " + std::to_string (page_size) + ".0;"
+        "const float vt_border    = " + std::to_string (page_border) + ".0;"
+        ""
+        // La retroalimentación se dibuja a 1/8 de resolución, así que sus derivadas son 8 veces
+        // mayores y el nivel sale 3 por encima del que se verá:
+        "\n#ifdef FEEDBACK\n"
+        "const float vt_lod_bias = -3.0;"
+        "\n#else\n"
+        "const float vt_lod_bias = 0.0;"
+        "\n#endif\n"
+        ""
+        "float vt_level (vec2 uv)"
+        "{"
+        "   vec2  dx  = dFdx (uv * vt_size);"
+        "   vec2  dy  = dFdy (uv * vt_size);"
+        "   float lod = 0.5 * log2 (max (max (dot (dx, dx), dot (dy, dy)), 1e-8)) + vt_lod_bias;"
+        "   return clamp (floor (lod), 0.0, vt_max_level);"
+        "}"
+        ""
+        "vec2 vt_level_size (float level)"
+        "{"
+        "   return max (floor (vt_size / exp2 (level)), vec2(1.0));"
+        "}"
+        ""
+        "vec2 vt_page (vec2 uv, float level)"
+        "{"
+        "   vec2 size = vt_level_size (level);"
+        "   return min (floor (uv * size / vt_page_size), ceil (size / vt_page_size) - 1.0);"
+        "}"
+        ""
+        "vec4 vt_request (vec2 uv)"
+        "{"
+        "   uv = clamp (uv, 0.0, 1.0);"
+        "   float level = vt_level (uv);"
+        "   return vec4(vt_page (uv, level), level, 255.0) / 255.0;"
+        "}"
+        ""
+        "vec3 vt_sample (vec2 uv)"
+        "{"
+        "   uv = clamp (uv, 0.0, 1.0);"
+        "   float level = vt_level (uv);"
+        "   ivec2 page  = ivec2(vt_page (uv, level));"
+        "   vec4  entry = floor (texelFetch (vt_indirection, ivec2(vt_level_offsets[int(level)] + page.x, page.y), 0) * 255.0 + 0.5);"
+        ""
+        "   if (entry.a == 0.0) return vec3(0.5);"
+        ""
+        // Si la página no está, la entrada apunta a un antecesor y se lee en su nivel:
+        "   vec2 texel    = uv * vt_level_size (entry.b);"
+        "   vec2 position = entry.xy * (vt_page_size + 2.0 * vt_border) + vt_border + texel - vt_page (uv, entry.b) * vt_page_size;"
+        ""
+        "   return textureLod (vt_cache, position / vt_cache_size, 0.0).rgb;"
+        "}";
+
+    Virtual_Texture::Virtual_Texture()
+    :
+        cache_texture_id       (0),
+        indirection_texture_id (0),
+        feedback_framebuffer_id(0),
+        feedback_color_id      (0),
+        feedback_depth_id      (0),
+        feedback_pbo_ids       { 0, 0 },
+        feedback_fences        { nullptr, nullptr },
+        feedback_width         (0),
+        feedback_height        (0),
+        feedback_index         (0),
+        saved_viewport         { 0, 0, 0, 0 },
+        in_flight              (0),
+        loaded_pages           (max_loads_in_flight * 2),
+        workers                (1)
+    {
+    }
+
+    Virtual_Texture::~Virtual_Texture()
+    {
+        for (GLsync fence : feedback_fences) if (fence) glDeleteSync (fence);
+
+        if (feedback_pbo_ids[0]    ) glDeleteBuffers      (2, feedback_pbo_ids);
+        if (feedback_framebuffer_id) glDeleteFramebuffers (1, &feedback_framebuffer_id);
+        if (feedback_color_id      ) glDeleteTextures     (1, &feedback_color_id);
+        if (feedback_depth_id      ) glDeleteRenderbuffers(1, &feedback_depth_id);
+        if (indirection_texture_id ) glDeleteTextures     (1, &indirection_texture_id);
+        if (cache_texture_id       ) glDeleteTextures     (1, &cache_texture_id);
+    }
+
+    bool Virtual_Texture::open (const std::string & path, unsigned slots_per_side)
+    {
+        if (!file.open (path)) return false;
+
+        Header header;
+
+        if (file.size () < sizeof(header))
+        {
+            file.close ();
+            return false;
+        }
+
+        std::memcpy (&header, file.data (), sizeof(header));
+
+        if (header.magic != file_magic || header.version != file_version || header.page_size != page_size || header.border != page_border
+         || header.width == 0 || header.height == 0)
+        {
+            std::cerr << "Invalid virtual texture: " << path << std::endl;
+            file.close ();
+            return false;
+        }
+
+        auto pages = std::make_unique< Page_Cache > (header.width, header.height, unsigned(page_size), slots_per_side);
+
+        // La retroalimentación guarda la página en 8 bits por coordenada, y la indirección el
+        // slot también en 8 bits:
+
+        if (pages->get_level_count () != header.level_count || pages->get_page_count_x (0) > 256 || pages->get_page_count_y (0) > 256 || slots_per_side > 256)
+        {
+            std::cerr << "Unsupported virtual texture: " << path << std::endl;
+            file.close ();
+            return false;
+        }
+
+        size_t page_count = 0;
+        int    columns    = 0;
+
+        first_page   .clear ();
+        level_offsets.clear ();
+
+        for (unsigned level = 0; level < pages->get_level_count (); ++level)
+        {
+            first_page   .push_back (page_count);
+            level_offsets.push_back (columns);
+
+            page_count += size_t(pages->get_page_count_x (level)) * pages->get_page_count_y (level);
+            columns    += int(pages->get_page_count_x (level));
+        }
+
+        if (file.size () < sizeof(Header) + page_count * slot_size * slot_size * 4)
+        {
+            std::cerr << "Truncated virtual texture: " << path << std::endl;
+            file.close ();
+            return false;
+        }
+
+        cache = std::move (pages);
+
+        // Caché física sin mipmaps: cada slot guarda una página ya filtrada para su nivel:
+
+        const GLsizei cache_size = GLsizei(slots_per_side * slot_size);
+
+        if (!cache_texture_id) glGenTextures (1, &cache_texture_id);
+
+        glBindTexture   (GL_TEXTURE_2D, cache_texture_id);
+        glTexImage2D    (GL_TEXTURE_2D, 0, GL_RGBA8, cache_size, cache_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,     GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,  0);
+
+        if (!indirection_texture_id) glGenTextures (1, &indirection_texture_id);
+
+        std::vector< uint32_t > empty(size_t(columns) * cache->get_page_count_y (0), 0u);
+
+        glBindTexture   (GL_TEXTURE_2D, indirection_texture_id);
+        glTexImage2D    (GL_TEXTURE_2D, 0, GL_RGBA8, columns, GLsizei(cache->get_page_count_y (0)), 0, GL_RGBA, GL_UNSIGNED_BYTE, empty.data ());
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,  0);
+        glBindTexture   (GL_TEXTURE_2D, 0);
+
+        return true;
+    }
+
+    bool Virtual_Texture::cook (const std::string & image_path, const std::string & output_path, Thread_Pool * workers)
+    {
+        std::unique_ptr< Texture::Color_Buffer > image = Texture::load_image (image_path);
+
+        if (!image)
+        {
+            std::cerr << "Error loading image: " << image_path << std::endl;
+            return false;
+        }
+
+        const unsigned width  = image->get_width  ();
+        const unsigned height = image->get_height ();
+
+        Texture::Mip_Chain mips(std::move (*image));
+
+        mips.build (Texture::mip_filter, Texture::mip_srgb, workers);
+
+        Page_Cache layout(width, height, page_size, 1);
+
+        std::ofstream output(output_path, std::ios::binary);
+
+        if (!output)
+        {
+            std::cerr << "Error writing virtual texture: " << output_path << std::endl;
+            return false;
+        }
+
+        const Header header{ file_magic, file_version, width, height, page_size, page_border, layout.get_level_count (), 0 };
+
+        output.write (reinterpret_cast< const char * >(&header), sizeof(header));
+
+        // Cada página lleva alrededor un borde con los texels vecinos (o los del límite de la
+        // imagen repetidos) para que el filtrado bilineal no lea de otro slot:
+
+        std::vector< Rgba8888 > page(size_t(slot_size) * slot_size);
+
+        for (unsigned level = 0; level < layout.get_level_count (); ++level)
+        {
+            const Texture::Color_Buffer & source = mips.get_level (level);
+
+            const int level_width  = int(source.get_width  ());
+            const int level_height = int(source.get_height ());
+
+            for (unsigned page_y = 0; page_y < layout.get_page_count_y (level); ++page_y)
+            {
+                for (unsigned page_x = 0; page_x < layout.get_page_count_x (level); ++page_x)
+                {
+                    for (int y = 0; y < int(slot_size); ++y)
+                    {
+                        const int source_y = std::min (std::max (int(page_y * page_size) + y - int(page_border), 0), level_height - 1);
+
+                        for (int x = 0; x < int(slot_size); ++x)
+                        {
+                            const int source_x = std::min (std::max (int(page_x * page_size) + x - int(page_border), 0), level_width - 1);
+
+                            page[size_t(y) * slot_size + x] = source.row (unsigned(source_y))[source_x];
+                        }
+                    }
+
+                    output.write (reinterpret_cast< const char * >(page.data ()), std::streamsize(page.size () * sizeof(Rgba8888)));
+                }
+            }
+        }
+
+        return bool(output);
+    }
+
+    void Virtual_Texture::resize (unsigned width, unsigned height)
+    {
+        feedback_width  = std::max (width  / feedback_divisor, 1u);
+        feedback_height = std::max (height / feedback_divisor, 1u);
+
+        if (!feedback_framebuffer_id)
+        {
+            glGenFramebuffers  (1, &feedback_framebuffer_id);
+            glGenTextures      (1, &feedback_color_id);
+            glGenRenderbuffers (1, &feedback_depth_id);
+            glGenBuffers       (2, feedback_pbo_ids);
+        }
+
+        glBindTexture   (GL_TEXTURE_2D, feedback_color_id);
+        glTexImage2D    (GL_TEXTURE_2D, 0, GL_RGBA8, GLsizei(feedback_width), GLsizei(feedback_height), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture   (GL_TEXTURE_2D, 0);
+
+        glBindRenderbuffer    (GL_RENDERBUFFER, feedback_depth_id);
+        glRenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, GLsizei(feedback_width), GLsizei(feedback_height));
+        glBindRenderbuffer    (GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer         (GL_FRAMEBUFFER, feedback_framebuffer_id);
+        glFramebufferTexture2D    (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedback_color_id, 0);
+        glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,  GL_RENDERBUFFER, feedback_depth_id);
+        glBindFramebuffer         (GL_FRAMEBUFFER, 0);
+
+        // Las lecturas pendientes tienen el tamaño anterior y se descartan:
+
+        for (int i = 0; i < 2; ++i)
+        {
+            if (feedback_fences[i]) glDeleteSync (feedback_fences[i]);
+
+            feedback_fences[i] = nullptr;
+
+            glBindBuffer (GL_PIXEL_PACK_BUFFER, feedback_pbo_ids[i]);
+            glBufferData (GL_PIXEL_PACK_BUFFER, GLsizeiptr(feedback_width) * feedback_height * 4, nullptr, GL_STREAM_READ);
+        }
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void Virtual_Texture::update ()
+    {
+        if (!cache) return;
+
+        read_feedback ();
+
+        // Se leen del archivo las páginas que faltan. La copia fuerza a leer del disco en el
+        // hilo de trabajo en lugar de en el de render:
+
+        for (uint32_t key : cache->take_loads (max_loads_in_flight - in_flight))
+        {
+            ++in_flight;
+
+            workers.submit
+            (
+                [this, key] ()
+                {
+                    const uint8_t * texels = get_page (key);
+
+                    Loaded_Page page{ key, std::vector< uint8_t >(texels, texels + size_t(slot_size) * slot_size * 4) };
+
+                    while (!loaded_pages.try_push (std::move (page)))
+                    {
+                        std::this_thread::yield ();
+                    }
+                }
+            );
+        }
+
+        // Se suben unas pocas por fotograma a su slot:
+
+        Loaded_Page page;
+
+        glBindBuffer  (GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture (GL_TEXTURE_2D, cache_texture_id);
+
+        for (size_t count = 0; count < max_uploads_per_frame && loaded_pages.try_pop (page); ++count)
+        {
+            --in_flight;
+
+            const unsigned slot = cache->insert (page.key);
+
+            if (slot == Page_Cache::no_slot) continue;
+
+            const unsigned side = cache->get_slots_per_side ();
+
+            glTexSubImage2D
+            (
+                GL_TEXTURE_2D, 0,
+                GLint(slot % side * slot_size), GLint(slot / side * slot_size), slot_size, slot_size,
+                GL_RGBA, GL_UNSIGNED_BYTE, page.texels.data ()
+            );
+        }
+
+        // Y se actualizan las zonas de la indirección que han cambiado:
+
+        glBindTexture (GL_TEXTURE_2D, indirection_texture_id);
+
+        for (unsigned level = 0; level < cache->get_level_count (); ++level)
+        {
+            if (!cache->is_dirty (level)) continue;
+
+            glTexSubImage2D
+            (
+                GL_TEXTURE_2D, 0, level_offsets[level], 0,
+                GLsizei(cache->get_page_count_x (level)), GLsizei(cache->get_page_count_y (level)),
+                GL_RGBA, GL_UNSIGNED_BYTE, cache->get_indirection (level).data ()
+            );
+
+            cache->clear_dirty (level);
+        }
+
+        glBindTexture (GL_TEXTURE_2D, 0);
+    }
+
+    void Virtual_Texture::read_feedback ()
+    {
+        // Se lee la retroalimentación más reciente sólo si la GPU ya la ha copiado al PBO:
+
+        const unsigned index = feedback_index ^ 1;
+        GLsync         fence = feedback_fences[index];
+
+        if (!fence) return;
+
+        const GLenum result = glClientWaitSync (fence, 0, 0);
+
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) return;
+
+        glDeleteSync (fence);
+
+        feedback_fences[index] = nullptr;
+
+        const size_t byte_count = size_t(feedback_width) * feedback_height * 4;
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, feedback_pbo_ids[index]);
+
+        const uint8_t * pixels = static_cast< const uint8_t * >(glMapBufferRange (GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(byte_count), GL_MAP_READ_BIT));
+
+        if (pixels)
+        {
+            cache->begin_frame ();
+
+            for (size_t offset = 0; offset < byte_count; offset += 4)
+            {
+                if (pixels[offset + 3] == 255)
+                {
+                    cache->request (Page_Cache::make_key (pixels[offset + 2], pixels[offset + 0], pixels[offset + 1]));
+                }
+            }
+
+            glUnmapBuffer (GL_PIXEL_PACK_BUFFER);
+        }
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void Virtual_Texture::begin_feedback ()
+    {
+        glGetIntegerv (GL_VIEWPORT, saved_viewport);
+
+        GLfloat clear_color[4];
+
+        glGetFloatv (GL_COLOR_CLEAR_VALUE, clear_color);
+
+        // Los píxeles con alfa 0 no piden ninguna página:
+
+        glBindFramebuffer (GL_FRAMEBUFFER, feedback_framebuffer_id);
+        glViewport        (0, 0, GLsizei(feedback_width), GLsizei(feedback_height));
+        glClearColor      (0.f, 0.f, 0.f, 0.f);
+        glClear           (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor      (clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    }
+
+    void Virtual_Texture::end_feedback ()
+    {
+        // La copia al PBO es asíncrona; update() la recoge cuando su fence se ha señalado:
+
+        if (feedback_fences[feedback_index]) glDeleteSync (feedback_fences[feedback_index]);
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, feedback_pbo_ids[feedback_index]);
+        glReadPixels (0, 0, GLsizei(feedback_width), GLsizei(feedback_height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+        feedback_fences[feedback_index] = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        feedback_index ^= 1;
+
+        glBindFramebuffer (GL_FRAMEBUFFER, 0);
+        glViewport        (saved_viewport[0], saved_viewport[1], saved_viewport[2], saved_viewport[3]);
+    }
+
+    void Virtual_Texture::bind (GLuint program_id, GLuint first_unit) const
+    {
+        glActiveTexture (GL_TEXTURE0 + first_unit);
+        glBindTexture   (GL_TEXTURE_2D, indirection_texture_id);
+        glActiveTexture (GL_TEXTURE0 + first_unit + 1);
+        glBindTexture   (GL_TEXTURE_2D, cache_texture_id);
+        glActiveTexture (GL_TEXTURE0);
+
+        glUniform1i  (glGetUniformLocation (program_id, "vt_indirection"  ), GLint(first_unit));
+        glUniform1i  (glGetUniformLocation (program_id, "vt_cache"        ), GLint(first_unit + 1));
+        glUniform2f  (glGetUniformLocation (program_id, "vt_size"         ), float(cache->get_level_width (0)), float(cache->get_level_height (0)));
+        glUniform1f  (glGetUniformLocation (program_id, "vt_max_level"    ), float(cache->get_level_count () - 1));
+        glUniform1iv (glGetUniformLocation (program_id, "vt_level_offsets"), GLsizei(level_offsets.size ()), level_offsets.data ());
+        glUniform1f  (glGetUniformLocation (program_id, "vt_cache_size"   ), float(cache->get_slots_per_side () * slot_size));
+    }
+
+    const uint8_t * Virtual_Texture::get_page (uint32_t key) const
+    {
+        const unsigned level = Page_Cache::get_level (key);
+        const size_t   index = first_page[level] + size_t(Page_Cache::get_y (key)) * cache->get_page_count_x (level) + Page_Cache::get_x (key);
+
+        return file.data () + sizeof(Header) + index * slot_size * slot_size * 4;
+    }
+
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include <Mapped_File.hpp>
+#include <Mpmc_Queue.hpp>
+#include <Page_Cache.hpp>
+#include <Thread_Pool.hpp>
+
+namespace udit
+{
+
+    // Textura virtual dispersa. La imagen y sus mipmaps se guardan en disco troceados en páginas
+    // de 128 x 128 texels (más un borde de 4 para el filtrado bilineal) y en la GPU sólo están
+    // las páginas que se ven, en una caché física de slots. Una textura de indirección con una
+    // zona por nivel dice, para cada página, en qué slot está ella o su antecesor residente.
+    //
+    // Cada fotograma se dibuja la escena a baja resolución con un shader que escribe la página
+    // que necesita cada píxel (retroalimentación). Ese búfer se lee un fotograma después sin
+    // bloquear y Page_Cache decide qué páginas leer y cuáles expulsar. Las páginas se copian del
+    // archivo proyectado en memoria en un hilo de trabajo y se suben en update().
+    //
+    // Los shaders que la usan incluyen shader_code, que define vt_sample (uv) y vt_request (uv).
+
+    class Virtual_Texture
+    {
+    public:
+
+        static constexpr unsigned page_size        = 128;
+        static constexpr unsigned page_border      = 4;
+        static constexpr unsigned slot_size        = page_size + 2 * page_border;
+        static constexpr unsigned feedback_divisor = 8;        // La retroalimentación se dibuja a 1/8
+        static constexpr unsigned default_slots_per_side = 16; // 256 slots, unos 19 MB
+        static constexpr size_t   max_loads_in_flight    = 32;
+        static constexpr size_t   max_uploads_per_frame  = 8;
+
+        static constexpr uint32_t file_magic   = 0x58545655;  // "UVTX"
+        static constexpr uint32_t file_version = 1;
+
+        static const std::string shader_code;
+
+    private:
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t page_size;
+            uint32_t border;
+            uint32_t level_count;
+            uint32_t reserved;
+        };
+
+        struct Loaded_Page
+        {
+            uint32_t               key;
+            std::vector< uint8_t > texels;
+        };
+
+        Mapped_File                   file;
+        std::unique_ptr< Page_Cache > cache;
+        std::vector< size_t >         first_page;       // Índice de la primera página de cada nivel
+        std::vector< int >            level_offsets;    // Columna de cada nivel en la indirección
+
+        GLuint   cache_texture_id;
+        GLuint   indirection_texture_id;
+        GLuint   feedback_framebuffer_id;
+        GLuint   feedback_color_id;
+        GLuint   feedback_depth_id;
+        GLuint   feedback_pbo_ids[2];
+        GLsync   feedback_fences [2];
+        unsigned feedback_width;
+        unsigned feedback_height;
+        unsigned feedback_index;
+        GLint    saved_viewport[4];
+
+        size_t                        in_flight;
+        Mpmc_Queue< Loaded_Page >     loaded_pages;
+        Thread_Pool                   workers;          // Se destruye antes que la cola
+
+    public:
+
+        Virtual_Texture();
+       ~Virtual_Texture();
+
+        Virtual_Texture(const Virtual_Texture & ) = delete;
+        Virtual_Texture & operator = (const Virtual_Texture & ) = delete;
+
+    public:
+
+        bool open (const std::string & path, unsigned slots_per_side = default_slots_per_side);
+
+        // Trocea una imagen y su cadena de mipmaps en páginas. No usa OpenGL:
+
+        static bool cook (const std::string & image_path, const std::string & output_path, Thread_Pool * workers = nullptr);
+
+        // Ajusta el tamaño de la retroalimentación al de la ventana:
+
+        void resize (unsigned width, unsigned height);
+
+        // Lee la retroalimentación anterior, pide páginas y sube las que han llegado:
+
+        void update ();
+
+        // Entre estas dos llamadas se dibuja con un programa compilado con FEEDBACK:
+
+        void begin_feedback ();
+        void end_feedback   ();
+
+        // Enlaza la indirección y la caché a las unidades first_unit y first_unit + 1 y
+        // establece los uniforms de shader_code en program_id, que debe estar activo:
+
+        void bind (GLuint program_id, GLuint first_unit) const;
+
+        const Page_Cache & get_cache () const
+        {
+            return *cache;
+        }
+
+    private:
+
+        const uint8_t * get_page (uint32_t key) const;
+
+        void read_feedback ();
+
+    };
+
+}
@@ -1,22 +1,54 @@
-
 // Este código es de dominio público
 // angel.rodriguez@udit.es
 
 #include "Scene.hpp"
+#include "tools/Tools.hpp"
 #include <Window.hpp>
 #include <SDL3/SDL_main.h>
 
+#include <cstdlib>
+#include <cstring>
+
 using udit::Scene;
 using udit::Window;
 
-int main (int , char * [])
+int main (int argc, char * argv[])
 {
+    // Las herramientas de línea de comandos (ver tools/Tools.hpp) que no necesitan ventana ni
+    // contexto de OpenGL terminan aquí:
+
+    if (const udit::tools::Tool * tool = udit::tools::find_tool (argc, argv))
+    {
+        return tool->run (argc, argv);
+    }
+
     constexpr unsigned viewport_width  = 1024;
     constexpr unsigned viewport_height =  576;
 
-    Window window("OpenGL example", viewport_width, viewport_height, { 3, 3 });    
+    // Con las herramientas que miden la escena se desactiva la sincronización vertical para no
+    // limitar los frames:
+
+    const udit::tools::Scene_Tool * scene_tool = udit::tools::find_scene_tool (argc, argv);
+
+    Window window("OpenGL example", viewport_width, viewport_height, { 3, 3, true, 24, 0, !scene_tool });    
     Scene  scene (viewport_width, viewport_height);
 
+    // --texture-budget <MB> limita la memoria de vídeo de los mipmaps de los modelos:
+
+    if (argc > 2 && std::strcmp (argv[1], "--texture-budget") == 0)
+    {
+        scene.set_texture_budget (size_t(std::strtoul (argv[2], nullptr, 10)) << 20);
+    }
+
+    if (scene_tool)
+    {
+        const int result = scene_tool->run (window, scene, argc, argv);
+
+        SDL_Quit ();
+
+        return result;
+    }
+
     bool exit = false;
 
     do
@@ -0,0 +1,426 @@
+#include "Tools.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <Thread_Pool.hpp>
+
+#include "../Glb_File.hpp"
+#include "../Mesh.hpp"
+#include "../Obj_File.hpp"
+
+#ifdef UDIT_COUNT_ALLOCATIONS
+
+namespace
+{
+    std::atomic< size_t > heap_allocation_count(0);
+}
+
+// Sólo en la compilación de pruebas (con UDIT_COUNT_ALLOCATIONS definido) se sustituye el
+// operator new global para contar las reservas que hace cada carga. new[] y los demás delete
+// acaban en estos:
+
+void * operator new (std::size_t size)
+{
+    heap_allocation_count.fetch_add (1, std::memory_order_relaxed);
+
+    if (void * pointer = std::malloc (size > 0 ? size : 1)) return pointer;
+
+    throw std::bad_alloc ();
+}
+
+void operator delete (void * pointer) noexcept
+{
+    std::free (pointer);
+}
+
+void operator delete (void * pointer, std::size_t ) noexcept
+{
+    std::free (pointer);
+}
+
+#endif
+
+namespace udit
+{
+
+    namespace tools
+    {
+
+        #ifdef UDIT_COUNT_ALLOCATIONS
+
+        namespace
+        {
+
+            // Escribe una malla .obj con 256 rejillas onduladas de 512 triángulos repartidas en
+            // object_count objetos. Todos los archivos tienen las mismas líneas y sólo cambian
+            // los nombres tras cada o, así que cualquier diferencia en las reservas se debe al
+            // número de submallas:
+
+            bool write_patch_obj (const std::string & path, unsigned object_count)
+            {
+                constexpr unsigned patch_count   = 256;
+                constexpr unsigned grid_side     = 16;
+                constexpr unsigned side_vertices = grid_side + 1;
+
+                std::ofstream file(path);
+
+                for (unsigned patch = 0; patch < patch_count; ++patch)
+                {
+                    file << "o patch" << patch * object_count / patch_count << '\n';
+
+                    for (unsigned y = 0; y < side_vertices; ++y)
+                    {
+                        for (unsigned x = 0; x < side_vertices; ++x)
+                        {
+                            const float u = float(x) / grid_side, v = float(y) / grid_side;
+
+                            file << "v "  << u << ' ' << 0.1f * std::sin (6.f * u + float(patch)) * std::cos (5.f * v) << ' ' << v + float(patch) << '\n'
+                                 << "vt " << u << ' ' << v << '\n';
+                        }
+                    }
+
+                    const unsigned first = patch * side_vertices * side_vertices + 1;
+
+                    for (unsigned y = 0; y < grid_side; ++y)
+                    {
+                        for (unsigned x = 0; x < grid_side; ++x)
+                        {
+                            const unsigned a = first + y * side_vertices + x, b = a + 1, c = a + side_vertices, d = c + 1;
+
+                            file << "f " << a << '/' << a << ' ' << c << '/' << c << ' ' << d << '/' << d << ' ' << b << '/' << b << '\n';
+                        }
+                    }
+                }
+
+                return bool(file);
+            }
+
+        }
+
+        #endif
+
+        // Importa con Mesh::import (lector .obj, LODs y bases tangentes) la misma malla partida en
+        // 1, 16 y 256 submallas contando las reservas en el heap. Tienen que ser las mismas en los
+        // tres casos: ninguna fase reserva memoria por submalla. Necesita una compilación con
+        // UDIT_COUNT_ALLOCATIONS definido:
+
+        bool run_mesh_allocation_check ()
+        {
+            #ifndef UDIT_COUNT_ALLOCATIONS
+
+                std::cout << "  --mesh-allocation-check needs a build with UDIT_COUNT_ALLOCATIONS defined" << std::endl;
+
+                return false;
+
+            #else
+
+                const unsigned    object_counts[] = { 1, 16, 256 };
+                const std::string path            = "mesh-allocation-check.obj";
+
+                size_t first_count = 0;
+                bool   passed      = true;
+
+                for (unsigned object_count : object_counts)
+                {
+                    if (!write_patch_obj (path, object_count))
+                    {
+                        std::cout << "  could not write " << path << std::endl;
+                        return false;
+                    }
+
+                    // El informe de la importación se descarta mientras se mide. La primera carga
+                    // sólo calienta el pool de hilos de la importación:
+
+                    std::streambuf * output = std::cout.rdbuf (nullptr);
+
+                    {
+                        Mesh::Data warm_up;
+                        Mesh::import (path, warm_up);
+                    }
+
+                    Mesh::Data data;
+
+                    const size_t before      = heap_allocation_count.load ();
+                    const bool   loaded      = Mesh::import (path, data);
+                    const size_t allocations = heap_allocation_count.load () - before;
+
+                    std::cout.rdbuf (output);
+                    std::cout.clear ();
+                    std::cout.width (0);                    // Sin sentry el setw del informe no se consume
+
+                    size_t lod_count = 0;
+
+                    for (const auto & submesh : data.submeshes) lod_count += submesh.lods.size ();
+
+                    if (first_count == 0) first_count = allocations;
+
+                    std::cout << "  " << data.submeshes.size () << " submeshes, " << lod_count << " LODs: " << allocations << " heap allocations" << std::endl;
+
+                    passed = passed && loaded && data.submeshes.size () == object_count && allocations == first_count && lod_count > object_count;
+                }
+
+                std::remove (path.c_str ());
+
+                std::cout << (passed ? "  PASSED" : "  FAILED") << std::endl;
+
+                return passed;
+
+            #endif
+        }
+
+        // Importa cada malla y vuelve a generar sus bases tangentes varias veces (a partir del
+        // LOD 0, como en la importación), midiendo la mejor:
+
+        void run_tangent_frame_benchmark (const std::vector< std::string > & mesh_paths)
+        {
+            using clock = std::chrono::steady_clock;
+
+            constexpr int repetitions = 5;
+
+            for (const auto & path : mesh_paths)
+            {
+                Mesh::Data data;
+
+                // El informe de la importación no interesa aquí:
+
+                std::streambuf * output = std::cout.rdbuf (nullptr);
+
+                const bool loaded = Mesh::import (path, data);
+
+                std::cout.rdbuf (output);
+                std::cout.clear ();
+                std::cout.width (0);
+
+                if (!loaded || data.submeshes.empty ())
+                {
+                    std::cout << path << ": could not be loaded" << std::endl;
+                    continue;
+                }
+
+                double best = INFINITY;
+
+                for (int i = 0; i < repetitions; ++i)
+                {
+                    auto start = clock::now ();
+
+                    Mesh::build_tangent_frames (data);
+
+                    best = std::min (best, std::chrono::duration< double, std::milli > (clock::now () - start).count ());
+                }
+
+                size_t triangle_count = 0;
+
+                for (const auto & submesh : data.submeshes) triangle_count += size_t(submesh.lods.front ().index_count) / 3;
+
+                std::cout << path << ": " << data.positions.size () << " vertices, " << triangle_count << " triangles, tangent frames in " << best << " ms" << std::endl;
+            }
+        }
+
+        namespace
+        {
+
+            template< typename VALUE >
+            bool check_same_stream (const char * name, const std::vector< VALUE > & native, const std::vector< VALUE > & reference)
+            {
+                if (native.size () == reference.size () && (native.empty () || std::memcmp (native.data (), reference.data (), native.size () * sizeof(VALUE)) == 0))
+                {
+                    return true;
+                }
+
+                std::cout << "  " << name << " differ (" << native.size () << " vs " << reference.size () << ")" << std::endl;
+
+                return false;
+            }
+
+            // Assimp convierte los números con fast_atoreal_move, que no siempre da el float bien
+            // redondeado, así que las coordenadas de Obj_File pueden diferir en alguna ULP:
+
+            constexpr int64_t max_ulp_difference = 2;
+
+            int64_t get_ulp_distance (float a, float b)
+            {
+                int32_t x, y;
+
+                std::memcpy (&x, &a, sizeof(x));
+                std::memcpy (&y, &b, sizeof(y));
+
+                // Los negativos se reordenan para que los enteros sigan el orden de los floats:
+
+                const int64_t ordered_x = x < 0 ? int64_t(INT32_MIN) - x : x;
+                const int64_t ordered_y = y < 0 ? int64_t(INT32_MIN) - y : y;
+
+                return ordered_x > ordered_y ? ordered_x - ordered_y : ordered_y - ordered_x;
+            }
+
+            template< typename VECTOR >
+            bool check_close_stream (const char * name, const std::vector< VECTOR > & native, const std::vector< VECTOR > & reference)
+            {
+                if (native.size () != reference.size ())
+                {
+                    std::cout << "  " << name << " differ (" << native.size () << " vs " << reference.size () << ")" << std::endl;
+                    return false;
+                }
+
+                const size_t  component_count = native.size () * (sizeof(VECTOR) / sizeof(float));
+                const float * a               = reinterpret_cast< const float * >(native   .data ());
+                const float * b               = reinterpret_cast< const float * >(reference.data ());
+                int64_t       worst           = 0;
+                size_t        differing       = 0;
+
+                for (size_t i = 0; i < component_count; ++i)
+                {
+                    const int64_t distance = get_ulp_distance (a[i], b[i]);
+
+                    worst      = std::max (worst, distance);
+                    differing += distance > 0;
+                }
+
+                if (differing > 0)
+                {
+                    std::cout << "  " << name << ": " << differing << " of " << component_count << " components differ by up to " << worst << " ULP" << std::endl;
+                }
+
+                return worst <= max_ulp_difference;
+            }
+
+            // Carga cada archivo con un lector nativo y con Assimp, midiendo la mejor de varias
+            // cargas de cada uno, y compara los streams y los rangos de las submallas. Si no se
+            // piden coordenadas exactas pueden diferir en max_ulp_difference:
+
+            template< typename READER >
+            bool compare_with_assimp (const std::vector< std::string > & paths, const char * reader_name, bool exact_coordinates, READER read)
+            {
+                using clock = std::chrono::steady_clock;
+
+                constexpr int repetitions = 3;
+
+                bool passed = true;
+
+                auto milliseconds = [] (clock::time_point start, clock::time_point end)
+                {
+                    return std::chrono::duration< double, std::milli > (end - start).count ();
+                };
+
+                for (const auto & path : paths)
+                {
+                    Mesh::Data native;
+                    Mesh::Data reference;
+                    double     native_time = INFINITY;
+                    double     assimp_time = INFINITY;
+                    bool       loaded      = true;
+
+                    for (int i = 0; i < repetitions && loaded; ++i)
+                    {
+                        auto start  = clock::now ();
+                        loaded      = read (path, native);
+                        auto middle = clock::now ();
+                        loaded      = Mesh::import_with_assimp (path, reference) && loaded;
+                        auto end    = clock::now ();
+
+                        native_time = std::min (native_time, milliseconds (start,  middle));
+                        assimp_time = std::min (assimp_time, milliseconds (middle, end   ));
+                    }
+
+                    if (!loaded)
+                    {
+                        std::cout << path << ": could not be loaded" << std::endl;
+                        passed = false;
+                        continue;
+                    }
+
+                    bool matching = exact_coordinates
+                                  ? check_same_stream  ("positions", native.positions, reference.positions) & check_same_stream  ("uvs", native.uvs, reference.uvs)
+                                  : check_close_stream ("positions", native.positions, reference.positions) & check_close_stream ("uvs", native.uvs, reference.uvs);
+
+                    matching &= check_same_stream ("indices", native.indices, reference.indices);
+
+                    if (native.submeshes.size () != reference.submeshes.size ())
+                    {
+                        std::cout << "  submesh count differs (" << native.submeshes.size () << " vs " << reference.submeshes.size () << ")" << std::endl;
+                        matching = false;
+                    }
+                    else
+                    {
+                        for (size_t i = 0; i < native.submeshes.size (); ++i)
+                        {
+                            const Mesh::SubMesh & a = native   .submeshes[i];
+                            const Mesh::SubMesh & b = reference.submeshes[i];
+
+                            if (a.base_vertex != b.base_vertex || a.vertex_count != b.vertex_count
+                             || a.lods.front ().index_offset != b.lods.front ().index_offset || a.lods.front ().index_count != b.lods.front ().index_count)
+                            {
+                                std::cout << "  submesh " << i << " differs" << std::endl;
+                                matching = false;
+                            }
+                        }
+                    }
+
+                    std::cout << path << ": " << native.positions.size () << " vertices, " << native.indices.size () / 3 << " triangles, "
+                              << native.submeshes.size () << " submeshes" << std::endl
+                              << "  " << reader_name << " " << native_time << " ms, Assimp " << assimp_time << " ms ("
+                              << assimp_time / std::max (native_time, 1e-6) << "x), " << (matching ? "match" : "MISMATCH") << std::endl;
+
+                    passed = passed && matching;
+                }
+
+                std::cout << (passed ? "  PASSED" : "  FAILED") << std::endl;
+
+                return passed;
+            }
+
+        }
+
+        // Carga cada .obj con el lector propio y con Assimp (sin LODs ni bases tangentes). Los
+        // índices y los rangos de las submallas tienen que ser idénticos y las coordenadas sólo
+        // pueden diferir en el redondeo de Assimp:
+
+        bool run_obj_check (const std::vector< std::string > & obj_paths)
+        {
+            udit::Thread_Pool workers;
+
+            return compare_with_assimp
+            (
+                obj_paths, "Obj_File", false,
+                [&workers] (const std::string & path, Mesh::Data & data)
+                {
+                    return udit::Obj_File::is_obj (path) && udit::Obj_File::read (path, data, workers);
+                }
+            );
+        }
+
+        // Lo mismo con los .glb y Glb_File. Los dos lectores toman los floats tal cual del
+        // archivo e invierten V igual, así que todo tiene que coincidir bit a bit. Assimp une los
+        // vértices repetidos, de modo que un archivo que los tenga aparece como distinto:
+
+        bool run_glb_check (const std::vector< std::string > & glb_paths)
+        {
+            return compare_with_assimp
+            (
+                glb_paths, "Glb_File", true,
+                [] (const std::string & path, Mesh::Data & data)
+                {
+                    udit::Glb_File glb;
+
+                    if (!udit::Glb_File::is_glb (path) || !glb.open (path)) return false;
+
+                    Mesh::read_glb (glb, data);
+
+                    return true;
+                }
+            );
+        }
+
+    }
+
+}
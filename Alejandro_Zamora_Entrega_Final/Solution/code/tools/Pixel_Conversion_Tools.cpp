@@ -0,0 +1,309 @@
+#include "Tools.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <Pixel_Conversion.hpp>
+
+namespace udit
+{
+
+    namespace tools
+    {
+
+        namespace
+        {
+
+            // Compara cada juego de kernels de Pixel_Conversion que admite la CPU con la versión
+            // escalar: con la entrada completa, con todos los tamaños de 0 a 67 píxeles desde
+            // direcciones desalineadas (para los restos de cada bloque, comprobando que no se
+            // escribe fuera) y en el sitio cuando la conversión lo admite:
+
+            template< typename SOURCE, typename TARGET >
+            bool check_pixel_conversion
+            (
+                const char                * name,
+                void (* convert)(const SOURCE *, TARGET *, size_t, udit::Pixel_Conversion::Kernels),
+                const std::vector< SOURCE > & source,
+                size_t                      source_channels,
+                size_t                      target_channels
+            )
+            {
+                using udit::Pixel_Conversion;
+
+                const size_t count    = source.size () / source_channels;
+                const bool   in_place = sizeof(SOURCE) == sizeof(TARGET) && target_channels <= source_channels;
+
+                std::vector< TARGET > expected(count * target_channels);
+                std::vector< TARGET > result  (count * target_channels);
+
+                convert (source.data (), expected.data (), count, Pixel_Conversion::SCALAR);
+
+                bool passed = true;
+
+                for (auto kernels : { Pixel_Conversion::SSE41, Pixel_Conversion::AVX2 })
+                {
+                    if (Pixel_Conversion::resolve (kernels) != kernels) continue;
+
+                    const char * failure = nullptr;
+
+                    convert (source.data (), result.data (), count, kernels);
+
+                    if (result != expected) failure = "full input";
+
+                    for (size_t offset = 0; offset < 4 && !failure; ++offset)
+                    {
+                        for (size_t length = 0; length <= 67 && length + offset <= count && !failure; ++length)
+                        {
+                            const SOURCE * input = source.data () + offset * source_channels;
+
+                            // El destino tiene un margen con un valor conocido detrás de los píxeles:
+
+                            std::vector< TARGET > reference((offset + length) * target_channels + 64, TARGET(0xCD));
+                            std::vector< TARGET > output   (reference);
+
+                            convert (input, reference.data () + offset * target_channels, length, Pixel_Conversion::SCALAR);
+                            convert (input, output   .data () + offset * target_channels, length, kernels);
+
+                            if (output != reference) failure = "tail or overrun";
+
+                            if (in_place && length > 0 && !failure)
+                            {
+                                std::vector< SOURCE > buffer(input, input + length * source_channels);
+
+                                convert (buffer.data (), reinterpret_cast< TARGET * >(buffer.data ()), length, kernels);
+
+                                if (std::memcmp (buffer.data (), reference.data () + offset * target_channels, length * target_channels * sizeof(TARGET)) != 0)
+                                {
+                                    failure = "in place";
+                                }
+                            }
+                        }
+                    }
+
+                    std::cout << "  " << name << " " << Pixel_Conversion::get_name (kernels) << ": " << (failure ? "MISMATCH (" : "OK") << (failure ? failure : "") << (failure ? ")" : "") << std::endl;
+
+                    passed = passed && !failure;
+                }
+
+                return passed;
+            }
+
+        }
+
+        bool run_pixel_conversion_check ()
+        {
+            using udit::Pixel_Conversion;
+
+            std::cout << "pixel conversion kernels on this CPU: " << Pixel_Conversion::get_name (Pixel_Conversion::BEST) << std::endl;
+
+            bool passed = true;
+
+            // Todos los colores RGB con un alfa que varía de un píxel a otro:
+
+            std::vector< uint8_t > rgb (size_t(3) << 24);
+            std::vector< uint8_t > rgba(size_t(4) << 24);
+
+            for (uint32_t i = 0; i < (1u << 24); ++i)
+            {
+                const uint8_t color[4] = { uint8_t(i), uint8_t(i >> 8), uint8_t(i >> 16), uint8_t(i * 2654435761u >> 24) };
+
+                std::memcpy (&rgb [size_t(i) * 3], color, 3);
+                std::memcpy (&rgba[size_t(i) * 4], color, 4);
+            }
+
+            passed &= check_pixel_conversion ("rgb_to_rgba",       &Pixel_Conversion::rgb_to_rgba,       rgb,  3, 4);
+            passed &= check_pixel_conversion ("rgba_to_rgb",       &Pixel_Conversion::rgba_to_rgb,       rgba, 4, 3);
+            passed &= check_pixel_conversion ("rgba_to_luminance", &Pixel_Conversion::rgba_to_luminance, rgba, 4, 1);
+            passed &= check_pixel_conversion ("swap_red_blue",     &Pixel_Conversion::swap_red_blue,     rgba, 4, 4);
+
+            // Todos los pares de color y alfa en cada canal:
+
+            std::vector< uint8_t > pairs(size_t(4) << 16);
+
+            for (uint32_t i = 0; i < (1u << 16); ++i)
+            {
+                const uint8_t color = uint8_t(i), alpha = uint8_t(i >> 8);
+                const uint8_t pixel[4] = { color, uint8_t(255 - color), uint8_t(color ^ 0x5A), alpha };
+
+                std::memcpy (&pairs[size_t(i) * 4], pixel, 4);
+            }
+
+            passed &= check_pixel_conversion ("premultiply_alpha", &Pixel_Conversion::premultiply_alpha, pairs, 4, 4);
+
+            // La versión escalar tiene que redondear como round (c * a / 255):
+
+            std::vector< uint8_t > premultiplied(pairs.size ());
+
+            Pixel_Conversion::premultiply_alpha (pairs.data (), premultiplied.data (), size_t(1) << 16, Pixel_Conversion::SCALAR);
+
+            for (uint32_t i = 0; i < (1u << 16); ++i)
+            {
+                const unsigned color = i & 255, alpha = i >> 8;
+
+                if (premultiplied[size_t(i) * 4] != unsigned(std::lround (color * alpha / 255.0)) || premultiplied[size_t(i) * 4 + 3] != alpha)
+                {
+                    std::cout << "  premultiply_alpha scalar: WRONG ROUNDING" << std::endl;
+                    passed = false;
+                    break;
+                }
+            }
+
+            // Todos los valores de 8 y de 16 bits por canal:
+
+            std::vector< uint8_t  > unorms(256 * 4);
+            std::vector< uint16_t > halves(1 << 16);
+
+            for (size_t i = 0; i < unorms.size (); ++i) unorms[i] = uint8_t(i * 97);
+            for (size_t i = 0; i < halves.size (); ++i) halves[i] = uint16_t(i);
+
+            passed &= check_pixel_conversion ("luminance_to_rgba", &Pixel_Conversion::luminance_to_rgba, unorms, 1, 4);
+            passed &= check_pixel_conversion ("unorm_to_float",    &Pixel_Conversion::unorm_to_float,    unorms, 1, 1);
+            passed &= check_pixel_conversion ("unorm_to_half",     &Pixel_Conversion::unorm_to_half,     unorms, 1, 1);
+            passed &= check_pixel_conversion ("half_to_unorm",     &Pixel_Conversion::half_to_unorm,     halves, 1, 1);
+
+            // Ida y vuelta sin pérdidas a float y a half:
+
+            std::vector< float    > floats(256);
+            std::vector< uint16_t > packed(256);
+            std::vector< uint8_t  > back  (256);
+
+            Pixel_Conversion::unorm_to_float (unorms.data (), floats.data (), 256);
+            Pixel_Conversion::float_to_unorm (floats.data (), back.data (), 256);
+
+            const bool float_round_trip = std::equal (back.begin (), back.end (), unorms.begin ());
+
+            Pixel_Conversion::unorm_to_half (unorms.data (), packed.data (), 256);
+            Pixel_Conversion::half_to_unorm (packed.data (), back.data (), 256);
+
+            const bool half_round_trip = std::equal (back.begin (), back.end (), unorms.begin ());
+
+            std::cout << "  round trip float: " << (float_round_trip ? "OK" : "LOSSY") << ", half: " << (half_round_trip ? "OK" : "LOSSY") << std::endl;
+
+            passed = passed && float_round_trip && half_round_trip;
+
+            // float_to_unorm con todos los patrones de 32 bits (NaN, infinitos, negativos,
+            // desnormales...), por trozos:
+
+            std::vector< float > samples = { std::nanf (""), -INFINITY, INFINITY, -1.f, -0.f, 1e-40f, 0.5f / 255.f, 254.5f / 255.f, 1.f, 2.f, 1e30f };
+
+            for (uint32_t i = 0; i < 4096; ++i)
+            {
+                samples.push_back (float(i) / 3000.f - 0.1f);
+            }
+
+            passed &= check_pixel_conversion ("float_to_unorm", &Pixel_Conversion::float_to_unorm, samples, 1, 1);
+
+            constexpr size_t chunk = size_t(1) << 20;
+
+            std::vector< float > all_floats(chunk);
+
+            for (auto kernels : { Pixel_Conversion::SSE41, Pixel_Conversion::AVX2 })
+            {
+                if (Pixel_Conversion::resolve (kernels) != kernels) continue;
+
+                std::vector< uint8_t > expected(chunk), result(chunk);
+
+                bool identical = true;
+
+                for (uint64_t first = 0; first < (uint64_t(1) << 32) && identical; first += chunk)
+                {
+                    for (size_t i = 0; i < chunk; ++i)
+                    {
+                        const uint32_t bits = uint32_t(first + i);
+
+                        std::memcpy (&all_floats[i], &bits, sizeof(float));
+                    }
+
+                    Pixel_Conversion::float_to_unorm (all_floats.data (), expected.data (), chunk, Pixel_Conversion::SCALAR);
+                    Pixel_Conversion::float_to_unorm (all_floats.data (), result  .data (), chunk, kernels);
+
+                    identical = result == expected;
+                }
+
+                std::cout << "  float_to_unorm (every float) " << Pixel_Conversion::get_name (kernels) << ": " << (identical ? "OK" : "MISMATCH") << std::endl;
+
+                passed = passed && identical;
+            }
+
+            std::cout << (passed ? "  PASSED" : "  FAILED") << std::endl;
+
+            return passed;
+        }
+
+        // Mide cada conversión de Pixel_Conversion con cada juego de kernels que admite la CPU en
+        // GB/s (bytes leídos más bytes escritos), con el mejor de varios intentos:
+
+        void run_pixel_conversion_benchmark (size_t megapixels)
+        {
+            using clock = std::chrono::steady_clock;
+            using udit::Pixel_Conversion;
+
+            constexpr int repetitions = 5;
+
+            const size_t count = std::max (megapixels, size_t(1)) << 20;
+
+            std::vector< uint8_t  > bytes (count * 4);
+            std::vector< uint8_t  > output(count * 4);
+            std::vector< float    > floats(count);
+            std::vector< uint16_t > halves(count);
+
+            for (size_t i = 0; i < bytes.size (); ++i) bytes[i] = uint8_t(i * 2654435761u >> 24);
+
+            Pixel_Conversion::unorm_to_float (bytes.data (), floats.data (), count);
+            Pixel_Conversion::unorm_to_half  (bytes.data (), halves.data (), count);
+
+            std::cout << "pixel conversion, " << count / (1024 * 1024) << " Mi pixels or values, best kernels " << Pixel_Conversion::get_name (Pixel_Conversion::BEST) << ":" << std::endl;
+
+            // convert (kernels) hace la conversión completa; moved son los bytes que lee y escribe:
+
+            auto measure = [&] (const char * name, size_t moved, auto convert)
+            {
+                std::cout << "  " << name << ":";
+
+                double scalar = 0;
+
+                for (auto kernels : { Pixel_Conversion::SCALAR, Pixel_Conversion::SSE41, Pixel_Conversion::AVX2 })
+                {
+                    if (Pixel_Conversion::resolve (kernels) != kernels) continue;
+
+                    double best = 1e30;
+
+                    for (int i = 0; i < repetitions; ++i)
+                    {
+                        auto start = clock::now ();
+                        convert (kernels);
+                        best = std::min (best, std::chrono::duration< double > (clock::now () - start).count ());
+                    }
+
+                    const double speed = double(moved) / best / 1e9;
+
+                    if (kernels == Pixel_Conversion::SCALAR) scalar = speed;
+
+                    std::cout << " " << Pixel_Conversion::get_name (kernels) << " " << speed << " GB/s";
+
+                    if (kernels != Pixel_Conversion::SCALAR) std::cout << " (x" << speed / scalar << ")";
+                }
+
+                std::cout << std::endl;
+            };
+
+            measure ("luminance_to_rgba", count * 5, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::luminance_to_rgba (bytes.data (), output.data (), count, k); });
+            measure ("rgba_to_luminance", count * 5, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::rgba_to_luminance (bytes.data (), output.data (), count, k); });
+            measure ("rgb_to_rgba",       count * 7, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::rgb_to_rgba       (bytes.data (), output.data (), count, k); });
+            measure ("rgba_to_rgb",       count * 7, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::rgba_to_rgb       (bytes.data (), output.data (), count, k); });
+            measure ("swap_red_blue",     count * 8, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::swap_red_blue     (bytes.data (), output.data (), count, k); });
+            measure ("premultiply_alpha", count * 8, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::premultiply_alpha (bytes.data (), output.data (), count, k); });
+            measure ("unorm_to_float",    count * 5, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::unorm_to_float    (bytes.data (), floats.data (), count, k); });
+            measure ("float_to_unorm",    count * 5, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::float_to_unorm    (floats.data (), output.data (), count, k); });
+            measure ("unorm_to_half",     count * 3, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::unorm_to_half     (bytes.data (), halves.data (), count, k); });
+            measure ("half_to_unorm",     count * 3, [&] (Pixel_Conversion::Kernels k) { Pixel_Conversion::half_to_unorm     (halves.data (), output.data (), count, k); });
+        }
+
+    }
+
+}
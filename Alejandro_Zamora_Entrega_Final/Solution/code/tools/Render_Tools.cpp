@@ -0,0 +1,503 @@
+#include "Tools.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Image_File.hpp>
+#include <Mip_Chain.hpp>
+#include <Program_Cache.hpp>
+#include <Software_Rasterizer.hpp>
+#include <Thread_Pool.hpp>
+
+#include "../Asset_Loader.hpp"
+#include "../Asset_Registry.hpp"
+#include "../Software_Scene.hpp"
+#include "../Texture.hpp"
+
+namespace udit
+{
+
+    namespace tools
+    {
+
+        // Mide el coste por frame de dibujar un número creciente de faros instanciados y el de
+        // componer sus matrices en la CPU (escalar frente a SIMD):
+
+        void run_instancing_benchmark (Window & window, Scene & scene)
+        {
+            using clock = std::chrono::steady_clock;
+
+            while (!scene.is_ready ())
+            {
+                scene.update ();
+            }
+
+            for (size_t count = 1000; count <= 1000000; count *= 10)
+            {
+                std::vector< udit::Instance_Transform > transforms(count, { glm::vec3(0.f), 1.f, glm::vec4(0.f, 0.f, 0.f, 1.f) });
+                std::vector< glm::mat4 >                matrices  (count);
+
+                auto start = clock::now ();
+                udit::compose_transforms_scalar (transforms.data (), count, matrices.data ());
+                auto middle = clock::now ();
+                udit::compose_transforms        (transforms.data (), count, matrices.data ());
+                auto end = clock::now ();
+
+                scene.set_instance_count (count);
+
+                constexpr int warm_up_frames  = 5;
+                constexpr int measured_frames = 50;
+
+                for (int frame = 0; frame < warm_up_frames; ++frame)
+                {
+                    scene.render ();
+                    window.swap_buffers ();
+                }
+
+                glFinish ();
+
+                auto frames_start = clock::now ();
+
+                for (int frame = 0; frame < measured_frames; ++frame)
+                {
+                    scene.render ();
+                    window.swap_buffers ();
+                }
+
+                glFinish ();
+
+                auto frames_end = clock::now ();
+
+                std::cout << count << " instances: "
+                          << std::chrono::duration< double, std::milli > (frames_end - frames_start).count () / measured_frames << " ms/frame, compose "
+                          << std::chrono::duration< double, std::milli > (middle - start).count () << " ms scalar / "
+                          << std::chrono::duration< double, std::milli > (end - middle).count () << " ms SIMD" << std::endl;
+            }
+        }
+
+        // Busca cuántos personajes animados se pueden dibujar a 60 fps con cada backend de skinning.
+        // El tiempo de cada fotograma incluye el muestreo de las animaciones y el skinning por CPU:
+
+        void run_skinning_benchmark (Window & window, Scene & scene)
+        {
+            using clock = std::chrono::steady_clock;
+            using udit::Skinned_Crowd;
+
+            const double frame_budget_ms = 1000.0 / 60.0;
+
+            auto measure = [&window, &scene] (size_t count, Skinned_Crowd::Backend backend)
+            {
+                scene.set_crowd (count, backend);
+
+                constexpr int warm_up_frames  = 5;
+                constexpr int measured_frames = 30;
+
+                for (int frame = 0; frame < warm_up_frames; ++frame)
+                {
+                    scene.update ();
+                    scene.render ();
+                    window.swap_buffers ();
+                }
+
+                glFinish ();
+
+                auto start = clock::now ();
+
+                for (int frame = 0; frame < measured_frames; ++frame)
+                {
+                    scene.update ();
+                    scene.render ();
+                    window.swap_buffers ();
+                }
+
+                glFinish ();
+
+                double milliseconds = std::chrono::duration< double, std::milli > (clock::now () - start).count () / measured_frames;
+
+                std::cout << "  " << count << " characters: " << milliseconds << " ms/frame, animation "
+                          << scene.get_crowd ()->get_animation_milliseconds () << " ms" << std::endl;
+
+                return milliseconds;
+            };
+
+            const Skinned_Crowd::Backend backends[] = { Skinned_Crowd::CPU_SKINNING, Skinned_Crowd::GPU_SKINNING };
+            const char *                 names   [] = { "CPU", "GPU" };
+
+            for (int b = 0; b < 2; ++b)
+            {
+                std::cout << names[b] << " skinning:" << std::endl;
+
+                scene.set_crowd (0, backends[b]);
+
+                // Límite de cada backend: el texture buffer de las paletas o 1 GB de posiciones deformadas:
+
+                const Skinned_Crowd & crowd = *scene.get_crowd ();
+
+                const size_t limit = backends[b] == Skinned_Crowd::GPU_SKINNING
+                                   ? crowd.get_max_gpu_characters ()
+                                   : (size_t(1) << 30) / (std::max (crowd.get_mesh ().get_data ().positions.size (), size_t(1)) * sizeof(glm::vec4));
+
+                // Se dobla el número de personajes hasta pasarse del presupuesto y después se afina
+                // con una búsqueda binaria:
+
+                size_t good = 0;
+                size_t bad  = 0;
+
+                for (size_t count = 16; count <= limit; count *= 2)
+                {
+                    if (measure (count, backends[b]) > frame_budget_ms)
+                    {
+                        bad = count;
+                        break;
+                    }
+
+                    good = count;
+                }
+
+                while (bad != 0 && bad - good > std::max (good / 32, size_t(1)))
+                {
+                    size_t middle = (good + bad) / 2;
+
+                    if (measure (middle, backends[b]) > frame_budget_ms) bad = middle; else good = middle;
+                }
+
+                std::cout << names[b] << " skinning: " << good << " characters at 60 fps" << (bad == 0 ? " (backend limit reached)" : "") << std::endl;
+            }
+
+            scene.set_crowd (0, Skinned_Crowd::GPU_SKINNING);
+        }
+
+        // Carga count texturas sintéticas de size x size (con sus mipmaps) mientras se dibuja la
+        // escena, primero subiéndolas enteras al sacarlas de la cola y después por bandas a través
+        // del anillo de PBOs. Se mide cuánto tarda en aparecer la primera, cuánto tardan todas y
+        // los tirones: el tiempo de los fotogramas más lentos. Las texturas se sueltan en cuanto
+        // están en la GPU para no agotar la memoria de vídeo:
+
+        void run_texture_streaming_benchmark (Window & window, Scene & scene, size_t count, unsigned size)
+        {
+            using clock     = std::chrono::steady_clock;
+            using Mip_Chain = udit::Texture::Mip_Chain;
+
+            while (!scene.is_ready ())
+            {
+                scene.update ();
+            }
+
+            auto decoder = [size] (size_t index) -> udit::Asset_Loader::Texture_Decoder
+            {
+                return [size, index] ()
+                {
+                    udit::Texture::Color_Buffer image(size, size);
+
+                    for (unsigned y = 0; y < size; ++y)
+                    {
+                        for (unsigned x = 0; x < size; ++x)
+                        {
+                            udit::Rgba8888 color;
+
+                            color.components[udit::Rgba8888::RED  ] = uint8_t(x + index);
+                            color.components[udit::Rgba8888::GREEN] = uint8_t(y);
+                            color.components[udit::Rgba8888::BLUE ] = ((x ^ y) & 32) ? 255 : 0;
+                            color.components[udit::Rgba8888::ALPHA] = 255;
+
+                            image.set (y * size + x, color);
+                        }
+                    }
+
+                    auto mips = std::make_unique< Mip_Chain > (std::move (image));
+
+                    mips->build (udit::Mip_Filter::BOX, false);
+
+                    return mips;
+                };
+            };
+
+            std::cout << count << " textures of " << size << "x" << size << " RGBA8:" << std::endl;
+
+            for (bool streaming : { false, true })
+            {
+                udit::Asset_Loader loader;
+
+                loader.set_streaming_uploads (streaming);
+
+                auto start = clock::now ();
+
+                std::vector< std::shared_ptr< udit::Texture > > textures;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    textures.push_back (loader.load_texture (decoder (i)));
+                }
+
+                std::vector< double > frame_times;
+                double                first_loaded = -1.0;
+
+                while (loader.get_pending_count () > 0)
+                {
+                    auto frame_start = clock::now ();
+
+                    scene.update ();
+                    loader.process_uploads (2.0);
+                    scene.render ();
+                    window.swap_buffers ();
+
+                    auto frame_end = clock::now ();
+
+                    frame_times.push_back (std::chrono::duration< double, std::milli > (frame_end - frame_start).count ());
+
+                    auto loaded = std::remove_if (textures.begin (), textures.end (), [] (const auto & texture) { return texture->is_loaded (); });
+
+                    if (loaded != textures.end () && first_loaded < 0.0)
+                    {
+                        first_loaded = std::chrono::duration< double, std::milli > (frame_end - start).count ();
+                    }
+
+                    textures.erase (loaded, textures.end ());
+                }
+
+                glFinish ();
+
+                const double total = std::chrono::duration< double, std::milli > (clock::now () - start).count ();
+
+                std::sort (frame_times.begin (), frame_times.end ());
+
+                double average = 0.0;
+                size_t hitches = 0;
+
+                for (double time : frame_times)
+                {
+                    average += time;
+                    hitches += time > 1000.0 / 60.0;
+                }
+
+                average /= std::max (frame_times.size (), size_t(1));
+
+                const double p99     = frame_times.empty () ? 0.0 : frame_times[frame_times.size () * 99 / 100];
+                const double maximum = frame_times.empty () ? 0.0 : frame_times.back ();
+
+                std::cout << "  " << (streaming ? "PBO ring" : "glTexImage2D") << ": first texture " << first_loaded << " ms, all in "
+                          << total << " ms, " << frame_times.size () << " frames, avg " << average << " ms, p99 " << p99
+                          << " ms, max " << maximum << " ms, " << hitches << " over 16.7 ms";
+
+                if (streaming)
+                {
+                    std::cout << ", " << loader.get_upload_ring ().get_statistics ().stall_count << " ring stalls";
+                }
+
+                std::cout << std::endl;
+            }
+        }
+
+        // Compara la carga del cielo decodificando las caras una tras otra y en paralelo, y cuenta
+        // cuántos fragmentos del cielo se sombrean al dibujarlo al final con la profundidad a 1
+        // frente a los de dibujarlo primero, que serían todos los de la ventana:
+
+        void run_skybox_benchmark (Window & window, Scene & scene, unsigned width, unsigned height)
+        {
+            udit::Thread_Pool workers;
+
+            std::cout << "Skybox, 6 faces:" << std::endl;
+
+            for (udit::Thread_Pool * pool : { (udit::Thread_Pool *)nullptr, &workers })
+            {
+                double best = 0.0;
+
+                for (int attempt = 0; attempt < 3; ++attempt)
+                {
+                    udit::Skybox sky(udit::Skybox::default_face_paths, pool);
+
+                    if (!sky.is_loaded ()) return;
+
+                    best = attempt == 0 ? sky.get_load_milliseconds () : std::min (best, sky.get_load_milliseconds ());
+                }
+
+                std::cout << "  " << (pool ? "parallel (" + std::to_string (pool->get_thread_count () + 1) + " threads)" : std::string("sequential"))
+                          << ": " << best << " ms" << std::endl;
+            }
+
+            if (!scene.get_skybox () || !scene.get_skybox ()->is_loaded ()) return;
+
+            while (!scene.is_ready ())
+            {
+                scene.update ();
+            }
+
+            constexpr size_t frame_count = 240;
+
+            uint64_t total_fragments = 0;
+            uint64_t min_fragments   = UINT64_MAX;
+            uint64_t max_fragments   = 0;
+
+            for (size_t frame = 0; frame < frame_count; ++frame)
+            {
+                scene.update ();
+                scene.render ();
+                window.swap_buffers ();
+
+                // El recuento llega con un par de fotogramas de retraso:
+
+                if (frame < 4) continue;
+
+                const uint64_t fragments = scene.get_skybox ()->get_shaded_fragments ();
+
+                total_fragments += fragments;
+                min_fragments    = std::min (min_fragments, fragments);
+                max_fragments    = std::max (max_fragments, fragments);
+            }
+
+            const double   average = double(total_fragments) / double(frame_count - 4);
+            const uint64_t pixels  = uint64_t(width) * height;
+
+            std::cout << "  shaded fragments per frame: avg " << average << ", min " << min_fragments << ", max " << max_fragments
+                      << " of " << pixels << " pixels (" << 100.0 * average / double(pixels) << "% of drawing it first)" << std::endl;
+        }
+
+        // Crea 500 texturas como las de 500 modelos. Antes cada una compilaba su propio par de
+        // programas; ahora el contador de Program_Cache no debe subir más allá de esos dos:
+
+        bool run_program_cache_check ()
+        {
+            constexpr size_t texture_count = 500;
+
+            udit::Program_Cache & cache  = udit::Program_Cache::get_instance ();
+            auto                  before = cache.get_statistics ();
+
+            {
+                std::vector< std::unique_ptr< udit::Texture > > textures;
+
+                for (size_t i = 0; i < texture_count; ++i)
+                {
+                    textures.push_back (std::make_unique< udit::Texture > ());
+                }
+            }
+
+            auto   after    = cache.get_statistics ();
+            size_t compiled = after.compile_count - before.compile_count;
+
+            std::cout << texture_count << " textures: " << compiled << " programs compiled, "
+                      << after.hit_count - before.hit_count << " reused" << std::endl;
+
+            return compiled <= 2;
+        }
+
+        // Dos modelos que piden los mismos archivos al mismo registro tienen que compartir la malla
+        // y la textura: dos aciertos, dos fallos y una sola copia de cada recurso. Al destruir los
+        // modelos no debe quedar ningún recurso vivo:
+
+        bool run_asset_registry_check ()
+        {
+            const std::string mesh_path    = "../../../shared/assets/lighthouse.obj";
+            const std::string texture_path = "../../../shared/assets/uv-checker.png";
+
+            udit::Asset_Loader   loader;
+            udit::Asset_Registry registry(loader);
+
+            bool passed;
+
+            {
+                Model first (registry, texture_path, mesh_path);
+                Model second(registry, texture_path, mesh_path);
+
+                while (loader.get_pending_count () > 0)
+                {
+                    if (loader.process_uploads (1.0) == 0) std::this_thread::yield ();
+                }
+
+                udit::Asset_Registry::Statistics statistics = registry.get_statistics ();
+
+                std::cout << "Asset registry: " << statistics.hits << " hits, " << statistics.misses << " misses, "
+                          << statistics.resident_count << " resources, " << statistics.resident_bytes / 1024 << " KB resident" << std::endl;
+
+                const bool shared_mesh    = first.get_mesh () == second.get_mesh ();
+                const bool shared_texture = first.texture     == second.texture;
+
+                std::cout << "  mesh " << (shared_mesh ? "shared" : "DUPLICATED") << ", texture " << (shared_texture ? "shared" : "DUPLICATED") << std::endl;
+
+                passed = shared_mesh && shared_texture && statistics.hits == 2 && statistics.misses == 2 && statistics.resident_count == 2;
+            }
+
+            const size_t released = registry.get_statistics ().resident_count;
+
+            std::cout << "  " << released << " resources left after releasing the models" << std::endl;
+
+            passed = passed && released == 0;
+
+            std::cout << (passed ? "  PASSED" : "  FAILED") << std::endl;
+
+            return passed;
+        }
+
+        // Dibuja la escena con el rasterizador por software, sin ventana ni OpenGL, primero en el
+        // hilo principal y después repartiendo las casillas entre todos los núcleos. Comprueba que
+        // los dos dan la misma imagen y guarda el último fotograma si se indica output:
+
+        void run_software_render (unsigned width, unsigned height, size_t frame_count, const std::string & output)
+        {
+            using clock = std::chrono::steady_clock;
+
+            udit::Software_Scene scene(width, height);
+            udit::Thread_Pool    workers;
+
+            frame_count = std::max (frame_count, size_t(1));
+
+            auto measure = [&] (udit::Thread_Pool * pool)
+            {
+                scene.render (pool);                    // Calentamiento
+
+                auto start = clock::now ();
+
+                for (size_t i = 0; i < frame_count; ++i)
+                {
+                    scene.update ();
+                    scene.render (pool);
+                }
+
+                return std::chrono::duration< double, std::milli > (clock::now () - start).count () / double(frame_count);
+            };
+
+            const double serial_ms   = measure (nullptr);
+            const double parallel_ms = measure (&workers);
+
+            const udit::Software_Rasterizer::Statistics statistics = scene.get_rasterizer ().get_statistics ();
+
+            // Sin update() entre medias el fotograma es el mismo:
+
+            const udit::Software_Rasterizer::Color_Buffer parallel = scene.get_rasterizer ().get_color_buffer ();
+
+            scene.render (nullptr);
+
+            const bool identical = std::memcmp
+            (
+                parallel.colors (),
+                scene.get_rasterizer ().get_color_buffer ().colors (),
+                size_t(width) * height * sizeof(udit::Rgba8888)
+            ) == 0;
+
+            std::cout << "software render " << width << "x" << height << (scene.has_lighthouse () ? "" : " (without lighthouse)") << ":" << std::endl
+                      << "  1 thread:   " << serial_ms << " ms/frame" << std::endl
+                      << "  " << workers.get_thread_count () + 1 << " threads:  " << parallel_ms << " ms/frame (x" << serial_ms / parallel_ms << ")"
+                      << (identical ? "" : "  MISMATCH") << std::endl
+                      << "  " << statistics.primitives << " primitives, " << statistics.culled << " culled, "
+                      << statistics.tile_references << " tile references, " << statistics.fragments << " fragments" << std::endl;
+
+            if (output.empty ()) return;
+
+            const udit::Software_Rasterizer::Color_Buffer & image  = scene.get_rasterizer ().get_color_buffer ();
+            const uint8_t                                 * pixels = reinterpret_cast< const uint8_t * >(image.colors ());
+
+            const bool saved = udit::Image_File::is_fast (output)
+                ? udit::Image_File::save (output, pixels, image.get_width (), image.get_height (), image.get_pitch ())
+                : SOIL_save_image (output.c_str (), SOIL_SAVE_TYPE_PNG, int(image.get_width ()), int(image.get_height ()), 4, pixels) != 0;
+
+            if (!saved) std::cerr << "Error saving image: " << output << std::endl;
+        }
+
+    }
+
+}
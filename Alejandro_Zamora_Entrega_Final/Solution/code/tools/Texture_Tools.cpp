@@ -0,0 +1,583 @@
+#include "Tools.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Block_Compression.hpp>
+#include <Image_File.hpp>
+#include <Mapped_File.hpp>
+#include <Mip_Chain.hpp>
+#include <Mip_Residency.hpp>
+#include <Page_Cache.hpp>
+#include <Thread_Pool.hpp>
+
+#include "../Material_Array.hpp"
+#include "../Texture.hpp"
+#include "../Virtual_Texture.hpp"
+
+namespace udit
+{
+
+    namespace tools
+    {
+
+        // Comprime las imágenes en cada formato de bloque sin usar la GPU. Se mide la velocidad del
+        // compresor con un hilo y con todo el pool, y la calidad (PSNR) del nivel 0 descomprimido:
+
+        void run_texture_benchmark (const std::vector< std::string > & image_paths)
+        {
+            using clock = std::chrono::steady_clock;
+            using udit::Block_Compression;
+
+            const Block_Compression::Format formats[] = { Block_Compression::BC1, Block_Compression::BC3, Block_Compression::BC4, Block_Compression::BC5 };
+
+            udit::Thread_Pool workers;
+
+            for (const auto & path : image_paths)
+            {
+                auto image = udit::Texture::load_image (path);
+
+                if (!image)
+                {
+                    std::cerr << "Error loading image: " << path << std::endl;
+                    continue;
+                }
+
+                const unsigned width      = image->get_width  ();
+                const unsigned height     = image->get_height ();
+                const double   megapixels = double(width) * double(height) / 1e6;
+
+                std::cout << path << " (" << width << "x" << height << "):" << std::endl;
+
+                std::vector< uint8_t >      blocks;
+                udit::Texture::Color_Buffer decoded(width, height);
+
+                for (auto format : formats)
+                {
+                    blocks.resize (Block_Compression::get_compressed_size (format, width, height));
+
+                    auto start = clock::now ();
+                    Block_Compression::encode (format, image->colors (), width, height, blocks.data ());
+                    auto middle = clock::now ();
+                    Block_Compression::encode (format, image->colors (), width, height, blocks.data (), &workers);
+                    auto end = clock::now ();
+
+                    Block_Compression::decode (format, blocks.data (), width, height, decoded.colors ());
+
+                    std::cout << "  " << Block_Compression::get_name (format) << ": PSNR "
+                              << Block_Compression::psnr (format, image->colors (), decoded.colors (), size_t(width) * height) << " dB, "
+                              << megapixels / std::chrono::duration< double > (middle - start).count () << " MPix/s with 1 thread, "
+                              << megapixels / std::chrono::duration< double > (end - middle).count () << " MPix/s with "
+                              << workers.get_thread_count () + 1 << ", " << blocks.size () << " bytes ("
+                              << size_t(width) * height * sizeof(udit::Rgba8888) << " in RGBA8)" << std::endl;
+                }
+            }
+        }
+
+        // Compara el tiempo de decodificar cada imagen desde memoria en PNG (SOIL2), QOI y RAW. Los
+        // archivos se leen antes de medir, así que sólo cuenta la decodificación. Se toma el mejor
+        // de varios intentos y se comprueba que QOI y RAW devuelven los mismos píxeles que el PNG:
+
+        void run_image_format_benchmark (const std::vector< std::string > & image_paths)
+        {
+            using clock = std::chrono::steady_clock;
+            using udit::Image_File;
+
+            constexpr int repetitions = 5;
+
+            double total_png = 0, total_qoi = 0, total_raw = 0;
+            size_t total_pixels = 0;
+
+            for (const auto & path : image_paths)
+            {
+                udit::Mapped_File file;
+
+                if (!file.open (path))
+                {
+                    std::cerr << "Error loading image: " << path << std::endl;
+                    continue;
+                }
+
+                auto best_of = [] (auto decode)
+                {
+                    double best = 1e30;
+
+                    for (int i = 0; i < repetitions; ++i)
+                    {
+                        auto start = clock::now ();
+                        decode ();
+                        best = std::min (best, std::chrono::duration< double, std::milli > (clock::now () - start).count ());
+                    }
+
+                    return best;
+                };
+
+                int       width    = 0;
+                int       height   = 0;
+                int       channels = 0;
+                uint8_t * png      = SOIL_load_image_from_memory (file.data (), int(file.size ()), &width, &height, &channels, SOIL_LOAD_RGBA);
+
+                if (!png)
+                {
+                    std::cerr << "Error decoding image: " << path << std::endl;
+                    continue;
+                }
+
+                std::vector< uint8_t > qoi, raw;
+
+                Image_File::encode_qoi (png, unsigned(width), unsigned(height), size_t(width), qoi);
+                Image_File::encode_raw (png, unsigned(width), unsigned(height), size_t(width), raw);
+
+                const size_t bytes    = size_t(width) * height * 4;
+                bool         lossless = true;
+
+                auto check = [&] (uint8_t * pixels)
+                {
+                    lossless = lossless && pixels && std::memcmp (pixels, png, bytes) == 0;
+                    Image_File::free_pixels (pixels);
+                };
+
+                unsigned w, h;
+
+                const double png_ms = best_of ([&] { SOIL_free_image_data (SOIL_load_image_from_memory (file.data (), int(file.size ()), &width, &height, &channels, SOIL_LOAD_RGBA)); });
+                const double qoi_ms = best_of ([&] { check (Image_File::decode_qoi (qoi.data (), qoi.size (), w, h, 4)); });
+                const double raw_ms = best_of ([&] { check (Image_File::decode_raw (raw.data (), raw.size (), w, h, 4)); });
+
+                SOIL_free_image_data (png);
+
+                const double megapixels = double(width) * height / 1e6;
+
+                std::cout << path << " (" << width << "x" << height << "):" << std::endl
+                          << "  PNG: " << file.size () / 1024 << " KB, " << png_ms << " ms, " << megapixels * 1000.0 / png_ms << " MPix/s" << std::endl
+                          << "  QOI: " << qoi.size () / 1024 << " KB, " << qoi_ms << " ms, " << megapixels * 1000.0 / qoi_ms << " MPix/s (x" << png_ms / qoi_ms << ")" << std::endl
+                          << "  RAW: " << raw.size () / 1024 << " KB, " << raw_ms << " ms, " << megapixels * 1000.0 / raw_ms << " MPix/s (x" << png_ms / raw_ms << ")"
+                          << (lossless ? "" : "  MISMATCH") << std::endl;
+
+                total_png    += png_ms;
+                total_qoi    += qoi_ms;
+                total_raw    += raw_ms;
+                total_pixels += size_t(width) * height;
+            }
+
+            if (total_pixels == 0) return;
+
+            std::cout << "total " << double(total_pixels) / 1e6 << " MPix: PNG " << total_png << " ms, QOI " << total_qoi
+                      << " ms (x" << total_png / total_qoi << "), RAW " << total_raw << " ms (x" << total_png / total_raw << ")" << std::endl;
+        }
+
+        // Calcula la cadena de mipmaps de una imagen sintética de size x size con cada filtro: en
+        // escalar, con SIMD en un hilo y con SIMD repartiendo franjas entre todos los núcleos:
+
+        void run_mip_benchmark (unsigned size)
+        {
+            using clock = std::chrono::steady_clock;
+            using udit::Mip_Filter;
+            using Mip_Chain = udit::Texture::Mip_Chain;
+
+            udit::Texture::Color_Buffer image(size, size);
+
+            for (unsigned y = 0; y < size; ++y)
+            {
+                for (unsigned x = 0; x < size; ++x)
+                {
+                    udit::Rgba8888 color;
+
+                    color.components[udit::Rgba8888::RED  ] = uint8_t(x * 255 / size);
+                    color.components[udit::Rgba8888::GREEN] = ((x ^ y) & 8) ? 255 : 0;
+                    color.components[udit::Rgba8888::BLUE ] = uint8_t((x * 7 + y * 13) & 255);
+                    color.components[udit::Rgba8888::ALPHA] = uint8_t(y * 255 / size);
+
+                    image.set (y * size + x, color);
+                }
+            }
+
+            udit::Thread_Pool workers;
+
+            const Mip_Filter::Filter filters[] = { Mip_Filter::BOX, Mip_Filter::KAISER, Mip_Filter::LANCZOS };
+
+            std::cout << size << "x" << size << " RGBA8, sRGB, " << Mip_Filter::get_simd_name () << ", "
+                      << workers.get_thread_count () + 1 << " threads:" << std::endl;
+
+            for (auto filter : filters)
+            {
+                auto measure = [&] (bool simd, udit::Thread_Pool * pool)
+                {
+                    Mip_Chain mips{ udit::Texture::Color_Buffer(image) };
+
+                    auto start = clock::now ();
+                    mips.build (filter, true, pool, simd);
+                    return std::chrono::duration< double, std::milli > (clock::now () - start).count ();
+                };
+
+                const double scalar   = measure (false, nullptr );
+                const double simd     = measure (true,  nullptr );
+                const double parallel = measure (true,  &workers);
+
+                std::cout << "  " << Mip_Filter::get_name (filter) << ": scalar " << scalar << " ms, SIMD " << simd
+                          << " ms (x" << scalar / simd << "), SIMD + threads " << parallel << " ms (x" << scalar / parallel << ")" << std::endl;
+            }
+        }
+
+        // Empaqueta un conjunto de texturas como si fuesen los materiales de un modelo. Dibujando
+        // cada material con su propia textura hay que cambiar de textura entre las submallas; con
+        // el array basta un enlace por modelo. Sin rutas se usa un conjunto sintético de 64
+        // texturas pequeñas de distintos tamaños, como las de un escenario con muchos objetos:
+
+        void run_atlas_report (const std::vector< std::string > & image_paths)
+        {
+            using udit::Material_Array;
+
+            std::vector< std::unique_ptr< Material_Array::Color_Buffer > > images;
+
+            if (image_paths.empty ())
+            {
+                const unsigned sizes[] = { 32, 48, 64, 96, 128, 192, 256 };
+
+                for (unsigned i = 0; i < 64; ++i)
+                {
+                    const unsigned width  = sizes[(i * 5 + 1) % 7];
+                    const unsigned height = sizes[(i * 3 + 2) % 7];
+
+                    images.push_back (std::make_unique< Material_Array::Color_Buffer > (width, height));
+
+                    std::fill_n (images.back ()->colors (), size_t(width) * height, udit::Rgba8888{ 0xFF000000u | (i * 0x9E3779u & 0xFFFFFFu) });
+                }
+            }
+
+            for (const auto & path : image_paths)
+            {
+                images.push_back (udit::Texture::load_image (path));
+
+                if (!images.back ()) std::cerr << "Error loading image: " << path << std::endl;
+            }
+
+            size_t   separate_bytes = 0;
+            unsigned largest_width  = 1;
+            unsigned largest_height = 1;
+
+            for (const auto & image : images)
+            {
+                if (!image) continue;
+
+                separate_bytes += size_t(image->get_width ()) * image->get_height () * sizeof(udit::Rgba8888);
+                largest_width   = std::max (largest_width,  std::min (image->get_width  (), unsigned(Material_Array::max_layer_size)));
+                largest_height  = std::max (largest_height, std::min (image->get_height (), unsigned(Material_Array::max_layer_size)));
+            }
+
+            auto layers = Material_Array::pack_layers (images);
+
+            const size_t packed_bytes    = size_t(layers->width) * layers->height * layers->count * sizeof(udit::Rgba8888);
+            const size_t per_layer_bytes = size_t(largest_width) * largest_height * images.size () * sizeof(udit::Rgba8888);
+            const double occupancy       = double(layers->used_texels) / (double(layers->width) * layers->height * layers->count);
+
+            std::cout << images.size () << " textures: " << images.size () << " texture binds per model drawn one by one, 1 with the array ("
+                      << images.size () << "x fewer)" << std::endl
+                      << "  " << layers->count << " layers of " << layers->width << "x" << layers->height << ", "
+                      << occupancy * 100.0 << "% occupancy, padding " << Material_Array::padding << " texels" << std::endl
+                      << "  level 0: " << separate_bytes / 1024 << " KB as separate textures, " << packed_bytes / 1024
+                      << " KB packed, " << per_layer_bytes / 1024 << " KB with one resampled layer per texture" << std::endl;
+        }
+
+        // Simula en la CPU la textura virtual de un terreno de 1 km con una imagen de 16k x 16k que
+        // se sobrevuela con una cámara. La retroalimentación se calcula lanzando un rayo por píxel
+        // al plano del suelo y eligiendo el nivel como lo hace el shader, y las páginas pedidas
+        // tardan unos fotogramas en llegar. Es determinista, así que sirve para comparar tamaños de
+        // caché y cambios en Page_Cache sin GPU:
+
+        void run_virtual_texture_simulation (size_t frame_count)
+        {
+            using udit::Page_Cache;
+            using udit::Virtual_Texture;
+
+            const unsigned texture_size    = 16384;
+            const float    world_size      = 1000.f;
+            const unsigned feedback_width  = 1280 / Virtual_Texture::feedback_divisor;
+            const unsigned feedback_height =  720 / Virtual_Texture::feedback_divisor;
+            const float    tan_half_fov    = std::tan (glm::radians (30.f));
+            const float    aspect          = float(feedback_width) / float(feedback_height);
+            const size_t   load_latency    = 3;                                 // Fotogramas hasta que llega una página
+
+            std::cout << frame_count << " frames, " << texture_size << "x" << texture_size << " texture, "
+                      << feedback_width << "x" << feedback_height << " feedback, " << load_latency << " frames of load latency:" << std::endl;
+
+            for (unsigned slots_per_side : { 8u, 12u, 16u, 24u, 32u })
+            {
+                Page_Cache cache(texture_size, texture_size, Virtual_Texture::page_size, slots_per_side);
+
+                struct Pending_Load
+                {
+                    uint32_t key;
+                    size_t   ready_frame;
+                };
+
+                std::deque< Pending_Load > pending;
+                std::vector< glm::vec2 >   uvs(size_t(feedback_width + 1) * (feedback_height + 1));
+                std::vector< bool >        hits_ground(uvs.size ());
+                size_t                     frame_hits     = 0;
+                size_t                     frame_requests = 0;
+
+                for (size_t frame = 0; frame < frame_count; ++frame)
+                {
+                    // La cámara recorre una curva sobre el terreno subiendo y bajando:
+
+                    const float     time     = float(frame) / 60.f;
+                    const glm::vec3 eye      (500.f + 380.f * std::sin (time * 0.21f), 12.f + 40.f * (1.f + std::sin (time * 0.37f)), 500.f + 380.f * std::sin (time * 0.13f));
+                    const glm::vec3 ahead    (500.f + 380.f * std::sin ((time + 1.f) * 0.21f), 0.f, 500.f + 380.f * std::sin ((time + 1.f) * 0.13f));
+                    const glm::vec3 forward  = glm::normalize (ahead - eye);
+                    const glm::vec3 right    = glm::normalize (glm::cross (forward, glm::vec3(0.f, 1.f, 0.f)));
+                    const glm::vec3 up       = glm::cross (right, forward);
+
+                    // Se calculan las coordenadas de textura en las esquinas de los píxeles para
+                    // sacar de ellas las derivadas:
+
+                    for (unsigned y = 0; y <= feedback_height; ++y)
+                    {
+                        for (unsigned x = 0; x <= feedback_width; ++x)
+                        {
+                            const float     u         = (2.f * float(x) / float(feedback_width ) - 1.f) * tan_half_fov * aspect;
+                            const float     v         = (1.f - 2.f * float(y) / float(feedback_height)) * tan_half_fov;
+                            const glm::vec3 direction = forward + u * right + v * up;
+                            const size_t    index     = size_t(y) * (feedback_width + 1) + x;
+
+                            hits_ground[index] = direction.y < -1e-4f;
+
+                            if (hits_ground[index])
+                            {
+                                const glm::vec3 point = eye + direction * (-eye.y / direction.y);
+
+                                uvs[index] = glm::vec2(point.x, point.z) / world_size;
+                            }
+                        }
+                    }
+
+                    cache.begin_frame ();
+
+                    const size_t requests_before = cache.get_statistics ().requests;
+                    const size_t hits_before     = cache.get_statistics ().hits;
+
+                    for (unsigned y = 0; y < feedback_height; ++y)
+                    {
+                        for (unsigned x = 0; x < feedback_width; ++x)
+                        {
+                            const size_t index = size_t(y) * (feedback_width + 1) + x;
+
+                            if (!hits_ground[index] || !hits_ground[index + 1] || !hits_ground[index + feedback_width + 1]) continue;
+
+                            const glm::vec2 uv = uvs[index];
+
+                            if (uv.x < 0.f || uv.y < 0.f || uv.x > 1.f || uv.y > 1.f) continue;
+
+                            const glm::vec2 dx    = (uvs[index + 1] - uv) * float(texture_size);
+                            const glm::vec2 dy    = (uvs[index + feedback_width + 1] - uv) * float(texture_size);
+                            const float     lod   = 0.5f * std::log2 (std::max (std::max (glm::dot (dx, dx), glm::dot (dy, dy)), 1e-8f)) - 3.f;
+                            const unsigned  level = unsigned(std::min (std::max (std::floor (lod), 0.f), float(cache.get_level_count () - 1)));
+
+                            const unsigned  page_x = std::min (unsigned(uv.x * float(cache.get_level_width  (level))) / Virtual_Texture::page_size, cache.get_page_count_x (level) - 1);
+                            const unsigned  page_y = std::min (unsigned(uv.y * float(cache.get_level_height (level))) / Virtual_Texture::page_size, cache.get_page_count_y (level) - 1);
+
+                            cache.request (Page_Cache::make_key (level, page_x, page_y));
+                        }
+                    }
+
+                    // El arranque, con la caché vacía, no cuenta para la tasa de aciertos:
+
+                    if (frame >= load_latency * 4)
+                    {
+                        frame_requests += cache.get_statistics ().requests - requests_before;
+                        frame_hits     += cache.get_statistics ().hits     - hits_before;
+                    }
+
+                    // Se piden las páginas que faltan y se colocan las que ya han llegado, con los
+                    // mismos límites que Virtual_Texture::update ():
+
+                    for (uint32_t key : cache.take_loads (Virtual_Texture::max_loads_in_flight - pending.size ()))
+                    {
+                        pending.push_back (Pending_Load{ key, frame + load_latency });
+                    }
+
+                    for (size_t count = 0; count < Virtual_Texture::max_uploads_per_frame && !pending.empty () && pending.front ().ready_frame <= frame; ++count)
+                    {
+                        cache.insert (pending.front ().key);
+                        pending.pop_front ();
+                    }
+                }
+
+                const Page_Cache::Statistics & statistics = cache.get_statistics ();
+
+                std::cout << "  " << slots_per_side * slots_per_side << " slots (" << (slots_per_side * Virtual_Texture::slot_size) * (slots_per_side * Virtual_Texture::slot_size) * 4 / (1024 * 1024)
+                          << " MB): " << (frame_requests ? 100.0 * double(frame_hits) / double(frame_requests) : 0.0) << "% hits, "
+                          << double(statistics.requests) / double(frame_count) << " pages/frame, " << statistics.loads << " loads, "
+                          << statistics.evictions << " evictions, " << statistics.drops << " drops" << std::endl;
+            }
+        }
+
+        // Comprueba Mip_Residency con escenas sintéticas y sin GPU. Una cámara recorre un campo
+        // de texturas de distintos tamaños y, tras cada update(), lo residente debe caber en el
+        // presupuesto y no pasar de lo que pide cada textura. Después se reduce el presupuesto a la
+        // mitad y, por último, se pide menos de lo que ocupan los niveles fijos:
+
+        bool run_mip_streaming_check ()
+        {
+            using udit::Mip_Residency;
+
+            constexpr unsigned side_count    = 20;                  // 400 texturas en una rejilla
+            constexpr float    spacing       = 10.f;
+            constexpr float    object_size   = 4.f;                 // La textura cubre el objeto una vez
+            constexpr float    focal_pixels  = 1000.f;              // Píxeles por unidad a una unidad de distancia
+
+            const unsigned sizes[] = { 512, 1024, 2048, 4096 };
+
+            Mip_Residency residency(size_t(96) << 20);
+
+            struct Object
+            {
+                glm::vec2             position;
+                unsigned              size;
+                Mip_Residency::Handle handle;
+            };
+
+            std::vector< Object > objects;
+
+            size_t full_bytes = 0;
+
+            for (unsigned i = 0; i < side_count * side_count; ++i)
+            {
+                const unsigned size   = sizes[(i * 7 + i / 3) % 4];
+                const unsigned levels = unsigned(std::log2 (float(size))) + 1;
+
+                objects.push_back (Object{ glm::vec2(float(i % side_count), float(i / side_count)) * spacing, size, residency.add (size, size, levels) });
+
+                full_bytes += residency.get_bytes (objects.back ().handle, 0);
+            }
+
+            bool   passed          = true;
+            size_t peak_bytes      = 0;
+            size_t frame           = 0;
+
+            auto fail = [&passed, &frame] (const char * reason)
+            {
+                if (passed) std::cout << "  FAILED at frame " << frame << ": " << reason << std::endl;
+
+                passed = false;
+            };
+
+            // Cada fotograma pide el nivel de las texturas a menos de 60 unidades de la cámara:
+
+            auto run_frame = [&] (glm::vec2 camera)
+            {
+                residency.begin_frame ();
+
+                for (const auto & object : objects)
+                {
+                    const float distance = std::max (glm::length (object.position - camera), 1.f);
+
+                    if (distance > 60.f) continue;
+
+                    residency.request (object.handle, Mip_Residency::estimate_level (object.size, object.size, 1.f / object_size, focal_pixels / distance));
+                }
+
+                residency.update (size_t(8) << 20);
+
+                size_t resident_bytes = 0;
+
+                for (const auto & object : objects)
+                {
+                    const unsigned resident = residency.get_resident_level (object.handle);
+
+                    if (resident < residency.get_target_level (object.handle)) fail ("a texture is above its target level");
+                    if (resident > residency.get_tail_level   (object.handle)) fail ("a texture lost its tail levels");
+
+                    resident_bytes += residency.get_bytes (object.handle, resident);
+                }
+
+                if (resident_bytes != residency.get_statistics ().resident_bytes) fail ("resident byte count is out of sync");
+
+                if (resident_bytes > residency.get_budget () && residency.get_statistics ().overflow_count == 0) fail ("resident bytes over budget");
+
+                peak_bytes = std::max (peak_bytes, resident_bytes);
+
+                ++frame;
+            };
+
+            std::cout << objects.size () << " textures, " << full_bytes / (1024 * 1024) << " MB with every level resident, budget "
+                      << residency.get_budget () / (1024 * 1024) << " MB:" << std::endl;
+
+            // Recorrido en diagonal por el campo:
+
+            for (size_t step = 0; step < 600; ++step)
+            {
+                const float t = float(step) / 600.f;
+
+                run_frame (glm::vec2(t, 0.5f + 0.4f * std::sin (t * 6.f)) * (spacing * side_count));
+            }
+
+            std::cout << "  fly-through: peak " << peak_bytes / (1024 * 1024) << " MB, wanted " << residency.get_statistics ().wanted_bytes / (1024 * 1024)
+                      << " MB in the last frame, " << residency.get_statistics ().loaded_levels << " levels loaded, "
+                      << residency.get_statistics ().released_levels << " released" << std::endl;
+
+            // Con la cámara quieta y lo pedido dentro del presupuesto, todas las visibles deben
+            // llegar a su nivel:
+
+            const glm::vec2 still_camera = glm::vec2(0.5f, 0.5f) * (spacing * side_count);
+
+            for (size_t step = 0; step < 200; ++step) run_frame (still_camera);
+
+            if (residency.get_statistics ().wanted_bytes <= residency.get_budget ())
+            {
+                for (const auto & object : objects)
+                {
+                    if (glm::length (object.position - still_camera) <= 60.f && residency.get_resident_level (object.handle) != residency.get_wanted_level (object.handle))
+                    {
+                        fail ("a visible texture did not reach its wanted level");
+                        break;
+                    }
+                }
+            }
+
+            // Al reducir el presupuesto las bajadas se aplican en el mismo update():
+
+            residency.set_budget (residency.get_budget () / 8);
+            peak_bytes = 0;
+
+            run_frame (still_camera);
+
+            std::cout << "  budget cut to " << residency.get_budget () / (1024 * 1024) << " MB: " << residency.get_statistics ().resident_bytes / (1024 * 1024)
+                      << " MB resident in the next frame" << std::endl;
+
+            // Presupuesto menor que los niveles fijos: se avisa del desbordamiento y no se descarga nada
+            // por debajo de ellos:
+
+            residency.set_budget (size_t(1) << 20);
+
+            const size_t overflows = residency.get_statistics ().overflow_count;
+
+            run_frame (still_camera);
+
+            if (residency.get_statistics ().overflow_count != overflows + 1) fail ("overflow not reported");
+
+            for (const auto & object : objects)
+            {
+                if (residency.get_resident_level (object.handle) != residency.get_tail_level (object.handle))
+                {
+                    fail ("textures kept levels above their tail while over budget");
+                    break;
+                }
+            }
+
+            std::cout << "  budget cut to 1 MB: " << residency.get_statistics ().resident_bytes / 1024 << " KB of tail levels resident, overflow reported" << std::endl;
+
+            std::cout << (passed ? "  PASSED" : "  FAILED") << std::endl;
+
+            return passed;
+        }
+
+    }
+
+}
@@ -0,0 +1,348 @@
+#include "Tools.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <Block_Compression.hpp>
+#include <Image_File.hpp>
+#include <Thread_Pool.hpp>
+
+#include "../Texture.hpp"
+#include "../Virtual_Texture.hpp"
+
+namespace udit
+{
+
+    namespace tools
+    {
+
+        namespace
+        {
+
+            bool parse_block_format (const char * name, Block_Compression::Format & format)
+            {
+                const Block_Compression::Format formats[] = { Block_Compression::BC1, Block_Compression::BC3, Block_Compression::BC4, Block_Compression::BC5 };
+                const char *                    names  [] = { "bc1", "bc3", "bc4", "bc5" };
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (std::strcmp (name, names[i]) == 0)
+                    {
+                        format = formats[i];
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            // Argumentos opcionales a partir de argv[2]:
+
+            std::vector< std::string > get_paths (int argc, char * argv[], std::vector< std::string > defaults)
+            {
+                std::vector< std::string > paths(argv + 2, argv + argc);
+
+                return paths.empty () ? defaults : paths;
+            }
+
+            unsigned long get_number (int argc, char * argv[], int index, unsigned long default_value)
+            {
+                return argc > index ? std::strtoul (argv[index], nullptr, 10) : default_value;
+            }
+
+            // Herramientas sin ventana:
+
+            int texture_benchmark (int argc, char * argv[])
+            {
+                run_texture_benchmark
+                (
+                    get_paths
+                    (
+                        argc, argv,
+                        {
+                            "../../../shared/assets/uv-checker.png",
+                            "../../../shared/assets/tex.png",
+                            "../../../shared/assets/height-map.png"
+                        }
+                    )
+                );
+
+                return 0;
+            }
+
+            int atlas_report (int argc, char * argv[])
+            {
+                run_atlas_report (std::vector< std::string >(argv + 2, argv + argc));
+
+                return 0;
+            }
+
+            int mip_benchmark (int argc, char * argv[])
+            {
+                run_mip_benchmark (unsigned(get_number (argc, argv, 2, 8192)));
+
+                return 0;
+            }
+
+            // --cook-texture <image> <output.ktx2> [bc1|bc3|bc4|bc5]
+
+            int cook_texture (int argc, char * argv[])
+            {
+                Block_Compression::Format format = Block_Compression::BC1;
+
+                if (argc < 4 || (argc > 4 && !parse_block_format (argv[4], format)))
+                {
+                    std::cerr << "usage: --cook-texture <image> <output.ktx2> [bc1|bc3|bc4|bc5]" << std::endl;
+                    return 1;
+                }
+
+                Thread_Pool workers;
+
+                return Texture::cook (argv[2], argv[3], format, &workers) ? 0 : 1;
+            }
+
+            int image_format_benchmark (int argc, char * argv[])
+            {
+                run_image_format_benchmark
+                (
+                    get_paths
+                    (
+                        argc, argv,
+                        {
+                            "../../../shared/assets/height-map.png",
+                            "../../../shared/assets/sky-cube-map-0.png",
+                            "../../../shared/assets/sky-cube-map-1.png",
+                            "../../../shared/assets/sky-cube-map-2.png",
+                            "../../../shared/assets/sky-cube-map-3.png",
+                            "../../../shared/assets/sky-cube-map-4.png",
+                            "../../../shared/assets/sky-cube-map-5.png",
+                            "../../../shared/assets/tex.png",
+                            "../../../shared/assets/uv-checker.png"
+                        }
+                    )
+                );
+
+                return 0;
+            }
+
+            // Convierte una imagen a un formato de decodificación rápida (elegido por la extensión):
+
+            int cook_image (int argc, char * argv[])
+            {
+                if (argc < 4 || !Image_File::is_fast (argv[3]))
+                {
+                    std::cerr << "usage: --cook-image <image> <output.qoi|output.raw>" << std::endl;
+                    return 1;
+                }
+
+                auto image = Texture::load_image (argv[2]);
+
+                if (!image)
+                {
+                    std::cerr << "Error loading image: " << argv[2] << std::endl;
+                    return 1;
+                }
+
+                const uint8_t * pixels = reinterpret_cast< const uint8_t * >(image->colors ());
+
+                return Image_File::save (argv[3], pixels, image->get_width (), image->get_height (), image->get_pitch ()) ? 0 : 1;
+            }
+
+            // --software-render [width] [height] [frames] [output.png|.qoi|.raw]
+
+            int software_render (int argc, char * argv[])
+            {
+                run_software_render
+                (
+                    unsigned(get_number (argc, argv, 2, 1920)),
+                    unsigned(get_number (argc, argv, 3, 1080)),
+                    size_t  (get_number (argc, argv, 4,   60)),
+                    argc > 5 ? argv[5] : ""
+                );
+
+                return 0;
+            }
+
+            int mip_streaming_check (int , char * [])
+            {
+                return run_mip_streaming_check () ? 0 : 1;
+            }
+
+            int mesh_allocation_check (int , char * [])
+            {
+                return run_mesh_allocation_check () ? 0 : 1;
+            }
+
+            // --obj-check [file.obj...]
+
+            int obj_check (int argc, char * argv[])
+            {
+                return run_obj_check (get_paths (argc, argv, { "../../../shared/assets/lighthouse.obj" })) ? 0 : 1;
+            }
+
+            // --glb-check <file.glb...>
+
+            int glb_check (int argc, char * argv[])
+            {
+                if (argc < 3)
+                {
+                    std::cerr << "usage: --glb-check <file.glb...>" << std::endl;
+                    return 1;
+                }
+
+                return run_glb_check (std::vector< std::string >(argv + 2, argv + argc)) ? 0 : 1;
+            }
+
+            // --tangent-frame-benchmark <mesh...>
+
+            int tangent_frame_benchmark (int argc, char * argv[])
+            {
+                if (argc < 3)
+                {
+                    std::cerr << "usage: --tangent-frame-benchmark <mesh...>" << std::endl;
+                    return 1;
+                }
+
+                run_tangent_frame_benchmark (std::vector< std::string >(argv + 2, argv + argc));
+
+                return 0;
+            }
+
+            int pixel_conversion_check (int , char * [])
+            {
+                return run_pixel_conversion_check () ? 0 : 1;
+            }
+
+            // --pixel-conversion-benchmark [megapixels]
+
+            int pixel_conversion_benchmark (int argc, char * argv[])
+            {
+                run_pixel_conversion_benchmark (size_t(get_number (argc, argv, 2, 16)));
+
+                return 0;
+            }
+
+            int cook_virtual_texture (int argc, char * argv[])
+            {
+                if (argc < 4)
+                {
+                    std::cerr << "usage: --cook-virtual-texture <image> <output.vtex>" << std::endl;
+                    return 1;
+                }
+
+                Thread_Pool workers;
+
+                return Virtual_Texture::cook (argv[2], argv[3], &workers) ? 0 : 1;
+            }
+
+            int virtual_texture_simulation (int argc, char * argv[])
+            {
+                run_virtual_texture_simulation (size_t(get_number (argc, argv, 2, 1800)));
+
+                return 0;
+            }
+
+            // Herramientas con la escena:
+
+            int instancing_benchmark (Window & window, Scene & scene, int , char * [])
+            {
+                run_instancing_benchmark (window, scene);
+
+                return 0;
+            }
+
+            int skinning_benchmark (Window & window, Scene & scene, int , char * [])
+            {
+                run_skinning_benchmark (window, scene);
+
+                return 0;
+            }
+
+            // --texture-streaming-benchmark [count] [size]
+
+            int texture_streaming_benchmark (Window & window, Scene & scene, int argc, char * argv[])
+            {
+                run_texture_streaming_benchmark (window, scene, size_t(get_number (argc, argv, 2, 200)), unsigned(get_number (argc, argv, 3, 4096)));
+
+                return 0;
+            }
+
+            int skybox_benchmark (Window & window, Scene & scene, int , char * [])
+            {
+                // La escena ajusta el viewport al tamaño de la ventana:
+
+                GLint viewport[4];
+
+                glGetIntegerv (GL_VIEWPORT, viewport);
+
+                run_skybox_benchmark (window, scene, unsigned(viewport[2]), unsigned(viewport[3]));
+
+                return 0;
+            }
+
+            int program_cache_check (Window & , Scene & , int , char * [])
+            {
+                return run_program_cache_check () ? 0 : 1;
+            }
+
+            int asset_registry_check (Window & , Scene & , int , char * [])
+            {
+                return run_asset_registry_check () ? 0 : 1;
+            }
+
+            const Tool tools[] =
+            {
+                { "--texture-benchmark",          texture_benchmark          },
+                { "--atlas-report",               atlas_report               },
+                { "--mip-benchmark",              mip_benchmark              },
+                { "--cook-texture",               cook_texture               },
+                { "--image-format-benchmark",     image_format_benchmark     },
+                { "--cook-image",                 cook_image                 },
+                { "--software-render",            software_render            },
+                { "--mip-streaming-check",        mip_streaming_check        },
+                { "--mesh-allocation-check",      mesh_allocation_check      },
+                { "--obj-check",                  obj_check                  },
+                { "--glb-check",                  glb_check                  },
+                { "--tangent-frame-benchmark",    tangent_frame_benchmark    },
+                { "--pixel-conversion-check",     pixel_conversion_check     },
+                { "--pixel-conversion-benchmark", pixel_conversion_benchmark },
+                { "--cook-virtual-texture",       cook_virtual_texture       },
+                { "--virtual-texture-simulation", virtual_texture_simulation },
+            };
+
+            const Scene_Tool scene_tools[] =
+            {
+                { "--instancing-benchmark",        instancing_benchmark        },
+                { "--skinning-benchmark",          skinning_benchmark          },
+                { "--texture-streaming-benchmark", texture_streaming_benchmark },
+                { "--skybox-benchmark",            skybox_benchmark            },
+                { "--program-cache-check",         program_cache_check         },
+                { "--asset-registry-check",        asset_registry_check        },
+            };
+
+        }
+
+        const Tool * find_tool (int argc, char * argv[])
+        {
+            if (argc > 1)
+            {
+                for (const auto & tool : tools) if (std::strcmp (argv[1], tool.name) == 0) return &tool;
+            }
+
+            return nullptr;
+        }
+
+        const Scene_Tool * find_scene_tool (int argc, char * argv[])
+        {
+            if (argc > 1)
+            {
+                for (const auto & tool : scene_tools) if (std::strcmp (argv[1], tool.name) == 0) return &tool;
+            }
+
+            return nullptr;
+        }
+
+    }
+
+}
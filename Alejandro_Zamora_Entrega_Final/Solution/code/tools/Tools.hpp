@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <Window.hpp>
+
+#include "../Scene.hpp"
+
+namespace udit
+{
+
+    // Herramientas de línea de comandos del ejemplo: comprobaciones, benchmarks y
+    // conversores de recursos. main() sólo busca la que pide argv[1] y la ejecuta; cada
+    // grupo vive en su propia unidad de traducción de esta carpeta.
+
+    namespace tools
+    {
+
+        // Herramientas que no necesitan ventana ni contexto de OpenGL. run recibe los
+        // argumentos completos y devuelve el código de salida del programa:
+
+        struct Tool
+        {
+            const char * name;
+            int       (* run) (int argc, char * argv[]);
+        };
+
+        // Herramientas que miden o comprueban la escena, con la sincronización vertical
+        // desactivada para no limitar los fotogramas:
+
+        struct Scene_Tool
+        {
+            const char * name;
+            int       (* run) (Window & window, Scene & scene, int argc, char * argv[]);
+        };
+
+        // Devuelven la herramienta que pide argv[1] o nullptr si no es ninguna:
+
+        const Tool       * find_tool       (int argc, char * argv[]);
+        const Scene_Tool * find_scene_tool (int argc, char * argv[]);
+
+        // Render_Tools.cpp:
+
+        void run_instancing_benchmark        (Window & window, Scene & scene);
+        void run_skinning_benchmark          (Window & window, Scene & scene);
+        void run_texture_streaming_benchmark (Window & window, Scene & scene, size_t count, unsigned size);
+        void run_skybox_benchmark            (Window & window, Scene & scene, unsigned width, unsigned height);
+        bool run_program_cache_check         ();
+        bool run_asset_registry_check        ();
+        void run_software_render             (unsigned width, unsigned height, size_t frame_count, const std::string & output);
+
+        // Texture_Tools.cpp:
+
+        void run_texture_benchmark          (const std::vector< std::string > & image_paths);
+        void run_image_format_benchmark     (const std::vector< std::string > & image_paths);
+        void run_mip_benchmark              (unsigned size);
+        void run_atlas_report               (const std::vector< std::string > & image_paths);
+        void run_virtual_texture_simulation (size_t frame_count);
+        bool run_mip_streaming_check        ();
+
+        // Pixel_Conversion_Tools.cpp:
+
+        bool run_pixel_conversion_check     ();
+        void run_pixel_conversion_benchmark (size_t megapixels);
+
+        // Mesh_Tools.cpp:
+
+        bool run_mesh_allocation_check   ();
+        bool run_obj_check               (const std::vector< std::string > & obj_paths);
+        bool run_glb_check               (const std::vector< std::string > & glb_paths);
+        void run_tangent_frame_benchmark (const std::vector< std::string > & mesh_paths);
+
+    }
+
+}
@@ -0,0 +1,546 @@
+#include "Block_Compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Thread_Pool.hpp"
+
+namespace udit
+{
+
+    namespace
+    {
+
+        uint16_t pack_565 (const float color[3])
+        {
+            const int r = std::min (std::max (int(color[0] * (31.f / 255.f) + 0.5f), 0), 31);
+            const int g = std::min (std::max (int(color[1] * (63.f / 255.f) + 0.5f), 0), 63);
+            const int b = std::min (std::max (int(color[2] * (31.f / 255.f) + 0.5f), 0), 31);
+
+            return uint16_t(r << 11 | g << 5 | b);
+        }
+
+        void unpack_565 (uint16_t packed, int color[3])
+        {
+            const int r = packed >> 11 & 31;
+            const int g = packed >>  5 & 63;
+            const int b = packed       & 31;
+
+            color[0] = r << 3 | r >> 2;
+            color[1] = g << 2 | g >> 4;
+            color[2] = b << 3 | b >> 2;
+        }
+
+        // Paleta de un bloque BC1. Con color0 > color1 hay cuatro colores; si no, tres y negro
+        // transparente (el color de BC3 siempre usa cuatro):
+
+        void bc1_palette (uint16_t color0, uint16_t color1, bool four_colors, int palette[4][3])
+        {
+            unpack_565 (color0, palette[0]);
+            unpack_565 (color1, palette[1]);
+
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                if (four_colors)
+                {
+                    palette[2][k] = (2 * palette[0][k] +     palette[1][k]) / 3;
+                    palette[3][k] = (    palette[0][k] + 2 * palette[1][k]) / 3;
+                }
+                else
+                {
+                    palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+                    palette[3][k] = 0;
+                }
+            }
+        }
+
+        // Paleta de un bloque BC4. Con value0 > value1 hay ocho valores interpolados; si no,
+        // seis más 0 y 255 exactos:
+
+        void bc4_palette (int value0, int value1, int palette[8])
+        {
+            palette[0] = value0;
+            palette[1] = value1;
+
+            if (value0 > value1)
+            {
+                for (int k = 1; k < 7; ++k) palette[k + 1] = ((7 - k) * value0 + k * value1 + 3) / 7;
+            }
+            else
+            {
+                for (int k = 1; k < 5; ++k) palette[k + 1] = ((5 - k) * value0 + k * value1 + 2) / 5;
+
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+        }
+
+        // Elige para cada texel la entrada más cercana de la paleta. Devuelve el error
+        // cuadrático total:
+
+        uint32_t bc1_indices (const Rgba8888 * block, const int palette[4][3], uint32_t & indices)
+        {
+            uint32_t total = 0;
+
+            indices = 0;
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                uint32_t best       = std::numeric_limits< uint32_t >::max ();
+                uint32_t best_index = 0;
+
+                for (uint32_t p = 0; p < 4; ++p)
+                {
+                    const int dr = block[i].components[Rgba8888::RED  ] - palette[p][0];
+                    const int dg = block[i].components[Rgba8888::GREEN] - palette[p][1];
+                    const int db = block[i].components[Rgba8888::BLUE ] - palette[p][2];
+
+                    const uint32_t error = uint32_t(dr * dr + dg * dg + db * db);
+
+                    if (error < best)
+                    {
+                        best       = error;
+                        best_index = p;
+                    }
+                }
+
+                indices |= best_index << (2 * i);
+                total   += best;
+            }
+
+            return total;
+        }
+
+        uint32_t bc4_indices (const Rgba8888 * block, unsigned channel, const int palette[8], uint64_t & indices)
+        {
+            uint32_t total = 0;
+
+            indices = 0;
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                uint32_t best       = std::numeric_limits< uint32_t >::max ();
+                uint64_t best_index = 0;
+
+                for (uint64_t p = 0; p < 8; ++p)
+                {
+                    const int      difference = block[i].components[channel] - palette[p];
+                    const uint32_t error      = uint32_t(difference * difference);
+
+                    if (error < best)
+                    {
+                        best       = error;
+                        best_index = p;
+                    }
+                }
+
+                indices |= best_index << (3 * i);
+                total   += best;
+            }
+
+            return total;
+        }
+
+        // Cuantiza un par de extremos, calcula los índices y se queda con el bloque si mejora
+        // el mejor encontrado hasta ahora. Siempre se emite el modo de cuatro colores
+        // (color0 > color1) porque el de tres no aporta nada sin alfa:
+
+        void try_bc1_endpoints (const Rgba8888 * block, const float end0[3], const float end1[3], uint32_t & best_error, uint16_t best_colors[2], uint32_t & best_indices)
+        {
+            uint16_t color0 = pack_565 (end0);
+            uint16_t color1 = pack_565 (end1);
+            uint32_t indices;
+            uint32_t error;
+            int      palette[4][3];
+
+            if (color0 < color1) std::swap (color0, color1);
+
+            // Con un único color las cuatro entradas coinciden y basta el índice 0, que es
+            // válido en los dos modos:
+
+            bc1_palette (color0, color1, true, palette);
+
+            error = bc1_indices (block, palette, indices);
+
+            if (color0 == color1) indices = 0;
+
+            if (error < best_error)
+            {
+                best_error     = error;
+                best_colors[0] = color0;
+                best_colors[1] = color1;
+                best_indices   = indices;
+            }
+        }
+
+    }
+
+    const char * Block_Compression::get_name (Format format)
+    {
+        switch (format)
+        {
+            case BC1: return "BC1";
+            case BC3: return "BC3";
+            case BC4: return "BC4";
+            case BC5: return "BC5";
+        }
+
+        return "?";
+    }
+
+    void Block_Compression::encode (Format format, const Rgba8888 * pixels, unsigned width, unsigned height, uint8_t * blocks, Thread_Pool * workers)
+    {
+        const unsigned blocks_x    = (width  + 3) / 4;
+        const unsigned blocks_y    = (height + 3) / 4;
+        const size_t   block_bytes = get_block_bytes (format);
+
+        auto encode_rows = [=] (size_t begin, size_t end)
+        {
+            Rgba8888 block[16];
+
+            for (size_t by = begin; by < end; ++by)
+            {
+                for (unsigned bx = 0; bx < blocks_x; ++bx)
+                {
+                    // Se copia el bloque repitiendo el borde si la imagen no llega a 4x4:
+
+                    for (unsigned y = 0; y < 4; ++y)
+                    {
+                        const unsigned row = std::min (unsigned(by) * 4 + y, height - 1);
+
+                        for (unsigned x = 0; x < 4; ++x)
+                        {
+                            block[y * 4 + x] = pixels[size_t(row) * width + std::min (bx * 4 + x, width - 1)];
+                        }
+                    }
+
+                    uint8_t * output = blocks + (by * blocks_x + bx) * block_bytes;
+
+                    switch (format)
+                    {
+                        case BC1: encode_bc1_block (block, output); break;
+                        case BC3: encode_bc4_block (block, Rgba8888::ALPHA, output); encode_bc1_block (block, output + 8); break;
+                        case BC4: encode_bc4_block (block, Rgba8888::RED,   output); break;
+                        case BC5: encode_bc4_block (block, Rgba8888::RED,   output); encode_bc4_block (block, Rgba8888::GREEN, output + 8); break;
+                    }
+                }
+            }
+        };
+
+        if (workers) workers->parallel_for (blocks_y, encode_rows); else encode_rows (0, blocks_y);
+    }
+
+    void Block_Compression::decode (Format format, const uint8_t * blocks, unsigned width, unsigned height, Rgba8888 * pixels)
+    {
+        const unsigned blocks_x    = (width  + 3) / 4;
+        const unsigned blocks_y    = (height + 3) / 4;
+        const size_t   block_bytes = get_block_bytes (format);
+
+        Rgba8888 block[16];
+
+        for (unsigned by = 0; by < blocks_y; ++by)
+        {
+            for (unsigned bx = 0; bx < blocks_x; ++bx)
+            {
+                const uint8_t * input = blocks + (size_t(by) * blocks_x + bx) * block_bytes;
+
+                std::fill_n (block, 16, Rgba8888{ 0xFF000000 });
+
+                switch (format)
+                {
+                    case BC1: decode_bc1_block (input, block, false); break;
+                    case BC3: decode_bc4_block (input, Rgba8888::ALPHA, block); decode_bc1_block (input + 8, block, true); break;
+                    case BC4: decode_bc4_block (input, Rgba8888::RED,   block); break;
+                    case BC5: decode_bc4_block (input, Rgba8888::RED,   block); decode_bc4_block (input + 8, Rgba8888::GREEN, block); break;
+                }
+
+                for (unsigned y = 0; y < 4 && by * 4 + y < height; ++y)
+                {
+                    for (unsigned x = 0; x < 4 && bx * 4 + x < width; ++x)
+                    {
+                        pixels[size_t(by * 4 + y) * width + bx * 4 + x] = block[y * 4 + x];
+                    }
+                }
+            }
+        }
+    }
+
+    double Block_Compression::psnr (Format format, const Rgba8888 * original, const Rgba8888 * decoded, size_t count)
+    {
+        static const unsigned channels[][4] =
+        {
+            { Rgba8888::RED, Rgba8888::GREEN, Rgba8888::BLUE                  },     // BC1
+            { Rgba8888::RED, Rgba8888::GREEN, Rgba8888::BLUE, Rgba8888::ALPHA },     // BC3
+            { Rgba8888::RED                                                   },     // BC4
+            { Rgba8888::RED, Rgba8888::GREEN                                  },     // BC5
+        };
+
+        static const unsigned channel_counts[] = { 3, 4, 1, 2 };
+
+        double squared_error = 0.0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (unsigned c = 0; c < channel_counts[format]; ++c)
+            {
+                const double difference = double(original[i].components[channels[format][c]]) - double(decoded[i].components[channels[format][c]]);
+
+                squared_error += difference * difference;
+            }
+        }
+
+        if (squared_error == 0.0) return std::numeric_limits< double >::infinity ();
+
+        const double mse = squared_error / double(count * channel_counts[format]);
+
+        return 10.0 * std::log10 (255.0 * 255.0 / mse);
+    }
+
+    void Block_Compression::encode_bc1_block (const Rgba8888 * block, uint8_t * output)
+    {
+        // Se buscan el color medio y la covarianza del bloque:
+
+        float mean[3] = { 0.f, 0.f, 0.f };
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            for (unsigned k = 0; k < 3; ++k) mean[k] += block[i].components[k];
+        }
+
+        for (unsigned k = 0; k < 3; ++k) mean[k] *= 1.f / 16.f;
+
+        float covariance[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };      // xx xy xz yy yz zz
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            const float r = block[i].components[0] - mean[0];
+            const float g = block[i].components[1] - mean[1];
+            const float b = block[i].components[2] - mean[2];
+
+            covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+            covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+        }
+
+        // El eje principal (autovector de mayor autovalor) se aproxima con unas pocas
+        // iteraciones del método de la potencia:
+
+        float axis[3] = { 1.f, 1.f, 1.f };
+
+        for (unsigned iteration = 0; iteration < 6; ++iteration)
+        {
+            const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+            const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+            const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+
+            const float largest = std::max (std::max (std::fabs (x), std::fabs (y)), std::fabs (z));
+
+            if (largest < 1e-6f) break;
+
+            axis[0] = x / largest;
+            axis[1] = y / largest;
+            axis[2] = z / largest;
+        }
+
+        const float length = std::sqrt (axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+        for (unsigned k = 0; k < 3; ++k) axis[k] /= length;
+
+        // Los extremos iniciales son las proyecciones extremas de los texels sobre el eje:
+
+        float minimum =  std::numeric_limits< float >::max ();
+        float maximum = -std::numeric_limits< float >::max ();
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            const float t = (block[i].components[0] - mean[0]) * axis[0]
+                          + (block[i].components[1] - mean[1]) * axis[1]
+                          + (block[i].components[2] - mean[2]) * axis[2];
+
+            minimum = std::min (minimum, t);
+            maximum = std::max (maximum, t);
+        }
+
+        float end0[3], end1[3];
+
+        for (unsigned k = 0; k < 3; ++k)
+        {
+            end0[k] = mean[k] + axis[k] * maximum;
+            end1[k] = mean[k] + axis[k] * minimum;
+        }
+
+        uint32_t best_error   = std::numeric_limits< uint32_t >::max ();
+        uint16_t best_colors[2];
+        uint32_t best_indices = 0;
+
+        try_bc1_endpoints (block, end0, end1, best_error, best_colors, best_indices);
+
+        // Con los índices fijados, los extremos que minimizan el error cuadrático salen de un
+        // sistema 2x2 de mínimos cuadrados. Dos pasadas bastan para converger casi siempre:
+
+        static const float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+
+        for (unsigned pass = 0; pass < 2 && best_error > 0 && best_colors[0] != best_colors[1]; ++pass)
+        {
+            float aa = 0.f, ab = 0.f, bb = 0.f;
+            float ax[3] = { 0.f, 0.f, 0.f };
+            float bx[3] = { 0.f, 0.f, 0.f };
+
+            for (unsigned i = 0; i < 16; ++i)
+            {
+                const float a = weights[best_indices >> (2 * i) & 3];
+                const float b = 1.f - a;
+
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+
+                for (unsigned k = 0; k < 3; ++k)
+                {
+                    ax[k] += a * block[i].components[k];
+                    bx[k] += b * block[i].components[k];
+                }
+            }
+
+            const float determinant = aa * bb - ab * ab;
+
+            if (std::fabs (determinant) < 1e-6f) break;
+
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                end0[k] = std::min (std::max ((bb * ax[k] - ab * bx[k]) / determinant, 0.f), 255.f);
+                end1[k] = std::min (std::max ((aa * bx[k] - ab * ax[k]) / determinant, 0.f), 255.f);
+            }
+
+            const uint32_t previous_error = best_error;
+
+            try_bc1_endpoints (block, end0, end1, best_error, best_colors, best_indices);
+
+            if (best_error == previous_error) break;
+        }
+
+        output[0] = uint8_t(best_colors[0]);
+        output[1] = uint8_t(best_colors[0] >> 8);
+        output[2] = uint8_t(best_colors[1]);
+        output[3] = uint8_t(best_colors[1] >> 8);
+        output[4] = uint8_t(best_indices);
+        output[5] = uint8_t(best_indices >>  8);
+        output[6] = uint8_t(best_indices >> 16);
+        output[7] = uint8_t(best_indices >> 24);
+    }
+
+    void Block_Compression::encode_bc4_block (const Rgba8888 * block, unsigned channel, uint8_t * output)
+    {
+        int minimum       = 255, maximum       = 0;
+        int inner_minimum = 255, inner_maximum = 0;       // Sin contar 0 y 255
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            const int value = block[i].components[channel];
+
+            minimum = std::min (minimum, value);
+            maximum = std::max (maximum, value);
+
+            if (value != 0 && value != 255)
+            {
+                inner_minimum = std::min (inner_minimum, value);
+                inner_maximum = std::max (inner_maximum, value);
+            }
+        }
+
+        int      palette[8];
+        int      value0, value1;
+        uint64_t indices;
+        uint32_t error;
+
+        if (minimum == maximum)
+        {
+            value0  = value1 = maximum;
+            indices = 0;
+        }
+        else
+        {
+            // Modo de ocho valores entre el mínimo y el máximo:
+
+            value0 = maximum;
+            value1 = minimum;
+
+            bc4_palette (value0, value1, palette);
+
+            error = bc4_indices (block, channel, palette, indices);
+
+            // Modo de seis valores entre los extremos interiores, que gana cuando el bloque
+            // mezcla 0 o 255 con un rango estrecho:
+
+            if (error > 0 && (minimum == 0 || maximum == 255))
+            {
+                if (inner_minimum > inner_maximum) inner_minimum = inner_maximum = minimum == 0 ? maximum : minimum;
+
+                uint64_t inner_indices;
+
+                bc4_palette (inner_minimum, inner_maximum, palette);
+
+                if (bc4_indices (block, channel, palette, inner_indices) < error)
+                {
+                    value0  = inner_minimum;
+                    value1  = inner_maximum;
+                    indices = inner_indices;
+                }
+            }
+        }
+
+        output[0] = uint8_t(value0);
+        output[1] = uint8_t(value1);
+
+        for (unsigned k = 0; k < 6; ++k)
+        {
+            output[2 + k] = uint8_t(indices >> (8 * k));
+        }
+    }
+
+    void Block_Compression::decode_bc1_block (const uint8_t * input, Rgba8888 * block, bool always_four_colors)
+    {
+        const uint16_t color0  = uint16_t(input[0] | input[1] << 8);
+        const uint16_t color1  = uint16_t(input[2] | input[3] << 8);
+        const uint32_t indices = uint32_t(input[4]) | uint32_t(input[5]) << 8 | uint32_t(input[6]) << 16 | uint32_t(input[7]) << 24;
+        const bool     four    = always_four_colors || color0 > color1;
+
+        int palette[4][3];
+
+        bc1_palette (color0, color1, four, palette);
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            const unsigned index = indices >> (2 * i) & 3;
+
+            block[i].components[Rgba8888::RED  ] = uint8_t(palette[index][0]);
+            block[i].components[Rgba8888::GREEN] = uint8_t(palette[index][1]);
+            block[i].components[Rgba8888::BLUE ] = uint8_t(palette[index][2]);
+
+            if (!always_four_colors)
+            {
+                block[i].components[Rgba8888::ALPHA] = !four && index == 3 ? 0 : 255;
+            }
+        }
+    }
+
+    void Block_Compression::decode_bc4_block (const uint8_t * input, unsigned channel, Rgba8888 * block)
+    {
+        uint64_t indices = 0;
+
+        for (unsigned k = 0; k < 6; ++k)
+        {
+            indices |= uint64_t(input[2 + k]) << (8 * k);
+        }
+
+        int palette[8];
+
+        bc4_palette (input[0], input[1], palette);
+
+        for (unsigned i = 0; i < 16; ++i)
+        {
+            block[i].components[channel] = uint8_t(palette[indices >> (3 * i) & 7]);
+        }
+    }
+
+}
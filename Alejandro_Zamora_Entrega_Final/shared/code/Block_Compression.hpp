@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Color.hpp"
+
+namespace udit
+{
+
+    class Thread_Pool;
+
+    // Compresor y descompresor por bloques de 4x4 texels de los formatos BCn que la GPU
+    // muestrea directamente:
+    //
+    //   BC1  RGB en 8 bytes por bloque (4 bits por texel): dos colores 565 y 2 bits por texel.
+    //   BC3  RGBA en 16 bytes: un bloque BC4 para el alfa seguido de un bloque BC1 para el color.
+    //   BC4  Un canal (rojo) en 8 bytes: dos valores de 8 bits y 3 bits por texel.
+    //   BC5  Dos canales (rojo y verde) en 16 bytes: dos bloques BC4.
+    //
+    // No usa OpenGL, así que sirve para cocinar texturas sin GPU y desde hilos de trabajo.
+
+    class Block_Compression
+    {
+    public:
+
+        enum Format
+        {
+            BC1,
+            BC3,
+            BC4,
+            BC5
+        };
+
+    public:
+
+        static const char * get_name (Format format);
+
+        static size_t get_block_bytes (Format format)
+        {
+            return format == BC1 || format == BC4 ? 8 : 16;
+        }
+
+        static size_t get_compressed_size (Format format, unsigned width, unsigned height)
+        {
+            return size_t((width + 3) / 4) * size_t((height + 3) / 4) * get_block_bytes (format);
+        }
+
+        // blocks debe tener espacio para get_compressed_size() bytes. Los bloques del borde de
+        // una imagen cuyo tamaño no es múltiplo de 4 repiten la última fila o columna. Si se
+        // pasa un pool, las filas de bloques se reparten entre sus hilos:
+
+        static void encode
+        (
+            Format           format,
+            const Rgba8888 * pixels,
+            unsigned         width,
+            unsigned         height,
+            uint8_t        * blocks,
+            Thread_Pool    * workers = nullptr
+        );
+
+        // Los canales que el formato no guarda se devuelven como los muestrearía la GPU (0 para
+        // el color y 255 para el alfa):
+
+        static void decode
+        (
+            Format          format,
+            const uint8_t * blocks,
+            unsigned        width,
+            unsigned        height,
+            Rgba8888      * pixels
+        );
+
+        // PSNR en dB de los canales que guarda el formato. Es infinito si no hay diferencias:
+
+        static double psnr (Format format, const Rgba8888 * original, const Rgba8888 * decoded, size_t count);
+
+    private:
+
+        static void encode_bc1_block (const Rgba8888 * block, uint8_t * output);
+        static void encode_bc4_block (const Rgba8888 * block, unsigned channel, uint8_t * output);
+
+        static void decode_bc1_block (const uint8_t * input, Rgba8888 * block, bool always_four_colors);
+        static void decode_bc4_block (const uint8_t * input, unsigned channel, Rgba8888 * block);
+
+    };
+
+}
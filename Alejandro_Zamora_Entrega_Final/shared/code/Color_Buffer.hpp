@@ -1,36 +1,129 @@
-
 // Este cdigo es de dominio pblico
 // angel.rodriguez@udit.es
 
 #pragma once
 
-#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
 
 namespace udit
 {
 
+    // Imagen de width x height colores. Puede ser duea de sus pxeles (reservados por ella o
+    // adoptados de otra biblioteca junto con la funcin que los libera) o ser una vista que no
+    // libera nada, por ejemplo de un rectngulo de otra imagen. Las filas estn separadas por
+    // pitch colores, que slo coincide con width si la imagen es contigua, as que el offset de
+    // get() y set() es y * get_pitch () + x.
+    //
+    // Copiar una imagen propia duplica los pxeles (la copia es contigua); copiar una vista
+    // slo copia la vista, que no debe sobrevivir a la imagen de la que sale.
+
     template< typename COLOR >
     class Color_Buffer
     {
     public:
 
-        using Color = COLOR;
+        using Color   = COLOR;
+        using Deleter = std::function< void (Color *) >;
 
     private:
 
         unsigned width;
         unsigned height;
+        unsigned pitch;
 
-        std::vector< Color > buffer;
+        std::unique_ptr< Color, Deleter > storage;          // nullptr en las vistas
+        Color                           * pixels;
 
     public:
 
         Color_Buffer(unsigned width, unsigned height) 
         :
-            width (width ), 
-            height(height),
-            buffer(width * height)
+            width  (width ), 
+            height (height),
+            pitch  (width ),
+            storage(new Color[size_t(width) * height](), [] (Color * colors) { delete [] colors; }),
+            pixels (storage.get ())
+        {
+        }
+
+        // Adopta pixels, que se liberarn llamando a deleter (p. ej. la memoria que devuelve
+        // un decodificador de imgenes):
+
+        Color_Buffer(Color * pixels, unsigned width, unsigned height, unsigned pitch, Deleter deleter)
+        :
+            width  (width ),
+            height (height),
+            pitch  (pitch ),
+            storage(pixels, std::move (deleter)),
+            pixels (pixels)
+        {
+        }
+
+        Color_Buffer(const Color_Buffer & other)
+        :
+            width  (other.width ),
+            height (other.height),
+            pitch  (other.pitch ),
+            pixels (other.pixels)
+        {
+            if (other.owns_pixels ()) *this = other.clone ();
+        }
+
+        Color_Buffer(Color_Buffer && other) noexcept
+        :
+            width  (other.width ),
+            height (other.height),
+            pitch  (other.pitch ),
+            storage(std::move (other.storage)),
+            pixels (other.pixels)
+        {
+            other.width  = other.height = other.pitch = 0;
+            other.pixels = nullptr;
+        }
+
+        Color_Buffer & operator = (Color_Buffer other) noexcept
+        {
+            std::swap (width,   other.width  );
+            std::swap (height,  other.height );
+            std::swap (pitch,   other.pitch  );
+            std::swap (storage, other.storage);
+            std::swap (pixels,  other.pixels );
+
+            return *this;
+        }
+
+    public:
+
+        // Vista de pixels sin hacerse cargo de ellos:
+
+        static Color_Buffer view_of (Color * pixels, unsigned width, unsigned height, unsigned pitch)
+        {
+            return Color_Buffer(pixels, width, height, pitch, nullptr, 0);
+        }
+
+        // Vista del rectngulo de width x height que empieza en (x, y):
+
+        Color_Buffer view (unsigned x, unsigned y, unsigned width, unsigned height)
         {
+            return view_of (pixels + size_t(y) * pitch + x, width, height, pitch);
+        }
+
+        // Copia contigua y propia de los pxeles, sea esto una vista o no:
+
+        Color_Buffer clone () const
+        {
+            Color_Buffer copy(width, height);
+
+            for (unsigned y = 0; y < height; ++y)
+            {
+                std::copy_n (row (y), width, copy.row (y));
+            }
+
+            return copy;
         }
 
         unsigned get_width () const
@@ -43,29 +136,66 @@ namespace udit
             return height;
         }
 
+        unsigned get_pitch () const
+        {
+            return pitch;
+        }
+
+        bool is_contiguous () const
+        {
+            return pitch == width;
+        }
+
+        bool owns_pixels () const
+        {
+            return bool(storage);
+        }
+
         Color * colors ()
         {
-            return buffer.data ();
+            return pixels;
         }
 
         const Color * colors () const
         {
-            return buffer.data ();
+            return pixels;
+        }
+
+        Color * row (unsigned y)
+        {
+            return pixels + size_t(y) * pitch;
+        }
+
+        const Color * row (unsigned y) const
+        {
+            return pixels + size_t(y) * pitch;
+        }
+
+        Color & get (size_t offset)
+        {
+            return pixels[offset];
         }
 
-        Color & get (unsigned offset)
+        const Color & get (size_t offset) const
         {
-            return buffer[offset];
+            return pixels[offset];
         }
 
-        const Color & get (unsigned offset) const
+        void set (size_t offset, const Color & color)
         {
-            return buffer[offset];
+            pixels[offset] = color;
         }
 
-        void set (unsigned offset, const Color & color)
+    private:
+
+        Color_Buffer(Color * pixels, unsigned width, unsigned height, unsigned pitch, std::nullptr_t, int)
+        :
+            width  (width ),
+            height (height),
+            pitch  (pitch ),
+            storage(nullptr, Deleter()),
+            pixels (pixels)
         {
-            buffer[offset] = color;
         }
 
     };
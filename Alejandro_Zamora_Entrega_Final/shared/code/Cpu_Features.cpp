@@ -0,0 +1,95 @@
+#include "Cpu_Features.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+    #define CPU_FEATURES_X86
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        Cpu_Features detect ()
+        {
+            #ifdef CPU_FEATURES_X86
+
+                unsigned leaf1[4] = { 0, 0, 0, 0 };
+                unsigned leaf7[4] = { 0, 0, 0, 0 };
+                unsigned maximum  = 0;
+                uint64_t xcr0     = 0;
+
+                #if defined(_MSC_VER) && !defined(__clang__)
+
+                    int registers[4];
+
+                    __cpuid (registers, 0);
+                    maximum = unsigned(registers[0]);
+
+                    __cpuidex (registers, 1, 0);
+                    std::memcpy (leaf1, registers, sizeof(leaf1));
+
+                    if (maximum >= 7)
+                    {
+                        __cpuidex (registers, 7, 0);
+                        std::memcpy (leaf7, registers, sizeof(leaf7));
+                    }
+
+                    if (leaf1[2] & (1u << 27)) xcr0 = _xgetbv (0);
+
+                #else
+
+                    maximum = __get_cpuid_max (0, nullptr);
+
+                    __cpuid_count (1, 0, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+
+                    if (maximum >= 7) __cpuid_count (7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+
+                    if (leaf1[2] & (1u << 27))
+                    {
+                        unsigned low, high;
+
+                        __asm__ ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+
+                        xcr0 = (uint64_t(high) << 32) | low;
+                    }
+
+                #endif
+
+                const bool ssse3 = (leaf1[2] & (1u <<  9)) != 0;
+                const bool fma   = (leaf1[2] & (1u << 12)) != 0;
+                const bool sse41 = (leaf1[2] & (1u << 19)) != 0;
+                const bool avx   = (leaf1[2] & (1u << 28)) != 0;
+                const bool f16c  = (leaf1[2] & (1u << 29)) != 0;
+                const bool avx2  = (leaf7[1] & (1u <<  5)) != 0;
+                const bool ymm   = (xcr0 & 6) == 6;                 // El sistema guarda los registros YMM
+
+                const bool vex   = avx && ymm;                      // FMA y F16C también usan registros YMM
+
+                return Cpu_Features{ ssse3 && sse41, vex && avx2, vex && fma, vex && f16c };
+
+            #else
+
+                return Cpu_Features{ false, false, false, false };
+
+            #endif
+        }
+
+    }
+
+    const Cpu_Features & Cpu_Features::get ()
+    {
+        static const Cpu_Features features = detect ();
+
+        return features;
+    }
+
+}
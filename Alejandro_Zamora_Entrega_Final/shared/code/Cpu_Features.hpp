@@ -0,0 +1,20 @@
+#pragma once
+
+namespace udit
+{
+
+    // Juegos de instrucciones de x86 que tiene la CPU y que el sistema operativo permite usar.
+    // Se detectan una sola vez; en otras arquitecturas todos valen false. Los módulos con
+    // kernels SIMD los compilan siempre con el atributo target y eligen cuál usar con esto:
+
+    struct Cpu_Features
+    {
+        bool sse41;                     // Incluye SSSE3
+        bool avx2;                      // Incluye AVX y registros YMM guardados por el sistema
+        bool fma;
+        bool f16c;
+
+        static const Cpu_Features & get ();
+    };
+
+}
@@ -0,0 +1,395 @@
+#include "Image_File.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "Mapped_File.hpp"
+#include "Pixel_Conversion.hpp"
+
+namespace udit
+{
+
+    namespace
+    {
+
+        constexpr size_t   qoi_header_size = 14;
+        constexpr size_t   qoi_padding     = 8;
+        constexpr size_t   raw_header_size = 24;
+        constexpr uint64_t max_pixels      = 400000000;        // Mismo límite que la implementación de referencia
+
+        constexpr uint8_t  QOI_OP_INDEX = 0x00;
+        constexpr uint8_t  QOI_OP_DIFF  = 0x40;
+        constexpr uint8_t  QOI_OP_LUMA  = 0x80;
+        constexpr uint8_t  QOI_OP_RUN   = 0xC0;
+        constexpr uint8_t  QOI_OP_RGB   = 0xFE;
+        constexpr uint8_t  QOI_OP_RGBA  = 0xFF;
+        constexpr uint8_t  QOI_MASK     = 0xC0;
+
+        const uint8_t qoi_end_marker[qoi_padding] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+        struct Pixel
+        {
+            uint8_t r, g, b, a;
+
+            bool operator == (const Pixel & other) const
+            {
+                return r == other.r && g == other.g && b == other.b && a == other.a;
+            }
+        };
+
+        inline unsigned qoi_hash (const Pixel & pixel)
+        {
+            return (pixel.r * 3u + pixel.g * 5u + pixel.b * 7u + pixel.a * 11u) & 63u;
+        }
+
+        inline uint32_t read_u32_be (const uint8_t * bytes)
+        {
+            return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+        }
+
+        inline void write_u32_be (std::vector< uint8_t > & bytes, uint32_t value)
+        {
+            bytes.push_back (uint8_t(value >> 24));
+            bytes.push_back (uint8_t(value >> 16));
+            bytes.push_back (uint8_t(value >>  8));
+            bytes.push_back (uint8_t(value      ));
+        }
+
+        inline uint32_t read_u32 (const uint8_t * bytes)
+        {
+            uint32_t value;
+            std::memcpy (&value, bytes, sizeof(value));
+            return value;
+        }
+
+        inline void write_u32 (std::vector< uint8_t > & bytes, uint32_t value)
+        {
+            const size_t offset = bytes.size ();
+            bytes.resize (offset + sizeof(value));
+            std::memcpy (bytes.data () + offset, &value, sizeof(value));
+        }
+
+        bool has_extension (const std::string & path, const char * extension)
+        {
+            const size_t length = std::strlen (extension);
+
+            if (path.size () < length) return false;
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                char c = path[path.size () - length + i];
+
+                if (c >= 'A' && c <= 'Z') c = char(c - 'A' + 'a');
+
+                if (c != extension[i]) return false;
+            }
+
+            return true;
+        }
+
+        // Convierte en el sitio píxeles RGBA a channels canales. Cada píxel de destino queda
+        // antes que el de origen, así que Pixel_Conversion lo puede hacer en el sitio:
+
+        void convert_rgba (uint8_t * pixels, size_t pixel_count, unsigned channels)
+        {
+            if (channels == 1)
+            {
+                Pixel_Conversion::rgba_to_luminance (pixels, pixels, pixel_count);
+            }
+            else
+            if (channels == 3)
+            {
+                Pixel_Conversion::rgba_to_rgb (pixels, pixels, pixel_count);
+            }
+        }
+
+    }
+
+    bool Image_File::is_qoi (const std::string & path)
+    {
+        return has_extension (path, ".qoi");
+    }
+
+    bool Image_File::is_raw (const std::string & path)
+    {
+        return has_extension (path, ".raw");
+    }
+
+    uint8_t * Image_File::load (const std::string & path, unsigned & width, unsigned & height, unsigned channels)
+    {
+        Mapped_File file;
+
+        if (!file.open (path)) return nullptr;
+
+        return is_qoi (path)
+             ? decode_qoi (file.data (), file.size (), width, height, channels)
+             : decode_raw (file.data (), file.size (), width, height, channels);
+    }
+
+    uint8_t * Image_File::decode_qoi (const uint8_t * bytes, size_t size, unsigned & width, unsigned & height, unsigned channels)
+    {
+        if (channels != 1 && channels != 3 && channels != 4) return nullptr;
+
+        if (size < qoi_header_size + qoi_padding || std::memcmp (bytes, "qoif", 4) != 0) return nullptr;
+
+        width  = read_u32_be (bytes + 4);
+        height = read_u32_be (bytes + 8);
+
+        if (width == 0 || height == 0 || uint64_t(width) * height > max_pixels) return nullptr;
+
+        const size_t pixel_count = size_t(width) * height;
+
+        uint8_t * pixels = new uint8_t[pixel_count * 4];
+
+        // Los códigos de más de un byte pueden leer del relleno final, pero nunca pasar de él:
+
+        const size_t end      = size - qoi_padding;
+        size_t       position = qoi_header_size;
+        Pixel        pixel    { 0, 0, 0, 255 };
+        Pixel        index[64];
+
+        std::memset (index, 0, sizeof(index));
+
+        Pixel * target = reinterpret_cast< Pixel * >(pixels);
+        Pixel * last   = target + pixel_count;
+
+        while (target < last)
+        {
+            // Las repeticiones se escriben de una vez. Si el archivo está truncado se repite el
+            // último color hasta completar la imagen, como hace la implementación de referencia:
+
+            size_t count = size_t(last - target);
+
+            if (position < end)
+            {
+                const uint8_t op = bytes[position++];
+
+                count = 1;
+
+                if (op == QOI_OP_RGB)
+                {
+                    pixel.r = bytes[position    ];
+                    pixel.g = bytes[position + 1];
+                    pixel.b = bytes[position + 2];
+
+                    position += 3;
+                }
+                else if (op == QOI_OP_RGBA)
+                {
+                    pixel.r = bytes[position    ];
+                    pixel.g = bytes[position + 1];
+                    pixel.b = bytes[position + 2];
+                    pixel.a = bytes[position + 3];
+
+                    position += 4;
+                }
+                else if ((op & QOI_MASK) == QOI_OP_INDEX)
+                {
+                    pixel = index[op];
+                }
+                else if ((op & QOI_MASK) == QOI_OP_DIFF)
+                {
+                    pixel.r = uint8_t(pixel.r + ((op >> 4) & 3) - 2);
+                    pixel.g = uint8_t(pixel.g + ((op >> 2) & 3) - 2);
+                    pixel.b = uint8_t(pixel.b + ( op       & 3) - 2);
+                }
+                else if ((op & QOI_MASK) == QOI_OP_LUMA)
+                {
+                    const uint8_t second = bytes[position++];
+                    const int     dg     = (op & 0x3F) - 32;
+
+                    pixel.r = uint8_t(pixel.r + dg - 8 + ((second >> 4) & 0x0F));
+                    pixel.g = uint8_t(pixel.g + dg);
+                    pixel.b = uint8_t(pixel.b + dg - 8 + ( second       & 0x0F));
+                }
+                else
+                {
+                    count = std::min (size_t(op & 0x3F) + 1, size_t(last - target));
+                }
+
+                index[qoi_hash (pixel)] = pixel;
+            }
+
+            if (count == 1)
+                *target++ = pixel;
+            else
+                target = std::fill_n (target, count, pixel);
+        }
+
+        convert_rgba (pixels, pixel_count, channels);
+
+        return pixels;
+    }
+
+    uint8_t * Image_File::decode_raw (const uint8_t * bytes, size_t size, unsigned & width, unsigned & height, unsigned channels)
+    {
+        if (channels != 1 && channels != 3 && channels != 4) return nullptr;
+
+        if (size < raw_header_size || read_u32 (bytes) != raw_magic || read_u32 (bytes + 4) != raw_version || read_u32 (bytes + 16) != 4) return nullptr;
+
+        width  = read_u32 (bytes +  8);
+        height = read_u32 (bytes + 12);
+
+        const uint64_t pixel_count = uint64_t(width) * height;
+
+        if (width == 0 || height == 0 || pixel_count > max_pixels || size - raw_header_size < pixel_count * 4) return nullptr;
+
+        // Los píxeles se guardan ya en RGBA, así que leerlos es una sola copia:
+
+        uint8_t * pixels = new uint8_t[size_t(pixel_count) * 4];
+
+        std::memcpy (pixels, bytes + raw_header_size, size_t(pixel_count) * 4);
+
+        convert_rgba (pixels, size_t(pixel_count), channels);
+
+        return pixels;
+    }
+
+    void Image_File::free_pixels (uint8_t * pixels)
+    {
+        delete [] pixels;
+    }
+
+    void Image_File::encode_qoi (const uint8_t * rgba, unsigned width, unsigned height, size_t pitch, std::vector< uint8_t > & bytes)
+    {
+        bool opaque = true;
+
+        for (unsigned y = 0; y < height && opaque; ++y)
+        {
+            for (unsigned x = 0; x < width; ++x)
+            {
+                if (rgba[(y * pitch + x) * 4 + 3] != 255)
+                {
+                    opaque = false;
+                    break;
+                }
+            }
+        }
+
+        bytes.clear ();
+        bytes.reserve (qoi_header_size + size_t(width) * height * 5 / 2 + qoi_padding);
+        bytes.insert  (bytes.end (), { 'q', 'o', 'i', 'f' });
+
+        write_u32_be (bytes, width );
+        write_u32_be (bytes, height);
+
+        bytes.push_back (opaque ? 3 : 4);           // Canales, sólo informativo
+        bytes.push_back (0);                        // sRGB con alfa lineal
+
+        Pixel    previous { 0, 0, 0, 255 };
+        Pixel    index[64];
+        unsigned run = 0;
+
+        std::memset (index, 0, sizeof(index));
+
+        for (unsigned y = 0; y < height; ++y)
+        {
+            for (unsigned x = 0; x < width; ++x)
+            {
+                Pixel pixel;
+
+                std::memcpy (&pixel, rgba + (y * pitch + x) * 4, 4);
+
+                const bool last = y + 1 == height && x + 1 == width;
+
+                if (pixel == previous)
+                {
+                    if (++run == 62 || last)
+                    {
+                        bytes.push_back (uint8_t(QOI_OP_RUN | (run - 1)));
+                        run = 0;
+                    }
+
+                    continue;
+                }
+
+                if (run > 0)
+                {
+                    bytes.push_back (uint8_t(QOI_OP_RUN | (run - 1)));
+                    run = 0;
+                }
+
+                const unsigned hash = qoi_hash (pixel);
+
+                if (index[hash] == pixel)
+                {
+                    bytes.push_back (uint8_t(QOI_OP_INDEX | hash));
+                }
+                else
+                {
+                    index[hash] = pixel;
+
+                    if (pixel.a == previous.a)
+                    {
+                        const int dr = int8_t(pixel.r - previous.r);
+                        const int dg = int8_t(pixel.g - previous.g);
+                        const int db = int8_t(pixel.b - previous.b);
+
+                        const int dr_dg = dr - dg;
+                        const int db_dg = db - dg;
+
+                        if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                        {
+                            bytes.push_back (uint8_t(QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                        }
+                        else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7)
+                        {
+                            bytes.push_back (uint8_t(QOI_OP_LUMA | (dg + 32)));
+                            bytes.push_back (uint8_t((dr_dg + 8) << 4 | (db_dg + 8)));
+                        }
+                        else
+                        {
+                            bytes.insert (bytes.end (), { QOI_OP_RGB, pixel.r, pixel.g, pixel.b });
+                        }
+                    }
+                    else
+                    {
+                        bytes.insert (bytes.end (), { QOI_OP_RGBA, pixel.r, pixel.g, pixel.b, pixel.a });
+                    }
+                }
+
+                previous = pixel;
+            }
+        }
+
+        bytes.insert (bytes.end (), qoi_end_marker, qoi_end_marker + qoi_padding);
+    }
+
+    void Image_File::encode_raw (const uint8_t * rgba, unsigned width, unsigned height, size_t pitch, std::vector< uint8_t > & bytes)
+    {
+        bytes.clear ();
+        bytes.reserve (raw_header_size + size_t(width) * height * 4);
+
+        write_u32 (bytes, raw_magic  );
+        write_u32 (bytes, raw_version);
+        write_u32 (bytes, width      );
+        write_u32 (bytes, height     );
+        write_u32 (bytes, 4          );             // Canales
+        write_u32 (bytes, 0          );
+
+        for (unsigned y = 0; y < height; ++y)
+        {
+            bytes.insert (bytes.end (), rgba + y * pitch * 4, rgba + (y * pitch + width) * 4);
+        }
+    }
+
+    bool Image_File::save (const std::string & path, const uint8_t * rgba, unsigned width, unsigned height, size_t pitch)
+    {
+        if (!is_fast (path)) return false;
+
+        std::vector< uint8_t > bytes;
+
+        if (is_qoi (path))
+            encode_qoi (rgba, width, height, pitch, bytes);
+        else
+            encode_raw (rgba, width, height, pitch, bytes);
+
+        std::ofstream file(path, std::ios::binary);
+
+        file.write (reinterpret_cast< const char * >(bytes.data ()), std::streamsize(bytes.size ()));
+
+        return bool(file);
+    }
+
+}
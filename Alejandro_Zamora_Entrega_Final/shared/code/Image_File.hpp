@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace udit
+{
+
+    // Formatos de imagen de decodificación rápida para los recursos cocinados, como alternativa
+    // a los PNG que lee SOIL2 (que pasan casi todo el tiempo en inflate):
+    //
+    //  - QOI (https://qoiformat.org): compresión sin pérdidas de un solo paso sin entropía. Se
+    //    decodifica a cientos de MB/s y ocupa algo más que un PNG.
+    //  - RAW: cabecera de 24 bytes y los píxeles tal cual. Leerlo es una copia de memoria.
+    //
+    // El formato se elige por la extensión (.qoi o .raw). Las funciones no usan OpenGL, así
+    // que se pueden llamar desde hilos de trabajo.
+
+    class Image_File
+    {
+    public:
+
+        static constexpr uint32_t raw_magic   = 0x57415255;        // "URAW"
+        static constexpr uint32_t raw_version = 1;
+
+    public:
+
+        static bool is_qoi  (const std::string & path);
+        static bool is_raw  (const std::string & path);
+
+        static bool is_fast (const std::string & path)
+        {
+            return is_qoi (path) || is_raw (path);
+        }
+
+        // Devuelve los píxeles con channels canales (1 = luminancia, 3 = RGB o 4 = RGBA) o
+        // nullptr si no se puede leer. Se liberan con free_pixels:
+
+        static uint8_t * load       (const std::string & path, unsigned & width, unsigned & height, unsigned channels);
+        static uint8_t * decode_qoi (const uint8_t * bytes, size_t size, unsigned & width, unsigned & height, unsigned channels);
+        static uint8_t * decode_raw (const uint8_t * bytes, size_t size, unsigned & width, unsigned & height, unsigned channels);
+        static void      free_pixels (uint8_t * pixels);
+
+        // Codifican una imagen RGBA cuyas filas empiezan cada pitch píxeles:
+
+        static void encode_qoi (const uint8_t * rgba, unsigned width, unsigned height, size_t pitch, std::vector< uint8_t > & bytes);
+        static void encode_raw (const uint8_t * rgba, unsigned width, unsigned height, size_t pitch, std::vector< uint8_t > & bytes);
+
+        // Elige el formato por la extensión de path:
+
+        static bool save (const std::string & path, const uint8_t * rgba, unsigned width, unsigned height, size_t pitch);
+
+    };
+
+}
@@ -0,0 +1,267 @@
+#include "Json.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace udit
+{
+
+    class Json::Parser
+    {
+    private:
+
+        const char * current;
+        const char * end;
+        unsigned     depth;
+
+        static constexpr unsigned maximum_depth = 128;
+
+    public:
+
+        Parser(const char * begin, const char * end) : current(begin), end(end), depth(0)
+        {
+        }
+
+        bool parse_document (Json & root)
+        {
+            if (!parse_value (root)) return false;
+
+            skip_whitespace ();
+
+            return current == end;
+        }
+
+    private:
+
+        void skip_whitespace ()
+        {
+            while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r')) ++current;
+        }
+
+        bool match (const char * literal)
+        {
+            size_t length = std::strlen (literal);
+
+            if (size_t(end - current) < length || std::memcmp (current, literal, length) != 0) return false;
+
+            current += length;
+
+            return true;
+        }
+
+        bool parse_value (Json & value)
+        {
+            skip_whitespace ();
+
+            if (current == end) return false;
+
+            switch (*current)
+            {
+                case '{': return parse_object (value);
+                case '[': return parse_array  (value);
+                case '"': value.type = STRING; return parse_string (value.text);
+                case 't': value.type = BOOLEAN; value.boolean = true;  return match ("true" );
+                case 'f': value.type = BOOLEAN; value.boolean = false; return match ("false");
+                case 'n': value.type = NULL_VALUE;                     return match ("null" );
+                default:  return parse_number (value);
+            }
+        }
+
+        bool parse_number (Json & value)
+        {
+            // strtod necesita una cadena terminada en nulo, así que se copia el número (que
+            // siempre es corto) a un búfer local:
+
+            char         buffer[64];
+            size_t       length = 0;
+            const char * start  = current;
+
+            while (current < end && length < sizeof(buffer) - 1 && std::strchr ("+-0123456789.eE", *current))
+            {
+                buffer[length++] = *current++;
+            }
+
+            buffer[length] = 0;
+
+            char * number_end;
+
+            value.type   = NUMBER;
+            value.number = std::strtod (buffer, &number_end);
+
+            return length > 0 && number_end == buffer + length && current != start;
+        }
+
+        bool parse_string (std::string & text)
+        {
+            ++current;                              // Comilla inicial
+
+            text.clear ();
+
+            while (current < end && *current != '"')
+            {
+                char character = *current++;
+
+                if (character != '\\')
+                {
+                    text += character;
+                    continue;
+                }
+
+                if (current == end) return false;
+
+                switch (character = *current++)
+                {
+                    case '"': case '\\': case '/': text += character; break;
+                    case 'b': text += '\b'; break;
+                    case 'f': text += '\f'; break;
+                    case 'n': text += '\n'; break;
+                    case 'r': text += '\r'; break;
+                    case 't': text += '\t'; break;
+                    case 'u':
+                    {
+                        if (end - current < 4) return false;
+
+                        unsigned code = unsigned(std::strtoul (std::string(current, 4).c_str (), nullptr, 16));
+                        current += 4;
+
+                        // Se codifica en UTF-8 (los pares sustitutos no se combinan):
+
+                        if (code < 0x80)
+                        {
+                            text += char(code);
+                        }
+                        else
+                        if (code < 0x800)
+                        {
+                            text += char(0xC0 | (code >> 6));
+                            text += char(0x80 | (code & 0x3F));
+                        }
+                        else
+                        {
+                            text += char(0xE0 | (code >> 12));
+                            text += char(0x80 | ((code >> 6) & 0x3F));
+                            text += char(0x80 | (code & 0x3F));
+                        }
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+
+            if (current == end) return false;
+
+            ++current;                              // Comilla final
+
+            return true;
+        }
+
+        bool parse_array (Json & value)
+        {
+            if (++depth > maximum_depth) return false;
+
+            ++current;
+
+            value.type = ARRAY;
+
+            skip_whitespace ();
+
+            if (current < end && *current == ']')
+            {
+                ++current;
+                --depth;
+                return true;
+            }
+
+            for (;;)
+            {
+                value.elements.emplace_back ();
+
+                if (!parse_value (value.elements.back ())) return false;
+
+                skip_whitespace ();
+
+                if (current == end) return false;
+
+                if (*current == ',') { ++current; continue; }
+                if (*current == ']') { ++current; break;    }
+
+                return false;
+            }
+
+            --depth;
+
+            return true;
+        }
+
+        bool parse_object (Json & value)
+        {
+            if (++depth > maximum_depth) return false;
+
+            ++current;
+
+            value.type = OBJECT;
+
+            skip_whitespace ();
+
+            if (current < end && *current == '}')
+            {
+                ++current;
+                --depth;
+                return true;
+            }
+
+            for (;;)
+            {
+                skip_whitespace ();
+
+                if (current == end || *current != '"') return false;
+
+                value.keys.emplace_back ();
+
+                if (!parse_string (value.keys.back ())) return false;
+
+                skip_whitespace ();
+
+                if (current == end || *current++ != ':') return false;
+
+                value.elements.emplace_back ();
+
+                if (!parse_value (value.elements.back ())) return false;
+
+                skip_whitespace ();
+
+                if (current == end) return false;
+
+                if (*current == ',') { ++current; continue; }
+                if (*current == '}') { ++current; break;    }
+
+                return false;
+            }
+
+            --depth;
+
+            return true;
+        }
+
+    };
+
+    bool Json::parse (const char * begin, const char * end, Json & root)
+    {
+        root = Json();
+
+        return Parser(begin, end).parse_document (root);
+    }
+
+    const Json * Json::find (const char * key) const
+    {
+        if (type != OBJECT) return nullptr;
+
+        for (size_t i = 0; i < keys.size (); ++i)
+        {
+            if (keys[i] == key) return &elements[i];
+        }
+
+        return nullptr;
+    }
+
+}
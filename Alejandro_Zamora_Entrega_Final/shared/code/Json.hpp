@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace udit
+{
+
+    // Árbol JSON mínimo de sólo lectura, suficiente para leer descripciones de recursos como
+    // la parte JSON de los archivos glTF.
+
+    class Json
+    {
+    public:
+
+        enum Type
+        {
+            NULL_VALUE,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+    private:
+
+        Type                      type;
+        bool                      boolean;
+        double                    number;
+        std::string               text;
+        std::vector< Json >       elements;             // Elementos de un array o valores de un objeto
+        std::vector< std::string > keys;                // Claves de un objeto (en paralelo con elements)
+
+    public:
+
+        Json() : type(NULL_VALUE), boolean(false), number(0.0)
+        {
+        }
+
+        static bool parse (const char * begin, const char * end, Json & root);
+
+    public:
+
+        Type get_type () const { return type; }
+
+        bool is_null   () const { return type == NULL_VALUE; }
+        bool is_number () const { return type == NUMBER; }
+        bool is_string () const { return type == STRING; }
+        bool is_array  () const { return type == ARRAY;  }
+        bool is_object () const { return type == OBJECT; }
+
+        double              as_number  () const { return number;  }
+        bool                as_boolean () const { return boolean; }
+        const std::string & as_string  () const { return text;    }
+
+        size_t size () const
+        {
+            return elements.size ();
+        }
+
+        const Json & operator [] (size_t index) const
+        {
+            return elements[index];
+        }
+
+        // Devuelve nullptr si no es un objeto o no tiene la clave:
+
+        const Json * find (const char * key) const;
+
+        double get_number (const char * key, double default_value) const
+        {
+            const Json * value = find (key);
+            return value && value->is_number () ? value->number : default_value;
+        }
+
+    private:
+
+        class Parser;
+
+    };
+
+}
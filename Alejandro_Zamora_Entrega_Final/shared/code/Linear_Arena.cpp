@@ -0,0 +1,78 @@
+#include "Linear_Arena.hpp"
+
+#include <algorithm>
+
+namespace udit
+{
+
+    Linear_Arena::Linear_Arena(size_t capacity) : used(0), allocation_count(0)
+    {
+        if (capacity > 0) add_block (capacity);
+    }
+
+    void * Linear_Arena::allocate_bytes (size_t size, size_t alignment)
+    {
+        if (!blocks.empty ())
+        {
+            Block   & block   = blocks.back ();
+            uintptr_t base    = reinterpret_cast< uintptr_t >(block.memory.get ());
+            size_t    aligned = size_t(((base + used + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+
+            if (aligned + size <= block.size)
+            {
+                used = aligned + size;
+                return block.memory.get () + aligned;
+            }
+        }
+
+        // No cabe en el bloque actual. El nuevo bloque al menos dobla al anterior para que el
+        // número de reservas crezca de forma logarítmica:
+
+        add_block (std::max (size + alignment, blocks.empty () ? size_t(0) : blocks.back ().size * 2));
+
+        return allocate_bytes (size, alignment);
+    }
+
+    void Linear_Arena::reserve (size_t capacity)
+    {
+        if (get_capacity () < capacity)
+        {
+            blocks.clear ();
+            add_block (capacity);
+        }
+
+        used = 0;
+    }
+
+    void Linear_Arena::reset ()
+    {
+        if (blocks.size () > 1)
+        {
+            size_t capacity = get_capacity ();
+
+            blocks.clear ();
+            add_block (capacity);
+        }
+
+        used = 0;
+    }
+
+    size_t Linear_Arena::get_capacity () const
+    {
+        size_t capacity = 0;
+
+        for (const Block & block : blocks) capacity += block.size;
+
+        return capacity;
+    }
+
+    void Linear_Arena::add_block (size_t size)
+    {
+        blocks.push_back ({ std::unique_ptr< uint8_t[] >(new uint8_t[size]), size });
+
+        used = 0;
+
+        ++allocation_count;
+    }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace udit
+{
+
+    // Reserva lineal de memoria para datos temporales de una carga. Las peticiones sólo
+    // avanzan un puntero dentro de un bloque reservado de antemano; si el bloque se agota se
+    // encadena otro más grande. reset() libera todo de golpe y, si hizo falta más de un bloque,
+    // los sustituye por uno solo del tamaño total para que la siguiente carga no reserve más.
+    //
+    // Sólo admite tipos que no necesitan destructor, ya que la memoria nunca se destruye
+    // elemento a elemento.
+
+    class Linear_Arena
+    {
+    private:
+
+        struct Block
+        {
+            std::unique_ptr< uint8_t[] > memory;
+            size_t                       size;
+        };
+
+        std::vector< Block > blocks;
+        size_t               used;                  // Bytes usados del último bloque
+        size_t               allocation_count;      // Reservas hechas en el heap
+
+    public:
+
+        explicit Linear_Arena(size_t capacity = 0);
+
+        Linear_Arena(const Linear_Arena & ) = delete;
+        Linear_Arena & operator = (const Linear_Arena & ) = delete;
+
+    public:
+
+        template< typename TYPE >
+        TYPE * allocate (size_t count)
+        {
+            static_assert (std::is_trivially_destructible< TYPE >::value, "Linear_Arena only holds trivially destructible types");
+
+            return static_cast< TYPE * >(allocate_bytes (count * sizeof(TYPE), alignof(TYPE)));
+        }
+
+        void * allocate_bytes (size_t size, size_t alignment);
+
+        // Descarta lo reservado hasta ahora y asegura que caben capacity bytes en un solo bloque:
+
+        void reserve (size_t capacity);
+
+        void reset ();
+
+        size_t get_capacity () const;
+
+        size_t get_allocation_count () const
+        {
+            return allocation_count;
+        }
+
+    private:
+
+        void add_block (size_t size);
+
+    };
+
+}
@@ -0,0 +1,158 @@
+#include "Mapped_File.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace udit
+{
+
+    Mapped_File::Mapped_File() : bytes(nullptr), byte_count(0)
+    {
+        #ifdef _WIN32
+            file_handle    = INVALID_HANDLE_VALUE;
+            mapping_handle = nullptr;
+        #endif
+    }
+
+    Mapped_File::Mapped_File(const std::string & path) : Mapped_File()
+    {
+        open (path);
+    }
+
+    Mapped_File::~Mapped_File()
+    {
+        close ();
+    }
+
+    uint8_t Mapped_File::prefetch (size_t offset, size_t size) const
+    {
+        if (!bytes || offset >= byte_count) return 0;
+
+        size = std::min (size, byte_count - offset);
+
+        #ifndef _WIN32
+
+            // Se pide al sistema que lea todo el rango por adelantado en lugar de página a página:
+
+            const size_t page_size = size_t(sysconf (_SC_PAGESIZE));
+            const size_t start     = offset / page_size * page_size;
+
+            madvise (const_cast< uint8_t * >(bytes) + start, offset + size - start, MADV_WILLNEED);
+
+        #endif
+
+        constexpr size_t stride = 4096;
+
+        uint8_t checksum = 0;
+
+        for (size_t position = offset; position < offset + size; position += stride)
+        {
+            checksum ^= bytes[position];
+        }
+
+        if (size > 0) checksum ^= bytes[offset + size - 1];
+
+        return checksum;
+    }
+
+    #ifdef _WIN32
+
+        bool Mapped_File::open (const std::string & path)
+        {
+            close ();
+
+            file_handle = CreateFileA (path.c_str (), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+            if (file_handle == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER file_size;
+
+            if (!GetFileSizeEx (file_handle, &file_size) || file_size.QuadPart == 0)
+            {
+                close ();
+                return false;
+            }
+
+            mapping_handle = CreateFileMappingA (file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+            if (mapping_handle)
+            {
+                bytes = static_cast< const uint8_t * >(MapViewOfFile (mapping_handle, FILE_MAP_READ, 0, 0, 0));
+            }
+
+            if (!bytes)
+            {
+                close ();
+                return false;
+            }
+
+            byte_count = size_t(file_size.QuadPart);
+
+            return true;
+        }
+
+        void Mapped_File::close ()
+        {
+            if (bytes         ) UnmapViewOfFile (bytes);
+            if (mapping_handle) CloseHandle     (mapping_handle);
+            if (file_handle != INVALID_HANDLE_VALUE) CloseHandle (file_handle);
+
+            bytes          = nullptr;
+            byte_count     = 0;
+            mapping_handle = nullptr;
+            file_handle    = INVALID_HANDLE_VALUE;
+        }
+
+    #else
+
+        bool Mapped_File::open (const std::string & path)
+        {
+            close ();
+
+            int descriptor = ::open (path.c_str (), O_RDONLY);
+
+            if (descriptor < 0) return false;
+
+            struct stat status;
+
+            if (fstat (descriptor, &status) == 0 && status.st_size > 0)
+            {
+                void * address = mmap (nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+                if (address != MAP_FAILED)
+                {
+                    madvise (address, size_t(status.st_size), MADV_SEQUENTIAL);
+
+                    bytes      = static_cast< const uint8_t * >(address);
+                    byte_count = size_t(status.st_size);
+                }
+            }
+
+            // La proyección sigue siendo válida después de cerrar el descriptor:
+
+            ::close (descriptor);
+
+            return bytes != nullptr;
+        }
+
+        void Mapped_File::close ()
+        {
+            if (bytes) munmap (const_cast< uint8_t * >(bytes), byte_count);
+
+            bytes      = nullptr;
+            byte_count = 0;
+        }
+
+    #endif
+
+}
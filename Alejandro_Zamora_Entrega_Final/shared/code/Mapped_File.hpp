@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace udit
+{
+
+    // Proyección en memoria de sólo lectura de un archivo completo. El sistema operativo trae
+    // las páginas bajo demanda, por lo que no hace falta copiar el archivo a un búfer propio.
+
+    class Mapped_File
+    {
+    private:
+
+        const uint8_t * bytes;
+        size_t          byte_count;
+
+        #ifdef _WIN32
+            void * file_handle;
+            void * mapping_handle;
+        #endif
+
+    public:
+
+        Mapped_File();
+        explicit Mapped_File(const std::string & path);
+       ~Mapped_File();
+
+        Mapped_File(const Mapped_File & ) = delete;
+        Mapped_File & operator = (const Mapped_File & ) = delete;
+
+    public:
+
+        bool open  (const std::string & path);
+        void close ();
+
+        bool is_open () const
+        {
+            return bytes != nullptr;
+        }
+
+        const uint8_t * data () const
+        {
+            return bytes;
+        }
+
+        size_t size () const
+        {
+            return byte_count;
+        }
+
+        // Lee un byte de cada página de [offset, offset + size) para que los fallos de página, y
+        // la lectura del disco, ocurran en el hilo que llama y no en el que copie después.
+        // Devuelve el XOR de los bytes leídos para que el compilador no elimine las lecturas:
+
+        uint8_t prefetch (size_t offset, size_t size) const;
+
+    };
+
+}
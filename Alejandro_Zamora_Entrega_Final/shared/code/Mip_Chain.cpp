@@ -0,0 +1,539 @@
+#include "Mip_Chain.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "Cpu_Features.hpp"
+#include "Thread_Pool.hpp"
+
+// SSE es la base de x64. Los kernels AVX2/FMA se compilan siempre (con el atributo target en
+// GCC y Clang; MSVC admite los intrínsecos sin /arch) y sólo se usan si la CPU los tiene:
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #define MIP_CHAIN_TARGET(features)
+    #else
+        #define MIP_CHAIN_TARGET(features) __attribute__((target (features)))
+    #endif
+    #define MIP_CHAIN_SSE
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        constexpr float    pi           = 3.14159265f;
+        constexpr unsigned tile_rows    = 16;              // Filas de destino por tarea
+        constexpr unsigned encode_steps = 4096;            // Entradas de la tabla de luz lineal a sRGB
+
+        float sinc (float x)
+        {
+            if (std::fabs (x) < 1e-5f) return 1.f;
+
+            x *= pi;
+
+            return std::sin (x) / x;
+        }
+
+        // Función de Bessel modificada de orden 0 (la serie converge rápido para x < 10):
+
+        float bessel_i0 (float x)
+        {
+            float sum  = 1.f;
+            float term = 1.f;
+
+            for (int k = 1; k < 32 && term > sum * 1e-7f; ++k)
+            {
+                term *= (x * 0.5f / float(k)) * (x * 0.5f / float(k));
+                sum  += term;
+            }
+
+            return sum;
+        }
+
+        float filter_radius (Mip_Filter::Filter filter)
+        {
+            return filter == Mip_Filter::BOX ? 0.5f : 3.f;
+        }
+
+        // Peso del filtro a una distancia x medida en texels del nivel de destino:
+
+        float filter_weight (Mip_Filter::Filter filter, float x)
+        {
+            x = std::fabs (x);
+
+            switch (filter)
+            {
+                case Mip_Filter::BOX:
+                {
+                    return x < 0.5f ? 1.f : x == 0.5f ? 0.5f : 0.f;
+                }
+
+                case Mip_Filter::KAISER:
+                {
+                    constexpr float alpha = 4.f;
+
+                    if (x >= 3.f) return 0.f;
+
+                    const float t = x / 3.f;
+
+                    return sinc (x) * bessel_i0 (alpha * std::sqrt (1.f - t * t)) / bessel_i0 (alpha);
+                }
+
+                case Mip_Filter::LANCZOS:
+                {
+                    return x < 3.f ? sinc (x) * sinc (x / 3.f) : 0.f;
+                }
+            }
+
+            return 0.f;
+        }
+
+        // Pesos del filtro en uno de los dos ejes. Todas las posiciones de destino usan el
+        // mismo número de taps (rellenando con pesos nulos), que se redondea al múltiplo que
+        // necesitan los bucles SIMD:
+
+        struct Kernel
+        {
+            unsigned              tap_count;
+            int                   padding;             // Texels que se leen antes del primero
+            std::vector< int   >  first;               // Primer texel de origen de cada posición
+            std::vector< float >  weights;             // tap_count pesos por posición
+
+            Kernel(Mip_Filter::Filter filter, unsigned source_size, unsigned size, unsigned tap_multiple)
+            :
+                first(size)
+            {
+                const float scale   = float(source_size) / float(size);
+                const float support = filter_radius (filter) * std::max (scale, 1.f);
+
+                int minimum_first = 0;
+                int maximum_count = 1;
+
+                for (unsigned i = 0; i < size; ++i)
+                {
+                    const float center = (float(i) + 0.5f) * scale;
+
+                    first[i] = int(std::ceil (center - support - 0.5f));
+
+                    maximum_count = std::max (maximum_count, int(std::floor (center + support - 0.5f)) - first[i] + 1);
+                    minimum_first = std::min (minimum_first, first[i]);
+                }
+
+                tap_count = (unsigned(maximum_count) + tap_multiple - 1) / tap_multiple * tap_multiple;
+                padding   = -minimum_first;
+
+                weights.assign (size_t(size) * tap_count, 0.f);
+
+                for (unsigned i = 0; i < size; ++i)
+                {
+                    const float center = (float(i) + 0.5f) * scale;
+
+                    float * w   = &weights[size_t(i) * tap_count];
+                    float   sum = 0.f;
+
+                    for (unsigned t = 0; t < tap_count; ++t)
+                    {
+                        const float position = float(first[i] + int(t)) + 0.5f;
+
+                        w[t] = std::fabs (position - center) < support ? filter_weight (filter, (position - center) / std::max (scale, 1.f)) : 0.f;
+                        sum += w[t];
+                    }
+
+                    for (unsigned t = 0; t < tap_count; ++t) w[t] /= sum;
+                }
+            }
+        };
+
+        // Tablas de conversión entre 8 bits y coma flotante. La de decodificación tiene una
+        // fila por canal para que el alfa no pase por la curva sRGB:
+
+        struct Conversion_Tables
+        {
+            float   decode[2][256];                    // [0] lineal, [1] sRGB a lineal
+            uint8_t encode[encode_steps + 1];          // Lineal a sRGB
+
+            Conversion_Tables()
+            {
+                for (int i = 0; i < 256; ++i)
+                {
+                    const float value = float(i) / 255.f;
+
+                    decode[0][i] = value;
+                    decode[1][i] = value <= 0.04045f ? value / 12.92f : std::pow ((value + 0.055f) / 1.055f, 2.4f);
+                }
+
+                for (unsigned i = 0; i <= encode_steps; ++i)
+                {
+                    const float value   = float(i) / float(encode_steps);
+                    const float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow (value, 1.f / 2.4f) - 0.055f;
+
+                    encode[i] = uint8_t(encoded * 255.f + 0.5f);
+                }
+            }
+        };
+
+        const Conversion_Tables & get_tables ()
+        {
+            static const Conversion_Tables tables;
+            return tables;
+        }
+
+        inline uint8_t encode_value (float value, bool srgb, const Conversion_Tables & tables)
+        {
+            value = std::min (std::max (value, 0.f), 1.f);
+
+            return srgb ? tables.encode[unsigned(value * float(encode_steps) + 0.5f)] : uint8_t(value * 255.f + 0.5f);
+        }
+
+        #ifdef MIP_CHAIN_SSE
+
+            bool use_avx2 ()
+            {
+                static const bool available = Cpu_Features::get ().avx2 && Cpu_Features::get ().fma;
+
+                return available;
+            }
+
+            // Filtro horizontal de 4 canales con dos taps por iteración (tap_count es par):
+
+            MIP_CHAIN_TARGET("avx2,fma")
+            void filter_row_rgba_avx2 (const float * row, const Kernel & kernel, const float * weights4, unsigned width, float * output)
+            {
+                const unsigned taps = kernel.tap_count;
+
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    const float * texels = row + size_t(kernel.first[x] + kernel.padding) * 4;
+                    const float * w      = weights4 + size_t(x) * taps * 4;
+
+                    __m256 sum = _mm256_setzero_ps ();
+
+                    for (unsigned t = 0; t < taps; t += 2)
+                    {
+                        sum = _mm256_fmadd_ps (_mm256_loadu_ps (w + t * 4), _mm256_loadu_ps (texels + t * 4), sum);
+                    }
+
+                    _mm_storeu_ps (output + size_t(x) * 4, _mm_add_ps (_mm256_castps256_ps128 (sum), _mm256_extractf128_ps (sum, 1)));
+                }
+            }
+
+            // Acumula de 8 en 8 y devuelve cuántos valores ha procesado:
+
+            MIP_CHAIN_TARGET("avx2,fma")
+            size_t accumulate_row_avx2 (float * sum, const float * row, float weight, size_t count)
+            {
+                const __m256 w8 = _mm256_set1_ps (weight);
+
+                size_t i = 0;
+
+                for ( ; i + 8 <= count; i += 8)
+                {
+                    _mm256_storeu_ps (sum + i, _mm256_fmadd_ps (w8, _mm256_loadu_ps (row + i), _mm256_loadu_ps (sum + i)));
+                }
+
+                return i;
+            }
+
+        #endif
+
+        // Filtra horizontalmente una fila ya convertida a coma flotante (con kernel.padding
+        // texels de margen a cada lado) y escribe width * channels valores en output:
+
+        void filter_row
+        (
+            const float  * row,
+            unsigned       channels,
+            const Kernel & kernel,
+            const float  * weights4,                   // Pesos repetidos 4 veces, para 4 canales con SIMD
+            unsigned       width,
+            float        * output,
+            bool           simd
+        )
+        {
+            const unsigned taps = kernel.tap_count;
+
+            #ifdef MIP_CHAIN_SSE
+
+            if (simd && channels == 4)
+            {
+                if (use_avx2 ())
+                {
+                    filter_row_rgba_avx2 (row, kernel, weights4, width, output);
+                    return;
+                }
+
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    const float * texels = row + size_t(kernel.first[x] + kernel.padding) * 4;
+                    const float * w      = weights4 + size_t(x) * taps * 4;
+
+                    __m128 sum = _mm_setzero_ps ();
+
+                    for (unsigned t = 0; t < taps; ++t)
+                    {
+                        sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (w + t * 4), _mm_loadu_ps (texels + t * 4)));
+                    }
+
+                    _mm_storeu_ps (output + size_t(x) * 4, sum);
+                }
+
+                return;
+            }
+
+            if (simd && channels == 1)
+            {
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    const float * texels = row + kernel.first[x] + kernel.padding;
+                    const float * w      = &kernel.weights[size_t(x) * taps];
+
+                    // Producto escalar de 4 en 4 taps (tap_count es múltiplo de 4):
+
+                    __m128 sum = _mm_setzero_ps ();
+
+                    for (unsigned t = 0; t < taps; t += 4)
+                    {
+                        sum = _mm_add_ps (sum, _mm_mul_ps (_mm_loadu_ps (w + t), _mm_loadu_ps (texels + t)));
+                    }
+
+                    sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+                    sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+
+                    output[x] = _mm_cvtss_f32 (sum);
+                }
+
+                return;
+            }
+
+            #endif
+
+            (void)weights4;
+            (void)simd;
+
+            for (unsigned x = 0; x < width; ++x)
+            {
+                const float * texels = row + size_t(kernel.first[x] + kernel.padding) * channels;
+                const float * w      = &kernel.weights[size_t(x) * taps];
+
+                for (unsigned c = 0; c < channels; ++c)
+                {
+                    float sum = 0.f;
+
+                    for (unsigned t = 0; t < taps; ++t) sum += w[t] * texels[t * channels + c];
+
+                    output[size_t(x) * channels + c] = sum;
+                }
+            }
+        }
+
+        // Acumula weight * row en sum (count valores):
+
+        void accumulate_row (float * sum, const float * row, float weight, size_t count, bool simd)
+        {
+            size_t i = 0;
+
+            #ifdef MIP_CHAIN_SSE
+
+            if (simd)
+            {
+                if (use_avx2 ()) i = accumulate_row_avx2 (sum, row, weight, count);
+
+                const __m128 w4 = _mm_set1_ps (weight);
+
+                for ( ; i + 4 <= count; i += 4)
+                {
+                    _mm_storeu_ps (sum + i, _mm_add_ps (_mm_loadu_ps (sum + i), _mm_mul_ps (w4, _mm_loadu_ps (row + i))));
+                }
+            }
+
+            #endif
+
+            (void)simd;
+
+            for ( ; i < count; ++i) sum[i] += weight * row[i];
+        }
+
+    }
+
+    void Mip_Filter::downsample
+    (
+        const uint8_t * source,
+        unsigned        source_width,
+        unsigned        source_height,
+        uint8_t       * destination,
+        unsigned        width,
+        unsigned        height,
+        unsigned        channels,
+        Filter          filter,
+        bool            srgb,
+        Thread_Pool   * workers,
+        bool            simd
+    )
+    {
+        // Los bucles SIMD recorren los taps horizontales de 2 en 2 (4 canales con AVX2) o de 4
+        // en 4 (1 canal), así que se rellenan con pesos nulos hasta ese múltiplo:
+
+        const unsigned horizontal_multiple = !simd ? 1 : channels == 1 ? 4 : 2;
+
+        const Kernel horizontal(filter, source_width,  width,  horizontal_multiple);
+        const Kernel vertical  (filter, source_height, height, 1);
+
+        // Los pesos horizontales se repiten para cada canal, de modo que un único load los
+        // alinea con los texels RGBA:
+
+        std::vector< float > weights4;
+
+        if (simd && channels == 4)
+        {
+            weights4.resize (horizontal.weights.size () * 4);
+
+            for (size_t i = 0; i < horizontal.weights.size (); ++i)
+            {
+                std::fill_n (&weights4[i * 4], 4, horizontal.weights[i]);
+            }
+        }
+
+        const Conversion_Tables & tables = get_tables ();
+
+        // Curva de cada canal (el cuarto es alfa y siempre es lineal):
+
+        bool channel_srgb[4];
+
+        for (unsigned c = 0; c < 4; ++c) channel_srgb[c] = srgb && c < 3;
+
+        // Texels de margen de la fila convertida: a la izquierda los que piden los primeros
+        // taps y a la derecha los que pueden pedir los últimos:
+
+        const int    left_margin = horizontal.padding;
+        const size_t row_texels  = size_t(left_margin) + source_width + horizontal.tap_count + 1;
+
+        const unsigned tile_count = (height + tile_rows - 1) / tile_rows;
+
+        auto process_tiles = [&] (size_t begin, size_t end)
+        {
+            std::vector< float > converted(row_texels * channels);
+            std::vector< float > filtered;
+            std::vector< float > sum(size_t(width) * channels);
+
+            for (size_t tile = begin; tile < end; ++tile)
+            {
+                const unsigned y0 = unsigned(tile) * tile_rows;
+                const unsigned y1 = std::min (y0 + tile_rows, height);
+
+                // Filas de origen que necesita la franja (con el borde repetido):
+
+                const int lowest  = std::max (vertical.first[y0], 0);
+                const int highest = std::min (vertical.first[y1 - 1] + int(vertical.tap_count) - 1, int(source_height) - 1);
+
+                filtered.resize (size_t(highest - lowest + 1) * width * channels);
+
+                for (int y = lowest; y <= highest; ++y)
+                {
+                    const uint8_t * texels = source + size_t(y) * source_width * channels;
+
+                    for (size_t x = 0; x < row_texels; ++x)
+                    {
+                        const int      clamped = std::min (std::max (int(x) - left_margin, 0), int(source_width) - 1);
+                        const uint8_t * texel  = texels + size_t(clamped) * channels;
+
+                        for (unsigned c = 0; c < channels; ++c)
+                        {
+                            converted[x * channels + c] = tables.decode[channel_srgb[c]][texel[c]];
+                        }
+                    }
+
+                    filter_row
+                    (
+                        converted.data (), channels, horizontal, weights4.data (), width,
+                       &filtered[size_t(y - lowest) * width * channels], simd
+                    );
+                }
+
+                // Filtrado vertical y conversión a 8 bits de cada fila de la franja:
+
+                for (unsigned y = y0; y < y1; ++y)
+                {
+                    std::fill (sum.begin (), sum.end (), 0.f);
+
+                    const float * w = &vertical.weights[size_t(y) * vertical.tap_count];
+
+                    for (unsigned t = 0; t < vertical.tap_count; ++t)
+                    {
+                        if (w[t] == 0.f) continue;
+
+                        const int row = std::min (std::max (vertical.first[y] + int(t), lowest), highest);
+
+                        accumulate_row (sum.data (), &filtered[size_t(row - lowest) * width * channels], w[t], sum.size (), simd);
+                    }
+
+                    uint8_t * output = destination + size_t(y) * width * channels;
+
+                    for (size_t i = 0; i < sum.size (); ++i)
+                    {
+                        output[i] = encode_value (sum[i], channel_srgb[i % channels], tables);
+                    }
+                }
+            }
+        };
+
+        if (workers) workers->parallel_for (tile_count, process_tiles); else process_tiles (0, tile_count);
+    }
+
+    const char * Mip_Filter::get_name (Filter filter)
+    {
+        switch (filter)
+        {
+            case BOX:     return "box";
+            case KAISER:  return "Kaiser";
+            case LANCZOS: return "Lanczos";
+        }
+
+        return "?";
+    }
+
+    const char * Mip_Filter::get_simd_name ()
+    {
+        #if defined(MIP_CHAIN_SSE)
+            return use_avx2 () ? "AVX2" : "SSE";
+        #else
+            return "none";
+        #endif
+    }
+
+    uint64_t Mip_Filter::hash (const void * bytes, size_t size, Filter filter, bool srgb)
+    {
+        // FNV-1a sobre palabras de 64 bits, que basta para distinguir imágenes y es mucho más
+        // rápido que byte a byte en imágenes grandes:
+
+        uint64_t value = 0xCBF29CE484222325ull;
+
+        auto mix = [&value] (uint64_t word)
+        {
+            value ^= word;
+            value *= 0x100000001B3ull;
+        };
+
+        mix (uint64_t(filter) << 1 | uint64_t(srgb));
+        mix (uint64_t(size));
+
+        const uint8_t * data = static_cast< const uint8_t * >(bytes);
+
+        size_t i = 0;
+
+        for ( ; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy (&word, data + i, 8);
+            mix (word);
+        }
+
+        for ( ; i < size; ++i) mix (data[i]);
+
+        return value;
+    }
+
+}
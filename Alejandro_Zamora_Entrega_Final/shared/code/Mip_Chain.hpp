@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Color.hpp"
+#include "Color_Buffer.hpp"
+
+namespace udit
+{
+
+    class Thread_Pool;
+
+    // Reducción de imágenes de 8 bits por canal con un filtro separable. Cada nivel se obtiene
+    // del anterior filtrando primero las filas y después las columnas en coma flotante. Con
+    // sRGB los canales de color se pasan a luz lineal antes de filtrar y se vuelven a
+    // codificar al final, de modo que los mipmaps no se oscurecen; el alfa (el cuarto canal)
+    // siempre se filtra tal cual.
+    //
+    // La imagen de destino se reparte en franjas de filas que se procesan en paralelo. Los
+    // bucles de los filtros usan AVX2 y FMA si la CPU los tiene y SSE en otro caso. No usa
+    // OpenGL.
+
+    class Mip_Filter
+    {
+    public:
+
+        enum Filter
+        {
+            BOX,                                    // Promedio de 2x2 texels
+            KAISER,                                 // Sinc con ventana de Kaiser (alfa = 4, 3 lóbulos)
+            LANCZOS                                 // Lanczos de 3 lóbulos
+        };
+
+    public:
+
+        // Reduce source (source_width x source_height) a destination (width x height). simd
+        // permite forzar la versión escalar para compararlas:
+
+        static void downsample
+        (
+            const uint8_t * source,
+            unsigned        source_width,
+            unsigned        source_height,
+            uint8_t       * destination,
+            unsigned        width,
+            unsigned        height,
+            unsigned        channels,
+            Filter          filter,
+            bool            srgb,
+            Thread_Pool   * workers = nullptr,
+            bool            simd    = true
+        );
+
+        static const char * get_name      (Filter filter);
+        static const char * get_simd_name ();
+
+        // Clave de la caché en disco: FNV-1a de la imagen original y de las opciones:
+
+        static uint64_t hash (const void * bytes, size_t size, Filter filter, bool srgb);
+
+    };
+
+    // Cadena completa de mipmaps de una imagen, del nivel 0 (la original) hasta 1x1. Se puede
+    // guardar en disco para no volver a calcularla en los siguientes arranques.
+
+    template< typename COLOR >
+    class Mip_Chain
+    {
+    public:
+
+        using Color_Buffer = udit::Color_Buffer< COLOR >;
+        using Filter       = Mip_Filter::Filter;
+
+        static constexpr uint32_t cache_magic   = 0x50494D55;      // "UMIP"
+        static constexpr uint32_t cache_version = 1;
+
+    private:
+
+        std::vector< Color_Buffer > levels;
+
+    public:
+
+        // La imagen base se adopta sin copiarla. Sólo si es una vista con filas separadas (un
+        // rectángulo de otra imagen) se copia, porque los filtros la recorren fila tras fila:
+
+        explicit Mip_Chain(Color_Buffer && base)
+        {
+            levels.push_back (base.is_contiguous () ? std::move (base) : base.clone ());
+        }
+
+        // Calcula los niveles que faltan hasta llegar a 1x1:
+
+        void build (Filter filter, bool srgb, Thread_Pool * workers = nullptr, bool simd = true)
+        {
+            levels.erase (levels.begin () + 1, levels.end ());
+
+            while (levels.back ().get_width () > 1 || levels.back ().get_height () > 1)
+            {
+                const Color_Buffer & source = levels.back ();
+
+                Color_Buffer level(std::max (source.get_width () / 2, 1u), std::max (source.get_height () / 2, 1u));
+
+                Mip_Filter::downsample
+                (
+                    reinterpret_cast< const uint8_t * >(source.colors ()), source.get_width (), source.get_height (),
+                    reinterpret_cast< uint8_t       * >(level .colors ()), level .get_width (), level .get_height (),
+                    unsigned(sizeof(COLOR)), filter, srgb, workers, simd
+                );
+
+                levels.push_back (std::move (level));
+            }
+        }
+
+        size_t get_level_count () const
+        {
+            return levels.size ();
+        }
+
+        const Color_Buffer & get_level (size_t level) const
+        {
+            return levels[level];
+        }
+
+        size_t get_byte_count () const
+        {
+            size_t byte_count = 0;
+
+            for (const auto & level : levels) byte_count += size_t(level.get_width ()) * level.get_height () * sizeof(COLOR);
+
+            return byte_count;
+        }
+
+        uint64_t get_cache_key (Filter filter, bool srgb) const
+        {
+            const Color_Buffer & base = levels.front ();
+
+            return Mip_Filter::hash (base.colors (), size_t(base.get_width ()) * base.get_height () * sizeof(COLOR), filter, srgb);
+        }
+
+        // En la caché sólo se guardan los niveles calculados; el nivel 0 sale de la imagen
+        // original, cuyo contenido identifica la clave:
+
+        bool write_cache (const std::string & path, uint64_t key) const
+        {
+            std::ofstream file(path, std::ios::binary);
+
+            if (!file) return false;
+
+            auto put = [&file] (const auto & value)
+            {
+                file.write (reinterpret_cast< const char * >(&value), sizeof(value));
+            };
+
+            // Copias locales para que put no tome referencias a las constantes de la clase,
+            // que no tienen definición fuera de ella:
+
+            const uint32_t magic   = cache_magic;
+            const uint32_t version = cache_version;
+
+            put (magic);
+            put (version);
+            put (key);
+            put (uint32_t(sizeof(COLOR)));
+            put (uint32_t(levels.size ()));
+
+            for (size_t level = 1; level < levels.size (); ++level)
+            {
+                const Color_Buffer & image = levels[level];
+
+                file.write (reinterpret_cast< const char * >(image.colors ()), std::streamsize(size_t(image.get_width ()) * image.get_height () * sizeof(COLOR)));
+            }
+
+            return bool(file);
+        }
+
+        bool read_cache (const std::string & path, uint64_t key)
+        {
+            std::ifstream file(path, std::ios::binary);
+
+            if (!file) return false;
+
+            auto get = [&file] (auto & value) -> bool
+            {
+                return bool(file.read (reinterpret_cast< char * >(&value), sizeof(value)));
+            };
+
+            uint32_t magic = 0, version = 0, color_size = 0, level_count = 0;
+            uint64_t stored_key = 0;
+
+            if (!get (magic) || magic != cache_magic || !get (version) || version != cache_version) return false;
+
+            if (!get (stored_key) || stored_key != key || !get (color_size) || color_size != sizeof(COLOR) || !get (level_count)) return false;
+
+            // El número de niveles tiene que coincidir con el que sale del tamaño de la imagen:
+
+            unsigned width  = levels.front ().get_width  ();
+            unsigned height = levels.front ().get_height ();
+            uint32_t expected_count = 1;
+
+            for (unsigned w = width, h = height; w > 1 || h > 1; w = std::max (w / 2, 1u), h = std::max (h / 2, 1u)) ++expected_count;
+
+            if (level_count != expected_count) return false;
+
+            std::vector< Color_Buffer > loaded;
+
+            while (width > 1 || height > 1)
+            {
+                width  = std::max (width  / 2, 1u);
+                height = std::max (height / 2, 1u);
+
+                loaded.emplace_back (width, height);
+
+                if (!file.read (reinterpret_cast< char * >(loaded.back ().colors ()), std::streamsize(size_t(width) * height * sizeof(COLOR)))) return false;
+            }
+
+            levels.erase (levels.begin () + 1, levels.end ());
+
+            for (auto & level : loaded) levels.push_back (std::move (level));
+
+            return true;
+        }
+
+    };
+
+}
@@ -0,0 +1,257 @@
+#include "Mip_Residency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <tuple>
+
+namespace udit
+{
+
+    Mip_Residency::Mip_Residency(size_t budget_bytes)
+    :
+        budget_bytes(budget_bytes),
+        frame       (0),
+        statistics  { 0, 0, 0, 0, 0 }
+    {
+    }
+
+    Mip_Residency::Handle Mip_Residency::add (unsigned width, unsigned height, unsigned level_count, unsigned resident_level, unsigned bytes_per_texel)
+    {
+        Entry entry;
+
+        entry.width           = std::max (width,  1u);
+        entry.height          = std::max (height, 1u);
+        entry.level_count     = std::max (level_count, 1u);
+        entry.bytes_per_texel = bytes_per_texel;
+        entry.tail_level      = 0;
+        entry.last_seen       = frame;
+        entry.used            = true;
+
+        while (entry.tail_level + 1 < entry.level_count && std::max (entry.width >> entry.tail_level, entry.height >> entry.tail_level) > tail_size)
+        {
+            ++entry.tail_level;
+        }
+
+        entry.resident_level = std::min (resident_level, entry.tail_level);
+        entry.target_level   = entry.resident_level;
+        entry.wanted_level   = entry.tail_level;
+
+        Handle handle;
+
+        if (free_handles.empty ())
+        {
+            handle = Handle(entries.size ());
+            entries.push_back (entry);
+        }
+        else
+        {
+            handle = free_handles.back ();
+            free_handles.pop_back ();
+            entries[handle] = entry;
+        }
+
+        statistics.resident_bytes += get_bytes (entry, entry.resident_level);
+
+        return handle;
+    }
+
+    void Mip_Residency::remove (Handle handle)
+    {
+        Entry & entry = entries[handle];
+
+        statistics.resident_bytes -= get_bytes (entry, entry.resident_level);
+
+        entry.used = false;
+
+        free_handles.push_back (handle);
+    }
+
+    void Mip_Residency::begin_frame ()
+    {
+        ++frame;
+
+        for (auto & entry : entries)
+        {
+            entry.wanted_level = entry.tail_level;
+        }
+    }
+
+    void Mip_Residency::request (Handle handle, float level)
+    {
+        Entry & entry = entries[handle];
+
+        const unsigned requested = level <= 0.f ? 0u : unsigned(std::min (std::floor (level), float(entry.tail_level)));
+
+        entry.wanted_level = std::min (entry.wanted_level, requested);
+        entry.last_seen    = frame;
+    }
+
+    void Mip_Residency::update (size_t max_load_bytes)
+    {
+        changes.clear ();
+
+        // Objetivo inicial: lo pedido por las visibles y lo que ya tienen todas, que sólo se
+        // pierde si hace falta sitio. Así una textura que se aleja y vuelve no se recarga:
+
+        size_t total_bytes  = 0;
+        size_t wanted_bytes = 0;
+
+        for (auto & entry : entries)
+        {
+            if (!entry.used) continue;
+
+            entry.target_level = entry.last_seen == frame ? std::min (entry.wanted_level, entry.resident_level) : entry.resident_level;
+
+            total_bytes  += get_bytes (entry, entry.target_level);
+            wanted_bytes += get_bytes (entry, entry.wanted_level);
+        }
+
+        statistics.wanted_bytes = wanted_bytes;
+
+        // Se quitan primero los niveles que no se necesitan, después los de las texturas que
+        // llevan más tiempo sin verse y, a igualdad, el nivel más grande:
+
+        if (total_bytes > budget_bytes)
+        {
+            using Candidate = std::tuple< bool, size_t, size_t, Handle >;  // Sobrante, antigüedad, bytes del nivel, textura
+
+            std::priority_queue< Candidate > candidates;
+
+            for (Handle handle = 0; handle < entries.size (); ++handle)
+            {
+                const Entry & entry = entries[handle];
+
+                if (entry.used && entry.target_level < entry.tail_level)
+                {
+                    candidates.emplace (entry.target_level < entry.wanted_level, frame - entry.last_seen, get_level_bytes (entry, entry.target_level), handle);
+                }
+            }
+
+            while (total_bytes > budget_bytes && !candidates.empty ())
+            {
+                Entry & entry = entries[std::get< 3 > (candidates.top ())];
+
+                candidates.pop ();
+
+                total_bytes -= get_level_bytes (entry, entry.target_level);
+
+                if (++entry.target_level < entry.tail_level)
+                {
+                    candidates.emplace (entry.target_level < entry.wanted_level, frame - entry.last_seen, get_level_bytes (entry, entry.target_level), Handle(&entry - entries.data ()));
+                }
+            }
+
+            if (total_bytes > budget_bytes) statistics.overflow_count++;
+        }
+
+        // Las bajadas se aplican todas antes de subir nada, así que lo residente sigue dentro del
+        // presupuesto mientras llegan las subidas:
+
+        std::vector< Handle > pending;
+
+        for (Handle handle = 0; handle < entries.size (); ++handle)
+        {
+            Entry & entry = entries[handle];
+
+            if (!entry.used) continue;
+
+            if (entry.target_level > entry.resident_level)
+            {
+                statistics.released_levels += entry.target_level - entry.resident_level;
+                statistics.resident_bytes  -= get_bytes (entry, entry.resident_level) - get_bytes (entry, entry.target_level);
+
+                entry.resident_level = entry.target_level;
+
+                changes.push_back (handle);
+            }
+            else if (entry.target_level < entry.resident_level)
+            {
+                pending.push_back (handle);
+            }
+        }
+
+        // Las subidas empiezan por las que están más lejos de su objetivo y cada pasada sube un
+        // nivel de cada una, de menor a mayor, para repartir el límite de bytes:
+
+        std::sort
+        (
+            pending.begin (), pending.end (),
+            [this] (Handle a, Handle b)
+            {
+                const Entry & ea = entries[a];
+                const Entry & eb = entries[b];
+
+                return ea.resident_level - ea.target_level != eb.resident_level - eb.target_level
+                     ? ea.resident_level - ea.target_level >  eb.resident_level - eb.target_level
+                     : a < b;
+            }
+        );
+
+        size_t              load_bytes = 0;
+        bool                loaded     = true;
+        std::vector< bool > changed(pending.size (), false);
+
+        while (loaded)
+        {
+            loaded = false;
+
+            for (size_t i = 0; i < pending.size (); ++i)
+            {
+                Entry & entry = entries[pending[i]];
+
+                if (entry.resident_level == entry.target_level) continue;
+
+                const size_t bytes = get_level_bytes (entry, entry.resident_level - 1);
+
+                if (load_bytes > 0 && load_bytes + bytes > max_load_bytes) continue;
+
+                if (!changed[i])
+                {
+                    changes.push_back (pending[i]);
+                    changed[i] = true;
+                }
+
+                load_bytes                += bytes;
+                statistics.resident_bytes += bytes;
+                statistics.loaded_levels  += 1;
+
+                entry.resident_level--;
+
+                loaded = true;
+            }
+        }
+    }
+
+    size_t Mip_Residency::get_bytes (Handle handle, unsigned first_level) const
+    {
+        return get_bytes (entries[handle], first_level);
+    }
+
+    size_t Mip_Residency::get_level_bytes (const Entry & entry, unsigned level) const
+    {
+        return size_t(std::max (entry.width >> level, 1u)) * std::max (entry.height >> level, 1u) * entry.bytes_per_texel;
+    }
+
+    size_t Mip_Residency::get_bytes (const Entry & entry, unsigned first_level) const
+    {
+        size_t bytes = 0;
+
+        for (unsigned level = first_level; level < entry.level_count; ++level)
+        {
+            bytes += get_level_bytes (entry, level);
+        }
+
+        return bytes;
+    }
+
+    float Mip_Residency::estimate_level (unsigned width, unsigned height, float uv_density, float pixels_per_unit)
+    {
+        // Texels de la textura que caen en un píxel de pantalla a lo largo de su lado mayor:
+
+        const float texels_per_pixel = float(std::max (width, height)) * uv_density / std::max (pixels_per_unit, 1e-6f);
+
+        return std::log2 (std::max (texels_per_pixel, 1e-6f));
+    }
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace udit
+{
+
+    // Residencia de los mipmaps de un conjunto de texturas dentro de un presupuesto de memoria.
+    // Cada textura tiene un nivel base residente: están en la GPU ese nivel y todos los más
+    // pequeños. Los niveles de tail_size texels o menos no se descargan nunca, para que siempre
+    // haya algo que mostrar.
+    //
+    // Cada fotograma se pide, para cada textura que se dibuja, el nivel que necesita según su
+    // tamaño en pantalla (ver estimate_level). update() calcula el nivel objetivo de todas: las
+    // texturas conservan lo que tienen mientras haya sitio y, si no cabe, se van quitando los
+    // niveles que nadie necesita, luego los de las que llevan más tiempo sin verse y, entre las
+    // visibles, siempre el más grande, de modo que acaban con una densidad de texels parecida.
+    // Las bajadas se aplican al momento y las subidas se reparten entre fotogramas con un
+    // límite de bytes, así que la memoria residente nunca pasa del presupuesto.
+    //
+    // No usa OpenGL, así que se puede simular sin GPU.
+
+    class Mip_Residency
+    {
+    public:
+
+        using Handle = unsigned;
+
+        struct Statistics
+        {
+            size_t resident_bytes;                  // Niveles residentes tras el último update()
+            size_t wanted_bytes;                    // Lo que ocuparían los niveles pedidos sin límite
+            size_t loaded_levels;                   // Niveles subidos desde el principio
+            size_t released_levels;                 // Niveles descargados desde el principio
+            size_t overflow_count;                  // update() en los que ni los niveles fijos cabían
+        };
+
+        static constexpr Handle   no_handle = ~0u;
+        static constexpr unsigned tail_size = 64;
+
+    private:
+
+        struct Entry
+        {
+            unsigned width;
+            unsigned height;
+            unsigned level_count;
+            unsigned bytes_per_texel;
+            unsigned tail_level;                    // Primer nivel que no se descarga nunca
+            unsigned wanted_level;                  // Pedido en este fotograma
+            unsigned target_level;
+            unsigned resident_level;
+            size_t   last_seen;                     // Último fotograma en que se pidió
+            bool     used;
+        };
+
+        std::vector< Entry  > entries;
+        std::vector< Handle > free_handles;
+        std::vector< Handle > changes;              // Texturas cuyo nivel residente cambió en update()
+
+        size_t     budget_bytes;
+        size_t     frame;
+        Statistics statistics;
+
+    public:
+
+        explicit Mip_Residency(size_t budget_bytes);
+
+    public:
+
+        // resident_level es el nivel base con el que ya está la textura en la GPU:
+
+        Handle add    (unsigned width, unsigned height, unsigned level_count, unsigned resident_level = 0, unsigned bytes_per_texel = 4);
+        void   remove (Handle handle);
+
+        // Empieza a acumular las peticiones del siguiente fotograma:
+
+        void begin_frame ();
+
+        // level puede tener decimales y estar fuera de rango; se queda el más fino de los pedidos:
+
+        void request (Handle handle, float level);
+
+        // Calcula los niveles objetivo y cambia los residentes, subiendo como mucho
+        // max_load_bytes (al menos un nivel si hay alguno pendiente):
+
+        void update (size_t max_load_bytes);
+
+        const std::vector< Handle > & get_changes () const
+        {
+            return changes;
+        }
+
+        unsigned get_resident_level (Handle handle) const { return entries[handle].resident_level; }
+        unsigned get_target_level   (Handle handle) const { return entries[handle].target_level;   }
+        unsigned get_wanted_level   (Handle handle) const { return entries[handle].wanted_level;   }
+        unsigned get_tail_level     (Handle handle) const { return entries[handle].tail_level;     }
+
+        // Bytes de los niveles first_level y siguientes:
+
+        size_t get_bytes (Handle handle, unsigned first_level) const;
+
+        void set_budget (size_t bytes)
+        {
+            budget_bytes = bytes;
+        }
+
+        size_t get_budget () const
+        {
+            return budget_bytes;
+        }
+
+        const Statistics & get_statistics () const
+        {
+            return statistics;
+        }
+
+        // Nivel que muestrea la GPU para una textura de width x height cuando uv_density
+        // unidades de UV ocupan una unidad del objeto y ésta ocupa pixels_per_unit píxeles:
+
+        static float estimate_level (unsigned width, unsigned height, float uv_density, float pixels_per_unit);
+
+    private:
+
+        size_t get_level_bytes (const Entry & entry, unsigned level) const;
+        size_t get_bytes       (const Entry & entry, unsigned first_level) const;
+
+    };
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace udit
+{
+
+    // Cola acotada sin bloqueos para varios productores y varios consumidores (algoritmo de
+    // Dmitry Vyukov). Cada celda lleva un número de secuencia que indica si está libre o
+    // contiene un elemento listo para leerse. La capacidad se redondea a potencia de 2.
+
+    template< typename T >
+    class Mpmc_Queue
+    {
+    private:
+
+        struct Cell
+        {
+            std::atomic< size_t > sequence;
+            T                     value;
+        };
+
+        // Se separan los contadores en líneas de caché distintas para que productores y
+        // consumidores no compitan por la misma línea:
+
+        alignas(64) std::unique_ptr< Cell[] > cells;
+        size_t                                mask;
+        alignas(64) std::atomic< size_t >     enqueue_position;
+        alignas(64) std::atomic< size_t >     dequeue_position;
+
+    public:
+
+        explicit Mpmc_Queue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+
+            cells = std::make_unique< Cell[] > (size);
+            mask  = size - 1;
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                cells[i].sequence.store (i, std::memory_order_relaxed);
+            }
+
+            enqueue_position.store (0, std::memory_order_relaxed);
+            dequeue_position.store (0, std::memory_order_relaxed);
+        }
+
+        Mpmc_Queue(const Mpmc_Queue & ) = delete;
+        Mpmc_Queue & operator = (const Mpmc_Queue & ) = delete;
+
+    public:
+
+        // Devuelve false si la cola está llena:
+
+        bool try_push (T && value)
+        {
+            size_t position = enqueue_position.load (std::memory_order_relaxed);
+            Cell * cell;
+
+            for (;;)
+            {
+                cell = &cells[position & mask];
+
+                size_t    sequence   = cell->sequence.load (std::memory_order_acquire);
+                ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position);
+
+                if (difference == 0)
+                {
+                    if (enqueue_position.compare_exchange_weak (position, position + 1, std::memory_order_relaxed)) break;
+                }
+                else
+                if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = enqueue_position.load (std::memory_order_relaxed);
+                }
+            }
+
+            cell->value = std::move (value);
+            cell->sequence.store (position + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Devuelve false si la cola está vacía:
+
+        bool try_pop (T & value)
+        {
+            size_t position = dequeue_position.load (std::memory_order_relaxed);
+            Cell * cell;
+
+            for (;;)
+            {
+                cell = &cells[position & mask];
+
+                size_t    sequence   = cell->sequence.load (std::memory_order_acquire);
+                ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position + 1);
+
+                if (difference == 0)
+                {
+                    if (dequeue_position.compare_exchange_weak (position, position + 1, std::memory_order_relaxed)) break;
+                }
+                else
+                if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = dequeue_position.load (std::memory_order_relaxed);
+                }
+            }
+
+            value = std::move (cell->value);
+            cell->value = T();
+            cell->sequence.store (position + mask + 1, std::memory_order_release);
+
+            return true;
+        }
+
+    };
+
+}
@@ -0,0 +1,237 @@
+#include "Page_Cache.hpp"
+
+#include <algorithm>
+
+namespace udit
+{
+
+    Page_Cache::Page_Cache(unsigned width, unsigned height, unsigned page_size, unsigned slots_per_side)
+    :
+        width         (width         ),
+        height        (height        ),
+        page_size     (page_size     ),
+        slots_per_side(slots_per_side),
+        level_count   (1             ),
+        frame         (0             ),
+        statistics    { 0, 0, 0, 0, 0 }
+    {
+        while (get_page_count_x (level_count - 1) > 1 || get_page_count_y (level_count - 1) > 1) ++level_count;
+
+        slots.resize (size_t(slots_per_side) * slots_per_side, Slot{ 0, 0, lru.end (), false });
+
+        // Se reparten primero los slots bajos:
+
+        for (unsigned slot = unsigned(slots.size ()); slot > 0; --slot) free_slots.push_back (slot - 1);
+
+        for (unsigned level = 0; level < level_count; ++level)
+        {
+            indirection.emplace_back (size_t(get_page_count_x (level)) * get_page_count_y (level), 0u);
+        }
+
+        dirty.assign (level_count, true);
+    }
+
+    void Page_Cache::begin_frame ()
+    {
+        ++frame;
+
+        wanted.clear ();
+        seen  .clear ();
+
+        // La raíz no cuenta como petición de la retroalimentación:
+
+        const uint32_t root = make_key (level_count - 1, 0, 0);
+        auto           page = resident.find (root);
+
+        if (page != resident.end ()) touch (page->second); else wanted.insert (root);
+
+        seen.insert (root);
+    }
+
+    void Page_Cache::request (uint32_t key)
+    {
+        if (!is_valid (key) || !seen.insert (key).second) return;
+
+        statistics.requests++;
+
+        // Si no está se pide también su padre, que es lo que se verá mientras tanto. Se sube
+        // hasta encontrar un antecesor residente, que se marca como usado:
+
+        for (bool first = true; ; first = false)
+        {
+            auto page = resident.find (key);
+
+            if (page != resident.end ())
+            {
+                if (first) statistics.hits++;
+
+                touch (page->second);
+                return;
+            }
+
+            wanted.insert (key);
+
+            const unsigned level = get_level (key);
+
+            if (level + 1 >= level_count) return;
+
+            key = make_key (level + 1, get_x (key) / 2, get_y (key) / 2);
+
+            seen.insert (key);
+        }
+    }
+
+    std::vector< uint32_t > Page_Cache::take_loads (size_t max_count)
+    {
+        std::vector< uint32_t > loads;
+
+        for (uint32_t key : wanted)
+        {
+            if (!in_flight.count (key) && !resident.count (key)) loads.push_back (key);
+        }
+
+        // Primero las páginas de menor resolución, que cubren más pantalla. La clave ordena por
+        // nivel y después por posición, así que el orden no depende del de la tabla hash:
+
+        std::sort
+        (
+            loads.begin (), loads.end (),
+            [] (uint32_t a, uint32_t b) { return get_level (a) != get_level (b) ? get_level (a) > get_level (b) : a < b; }
+        );
+
+        if (loads.size () > max_count) loads.resize (max_count);
+
+        for (uint32_t key : loads) in_flight.insert (key);
+
+        return loads;
+    }
+
+    unsigned Page_Cache::insert (uint32_t key)
+    {
+        in_flight.erase (key);
+
+        if (resident.count (key)) return no_slot;
+
+        unsigned slot;
+
+        if (!free_slots.empty ())
+        {
+            slot = free_slots.back ();
+            free_slots.pop_back ();
+        }
+        else
+        {
+            // Las páginas usadas en este fotograma se están viendo y no se pueden expulsar:
+
+            slot = lru.front ();
+
+            if (slots[slot].last_frame == frame)
+            {
+                statistics.drops++;
+                return no_slot;
+            }
+
+            evict (slot);
+
+            free_slots.pop_back ();
+        }
+
+        Slot & target = slots[slot];
+
+        target.key        = key;
+        target.used       = true;
+        target.last_frame = frame;
+        target.position   = lru.insert (lru.end (), slot);
+
+        resident[key] = slot;
+
+        fill_footprint (key, make_entry (slot, get_level (key)), get_level (key) + 1);
+
+        statistics.loads++;
+
+        return slot;
+    }
+
+    void Page_Cache::cancel (uint32_t key)
+    {
+        in_flight.erase (key);
+    }
+
+    void Page_Cache::touch (unsigned slot)
+    {
+        Slot & target = slots[slot];
+
+        target.last_frame = frame;
+
+        lru.splice (lru.end (), lru, target.position);
+    }
+
+    void Page_Cache::evict (unsigned slot)
+    {
+        Slot & target = slots[slot];
+
+        const uint32_t key = target.key;
+
+        lru.erase (target.position);
+        resident.erase (key);
+
+        target.used     = false;
+        target.position = lru.end ();
+
+        free_slots.push_back (slot);
+
+        // Las entradas que mostraban esta página pasan a mostrar su antecesor residente:
+
+        fill_footprint (key, find_ancestor_entry (key), get_level (key));
+
+        statistics.evictions++;
+    }
+
+    void Page_Cache::fill_footprint (uint32_t key, uint32_t entry, unsigned replaced_level)
+    {
+        const unsigned level = get_level (key);
+
+        for (unsigned target = 0; target <= level; ++target)
+        {
+            const unsigned shift    = level - target;
+            const unsigned count_x  = get_page_count_x (target);
+            const unsigned count_y  = get_page_count_y (target);
+            const unsigned x_begin  = get_x (key) << shift;
+            const unsigned y_begin  = get_y (key) << shift;
+            const unsigned x_end    = std::min ((get_x (key) + 1) << shift, count_x);
+            const unsigned y_end    = std::min ((get_y (key) + 1) << shift, count_y);
+
+            std::vector< uint32_t > & table = indirection[target];
+
+            for (unsigned y = y_begin; y < y_end; ++y)
+            {
+                for (unsigned x = x_begin; x < x_end; ++x)
+                {
+                    uint32_t & current = table[size_t(y) * count_x + x];
+
+                    // Las entradas que apuntan a una página más fina no se tocan:
+
+                    if ((current >> 24) == 0 || ((current >> 16) & 0xFF) >= replaced_level)
+                    {
+                        current = entry;
+                    }
+                }
+            }
+
+            dirty[target] = true;
+        }
+    }
+
+    uint32_t Page_Cache::find_ancestor_entry (uint32_t key) const
+    {
+        for (unsigned level = get_level (key) + 1, x = get_x (key) / 2, y = get_y (key) / 2; level < level_count; ++level, x /= 2, y /= 2)
+        {
+            auto page = resident.find (make_key (level, x, y));
+
+            if (page != resident.end ()) return make_entry (page->second, level);
+        }
+
+        return 0;
+    }
+
+}
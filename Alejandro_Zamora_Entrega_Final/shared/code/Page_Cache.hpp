@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace udit
+{
+
+    // Residencia de las páginas de una textura virtual en una caché física de slots. Cada
+    // página es un cuadrado de page_size texels de un nivel de la cadena de mipmaps; el último
+    // nivel tiene una sola página y se mantiene siempre en la caché para que haya algo que
+    // mostrar en cualquier punto.
+    //
+    // Por cada fotograma se pasan las páginas que ha pedido la retroalimentación. Las que no
+    // están se piden también a su padre, porque mientras llegan el shader usa el antecesor
+    // residente más cercano. take_loads() decide qué cargar (de menor a mayor resolución) e
+    // insert() coloca una página recién leída en el slot libre o en el que lleva más tiempo
+    // sin usarse (LRU). La tabla de indirección de cada nivel guarda, por página, el slot y el
+    // nivel de la página residente que la sustituye.
+    //
+    // No usa OpenGL, así que se puede simular sin GPU.
+
+    class Page_Cache
+    {
+    public:
+
+        struct Statistics
+        {
+            size_t requests;                        // Páginas distintas pedidas en cada fotograma
+            size_t hits;                            // De ellas, las que ya estaban residentes
+            size_t loads;                           // Páginas colocadas en la caché
+            size_t evictions;                       // Páginas expulsadas para hacer sitio
+            size_t drops;                           // Páginas leídas que no cupieron
+        };
+
+        static constexpr unsigned no_slot = ~0u;
+
+    private:
+
+        struct Slot
+        {
+            uint32_t                         key;
+            size_t                           last_frame;
+            std::list< unsigned >::iterator  position;  // En lru, si está ocupado
+            bool                             used;
+        };
+
+        unsigned                          width;
+        unsigned                          height;
+        unsigned                          page_size;
+        unsigned                          slots_per_side;
+        unsigned                          level_count;
+
+        std::vector< Slot >               slots;
+        std::list< unsigned >             lru;          // Slots ocupados, del usado hace más tiempo al último
+        std::vector< unsigned >           free_slots;
+        std::unordered_map< uint32_t, unsigned > resident;
+        std::unordered_set< uint32_t >    in_flight;
+        std::unordered_set< uint32_t >    wanted;       // Pedidas en este fotograma y no residentes
+        std::unordered_set< uint32_t >    seen;         // Pedidas en este fotograma
+
+        std::vector< std::vector< uint32_t > > indirection;
+        std::vector< bool >               dirty;
+
+        size_t                            frame;
+        Statistics                        statistics;
+
+    public:
+
+        Page_Cache(unsigned width, unsigned height, unsigned page_size, unsigned slots_per_side);
+
+    public:
+
+        // Las claves empaquetan el nivel y la posición de la página:
+
+        static uint32_t make_key (unsigned level, unsigned x, unsigned y)
+        {
+            return uint32_t(level) << 24 | uint32_t(y) << 12 | uint32_t(x);
+        }
+
+        static unsigned get_level (uint32_t key) { return key >> 24;         }
+        static unsigned get_x     (uint32_t key) { return key       & 0xFFF; }
+        static unsigned get_y     (uint32_t key) { return key >> 12 & 0xFFF; }
+
+        unsigned get_level_count    () const { return level_count;    }
+        unsigned get_page_size      () const { return page_size;      }
+        unsigned get_slots_per_side () const { return slots_per_side; }
+
+        unsigned get_level_width  (unsigned level) const { return width  >> level > 0 ? width  >> level : 1; }
+        unsigned get_level_height (unsigned level) const { return height >> level > 0 ? height >> level : 1; }
+
+        unsigned get_page_count_x (unsigned level) const { return (get_level_width  (level) + page_size - 1) / page_size; }
+        unsigned get_page_count_y (unsigned level) const { return (get_level_height (level) + page_size - 1) / page_size; }
+
+        bool is_valid (uint32_t key) const
+        {
+            return get_level (key) < level_count && get_x (key) < get_page_count_x (get_level (key)) && get_y (key) < get_page_count_y (get_level (key));
+        }
+
+        bool is_resident (uint32_t key) const
+        {
+            return resident.count (key) > 0;
+        }
+
+        // Empieza un fotograma de retroalimentación. La página del último nivel se pide siempre:
+
+        void begin_frame ();
+
+        void request (uint32_t key);
+
+        // Páginas que hay que leer, como mucho max_count, sin repetir las que ya están en camino:
+
+        std::vector< uint32_t > take_loads (size_t max_count);
+
+        // Devuelve el slot donde copiar una página ya leída o no_slot si todos los slots se han
+        // usado en este fotograma. En ese caso la página se descarta y se volverá a pedir:
+
+        unsigned insert (uint32_t key);
+
+        // Una lectura que ha fallado deja de estar en camino:
+
+        void cancel (uint32_t key);
+
+        // Entradas RGBA8 de la indirección de un nivel (x e y del slot, nivel, 255 si hay página):
+
+        const std::vector< uint32_t > & get_indirection (unsigned level) const
+        {
+            return indirection[level];
+        }
+
+        bool is_dirty (unsigned level) const
+        {
+            return dirty[level];
+        }
+
+        void clear_dirty (unsigned level)
+        {
+            dirty[level] = false;
+        }
+
+        size_t get_resident_count () const
+        {
+            return resident.size ();
+        }
+
+        const Statistics & get_statistics () const
+        {
+            return statistics;
+        }
+
+    private:
+
+        uint32_t make_entry (unsigned slot, unsigned level) const
+        {
+            return uint32_t(slot % slots_per_side) | uint32_t(slot / slots_per_side) << 8 | uint32_t(level) << 16 | 0xFF000000u;
+        }
+
+        void touch (unsigned slot);
+
+        void evict (unsigned slot);
+
+        // Cambia por entry las entradas de la huella de key que están vacías o apuntan a una
+        // página de nivel replaced_level o mayor:
+
+        void fill_footprint (uint32_t key, uint32_t entry, unsigned replaced_level);
+
+        // Entrada del antecesor residente más cercano por encima del nivel de key (0 si no hay):
+
+        uint32_t find_ancestor_entry (uint32_t key) const;
+
+    };
+
+}
@@ -0,0 +1,809 @@
+#include "Pixel_Conversion.hpp"
+
+#include <cstring>
+
+#include <half.hpp>
+
+#include "Cpu_Features.hpp"
+
+// Los kernels de cada juego de instrucciones se compilan siempre (con el atributo target en
+// GCC y Clang; MSVC admite los intrínsecos sin /arch) y se elige cuál usar al ejecutar:
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #define PIXEL_CONVERSION_TARGET(features)
+    #else
+        #define PIXEL_CONVERSION_TARGET(features) __attribute__((target (features)))
+    #endif
+    #define PIXEL_CONVERSION_X86
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        // Versiones escalares, que son la referencia:
+
+        void luminance_to_rgba_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, destination += 4)
+            {
+                destination[0] = destination[1] = destination[2] = source[i];
+                destination[3] = 255;
+            }
+        }
+
+        void rgba_to_luminance_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, source += 4)
+            {
+                destination[i] = uint8_t((source[0] * 77u + source[1] * 150u + source[2] * 29u) >> 8);
+            }
+        }
+
+        void rgb_to_rgba_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, source += 3, destination += 4)
+            {
+                destination[0] = source[0];
+                destination[1] = source[1];
+                destination[2] = source[2];
+                destination[3] = 255;
+            }
+        }
+
+        void rgba_to_rgb_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, source += 4, destination += 3)
+            {
+                destination[0] = source[0];
+                destination[1] = source[1];
+                destination[2] = source[2];
+            }
+        }
+
+        void swap_red_blue_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, source += 4, destination += 4)
+            {
+                const uint8_t red = source[0];
+
+                destination[0] = source[2];
+                destination[1] = source[1];
+                destination[2] = red;
+                destination[3] = source[3];
+            }
+        }
+
+        // round (x / 255) exacto para x hasta 255 * 255, sin dividir:
+
+        inline uint8_t divide_by_255 (unsigned x)
+        {
+            x += 128;
+
+            return uint8_t((x + (x >> 8)) >> 8);
+        }
+
+        void premultiply_alpha_scalar (const uint8_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i, source += 4, destination += 4)
+            {
+                const unsigned alpha = source[3];
+
+                destination[0] = divide_by_255 (source[0] * alpha);
+                destination[1] = divide_by_255 (source[1] * alpha);
+                destination[2] = divide_by_255 (source[2] * alpha);
+                destination[3] = uint8_t(alpha);
+            }
+        }
+
+        inline uint8_t to_unorm (float value)
+        {
+            // Escrito para que NaN acabe en 0 igual que con max/min de SSE:
+
+            value = value > 0.f ? value : 0.f;
+            value = value < 1.f ? value : 1.f;
+
+            return uint8_t(int(value * 255.f + 0.5f));
+        }
+
+        void unorm_to_float_scalar (const uint8_t * source, float * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) destination[i] = float(source[i]) / 255.f;
+        }
+
+        void float_to_unorm_scalar (const float * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) destination[i] = to_unorm (source[i]);
+        }
+
+        void unorm_to_half_scalar (const uint8_t * source, uint16_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const half_float::half value(float(source[i]) / 255.f);
+
+                std::memcpy (destination + i, &value, sizeof(uint16_t));
+            }
+        }
+
+        void half_to_unorm_scalar (const uint16_t * source, uint8_t * destination, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                half_float::half value;
+
+                std::memcpy (static_cast< void * >(&value), source + i, sizeof(uint16_t));
+
+                destination[i] = to_unorm (float(value));
+            }
+        }
+
+        #ifdef PIXEL_CONVERSION_X86
+
+            // Cada kernel procesa los bloques completos que caben en count y devuelve cuántos
+            // píxeles (o valores) ha convertido. El resto lo termina la versión escalar. Todos
+            // leen un bloque entero antes de escribirlo, así que admiten source == destination.
+
+            // SSE4.1
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t luminance_to_rgba_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m128i alpha = _mm_set1_epi32 (int(0xFF000000u));
+
+                const __m128i spread[4] =
+                {
+                    _mm_setr_epi8 ( 0,  0,  0, -1,  1,  1,  1, -1,  2,  2,  2, -1,  3,  3,  3, -1),
+                    _mm_setr_epi8 ( 4,  4,  4, -1,  5,  5,  5, -1,  6,  6,  6, -1,  7,  7,  7, -1),
+                    _mm_setr_epi8 ( 8,  8,  8, -1,  9,  9,  9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+                    _mm_setr_epi8 (12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+                };
+
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m128i luminance = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i));
+
+                    for (int block = 0; block < 4; ++block)
+                    {
+                        _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + (i + block * 4) * 4), _mm_or_si128 (_mm_shuffle_epi8 (luminance, spread[block]), alpha));
+                    }
+                }
+
+                return i;
+            }
+
+            // Luminancia de cuatro píxeles RGBA en los 32 bits de cada uno:
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            inline __m128i luminance_sse41 (__m128i pixels)
+            {
+                const __m128i low_bytes     = _mm_set1_epi32 (0x00FF00FF);
+                const __m128i red_blue      = _mm_set1_epi32 ((29 << 16) | 77);
+                const __m128i green_alpha   = _mm_set1_epi32 (150);
+
+                const __m128i rb = _mm_and_si128  (pixels, low_bytes);
+                const __m128i ga = _mm_srli_epi16 (pixels, 8);
+
+                return _mm_srli_epi32 (_mm_add_epi32 (_mm_madd_epi16 (rb, red_blue), _mm_madd_epi16 (ga, green_alpha)), 8);
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t rgba_to_luminance_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m128i * pixels = reinterpret_cast< const __m128i * >(source + i * 4);
+
+                    const __m128i l0 = luminance_sse41 (_mm_loadu_si128 (pixels + 0));
+                    const __m128i l1 = luminance_sse41 (_mm_loadu_si128 (pixels + 1));
+                    const __m128i l2 = luminance_sse41 (_mm_loadu_si128 (pixels + 2));
+                    const __m128i l3 = luminance_sse41 (_mm_loadu_si128 (pixels + 3));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i), _mm_packus_epi16 (_mm_packus_epi32 (l0, l1), _mm_packus_epi32 (l2, l3)));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t rgb_to_rgba_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m128i alpha  = _mm_set1_epi32 (int(0xFF000000u));
+                const __m128i expand = _mm_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+                size_t i = 0;
+
+                // 16 píxeles son 48 bytes, tres registros justos:
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m128i * pixels = reinterpret_cast< const __m128i * >(source + i * 3);
+                    __m128i       * target = reinterpret_cast<       __m128i * >(destination + i * 4);
+
+                    const __m128i a = _mm_loadu_si128 (pixels + 0);
+                    const __m128i b = _mm_loadu_si128 (pixels + 1);
+                    const __m128i c = _mm_loadu_si128 (pixels + 2);
+
+                    _mm_storeu_si128 (target + 0, _mm_or_si128 (_mm_shuffle_epi8 (a,                       expand), alpha));
+                    _mm_storeu_si128 (target + 1, _mm_or_si128 (_mm_shuffle_epi8 (_mm_alignr_epi8 (b, a, 12), expand), alpha));
+                    _mm_storeu_si128 (target + 2, _mm_or_si128 (_mm_shuffle_epi8 (_mm_alignr_epi8 (c, b,  8), expand), alpha));
+                    _mm_storeu_si128 (target + 3, _mm_or_si128 (_mm_shuffle_epi8 (_mm_srli_si128  (c,     4), expand), alpha));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t rgba_to_rgb_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m128i compact = _mm_setr_epi8 (0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m128i * pixels = reinterpret_cast< const __m128i * >(source + i * 4);
+                    __m128i       * target = reinterpret_cast<       __m128i * >(destination + i * 3);
+
+                    // Cada registro deja 12 bytes útiles que se encajan en tres de salida:
+
+                    const __m128i p0 = _mm_shuffle_epi8 (_mm_loadu_si128 (pixels + 0), compact);
+                    const __m128i p1 = _mm_shuffle_epi8 (_mm_loadu_si128 (pixels + 1), compact);
+                    const __m128i p2 = _mm_shuffle_epi8 (_mm_loadu_si128 (pixels + 2), compact);
+                    const __m128i p3 = _mm_shuffle_epi8 (_mm_loadu_si128 (pixels + 3), compact);
+
+                    _mm_storeu_si128 (target + 0, _mm_or_si128 (p0,                    _mm_slli_si128 (p1, 12)));
+                    _mm_storeu_si128 (target + 1, _mm_or_si128 (_mm_srli_si128 (p1, 4), _mm_slli_si128 (p2,  8)));
+                    _mm_storeu_si128 (target + 2, _mm_or_si128 (_mm_srli_si128 (p2, 8), _mm_slli_si128 (p3,  4)));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t swap_red_blue_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m128i swap = _mm_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+                size_t i = 0;
+
+                for ( ; i + 4 <= count; i += 4)
+                {
+                    const __m128i pixels = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i * 4));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i * 4), _mm_shuffle_epi8 (pixels, swap));
+                }
+
+                return i;
+            }
+
+            // Dos píxeles con un canal en cada palabra de 16 bits. El alfa se multiplica por 255,
+            // así que no cambia:
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            inline __m128i premultiply_sse41 (__m128i pixels)
+            {
+                const __m128i alpha_lanes = _mm_setr_epi16 (0, 0, 0, 255, 0, 0, 0, 255);
+                const __m128i rounding    = _mm_set1_epi16 (128);
+
+                const __m128i alpha   = _mm_or_si128 (_mm_shufflehi_epi16 (_mm_shufflelo_epi16 (pixels, 0xFF), 0xFF), alpha_lanes);
+                const __m128i product = _mm_add_epi16 (_mm_mullo_epi16 (pixels, alpha), rounding);
+
+                return _mm_srli_epi16 (_mm_add_epi16 (product, _mm_srli_epi16 (product, 8)), 8);
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t premultiply_alpha_sse41 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m128i zero = _mm_setzero_si128 ();
+
+                size_t i = 0;
+
+                for ( ; i + 4 <= count; i += 4)
+                {
+                    const __m128i pixels = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i * 4));
+
+                    const __m128i low  = premultiply_sse41 (_mm_unpacklo_epi8 (pixels, zero));
+                    const __m128i high = premultiply_sse41 (_mm_unpackhi_epi8 (pixels, zero));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i * 4), _mm_packus_epi16 (low, high));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t unorm_to_float_sse41 (const uint8_t * source, float * destination, size_t count)
+            {
+                const __m128 scale = _mm_set1_ps (255.f);
+
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    __m128i values = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i));
+
+                    for (int block = 0; block < 4; ++block, values = _mm_srli_si128 (values, 4))
+                    {
+                        _mm_storeu_ps (destination + i + block * 4, _mm_div_ps (_mm_cvtepi32_ps (_mm_cvtepu8_epi32 (values)), scale));
+                    }
+                }
+
+                return i;
+            }
+
+            // Saturación, escala y redondeo de to_unorm() con cuatro valores a la vez:
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            inline __m128i to_unorm_sse41 (__m128 values)
+            {
+                values = _mm_min_ps (_mm_max_ps (values, _mm_setzero_ps ()), _mm_set1_ps (1.f));
+
+                return _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (values, _mm_set1_ps (255.f)), _mm_set1_ps (0.5f)));
+            }
+
+            PIXEL_CONVERSION_TARGET("sse4.1")
+            size_t float_to_unorm_sse41 (const float * source, uint8_t * destination, size_t count)
+            {
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m128i v0 = to_unorm_sse41 (_mm_loadu_ps (source + i +  0));
+                    const __m128i v1 = to_unorm_sse41 (_mm_loadu_ps (source + i +  4));
+                    const __m128i v2 = to_unorm_sse41 (_mm_loadu_ps (source + i +  8));
+                    const __m128i v3 = to_unorm_sse41 (_mm_loadu_ps (source + i + 12));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i), _mm_packus_epi16 (_mm_packus_epi32 (v0, v1), _mm_packus_epi32 (v2, v3)));
+                }
+
+                return i;
+            }
+
+            // AVX2 (con F16C para los half)
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t luminance_to_rgba_avx2 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m256i alpha = _mm256_set1_epi32 (int(0xFF000000u));
+
+                // Se copian 16 valores en las dos mitades y cada una expande cuatro píxeles:
+
+                const __m256i spread[2] =
+                {
+                    _mm256_setr_epi8 ( 0,  0,  0, -1,  1,  1,  1, -1,  2,  2,  2, -1,  3,  3,  3, -1,
+                                       4,  4,  4, -1,  5,  5,  5, -1,  6,  6,  6, -1,  7,  7,  7, -1),
+                    _mm256_setr_epi8 ( 8,  8,  8, -1,  9,  9,  9, -1, 10, 10, 10, -1, 11, 11, 11, -1,
+                                      12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+                };
+
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m256i luminance = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i)));
+
+                    for (int block = 0; block < 2; ++block)
+                    {
+                        _mm256_storeu_si256 (reinterpret_cast< __m256i * >(destination + (i + block * 8) * 4), _mm256_or_si256 (_mm256_shuffle_epi8 (luminance, spread[block]), alpha));
+                    }
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            inline __m256i luminance_avx2 (__m256i pixels)
+            {
+                const __m256i low_bytes   = _mm256_set1_epi32 (0x00FF00FF);
+                const __m256i red_blue    = _mm256_set1_epi32 ((29 << 16) | 77);
+                const __m256i green_alpha = _mm256_set1_epi32 (150);
+
+                const __m256i rb = _mm256_and_si256  (pixels, low_bytes);
+                const __m256i ga = _mm256_srli_epi16 (pixels, 8);
+
+                return _mm256_srli_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (rb, red_blue), _mm256_madd_epi16 (ga, green_alpha)), 8);
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t rgba_to_luminance_avx2 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                // Los pack trabajan por mitades, así que al final hay que reordenar los grupos de
+                // cuatro píxeles:
+
+                const __m256i order = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);
+
+                size_t i = 0;
+
+                for ( ; i + 32 <= count; i += 32)
+                {
+                    const __m256i * pixels = reinterpret_cast< const __m256i * >(source + i * 4);
+
+                    const __m256i l0 = luminance_avx2 (_mm256_loadu_si256 (pixels + 0));
+                    const __m256i l1 = luminance_avx2 (_mm256_loadu_si256 (pixels + 1));
+                    const __m256i l2 = luminance_avx2 (_mm256_loadu_si256 (pixels + 2));
+                    const __m256i l3 = luminance_avx2 (_mm256_loadu_si256 (pixels + 3));
+
+                    const __m256i packed = _mm256_packus_epi16 (_mm256_packus_epi32 (l0, l1), _mm256_packus_epi32 (l2, l3));
+
+                    _mm256_storeu_si256 (reinterpret_cast< __m256i * >(destination + i), _mm256_permutevar8x32_epi32 (packed, order));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t rgb_to_rgba_avx2 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m256i alpha  = _mm256_set1_epi32 (int(0xFF000000u));
+                const __m256i expand = _mm256_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+                size_t i = 0;
+
+                // Cada mitad se carga desde los 12 bytes de sus cuatro píxeles. La última lectura
+                // pasa 4 bytes del bloque, así que se deja margen al final:
+
+                for ( ; i + 18 <= count; i += 16)
+                {
+                    const uint8_t * pixels = source + i * 3;
+                    __m256i       * target = reinterpret_cast< __m256i * >(destination + i * 4);
+
+                    for (int block = 0; block < 2; ++block, pixels += 24)
+                    {
+                        const __m128i low  = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(pixels     ));
+                        const __m128i high = _mm_loadu_si128 (reinterpret_cast< const __m128i * >(pixels + 12));
+
+                        const __m256i both = _mm256_inserti128_si256 (_mm256_castsi128_si256 (low), high, 1);
+
+                        _mm256_storeu_si256 (target + block, _mm256_or_si256 (_mm256_shuffle_epi8 (both, expand), alpha));
+                    }
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t swap_red_blue_avx2 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m256i swap = _mm256_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                       2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+                size_t i = 0;
+
+                for ( ; i + 8 <= count; i += 8)
+                {
+                    const __m256i pixels = _mm256_loadu_si256 (reinterpret_cast< const __m256i * >(source + i * 4));
+
+                    _mm256_storeu_si256 (reinterpret_cast< __m256i * >(destination + i * 4), _mm256_shuffle_epi8 (pixels, swap));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            inline __m256i premultiply_avx2 (__m256i pixels)
+            {
+                const __m256i alpha_lanes = _mm256_setr_epi16 (0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+                const __m256i rounding    = _mm256_set1_epi16 (128);
+
+                const __m256i alpha   = _mm256_or_si256 (_mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (pixels, 0xFF), 0xFF), alpha_lanes);
+                const __m256i product = _mm256_add_epi16 (_mm256_mullo_epi16 (pixels, alpha), rounding);
+
+                return _mm256_srli_epi16 (_mm256_add_epi16 (product, _mm256_srli_epi16 (product, 8)), 8);
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t premultiply_alpha_avx2 (const uint8_t * source, uint8_t * destination, size_t count)
+            {
+                const __m256i zero = _mm256_setzero_si256 ();
+
+                size_t i = 0;
+
+                // unpack y pack trabajan dentro de cada mitad, así que el orden se conserva:
+
+                for ( ; i + 8 <= count; i += 8)
+                {
+                    const __m256i pixels = _mm256_loadu_si256 (reinterpret_cast< const __m256i * >(source + i * 4));
+
+                    const __m256i low  = premultiply_avx2 (_mm256_unpacklo_epi8 (pixels, zero));
+                    const __m256i high = premultiply_avx2 (_mm256_unpackhi_epi8 (pixels, zero));
+
+                    _mm256_storeu_si256 (reinterpret_cast< __m256i * >(destination + i * 4), _mm256_packus_epi16 (low, high));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t unorm_to_float_avx2 (const uint8_t * source, float * destination, size_t count)
+            {
+                const __m256 scale = _mm256_set1_ps (255.f);
+
+                size_t i = 0;
+
+                for ( ; i + 8 <= count; i += 8)
+                {
+                    const __m128i values = _mm_loadl_epi64 (reinterpret_cast< const __m128i * >(source + i));
+
+                    _mm256_storeu_ps (destination + i, _mm256_div_ps (_mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (values)), scale));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            inline __m256i to_unorm_avx2 (__m256 values)
+            {
+                values = _mm256_min_ps (_mm256_max_ps (values, _mm256_setzero_ps ()), _mm256_set1_ps (1.f));
+
+                return _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (values, _mm256_set1_ps (255.f)), _mm256_set1_ps (0.5f)));
+            }
+
+            // Empaqueta dos registros de ocho enteros (de 0 a 255) en 16 bytes en orden:
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            inline __m128i pack_unorm_avx2 (__m256i low, __m256i high)
+            {
+                const __m256i words = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (low, high), 0xD8);
+
+                return _mm_packus_epi16 (_mm256_castsi256_si128 (words), _mm256_extracti128_si256 (words, 1));
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2")
+            size_t float_to_unorm_avx2 (const float * source, uint8_t * destination, size_t count)
+            {
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m256i low  = to_unorm_avx2 (_mm256_loadu_ps (source + i    ));
+                    const __m256i high = to_unorm_avx2 (_mm256_loadu_ps (source + i + 8));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i), pack_unorm_avx2 (low, high));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2,f16c")
+            size_t unorm_to_half_avx2 (const uint8_t * source, uint16_t * destination, size_t count)
+            {
+                const __m256 scale = _mm256_set1_ps (255.f);
+
+                size_t i = 0;
+
+                for ( ; i + 8 <= count; i += 8)
+                {
+                    const __m128i values = _mm_loadl_epi64 (reinterpret_cast< const __m128i * >(source + i));
+                    const __m256  floats = _mm256_div_ps (_mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (values)), scale);
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i), _mm256_cvtps_ph (floats, _MM_FROUND_TO_NEAREST_INT));
+                }
+
+                return i;
+            }
+
+            PIXEL_CONVERSION_TARGET("avx2,f16c")
+            size_t half_to_unorm_avx2 (const uint16_t * source, uint8_t * destination, size_t count)
+            {
+                size_t i = 0;
+
+                for ( ; i + 16 <= count; i += 16)
+                {
+                    const __m256 low  = _mm256_cvtph_ps (_mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i    )));
+                    const __m256 high = _mm256_cvtph_ps (_mm_loadu_si128 (reinterpret_cast< const __m128i * >(source + i + 8)));
+
+                    _mm_storeu_si128 (reinterpret_cast< __m128i * >(destination + i), pack_unorm_avx2 (to_unorm_avx2 (low), to_unorm_avx2 (high)));
+                }
+
+                return i;
+            }
+
+        #endif
+
+    }
+
+    Pixel_Conversion::Kernels Pixel_Conversion::get_best_kernels ()
+    {
+        #ifdef PIXEL_CONVERSION_X86
+
+            static const Kernels best = [] ()
+            {
+                const Cpu_Features & features = Cpu_Features::get ();
+
+                return features.avx2 && features.f16c ? AVX2 : features.sse41 ? SSE41 : SCALAR;
+            }();
+
+            return best;
+
+        #else
+
+            return SCALAR;
+
+        #endif
+    }
+
+    Pixel_Conversion::Kernels Pixel_Conversion::resolve (Kernels kernels)
+    {
+        const Kernels best = get_best_kernels ();
+
+        return kernels > best ? best : kernels;
+    }
+
+    const char * Pixel_Conversion::get_name (Kernels kernels)
+    {
+        switch (kernels)
+        {
+            case SCALAR: return "scalar";
+            case SSE41:  return "SSE4.1";
+            case AVX2:   return "AVX2";
+            case BEST:   return get_name (get_best_kernels ());
+        }
+
+        return "?";
+    }
+
+    void Pixel_Conversion::luminance_to_rgba (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = luminance_to_rgba_avx2  (source, destination, count); break;
+                case SSE41: done = luminance_to_rgba_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        luminance_to_rgba_scalar (source + done, destination + done * 4, count - done);
+    }
+
+    void Pixel_Conversion::rgba_to_luminance (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = rgba_to_luminance_avx2  (source, destination, count); break;
+                case SSE41: done = rgba_to_luminance_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        rgba_to_luminance_scalar (source + done * 4, destination + done, count - done);
+    }
+
+    void Pixel_Conversion::rgb_to_rgba (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = rgb_to_rgba_avx2  (source, destination, count); break;
+                case SSE41: done = rgb_to_rgba_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        rgb_to_rgba_scalar (source + done * 3, destination + done * 4, count - done);
+    }
+
+    void Pixel_Conversion::rgba_to_rgb (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        // Con AVX2 no se gana nada: las mitades de 128 bits no se pueden compactar juntas.
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:
+                case SSE41: done = rgba_to_rgb_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        rgba_to_rgb_scalar (source + done * 4, destination + done * 3, count - done);
+    }
+
+    void Pixel_Conversion::swap_red_blue (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = swap_red_blue_avx2  (source, destination, count); break;
+                case SSE41: done = swap_red_blue_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        swap_red_blue_scalar (source + done * 4, destination + done * 4, count - done);
+    }
+
+    void Pixel_Conversion::premultiply_alpha (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = premultiply_alpha_avx2  (source, destination, count); break;
+                case SSE41: done = premultiply_alpha_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        premultiply_alpha_scalar (source + done * 4, destination + done * 4, count - done);
+    }
+
+    void Pixel_Conversion::unorm_to_float (const uint8_t * source, float * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = unorm_to_float_avx2  (source, destination, count); break;
+                case SSE41: done = unorm_to_float_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        unorm_to_float_scalar (source + done, destination + done, count - done);
+    }
+
+    void Pixel_Conversion::float_to_unorm (const float * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            switch (resolve (kernels))
+            {
+                case AVX2:  done = float_to_unorm_avx2  (source, destination, count); break;
+                case SSE41: done = float_to_unorm_sse41 (source, destination, count); break;
+                default:    break;
+            }
+        #endif
+
+        float_to_unorm_scalar (source + done, destination + done, count - done);
+    }
+
+    void Pixel_Conversion::unorm_to_half (const uint8_t * source, uint16_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        // Sin F16C (antes de AVX2) la conversión a half es escalar:
+
+        #ifdef PIXEL_CONVERSION_X86
+            if (resolve (kernels) == AVX2) done = unorm_to_half_avx2 (source, destination, count);
+        #endif
+
+        unorm_to_half_scalar (source + done, destination + done, count - done);
+    }
+
+    void Pixel_Conversion::half_to_unorm (const uint16_t * source, uint8_t * destination, size_t count, Kernels kernels)
+    {
+        size_t done = 0;
+
+        #ifdef PIXEL_CONVERSION_X86
+            if (resolve (kernels) == AVX2) done = half_to_unorm_avx2 (source, destination, count);
+        #endif
+
+        half_to_unorm_scalar (source + done, destination + done, count - done);
+    }
+
+}
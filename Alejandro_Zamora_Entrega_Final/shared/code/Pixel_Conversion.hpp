@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Color.hpp"
+#include "Color_Buffer.hpp"
+
+namespace udit
+{
+
+    // Conversiones entre formatos de píxel de 8 bits por canal y a coma flotante. Cada función
+    // tiene una versión escalar y, según lo que admita la CPU en la que se ejecuta (no con la
+    // que se compila), otras con SSE4.1 o con AVX2 + F16C que procesan bloques enteros y dejan
+    // a la escalar el resto. Todas dan exactamente el mismo resultado que la escalar.
+    //
+    // count es el número de píxeles, salvo en las conversiones por canal (unorm, float y half)
+    // en las que es el número de valores. Las que reducen el tamaño (rgba_to_luminance,
+    // rgba_to_rgb) y las que lo mantienen se pueden hacer en el sitio (destination == source).
+    // No usa OpenGL.
+
+    class Pixel_Conversion
+    {
+    public:
+
+        enum Kernels
+        {
+            SCALAR,
+            SSE41,                                  // SSE4.1 (incluye SSSE3)
+            AVX2,                                   // AVX2 y F16C
+            BEST                                    // El mejor que admite la CPU
+        };
+
+    public:
+
+        // Devuelve el mejor juego de kernels que admite la CPU:
+
+        static Kernels get_best_kernels ();
+
+        // Limita kernels a lo que admite la CPU (BEST pasa a ser get_best_kernels()):
+
+        static Kernels resolve (Kernels kernels);
+
+        static const char * get_name (Kernels kernels);
+
+        // L8 -> RGBA8 (l, l, l, 255):
+
+        static void luminance_to_rgba (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+
+        // RGBA8 -> L8 con los mismos pesos que stb_image (SOIL_LOAD_L): (77 r + 150 g + 29 b) >> 8:
+
+        static void rgba_to_luminance (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+
+        // RGB8 -> RGBA8 con alfa 255 y RGBA8 -> RGB8:
+
+        static void rgb_to_rgba (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+        static void rgba_to_rgb (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+
+        // RGBA8 <-> BGRA8 (intercambia el primer y el tercer canal):
+
+        static void swap_red_blue (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+
+        // Multiplica el color de RGBA8 por su alfa redondeando al más cercano, round (c * a / 255):
+
+        static void premultiply_alpha (const uint8_t * source, uint8_t * destination, size_t count, Kernels kernels = BEST);
+
+        // Valores unorm de 8 bits <-> [0, 1]. Al volver a 8 bits se satura y se redondea al más
+        // cercano; NaN pasa a ser 0. Los half son los bits de un float de 16 bits:
+
+        static void unorm_to_float (const uint8_t  * source, float    * destination, size_t count, Kernels kernels = BEST);
+        static void float_to_unorm (const float    * source, uint8_t  * destination, size_t count, Kernels kernels = BEST);
+        static void unorm_to_half  (const uint8_t  * source, uint16_t * destination, size_t count, Kernels kernels = BEST);
+        static void half_to_unorm  (const uint16_t * source, uint8_t  * destination, size_t count, Kernels kernels = BEST);
+
+    public:
+
+        // Convierte una imagen entera entre Monochrome8 y Rgba8888, respetando el pitch de
+        // source (que puede ser una vista). El resultado es contiguo:
+
+        template< typename TARGET, typename SOURCE >
+        static Color_Buffer< TARGET > convert (const Color_Buffer< SOURCE > & source, Kernels kernels = BEST)
+        {
+            Color_Buffer< TARGET > target(source.get_width (), source.get_height ());
+
+            for (unsigned y = 0; y < source.get_height (); ++y)
+            {
+                convert_row (source.row (y), target.row (y), source.get_width (), kernels);
+            }
+
+            return target;
+        }
+
+    private:
+
+        static void convert_row (const Monochrome8 * source, Rgba8888 * destination, size_t count, Kernels kernels)
+        {
+            luminance_to_rgba (source, reinterpret_cast< uint8_t * >(destination), count, kernels);
+        }
+
+        static void convert_row (const Rgba8888 * source, Monochrome8 * destination, size_t count, Kernels kernels)
+        {
+            rgba_to_luminance (reinterpret_cast< const uint8_t * >(source), destination, count, kernels);
+        }
+
+        template< typename COLOR >
+        static void convert_row (const COLOR * source, COLOR * destination, size_t count, Kernels )
+        {
+            std::copy_n (source, count, destination);
+        }
+
+    };
+
+}
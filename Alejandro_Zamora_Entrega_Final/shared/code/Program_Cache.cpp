@@ -0,0 +1,155 @@
+#include "Program_Cache.hpp"
+
+#include "opengl-recipes.hpp"
+
+namespace udit
+{
+
+    Program_Cache & Program_Cache::get_instance ()
+    {
+        static Program_Cache instance;
+        return instance;
+    }
+
+    GLuint Program_Cache::acquire (const std::string & vertex_shader_code, const std::string & fragment_shader_code, const std::string & defines)
+    {
+        uint64_t key = hash (vertex_shader_code, fragment_shader_code, defines);
+
+        // Si dos fuentes distintas colisionan se prueba con la clave siguiente:
+
+        for (auto entry = entries.find (key); entry != entries.end (); entry = entries.find (++key))
+        {
+            const Entry & existing = entry->second;
+
+            if (existing.defines              == defines
+             && existing.vertex_shader_code   == vertex_shader_code
+             && existing.fragment_shader_code == fragment_shader_code)
+            {
+                entry->second.references++;
+                hit_count++;
+
+                return existing.program_id;
+            }
+        }
+
+        GLuint program_id = build (insert_defines (vertex_shader_code, defines), insert_defines (fragment_shader_code, defines));
+
+        compile_count++;
+
+        entries[key] = Entry{ program_id, 1, vertex_shader_code, fragment_shader_code, defines };
+        keys[program_id] = key;
+
+        return program_id;
+    }
+
+    void Program_Cache::release (GLuint program_id)
+    {
+        auto key = keys.find (program_id);
+
+        if (key == keys.end ()) return;
+
+        auto entry = entries.find (key->second);
+
+        if (--entry->second.references == 0)
+        {
+            glDeleteProgram (program_id);
+
+            entries.erase (entry);
+            keys   .erase (key);
+        }
+    }
+
+    uint64_t Program_Cache::hash (const std::string & vertex_shader_code, const std::string & fragment_shader_code, const std::string & defines)
+    {
+        // FNV-1a de 64 bits. Un separador entre las partes evita que "ab" + "c" y "a" + "bc"
+        // den el mismo hash:
+
+        uint64_t value = 0xCBF29CE484222325ull;
+
+        for (const std::string * part : { &defines, &vertex_shader_code, &fragment_shader_code })
+        {
+            for (char character : *part)
+            {
+                value ^= uint8_t(character);
+                value *= 0x100000001B3ull;
+            }
+
+            value ^= 0xFF;
+            value *= 0x100000001B3ull;
+        }
+
+        return value;
+    }
+
+    std::string Program_Cache::insert_defines (const std::string & shader_code, const std::string & defines)
+    {
+        if (defines.empty ()) return shader_code;
+
+        // GLSL exige que #version sea lo primero, así que los defines van en la línea siguiente:
+
+        size_t position = shader_code.compare (0, 8, "#version") == 0 ? shader_code.find ('\n') : std::string::npos;
+
+        if (position == std::string::npos) return defines + "\n" + shader_code;
+
+        return shader_code.substr (0, position + 1) + defines + "\n" + shader_code.substr (position + 1);
+    }
+
+    GLuint Program_Cache::build (const std::string & vertex_shader_code, const std::string & fragment_shader_code)
+    {
+        GLint succeeded = GL_FALSE;
+
+        // Se crean objetos para los shaders:
+
+        GLuint   vertex_shader_id = glCreateShader (GL_VERTEX_SHADER  );
+        GLuint fragment_shader_id = glCreateShader (GL_FRAGMENT_SHADER);
+
+        // Se carga el código de los shaders:
+
+        const char *   vertex_shaders_code[] = {          vertex_shader_code.c_str () };
+        const char * fragment_shaders_code[] = {        fragment_shader_code.c_str () };
+        const GLint    vertex_shaders_size[] = { (GLint)  vertex_shader_code.size  () };
+        const GLint  fragment_shaders_size[] = { (GLint)fragment_shader_code.size  () };
+
+        glShaderSource  (  vertex_shader_id, 1,   vertex_shaders_code,   vertex_shaders_size);
+        glShaderSource  (fragment_shader_id, 1, fragment_shaders_code, fragment_shaders_size);
+
+        // Se compilan los shaders:
+
+        glCompileShader (  vertex_shader_id);
+        glCompileShader (fragment_shader_id);
+
+        // Se comprueba que si la compilación ha tenido éxito:
+
+        glGetShaderiv   (  vertex_shader_id, GL_COMPILE_STATUS, &succeeded);
+        if (!succeeded) show_compilation_error (  vertex_shader_id);
+
+        glGetShaderiv   (fragment_shader_id, GL_COMPILE_STATUS, &succeeded);
+        if (!succeeded) show_compilation_error (fragment_shader_id);
+
+        // Se crea un objeto para un programa:
+
+        GLuint program_id = glCreateProgram ();
+
+        // Se cargan los shaders compilados en el programa:
+
+        glAttachShader  (program_id,   vertex_shader_id);
+        glAttachShader  (program_id, fragment_shader_id);
+
+        // Se linkan los shaders:
+
+        glLinkProgram   (program_id);
+
+        // Se comprueba si el linkage ha tenido éxito:
+
+        glGetProgramiv  (program_id, GL_LINK_STATUS, &succeeded);
+        if (!succeeded) show_linkage_error (program_id);
+
+        // Se liberan los shaders compilados una vez se han linkado:
+
+        glDeleteShader (  vertex_shader_id);
+        glDeleteShader (fragment_shader_id);
+
+        return program_id;
+    }
+
+}
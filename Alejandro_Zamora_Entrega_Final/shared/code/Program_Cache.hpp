@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <glad/gl.h>
+
+namespace udit
+{
+
+    // Caché de programas de shaders. Cada programa se identifica por un hash de su código y de
+    // sus defines, de modo que todos los objetos que piden los mismos shaders comparten un
+    // único programa ya compilado y enlazado. Se cuentan las referencias y el programa se
+    // borra cuando se libera la última.
+    //
+    // Usa OpenGL, así que sólo se puede llamar desde el hilo que tiene el contexto.
+
+    class Program_Cache
+    {
+    public:
+
+        struct Statistics
+        {
+            size_t compile_count;                   // Programas compilados y enlazados
+            size_t hit_count;                       // Peticiones servidas con un programa existente
+            size_t live_count;                      // Programas vivos
+        };
+
+    private:
+
+        struct Entry
+        {
+            GLuint      program_id;
+            size_t      references;
+            std::string vertex_shader_code;         // Se guardan para descartar colisiones del hash
+            std::string fragment_shader_code;
+            std::string defines;
+        };
+
+        std::unordered_map< uint64_t, Entry    > entries;
+        std::unordered_map< GLuint,   uint64_t > keys;
+
+        size_t compile_count;
+        size_t hit_count;
+
+    public:
+
+        static Program_Cache & get_instance ();
+
+        // defines se inserta justo después de la línea #version de los dos shaders:
+
+        GLuint acquire (const std::string & vertex_shader_code, const std::string & fragment_shader_code, const std::string & defines = std::string());
+        void   release (GLuint program_id);
+
+        Statistics get_statistics () const
+        {
+            return { compile_count, hit_count, entries.size () };
+        }
+
+    private:
+
+        Program_Cache() : compile_count(0), hit_count(0)
+        {
+        }
+
+        static uint64_t hash (const std::string & vertex_shader_code, const std::string & fragment_shader_code, const std::string & defines);
+
+        static std::string insert_defines (const std::string & shader_code, const std::string & defines);
+
+        static GLuint build (const std::string & vertex_shader_code, const std::string & fragment_shader_code);
+
+    };
+
+}
@@ -0,0 +1,99 @@
+#include "Skinning_Batch.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define SKINNING_BATCH_SSE
+#endif
+
+namespace udit
+{
+
+    void skin_positions_scalar
+    (
+        const glm::vec3    * positions,
+        const Skin_Weights * weights,
+        size_t               count,
+        const Skin_Matrix  * palette,
+        glm::vec4          * output
+    )
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            glm::vec4 rows[3] = { glm::vec4(0.f), glm::vec4(0.f), glm::vec4(0.f) };
+
+            for (unsigned influence = 0; influence < 4; ++influence)
+            {
+                const float         weight = float(weights[i].weights[influence]) * (1.f / 255.f);
+                const Skin_Matrix & matrix = palette[weights[i].joints[influence]];
+
+                rows[0] += weight * matrix.rows[0];
+                rows[1] += weight * matrix.rows[1];
+                rows[2] += weight * matrix.rows[2];
+            }
+
+            const glm::vec4 position(positions[i], 1.f);
+
+            output[i] = glm::vec4(glm::dot (rows[0], position), glm::dot (rows[1], position), glm::dot (rows[2], position), 1.f);
+        }
+    }
+
+    void skin_positions
+    (
+        const glm::vec3    * positions,
+        const Skin_Weights * weights,
+        size_t               count,
+        const Skin_Matrix  * palette,
+        glm::vec4          * output
+    )
+    {
+        #ifdef SKINNING_BATCH_SSE
+
+            const __m128  scale    = _mm_set1_ps (1.f / 255.f);
+            const __m128  w_one    = _mm_set_ss  (1.f);
+            const float * matrices = reinterpret_cast< const float * >(palette);
+            float       * result   = reinterpret_cast< float * >(output);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Skin_Weights & skin = weights[i];
+
+                // Se mezclan las tres filas de las cuatro matrices con sus pesos:
+
+                __m128 row0 = _mm_setzero_ps ();
+                __m128 row1 = _mm_setzero_ps ();
+                __m128 row2 = _mm_setzero_ps ();
+
+                for (unsigned influence = 0; influence < 4; ++influence)
+                {
+                    const __m128  weight = _mm_mul_ps (_mm_set1_ps (float(skin.weights[influence])), scale);
+                    const float * matrix = matrices + size_t(skin.joints[influence]) * 12;
+
+                    row0 = _mm_add_ps (row0, _mm_mul_ps (weight, _mm_loadu_ps (matrix + 0)));
+                    row1 = _mm_add_ps (row1, _mm_mul_ps (weight, _mm_loadu_ps (matrix + 4)));
+                    row2 = _mm_add_ps (row2, _mm_mul_ps (weight, _mm_loadu_ps (matrix + 8)));
+                }
+
+                // Cada fila se multiplica por (x, y, z, 1). Al trasponer los productos la suma de
+                // los cuatro registros deja (x', y', z', 1) sin sumas horizontales:
+
+                const glm::vec3 & p        = positions[i];
+                const __m128      position = _mm_set_ps (1.f, p.z, p.y, p.x);
+
+                __m128 x = _mm_mul_ps (row0, position);
+                __m128 y = _mm_mul_ps (row1, position);
+                __m128 z = _mm_mul_ps (row2, position);
+                __m128 w = w_one;
+
+                _MM_TRANSPOSE4_PS (x, y, z, w);
+
+                _mm_storeu_ps (result + i * 4, _mm_add_ps (_mm_add_ps (x, y), _mm_add_ps (z, w)));
+            }
+
+        #else
+
+            skin_positions_scalar (positions, weights, count, palette, output);
+
+        #endif
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm.hpp>
+
+namespace udit
+{
+
+    // Matriz afín de una articulación guardada por filas (48 bytes frente a los 64 de una mat4).
+    // Es también el formato de la paleta que lee el vertex shader: tres texels RGBA32F.
+
+    struct Skin_Matrix
+    {
+        glm::vec4 rows[3];
+    };
+
+    // Influencias de un vértice: cuatro índices de articulación de 8 bits y sus pesos en unorm8
+    // ordenados de mayor a menor. Los pesos de cada vértice suman exactamente 255.
+
+    struct Skin_Weights
+    {
+        uint8_t joints [4];
+        uint8_t weights[4];
+    };
+
+    // Deforma las posiciones de un lote de vértices mezclando las matrices de la paleta. Con SSE
+    // cada vértice mezcla las tres filas de sus cuatro articulaciones en registros. La salida usa
+    // 16 bytes por vértice (w = 1) para poder escribirse directamente en un búfer mapeado.
+
+    void skin_positions
+    (
+        const glm::vec3    * positions,
+        const Skin_Weights * weights,
+        size_t               count,
+        const Skin_Matrix  * palette,
+        glm::vec4          * output
+    );
+
+    // Versión escalar de referencia:
+
+    void skin_positions_scalar
+    (
+        const glm::vec3    * positions,
+        const Skin_Weights * weights,
+        size_t               count,
+        const Skin_Matrix  * palette,
+        glm::vec4          * output
+    );
+
+}
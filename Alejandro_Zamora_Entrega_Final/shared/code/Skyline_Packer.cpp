@@ -0,0 +1,119 @@
+#include "Skyline_Packer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace udit
+{
+
+    Skyline_Packer::Skyline_Packer(unsigned width, unsigned height, unsigned padding)
+    :
+        width    (width  ),
+        height   (height ),
+        padding  (padding),
+        skyline  { Segment{ 0, 0, width } },
+        used_area(0)
+    {
+    }
+
+    bool Skyline_Packer::insert (unsigned rect_width, unsigned rect_height, Rect & rect)
+    {
+        // El hueco incluye el margen a ambos lados y se redondea a múltiplos del margen para
+        // que todas las esquinas queden alineadas:
+
+        const unsigned alignment     = std::max (padding, 1u);
+        const unsigned padded_width  = (rect_width  + 2 * padding + alignment - 1) / alignment * alignment;
+        const unsigned padded_height = (rect_height + 2 * padding + alignment - 1) / alignment * alignment;
+
+        size_t   best_index = skyline.size ();
+        unsigned best_y     = std::numeric_limits< unsigned >::max ();
+        unsigned best_width = std::numeric_limits< unsigned >::max ();
+
+        for (size_t index = 0; index < skyline.size (); ++index)
+        {
+            unsigned y;
+
+            if (fit (index, padded_width, padded_height, y))
+            {
+                if (y < best_y || (y == best_y && skyline[index].width < best_width))
+                {
+                    best_index = index;
+                    best_y     = y;
+                    best_width = skyline[index].width;
+                }
+            }
+        }
+
+        if (best_index == skyline.size ()) return false;
+
+        const unsigned x = skyline[best_index].x;
+
+        // El nuevo segmento tapa los que quedan debajo; el último que solapa se recorta:
+
+        Segment added{ x, best_y + padded_height, padded_width };
+
+        skyline.insert (skyline.begin () + best_index, added);
+
+        for (size_t index = best_index + 1; index < skyline.size (); )
+        {
+            Segment & segment = skyline[index];
+
+            if (segment.x >= added.x + added.width) break;
+
+            const unsigned shrink = added.x + added.width - segment.x;
+
+            if (shrink < segment.width)
+            {
+                segment.x     += shrink;
+                segment.width -= shrink;
+                break;
+            }
+
+            skyline.erase (skyline.begin () + index);
+        }
+
+        // Se unen los segmentos contiguos que han quedado a la misma altura:
+
+        for (size_t index = 0; index + 1 < skyline.size (); )
+        {
+            if (skyline[index].y == skyline[index + 1].y)
+            {
+                skyline[index].width += skyline[index + 1].width;
+                skyline.erase (skyline.begin () + index + 1);
+            }
+            else ++index;
+        }
+
+        rect      = Rect{ x + padding, best_y + padding, rect_width, rect_height };
+        used_area += size_t(rect_width) * rect_height;
+
+        return true;
+    }
+
+    bool Skyline_Packer::fit (size_t index, unsigned rect_width, unsigned rect_height, unsigned & y) const
+    {
+        const unsigned x = skyline[index].x;
+
+        if (x + rect_width > width) return false;
+
+        // El rectángulo se apoya en el segmento más alto de los que cubre:
+
+        unsigned remaining = rect_width;
+
+        y = 0;
+
+        for (size_t i = index; remaining > 0; ++i)
+        {
+            if (i == skyline.size ()) return false;
+
+            y = std::max (y, skyline[i].y);
+
+            if (y + rect_height > height) return false;
+
+            remaining -= std::min (remaining, skyline[i].width);
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace udit
+{
+
+    // Empaquetado de rectángulos en una página de width x height con el algoritmo skyline: se
+    // guarda el contorno superior de lo ya colocado como una lista de segmentos horizontales y
+    // cada rectángulo se apoya sobre el segmento en el que queda más abajo (y, a igual altura,
+    // deja menos hueco debajo). Da ocupaciones parecidas a maxrects con mucho menos trabajo.
+    //
+    // Cada rectángulo se rodea de padding texels libres y su esquina se alinea a padding, de
+    // modo que los mipmaps hasta el nivel log2(padding) no mezclan texels de rectángulos
+    // vecinos. No usa OpenGL.
+
+    class Skyline_Packer
+    {
+    public:
+
+        struct Rect
+        {
+            unsigned x;                             // Esquina del rectángulo sin el margen
+            unsigned y;
+            unsigned width;
+            unsigned height;
+        };
+
+    private:
+
+        struct Segment
+        {
+            unsigned x;
+            unsigned y;
+            unsigned width;
+        };
+
+        unsigned               width;
+        unsigned               height;
+        unsigned               padding;
+        std::vector< Segment > skyline;
+        size_t                 used_area;           // Texels de los rectángulos, sin los márgenes
+
+    public:
+
+        Skyline_Packer(unsigned width, unsigned height, unsigned padding = 0);
+
+    public:
+
+        // Coloca un rectángulo de width x height. Devuelve false si no cabe en la página:
+
+        bool insert (unsigned width, unsigned height, Rect & rect);
+
+        unsigned get_width () const
+        {
+            return width;
+        }
+
+        unsigned get_height () const
+        {
+            return height;
+        }
+
+        unsigned get_padding () const
+        {
+            return padding;
+        }
+
+        size_t get_used_area () const
+        {
+            return used_area;
+        }
+
+        // Fracción de la página ocupada por los rectángulos (sin contar los márgenes):
+
+        float get_occupancy () const
+        {
+            return float(double(used_area) / (double(width) * double(height)));
+        }
+
+    private:
+
+        // Altura a la que quedaría un hueco de width texels que empieza en el segmento index, o
+        // false si se sale de la página:
+
+        bool fit (size_t index, unsigned width, unsigned height, unsigned & y) const;
+
+    };
+
+}
@@ -0,0 +1,719 @@
+#include "Software_Rasterizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+
+#include "Thread_Pool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SOFTWARE_RASTERIZER_SSE
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        using Vertex = Software_Rasterizer::Vertex;
+
+        constexpr int   subpixel_steps = 16;            // Los vértices se ajustan a 1/16 de píxel
+        constexpr float guard_band     = 2097152.f;     // Píxeles que puede salirse un vértice de la pantalla (2^21)
+
+        const glm::vec4 near_plane (0.f, 0.f,  1.f, 1.f);  // z >= -w
+        const glm::vec4 far_plane  (0.f, 0.f, -1.f, 1.f);  // z <=  w
+
+        // Recorta un polígono convexo contra el semiespacio dot(plane, position) >= 0 y devuelve
+        // cuántos vértices quedan en output (como mucho uno más que en input):
+
+        size_t clip_polygon (const Vertex * input, size_t count, const glm::vec4 & plane, Vertex * output)
+        {
+            size_t result = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Vertex & a = input[i];
+                const Vertex & b = input[(i + 1) % count];
+
+                const float distance_a = glm::dot (plane, a.position);
+                const float distance_b = glm::dot (plane, b.position);
+
+                if (distance_a >= 0.f) output[result++] = a;
+
+                if ((distance_a >= 0.f) != (distance_b >= 0.f))
+                {
+                    const float t = distance_a / (distance_a - distance_b);
+
+                    output[result++] = Vertex{ glm::mix (a.position, b.position, t), glm::mix (a.varyings, b.varyings, t) };
+                }
+            }
+
+            return result;
+        }
+
+        // Lo mismo para un segmento; devuelve false si queda entero fuera:
+
+        bool clip_line (Vertex & a, Vertex & b, const glm::vec4 & plane)
+        {
+            const float distance_a = glm::dot (plane, a.position);
+            const float distance_b = glm::dot (plane, b.position);
+
+            if (distance_a < 0.f && distance_b < 0.f) return false;
+
+            if (distance_a < 0.f || distance_b < 0.f)
+            {
+                const float t       = distance_a / (distance_a - distance_b);
+                const Vertex middle { glm::mix (a.position, b.position, t), glm::mix (a.varyings, b.varyings, t) };
+
+                (distance_a < 0.f ? a : b) = middle;
+            }
+
+            return true;
+        }
+
+        // Con la banda de guarda las coordenadas en la subrejilla están por debajo de 2^26, así
+        // que los productos de diferencias (menores de 2^54) no desbordan un entero de 64 bits:
+
+        inline int64_t edge (const glm::ivec2 & a, const glm::ivec2 & b, const glm::ivec2 & p)
+        {
+            return (int64_t(b.x) - a.x) * (int64_t(p.y) - a.y) - (int64_t(b.y) - a.y) * (int64_t(p.x) - a.x);
+        }
+
+        inline glm::vec4 unpack (Rgba8888 color)
+        {
+            return glm::vec4
+            (
+                color.components[Rgba8888::RED  ],
+                color.components[Rgba8888::GREEN],
+                color.components[Rgba8888::BLUE ],
+                color.components[Rgba8888::ALPHA]
+            ) * (1.f / 255.f);
+        }
+
+        inline Rgba8888 pack (const glm::vec4 & color)
+        {
+            const glm::vec4 scaled = glm::clamp (color, 0.f, 1.f) * 255.f + 0.5f;
+
+            Rgba8888 result;
+
+            result.components[Rgba8888::RED  ] = uint8_t(scaled.r);
+            result.components[Rgba8888::GREEN] = uint8_t(scaled.g);
+            result.components[Rgba8888::BLUE ] = uint8_t(scaled.b);
+            result.components[Rgba8888::ALPHA] = uint8_t(scaled.a);
+
+            return result;
+        }
+
+    }
+
+    Software_Rasterizer::Software_Rasterizer(unsigned width, unsigned height)
+    :
+        width       (0),
+        height      (0),
+        tiles_x     (0),
+        tiles_y     (0),
+        color_buffer(0, 0),
+        statistics  { 0, 0, 0, 0 }
+    {
+        resize (width, height);
+    }
+
+    void Software_Rasterizer::resize (unsigned new_width, unsigned new_height)
+    {
+        width   = std::max (new_width,  1u);
+        height  = std::max (new_height, 1u);
+        tiles_x = (width  + tile_size - 1) / tile_size;
+        tiles_y = (height + tile_size - 1) / tile_size;
+
+        color_buffer = Color_Buffer(width, height);
+
+        // Se reservan 4 valores de más para que la última lectura con SSE de una fila no se salga:
+
+        depth_buffer.assign (size_t(width) * height + 4, 1.f);
+
+        bins.assign (size_t(tiles_x) * tiles_y, std::vector< uint32_t > ());
+    }
+
+    void Software_Rasterizer::clear (const glm::vec4 & color)
+    {
+        std::fill_n (color_buffer.colors (), size_t(width) * height, pack (color));
+        std::fill   (depth_buffer.begin  (), depth_buffer.end (), 1.f);
+
+        setups.clear ();
+        draws .clear ();
+
+        for (auto & bin : bins) bin.clear ();
+
+        statistics = Statistics{ 0, 0, 0, 0 };
+    }
+
+    void Software_Rasterizer::draw (const Draw & draw)
+    {
+        const uint32_t draw_index = uint32_t(draws.size ());
+
+        draws.push_back (Draw_State{ draw.shader, draw.uniforms });
+
+        if (draw.primitive == LINES)
+        {
+            for (size_t i = 0; i + 1 < draw.index_count; i += 2)
+            {
+                setup_line (draw.vertices[draw.indices[i]], draw.vertices[draw.indices[i + 1]], draw_index);
+            }
+
+            return;
+        }
+
+        // Cada triángulo se recorta contra los planos cercano y lejano y, si algún vértice se sale
+        // de la banda de guarda, también contra ella. El polígono resultante (hasta nueve vértices)
+        // se dibuja como un abanico:
+
+        const float guard_x = 2.f * guard_band / float(width );
+        const float guard_y = 2.f * guard_band / float(height);
+
+        const glm::vec4 guard_planes[4] =
+        {
+            glm::vec4(-1.f,  0.f, 0.f, guard_x),        // x <=  guard_x * w
+            glm::vec4( 1.f,  0.f, 0.f, guard_x),        // x >= -guard_x * w
+            glm::vec4( 0.f, -1.f, 0.f, guard_y),        // y <=  guard_y * w
+            glm::vec4( 0.f,  1.f, 0.f, guard_y),        // y >= -guard_y * w
+        };
+
+        for (size_t i = 0; i + 2 < draw.index_count; i += 3)
+        {
+            Vertex polygon[9] = { draw.vertices[draw.indices[i]], draw.vertices[draw.indices[i + 1]], draw.vertices[draw.indices[i + 2]] };
+            Vertex clipped[9];
+
+            size_t count = clip_polygon (polygon, 3,     near_plane, clipped);
+                   count = clip_polygon (clipped, count, far_plane,  polygon);
+
+            bool outside_guard_band = false;
+
+            for (size_t k = 0; k < count; ++k)
+            {
+                const glm::vec4 & position = polygon[k].position;
+
+                outside_guard_band = outside_guard_band || std::abs (position.x) > guard_x * position.w || std::abs (position.y) > guard_y * position.w;
+            }
+
+            if (outside_guard_band)
+            {
+                count = clip_polygon (polygon, count, guard_planes[0], clipped);
+                count = clip_polygon (clipped, count, guard_planes[1], polygon);
+                count = clip_polygon (polygon, count, guard_planes[2], clipped);
+                count = clip_polygon (clipped, count, guard_planes[3], polygon);
+            }
+
+            for (size_t k = 1; k + 1 < count; ++k)
+            {
+                setup_triangle (polygon[0], polygon[k], polygon[k + 1], draw_index, draw);
+            }
+        }
+    }
+
+    void Software_Rasterizer::setup_triangle (const Vertex & a, const Vertex & b, const Vertex & c, uint32_t draw, const Draw & state)
+    {
+        Setup setup;
+
+        const Vertex * vertices[3] = { &a, &b, &c };
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const glm::vec4 & position = vertices[i]->position;
+            const float       inv_w    = 1.f / position.w;
+
+            // Del cubo normalizado a píxeles con la y hacia abajo, ajustando a la subrejilla para
+            // que las aristas compartidas se evalúen igual en los dos triángulos:
+
+            const float x = (position.x * inv_w * 0.5f + 0.5f) * float(width );
+            const float y = (0.5f - position.y * inv_w * 0.5f) * float(height);
+
+            setup.fixed   [i] = glm::ivec2(int(std::round (x * float(subpixel_steps))), int(std::round (y * float(subpixel_steps))));
+            setup.screen  [i] = glm::vec2(setup.fixed[i]) / float(subpixel_steps);
+            setup.depth   [i] = position.z * inv_w * 0.5f + 0.5f;
+            setup.inv_w   [i] = inv_w;
+            setup.varyings[i] = vertices[i]->varyings * inv_w;
+        }
+
+        // El doble del área en 1/256 de píxel cuadrado. Es exacta, así que los triángulos
+        // degenerados se descartan siempre:
+
+        int64_t area = edge (setup.fixed[0], setup.fixed[1], setup.fixed[2]);
+
+        // Con la y hacia abajo, un área positiva es un triángulo que OpenGL ve en el sentido de
+        // las agujas del reloj:
+
+        if (area == 0 || (state.cull == CULL_CW && area > 0) || (state.cull == CULL_CCW && area < 0))
+        {
+            statistics.culled++;
+            return;
+        }
+
+        if (state.wireframe)
+        {
+            setup_line (a, b, draw);
+            setup_line (b, c, draw);
+            setup_line (c, a, draw);
+            return;
+        }
+
+        // Se ordenan los vértices para que las tres funciones de arista sean positivas dentro:
+
+        if (area < 0)
+        {
+            std::swap (setup.screen  [1], setup.screen  [2]);
+            std::swap (setup.fixed   [1], setup.fixed   [2]);
+            std::swap (setup.depth   [1], setup.depth   [2]);
+            std::swap (setup.inv_w   [1], setup.inv_w   [2]);
+            std::swap (setup.varyings[1], setup.varyings[2]);
+
+            area = -area;
+        }
+
+        // Regla top-left: un píxel justo sobre una arista sólo es del triángulo si la arista es
+        // superior o izquierda, así que los triángulos vecinos no lo dibujan dos veces:
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const glm::ivec2 & from = setup.fixed[(i + 1) % 3];
+            const glm::ivec2 & to   = setup.fixed[(i + 2) % 3];
+
+            setup.top_left[i] = (from.y == to.y && to.x > from.x) || to.y < from.y;
+        }
+
+        setup.inv_area = 1.f / float(area);
+        setup.lod      = 0.f;
+
+        // El nivel de mipmap sale de la relación entre el área en téxeles y en píxeles:
+
+        if (state.texture_size.x > 0.f)
+        {
+            const glm::vec2 uv0 = a.varyings, uv1 = b.varyings, uv2 = c.varyings;
+
+            const float uv_area    = std::abs ((uv1.x - uv0.x) * (uv2.y - uv0.y) - (uv1.y - uv0.y) * (uv2.x - uv0.x));
+            const float texel_area = uv_area * state.texture_size.x * state.texture_size.y;
+
+            setup.lod = std::max (0.5f * std::log2 (std::max (texel_area * setup.inv_area * float(subpixel_steps * subpixel_steps), 1e-12f)), 0.f);
+        }
+
+        const float min_x = std::min ({ setup.screen[0].x, setup.screen[1].x, setup.screen[2].x });
+        const float min_y = std::min ({ setup.screen[0].y, setup.screen[1].y, setup.screen[2].y });
+        const float max_x = std::max ({ setup.screen[0].x, setup.screen[1].x, setup.screen[2].x });
+        const float max_y = std::max ({ setup.screen[0].y, setup.screen[1].y, setup.screen[2].y });
+
+        // Sólo cuentan los píxeles cuyo centro (x + 0.5, y + 0.5) cae en la caja del triángulo:
+
+        setup.min_x = std::max (int(std::ceil  (min_x - 0.5f)), 0);
+        setup.min_y = std::max (int(std::ceil  (min_y - 0.5f)), 0);
+        setup.max_x = std::min (int(std::floor (max_x - 0.5f)), int(width ) - 1);
+        setup.max_y = std::min (int(std::floor (max_y - 0.5f)), int(height) - 1);
+        setup.draw  = draw;
+        setup.line  = false;
+
+        if (setup.min_x > setup.max_x || setup.min_y > setup.max_y) return;
+
+        setups.push_back (setup);
+
+        bin (uint32_t(setups.size () - 1));
+    }
+
+    void Software_Rasterizer::setup_line (const Vertex & a, const Vertex & b, uint32_t draw)
+    {
+        Vertex from = a;
+        Vertex to   = b;
+
+        if (!clip_line (from, to, near_plane) || !clip_line (from, to, far_plane)) return;
+
+        Setup setup;
+
+        const Vertex * vertices[2] = { &from, &to };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            const glm::vec4 & position = vertices[i]->position;
+            const float       inv_w    = 1.f / position.w;
+
+            setup.screen  [i] = glm::vec2((position.x * inv_w * 0.5f + 0.5f) * float(width), (0.5f - position.y * inv_w * 0.5f) * float(height));
+            setup.depth   [i] = position.z * inv_w * 0.5f + 0.5f;
+            setup.inv_w   [i] = inv_w;
+            setup.varyings[i] = vertices[i]->varyings * inv_w;
+        }
+
+        if (setup.screen[0] == setup.screen[1]) return;
+
+        setup.lod   = 0.f;
+        setup.min_x = std::max (int(std::floor (std::min (setup.screen[0].x, setup.screen[1].x))), 0);
+        setup.min_y = std::max (int(std::floor (std::min (setup.screen[0].y, setup.screen[1].y))), 0);
+        setup.max_x = std::min (int(std::floor (std::max (setup.screen[0].x, setup.screen[1].x))), int(width ) - 1);
+        setup.max_y = std::min (int(std::floor (std::max (setup.screen[0].y, setup.screen[1].y))), int(height) - 1);
+        setup.draw  = draw;
+        setup.line  = true;
+
+        if (setup.min_x > setup.max_x || setup.min_y > setup.max_y) return;
+
+        setups.push_back (setup);
+
+        bin (uint32_t(setups.size () - 1));
+    }
+
+    void Software_Rasterizer::bin (uint32_t index)
+    {
+        const Setup & setup = setups[index];
+
+        const unsigned first_x = unsigned(setup.min_x) / tile_size, last_x = unsigned(setup.max_x) / tile_size;
+        const unsigned first_y = unsigned(setup.min_y) / tile_size, last_y = unsigned(setup.max_y) / tile_size;
+
+        for (unsigned y = first_y; y <= last_y; ++y)
+        {
+            for (unsigned x = first_x; x <= last_x; ++x)
+            {
+                bins[size_t(y) * tiles_x + x].push_back (index);
+            }
+        }
+
+        statistics.primitives      += 1;
+        statistics.tile_references += size_t(last_x - first_x + 1) * (last_y - first_y + 1);
+    }
+
+    void Software_Rasterizer::flush (Thread_Pool * workers)
+    {
+        // Las casillas con más primitivas se reparten primero para que no quede una muy cargada
+        // para el final mientras los demás hilos esperan:
+
+        std::vector< uint32_t > order(bins.size ());
+
+        std::iota (order.begin (), order.end (), 0u);
+
+        std::stable_sort
+        (
+            order.begin (), order.end (),
+            [this] (uint32_t a, uint32_t b) { return bins[a].size () > bins[b].size (); }
+        );
+
+        std::atomic< size_t > next_tile { 0 };
+        std::atomic< size_t > fragments { 0 };
+
+        auto process_tiles = [this, &order, &next_tile, &fragments] (size_t, size_t)
+        {
+            size_t count = 0;
+
+            for (size_t i; (i = next_tile++) < order.size (); )
+            {
+                count += raster_tile (order[i]);
+            }
+
+            fragments += count;
+        };
+
+        // Cada hilo (y el que llama) ejecuta un bucle que va tomando casillas hasta agotarlas:
+
+        if (workers)
+            workers->parallel_for (workers->get_thread_count () + 1, process_tiles);
+        else
+            process_tiles (0, 1);
+
+        statistics.fragments += fragments;
+
+        setups.clear ();
+        draws .clear ();
+
+        for (auto & bin : bins) bin.clear ();
+    }
+
+    size_t Software_Rasterizer::raster_tile (size_t tile)
+    {
+        const int x0 = int(tile % tiles_x) * int(tile_size);
+        const int y0 = int(tile / tiles_x) * int(tile_size);
+        const int x1 = std::min (x0 + int(tile_size), int(width )) - 1;
+        const int y1 = std::min (y0 + int(tile_size), int(height)) - 1;
+
+        size_t count = 0;
+
+        for (uint32_t index : bins[tile])
+        {
+            const Setup & setup = setups[index];
+
+            count += setup.line ? raster_line (setup, x0, y0, x1, y1) : raster_triangle (setup, x0, y0, x1, y1);
+        }
+
+        return count;
+    }
+
+    size_t Software_Rasterizer::raster_triangle (const Setup & setup, int x0, int y0, int x1, int y1)
+    {
+        x0 = std::max (x0, setup.min_x);
+        y0 = std::max (y0, setup.min_y);
+        x1 = std::min (x1, setup.max_x);
+        y1 = std::min (y1, setup.max_y);
+
+        if (x0 > x1 || y0 > y1) return 0;
+
+        // E(x, y) = A * x + B * y + C para cada arista, en enteros de 64 bits sobre la subrejilla:
+        // los dos triángulos de una arista compartida obtienen exactamente el mismo valor (con el
+        // signo cambiado) en cada centro de píxel. Las aristas que no son top-left restan 1, así
+        // que un píxel está dentro cuando las tres funciones son >= 0:
+
+        const int64_t sample_x = int64_t(x0) * subpixel_steps + subpixel_steps / 2;
+        const int64_t sample_y = int64_t(y0) * subpixel_steps + subpixel_steps / 2;
+
+        int64_t step_x[3], step_y[3], row_start[3], bias[3];
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const glm::ivec2 & a = setup.fixed[(i + 1) % 3];
+            const glm::ivec2 & b = setup.fixed[(i + 2) % 3];
+
+            bias  [i] = setup.top_left[i] ? 0 : 1;
+            step_x[i] = (int64_t(a.y) - b.y) * subpixel_steps;
+            step_y[i] = (int64_t(b.x) - a.x) * subpixel_steps;
+
+            row_start[i] = edge (a, b, glm::ivec2(0)) + (int64_t(a.y) - b.y) * sample_x + (int64_t(b.x) - a.x) * sample_y - bias[i];
+        }
+
+        // La profundidad es lineal en pantalla: se calcula en double al principio de cada fila y
+        // se avanza con su derivada en x:
+
+        const float  inv_area     = setup.inv_area;
+        const double depth_step_x = (double(step_x[0]) * setup.depth[0] + double(step_x[1]) * setup.depth[1] + double(step_x[2]) * setup.depth[2]) * inv_area;
+        size_t       count        = 0;
+
+        auto process_pixel = [&] (int x, int y, int64_t e0, int64_t e1, int64_t e2, float depth)
+        {
+            const float b0 = float(e0 + bias[0]) * inv_area;
+            const float b1 = float(e1 + bias[1]) * inv_area;
+            const float b2 = float(e2 + bias[2]) * inv_area;
+
+            // Los valores se interpolan divididos por w y se deshace la división en cada píxel:
+
+            const float one_over_w = b0 * setup.inv_w[0] + b1 * setup.inv_w[1] + b2 * setup.inv_w[2];
+
+            const glm::vec4 varyings = (setup.varyings[0] * b0 + setup.varyings[1] * b1 + setup.varyings[2] * b2) / one_over_w;
+
+            shade (setup, size_t(y) * width + size_t(x), depth, varyings);
+
+            ++count;
+        };
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            const float * depth_row   = depth_buffer.data () + size_t(y) * width;
+            const float   depth_start = float
+            (
+                (double(row_start[0] + bias[0]) * setup.depth[0] +
+                 double(row_start[1] + bias[1]) * setup.depth[1] +
+                 double(row_start[2] + bias[2]) * setup.depth[2]) * inv_area
+            );
+
+            int x = x0;
+
+            #ifdef SOFTWARE_RASTERIZER_SSE
+
+                // Cada registro lleva las funciones de dos píxeles. Un píxel está dentro si ninguna
+                // de las tres es negativa, es decir, si su OR no tiene el bit de signo:
+
+                const __m128 lanes = _mm_set_ps (3.f, 2.f, 1.f, 0.f);
+
+                __m128i edges[3][2], step4[3];
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    edges[i][0] = _mm_set_epi64x (row_start[i] +     step_x[i], row_start[i]                 );
+                    edges[i][1] = _mm_set_epi64x (row_start[i] + 3 * step_x[i], row_start[i] + 2 * step_x[i]);
+                    step4[i]    = _mm_set1_epi64x (4 * step_x[i]);
+                }
+
+                for ( ; x <= x1; x += 4)
+                {
+                    const __m128i low  = _mm_or_si128 (_mm_or_si128 (edges[0][0], edges[1][0]), edges[2][0]);
+                    const __m128i high = _mm_or_si128 (_mm_or_si128 (edges[0][1], edges[1][1]), edges[2][1]);
+
+                    int mask = ~(_mm_movemask_pd (_mm_castsi128_pd (low)) | _mm_movemask_pd (_mm_castsi128_pd (high)) << 2) & 15;
+
+                    // Al final de la fila pueden sobrar carriles:
+
+                    mask &= (1 << std::min (x1 - x + 1, 4)) - 1;
+
+                    if (mask)
+                    {
+                        alignas(16) int64_t e[3][4];
+                        alignas(16) float   z[4];
+
+                        for (int i = 0; i < 3; ++i)
+                        {
+                            _mm_store_si128 (reinterpret_cast< __m128i * >(e[i]    ), edges[i][0]);
+                            _mm_store_si128 (reinterpret_cast< __m128i * >(e[i] + 2), edges[i][1]);
+                        }
+
+                        // La profundidad de los cuatro píxeles se compara con el depth buffer a la vez:
+
+                        const __m128 depth = _mm_add_ps
+                        (
+                            _mm_set1_ps (depth_start),
+                            _mm_mul_ps (_mm_add_ps (lanes, _mm_set1_ps (float(x - x0))), _mm_set1_ps (float(depth_step_x)))
+                        );
+
+                        mask &= _mm_movemask_ps (_mm_cmplt_ps (depth, _mm_loadu_ps (depth_row + x)));
+
+                        _mm_store_ps (z, depth);
+
+                        for (int lane = 0; mask; mask >>= 1, ++lane)
+                        {
+                            if (mask & 1) process_pixel (x + lane, y, e[0][lane], e[1][lane], e[2][lane], z[lane]);
+                        }
+                    }
+
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        edges[i][0] = _mm_add_epi64 (edges[i][0], step4[i]);
+                        edges[i][1] = _mm_add_epi64 (edges[i][1], step4[i]);
+                    }
+                }
+
+            #else
+
+                int64_t e[3] = { row_start[0], row_start[1], row_start[2] };
+
+                for ( ; x <= x1; ++x)
+                {
+                    if ((e[0] | e[1] | e[2]) >= 0)
+                    {
+                        const float depth = depth_start + float(x - x0) * float(depth_step_x);
+
+                        if (depth < depth_row[x]) process_pixel (x, y, e[0], e[1], e[2], depth);
+                    }
+
+                    for (int i = 0; i < 3; ++i) e[i] += step_x[i];
+                }
+
+            #endif
+
+            for (int i = 0; i < 3; ++i) row_start[i] += step_y[i];
+        }
+
+        return count;
+    }
+
+    size_t Software_Rasterizer::raster_line (const Setup & setup, int x0, int y0, int x1, int y1)
+    {
+        const glm::vec2 & from  = setup.screen[0];
+        const glm::vec2 & to    = setup.screen[1];
+        const glm::vec2   delta = to - from;
+
+        // Se avanza un píxel por paso en el eje mayor y se dibujan los centros que quedan dentro
+        // de [from, to), así que dos segmentos encadenados no repiten el punto común:
+
+        const bool  x_major = std::abs (delta.x) >= std::abs (delta.y);
+        const float start   = x_major ? from.x  : from.y;
+        const float length  = x_major ? delta.x : delta.y;
+
+        int first = int(std::ceil (std::min (start, start + length) - 0.5f));
+        int last  = int(std::ceil (std::max (start, start + length) - 0.5f)) - 1;
+
+        first = std::max (first, x_major ? x0 : y0);
+        last  = std::min (last,  x_major ? x1 : y1);
+
+        size_t count = 0;
+
+        for (int major = first; major <= last; ++major)
+        {
+            const float t     = (float(major) + 0.5f - start) / length;
+            const int   minor = int(std::floor ((x_major ? from.y + delta.y * t : from.x + delta.x * t)));
+            const int   x     = x_major ? major : minor;
+            const int   y     = x_major ? minor : major;
+
+            if (x < x0 || x > x1 || y < y0 || y > y1) continue;
+
+            const size_t offset = size_t(y) * width + size_t(x);
+            const float  depth  = setup.depth[0] + (setup.depth[1] - setup.depth[0]) * t;
+
+            if (!(depth < depth_buffer[offset])) continue;
+
+            const float     one_over_w = setup.inv_w[0] + (setup.inv_w[1] - setup.inv_w[0]) * t;
+            const glm::vec4 varyings   = glm::mix (setup.varyings[0], setup.varyings[1], t) / one_over_w;
+
+            shade (setup, offset, depth, varyings);
+
+            ++count;
+        }
+
+        return count;
+    }
+
+    void Software_Rasterizer::shade (const Setup & setup, size_t offset, float depth, const glm::vec4 & varyings)
+    {
+        const Draw_State & state = draws[setup.draw];
+
+        glm::vec4 color = glm::clamp (state.shader (varyings, setup.lod, state.uniforms), 0.f, 1.f);
+
+        Rgba8888 & pixel = color_buffer.get (offset);
+
+        // glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), también para el alfa:
+
+        if (color.a < 1.f)
+        {
+            color = color * color.a + unpack (pixel) * (1.f - color.a);
+        }
+
+        pixel                = pack (color);
+        depth_buffer[offset] = depth;
+    }
+
+    glm::vec4 Software_Rasterizer::sample_bilinear (const Color_Buffer & image, const glm::vec2 & uv)
+    {
+        const int   width  = int(image.get_width  ());
+        const int   height = int(image.get_height ());
+
+        const float x = uv.x * float(width ) - 0.5f;
+        const float y = uv.y * float(height) - 0.5f;
+
+        const float floor_x = std::floor (x);
+        const float floor_y = std::floor (y);
+        const float fx      = x - floor_x;
+        const float fy      = y - floor_y;
+
+        const int x0 = std::min (std::max (int(floor_x),     0), width  - 1);
+        const int y0 = std::min (std::max (int(floor_y),     0), height - 1);
+        const int x1 = std::min (std::max (int(floor_x) + 1, 0), width  - 1);
+        const int y1 = std::min (std::max (int(floor_y) + 1, 0), height - 1);
+
+        // Se suman los cuatro téxeles con sus pesos y se pasa a [0, 1] una sola vez:
+
+        const Rgba8888 * top    = image.row (unsigned(y0));
+        const Rgba8888 * bottom = image.row (unsigned(y1));
+
+        const float weights[4] = { (1.f - fx) * (1.f - fy), fx * (1.f - fy), (1.f - fx) * fy, fx * fy };
+        const Rgba8888 texels[4] = { top[x0], top[x1], bottom[x0], bottom[x1] };
+
+        glm::vec4 color(0.f);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            color += glm::vec4
+            (
+                texels[i].components[Rgba8888::RED  ],
+                texels[i].components[Rgba8888::GREEN],
+                texels[i].components[Rgba8888::BLUE ],
+                texels[i].components[Rgba8888::ALPHA]
+            ) * weights[i];
+        }
+
+        return color * (1.f / 255.f);
+    }
+
+    glm::vec4 Software_Rasterizer::sample_trilinear (const Mip_Chain & mips, const glm::vec2 & uv, float lod)
+    {
+        const float  last  = float(mips.get_level_count () - 1);
+        const float  level = std::min (std::max (lod, 0.f), last);
+        const size_t lower = size_t(level);
+        const float  blend = level - float(lower);
+
+        const glm::vec4 color = sample_bilinear (mips.get_level (lower), uv);
+
+        if (blend == 0.f) return color;
+
+        return glm::mix (color, sample_bilinear (mips.get_level (lower + 1), uv), blend);
+    }
+
+}
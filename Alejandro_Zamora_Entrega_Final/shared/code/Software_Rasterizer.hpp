@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm.hpp>
+
+#include "Color.hpp"
+#include "Color_Buffer.hpp"
+#include "Mip_Chain.hpp"
+
+namespace udit
+{
+
+    class Thread_Pool;
+
+    // Rasterizador por software que imita el pipeline fijo de OpenGL que usa la escena: recorte
+    // contra los planos cercano y lejano, culling por orientación, test de profundidad GL_LESS
+    // con escritura de profundidad y mezcla GL_SRC_ALPHA / GL_ONE_MINUS_SRC_ALPHA.
+    //
+    // draw() transforma cada primitiva a pantalla y la reparte entre las casillas de tile_size
+    // píxeles que toca. flush() rasteriza las casillas en paralelo: cada hilo toma la siguiente
+    // casilla libre de un contador atómico, empezando por las más cargadas, y dentro de ella las
+    // primitivas se dibujan en el orden en que llegaron, así que el resultado no depende del
+    // número de hilos. Las funciones de arista se evalúan en enteros de 64 bits sobre la subrejilla
+    // de 1/16 de píxel, así que son exactas y la regla top-left no deja huecos ni repite píxeles
+    // entre triángulos vecinos; con SSE2 se evalúan de cuatro en cuatro píxeles. Los triángulos que
+    // se salen mucho de la pantalla se recortan contra una banda de guarda para que quepan en esos
+    // enteros. Los valores se interpolan con corrección de perspectiva.
+    //
+    // No usa OpenGL. El "vertex shader" lo ejecuta quien llama (los vértices llegan en clip
+    // space) y el fragment shader es una función que recibe los valores interpolados.
+
+    class Software_Rasterizer
+    {
+    public:
+
+        using Color_Buffer = udit::Color_Buffer< Rgba8888 >;
+        using Mip_Chain    = udit::Mip_Chain   < Rgba8888 >;
+
+        static constexpr unsigned tile_size = 64;
+
+        struct Vertex
+        {
+            glm::vec4 position;                     // Clip space
+            glm::vec4 varyings;                     // Se interpolan con corrección de perspectiva
+        };
+
+        // Devuelve el color (RGBA de 0 a 1) a partir de los valores interpolados. lod es el nivel
+        // de mipmap del triángulo si la draw call indica el tamaño de su textura:
+
+        using Fragment_Shader = glm::vec4 (*) (const glm::vec4 & varyings, float lod, const void * uniforms);
+
+        enum Primitive
+        {
+            TRIANGLES,
+            LINES
+        };
+
+        // Orientación en pantalla que se descarta, con el mismo criterio que OpenGL (y hacia arriba):
+
+        enum Cull
+        {
+            CULL_NONE,
+            CULL_CW,                                // glFrontFace (GL_CCW) + glCullFace (GL_BACK)
+            CULL_CCW                                // glFrontFace (GL_CW ) + glCullFace (GL_BACK)
+        };
+
+        // Los vértices y los índices se consumen en draw(), pero uniforms tiene que seguir siendo
+        // válido hasta flush():
+
+        struct Draw
+        {
+            const Vertex   * vertices;
+            const uint32_t * indices;
+            size_t           index_count;
+            Primitive        primitive;
+            Cull             cull;
+            bool             wireframe;             // Triángulos con glPolygonMode (GL_LINE)
+            Fragment_Shader  shader;
+            const void     * uniforms;
+            glm::vec2        texture_size;          // Para calcular lod con varyings.xy como UV; 0 si no hay textura
+        };
+
+        struct Statistics
+        {
+            size_t primitives;                      // Triángulos y líneas que llegan a pantalla
+            size_t culled;                          // Triángulos descartados por orientación o sin área
+            size_t tile_references;                 // Suma de las casillas que toca cada primitiva
+            size_t fragments;                       // Píxeles que pasan el test de profundidad
+        };
+
+    private:
+
+        struct Setup
+        {
+            glm::vec2  screen  [3];                 // Píxeles, con y hacia abajo
+            glm::ivec2 fixed   [3];                 // Los mismos, en 1/16 de píxel
+            float      depth   [3];                 // De 0 a 1, como gl_FragCoord.z
+            float      inv_w   [3];
+            glm::vec4  varyings[3];                 // Divididos por w
+            bool       top_left[3];                 // Regla de relleno de cada arista
+            float      inv_area;                    // En 1/256 de píxel cuadrado
+            float      lod;
+            int        min_x, min_y, max_x, max_y;  // Píxeles cuyo centro puede estar dentro
+            uint32_t   draw;
+            bool       line;                        // Sólo se usan los dos primeros vértices
+        };
+
+        struct Draw_State
+        {
+            Fragment_Shader shader;
+            const void    * uniforms;
+        };
+
+        unsigned width;
+        unsigned height;
+        unsigned tiles_x;
+        unsigned tiles_y;
+
+        Color_Buffer                          color_buffer;
+        std::vector< float >                  depth_buffer;
+        std::vector< Setup >                  setups;
+        std::vector< Draw_State >             draws;
+        std::vector< std::vector< uint32_t > > bins;            // Primitivas de cada casilla, en orden
+        Statistics                            statistics;
+
+    public:
+
+        Software_Rasterizer(unsigned width, unsigned height);
+
+        void resize (unsigned width, unsigned height);
+
+        // Borra el color y la profundidad (a 1) y empieza las estadísticas de un fotograma:
+
+        void clear (const glm::vec4 & color);
+
+        void draw  (const Draw & draw);
+
+        // Rasteriza todo lo pendiente. Sin workers se hace en el hilo que llama:
+
+        void flush (Thread_Pool * workers = nullptr);
+
+        const Color_Buffer & get_color_buffer () const
+        {
+            return color_buffer;
+        }
+
+        float get_depth (unsigned x, unsigned y) const
+        {
+            return depth_buffer[size_t(y) * width + x];
+        }
+
+        const Statistics & get_statistics () const
+        {
+            return statistics;
+        }
+
+        unsigned get_width  () const { return width;  }
+        unsigned get_height () const { return height; }
+
+    public:
+
+        // Muestreo de texturas como GL_LINEAR y GL_LINEAR_MIPMAP_LINEAR con GL_CLAMP_TO_EDGE:
+
+        static glm::vec4 sample_bilinear  (const Color_Buffer & image, const glm::vec2 & uv);
+        static glm::vec4 sample_trilinear (const Mip_Chain    & mips,  const glm::vec2 & uv, float lod);
+
+    private:
+
+        void setup_triangle (const Vertex & a, const Vertex & b, const Vertex & c, uint32_t draw, const Draw & state);
+        void setup_line     (const Vertex & a, const Vertex & b, uint32_t draw);
+        void bin            (uint32_t setup);
+
+        // Devuelven cuántos píxeles han pasado el test de profundidad:
+
+        size_t raster_tile     (size_t tile);
+        size_t raster_triangle (const Setup & setup, int x0, int y0, int x1, int y1);
+        size_t raster_line     (const Setup & setup, int x0, int y0, int x1, int y1);
+
+        // Sombrea un píxel que ya ha pasado el test de profundidad y lo mezcla con el fondo:
+
+        void shade (const Setup & setup, size_t offset, float depth, const glm::vec4 & varyings);
+
+    };
+
+}
@@ -0,0 +1,117 @@
+#include "Thread_Pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace udit
+{
+
+    Thread_Pool::Thread_Pool(unsigned thread_count) : stopping(false)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = std::max (2u, std::thread::hardware_concurrency ()) - 1;
+        }
+
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            workers.emplace_back ([this] { run (); });
+        }
+    }
+
+    Thread_Pool::~Thread_Pool()
+    {
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            stopping = true;
+        }
+
+        condition.notify_all ();
+
+        for (auto & worker : workers) worker.join ();
+    }
+
+    void Thread_Pool::submit (Task task)
+    {
+        {
+            std::lock_guard< std::mutex > lock(mutex);
+            tasks.push_back (std::move (task));
+        }
+
+        condition.notify_one ();
+    }
+
+    void Thread_Pool::parallel_for (size_t count, const std::function< void (size_t, size_t) > & function)
+    {
+        if (count == 0) return;
+
+        // Se generan unos cuantos bloques por hilo para repartir mejor la carga:
+
+        size_t block_count = std::min (count, size_t(get_thread_count () + 1) * 4);
+        size_t block_size  = (count + block_count - 1) / block_count;
+               block_count = (count + block_size  - 1) / block_size;
+
+        struct State
+        {
+            std::atomic< size_t > next_block { 0 };
+            std::atomic< size_t > done_blocks{ 0 };
+        };
+
+        auto state = std::make_shared< State > ();
+
+        // Los hilos auxiliares sólo tocan la función mientras quedan bloques pendientes, y el
+        // hilo que llama no retorna hasta que todos se han completado:
+
+        auto function_pointer = &function;
+
+        auto process_blocks = [state, function_pointer, count, block_count, block_size] ()
+        {
+            for (size_t block; (block = state->next_block++) < block_count; )
+            {
+                size_t begin = block * block_size;
+                size_t end   = std::min (begin + block_size, count);
+
+                (*function_pointer) (begin, end);
+
+                state->done_blocks++;
+            }
+        };
+
+        size_t helper_count = std::min (size_t(get_thread_count ()), block_count - 1);
+
+        for (size_t i = 0; i < helper_count; ++i)
+        {
+            submit (process_blocks);
+        }
+
+        process_blocks ();
+
+        while (state->done_blocks < block_count)
+        {
+            std::this_thread::yield ();
+        }
+    }
+
+    void Thread_Pool::run ()
+    {
+        for (;;)
+        {
+            Task task;
+
+            {
+                std::unique_lock< std::mutex > lock(mutex);
+
+                condition.wait (lock, [this] { return stopping || !tasks.empty (); });
+
+                if (stopping && tasks.empty ()) return;
+
+                task = std::move (tasks.front ());
+                tasks.pop_front ();
+            }
+
+            task ();
+        }
+    }
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace udit
+{
+
+    class Thread_Pool
+    {
+    public:
+
+        using Task = std::function< void () >;
+
+    private:
+
+        std::vector< std::thread > workers;
+        std::deque < Task        > tasks;
+        std::mutex                 mutex;
+        std::condition_variable    condition;
+        bool                       stopping;
+
+    public:
+
+        // Si no se indica el número de hilos se usa uno menos que el número de núcleos para
+        // dejar libre el hilo que renderiza:
+
+        explicit Thread_Pool(unsigned thread_count = 0);
+
+       ~Thread_Pool();
+
+        Thread_Pool(const Thread_Pool & ) = delete;
+        Thread_Pool & operator = (const Thread_Pool & ) = delete;
+
+    public:
+
+        unsigned get_thread_count () const
+        {
+            return unsigned(workers.size ());
+        }
+
+        void submit (Task task);
+
+        // Reparte el rango [0, count) en bloques que se procesan en paralelo. El hilo que llama
+        // también procesa bloques y no retorna hasta que se han completado todos:
+
+        void parallel_for (size_t count, const std::function< void (size_t begin, size_t end) > & function);
+
+    private:
+
+        void run ();
+
+    };
+
+}
@@ -0,0 +1,116 @@
+#include "Transform_Batch.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define TRANSFORM_BATCH_SSE
+#endif
+
+namespace udit
+{
+
+    namespace
+    {
+
+        inline void compose (const Instance_Transform & transform, glm::mat4 & matrix)
+        {
+            const float x = transform.rotation.x, y = transform.rotation.y;
+            const float z = transform.rotation.z, w = transform.rotation.w;
+            const float s = transform.scale;
+
+            const float xx = x * x, yy = y * y, zz = z * z;
+            const float xy = x * y, xz = x * z, yz = y * z;
+            const float wx = w * x, wy = w * y, wz = w * z;
+
+            matrix[0] = glm::vec4(s * (1.f - 2.f * (yy + zz)), s * (2.f * (xy + wz)), s * (2.f * (xz - wy)), 0.f);
+            matrix[1] = glm::vec4(s * (2.f * (xy - wz)), s * (1.f - 2.f * (xx + zz)), s * (2.f * (yz + wx)), 0.f);
+            matrix[2] = glm::vec4(s * (2.f * (xz + wy)), s * (2.f * (yz - wx)), s * (1.f - 2.f * (xx + yy)), 0.f);
+            matrix[3] = glm::vec4(transform.position, 1.f);
+        }
+
+    }
+
+    void compose_transforms_scalar (const Instance_Transform * transforms, size_t count, glm::mat4 * matrices)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            compose (transforms[i], matrices[i]);
+        }
+    }
+
+    void compose_transforms (const Instance_Transform * transforms, size_t count, glm::mat4 * matrices)
+    {
+        size_t i = 0;
+
+        #ifdef TRANSFORM_BATCH_SSE
+
+            const __m128 one  = _mm_set1_ps (1.f);
+            const __m128 zero = _mm_setzero_ps ();
+
+            for ( ; i + 4 <= count; i += 4)
+            {
+                // Cada transformación son dos registros: (px, py, pz, s) y (qx, qy, qz, qw). Al
+                // trasponer cuatro de ellas cada registro pasa a contener una componente de las
+                // cuatro instancias:
+
+                const float * source = reinterpret_cast< const float * >(transforms + i);
+
+                __m128 px = _mm_loadu_ps (source +  0), qx = _mm_loadu_ps (source +  4);
+                __m128 py = _mm_loadu_ps (source +  8), qy = _mm_loadu_ps (source + 12);
+                __m128 pz = _mm_loadu_ps (source + 16), qz = _mm_loadu_ps (source + 20);
+                __m128 s  = _mm_loadu_ps (source + 24), qw = _mm_loadu_ps (source + 28);
+
+                _MM_TRANSPOSE4_PS (px, py, pz, s );
+                _MM_TRANSPOSE4_PS (qx, qy, qz, qw);
+
+                const __m128 x2 = _mm_add_ps (qx, qx);
+                const __m128 y2 = _mm_add_ps (qy, qy);
+                const __m128 z2 = _mm_add_ps (qz, qz);
+
+                const __m128 xx = _mm_mul_ps (qx, x2), yy = _mm_mul_ps (qy, y2), zz = _mm_mul_ps (qz, z2);
+                const __m128 xy = _mm_mul_ps (qx, y2), xz = _mm_mul_ps (qx, z2), yz = _mm_mul_ps (qy, z2);
+                const __m128 wx = _mm_mul_ps (qw, x2), wy = _mm_mul_ps (qw, y2), wz = _mm_mul_ps (qw, z2);
+
+                // Columnas de la matriz de rotación escalada, cada una con sus tres filas:
+
+                __m128 c00 = _mm_mul_ps (s, _mm_sub_ps (one, _mm_add_ps (yy, zz)));
+                __m128 c01 = _mm_mul_ps (s, _mm_add_ps (xy, wz));
+                __m128 c02 = _mm_mul_ps (s, _mm_sub_ps (xz, wy));
+                __m128 c03 = zero;
+
+                __m128 c10 = _mm_mul_ps (s, _mm_sub_ps (xy, wz));
+                __m128 c11 = _mm_mul_ps (s, _mm_sub_ps (one, _mm_add_ps (xx, zz)));
+                __m128 c12 = _mm_mul_ps (s, _mm_add_ps (yz, wx));
+                __m128 c13 = zero;
+
+                __m128 c20 = _mm_mul_ps (s, _mm_add_ps (xz, wy));
+                __m128 c21 = _mm_mul_ps (s, _mm_sub_ps (yz, wx));
+                __m128 c22 = _mm_mul_ps (s, _mm_sub_ps (one, _mm_add_ps (xx, yy)));
+                __m128 c23 = zero;
+
+                __m128 c33 = one;
+
+                // Se vuelve a trasponer para obtener cada columna de cada instancia:
+
+                _MM_TRANSPOSE4_PS (c00, c01, c02, c03);
+                _MM_TRANSPOSE4_PS (c10, c11, c12, c13);
+                _MM_TRANSPOSE4_PS (c20, c21, c22, c23);
+                _MM_TRANSPOSE4_PS (px , py , pz , c33);
+
+                float * destination = reinterpret_cast< float * >(matrices + i);
+
+                _mm_storeu_ps (destination +  0, c00); _mm_storeu_ps (destination +  4, c10);
+                _mm_storeu_ps (destination +  8, c20); _mm_storeu_ps (destination + 12, px );
+                _mm_storeu_ps (destination + 16, c01); _mm_storeu_ps (destination + 20, c11);
+                _mm_storeu_ps (destination + 24, c21); _mm_storeu_ps (destination + 28, py );
+                _mm_storeu_ps (destination + 32, c02); _mm_storeu_ps (destination + 36, c12);
+                _mm_storeu_ps (destination + 40, c22); _mm_storeu_ps (destination + 44, pz );
+                _mm_storeu_ps (destination + 48, c03); _mm_storeu_ps (destination + 52, c13);
+                _mm_storeu_ps (destination + 56, c23); _mm_storeu_ps (destination + 60, c33);
+            }
+
+        #endif
+
+        compose_transforms_scalar (transforms + i, count - i, matrices + i);
+    }
+
+}
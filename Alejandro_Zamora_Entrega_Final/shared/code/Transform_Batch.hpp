@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm.hpp>
+
+namespace udit
+{
+
+    // Transformación compacta de una instancia (32 bytes frente a los 64 de una mat4). La
+    // rotación es un cuaternión unitario guardado como (x, y, z, w) y la escala es uniforme.
+
+    struct Instance_Transform
+    {
+        glm::vec3 position;
+        float     scale;
+        glm::vec4 rotation;
+    };
+
+    // Compone las matrices de modelo de un lote de instancias. Con SSE se procesan cuatro
+    // instancias a la vez en formato SoA. matrices puede apuntar a un búfer de OpenGL mapeado.
+
+    void compose_transforms        (const Instance_Transform * transforms, size_t count, glm::mat4 * matrices);
+
+    // Versión escalar de referencia:
+
+    void compose_transforms_scalar (const Instance_Transform * transforms, size_t count, glm::mat4 * matrices);
+
+}
@@ -0,0 +1,119 @@
+#include "Upload_Ring.hpp"
+
+namespace udit
+{
+
+    Upload_Ring::Upload_Ring(size_t capacity)
+    :
+        buffer_id     (0),
+        capacity      (capacity),
+        head          (0),
+        used_bytes    (0),
+        unfenced_bytes(0),
+        statistics    { 0, 0 }
+    {
+        glGenBuffers (1, &buffer_id);
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buffer_id);
+        glBufferData (GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(capacity), nullptr, GL_STREAM_DRAW);
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    Upload_Ring::~Upload_Ring()
+    {
+        for (auto & fence : fences) glDeleteSync (fence.sync);
+
+        glDeleteBuffers (1, &buffer_id);
+    }
+
+    uint8_t * Upload_Ring::map (size_t size, size_t & offset)
+    {
+        retire ();
+
+        size = (size + alignment - 1) / alignment * alignment;
+
+        if (size > capacity) return nullptr;
+
+        // Si la región no cabe antes del final se empieza desde el principio y el hueco que
+        // queda al final se cuenta como usado hasta el siguiente fence:
+
+        size_t start = head;
+        size_t waste = 0;
+
+        if (start + size > capacity)
+        {
+            waste = capacity - start;
+            start = 0;
+        }
+
+        if (used_bytes + waste + size > capacity)
+        {
+            statistics.stall_count++;
+            return nullptr;
+        }
+
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buffer_id);
+
+        void * pointer = glMapBufferRange
+        (
+            GL_PIXEL_UNPACK_BUFFER,
+            GLintptr  (start),
+            GLsizeiptr(size),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        );
+
+        if (!pointer)
+        {
+            glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+            return nullptr;
+        }
+
+        head            = start + size;
+        used_bytes     += waste + size;
+        unfenced_bytes += waste + size;
+        offset          = start;
+
+        statistics.uploaded_bytes += size;
+
+        return static_cast< uint8_t * >(pointer);
+    }
+
+    void Upload_Ring::unmap ()
+    {
+        glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    void Upload_Ring::fence ()
+    {
+        if (unfenced_bytes == 0) return;
+
+        fences.push_back (Fence{ glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0), unfenced_bytes });
+
+        // retire() consulta los fences sin vaciar la cola de comandos, así que hay que enviarlos
+        // ya o no se señalarían hasta el siguiente swap:
+
+        glFlush ();
+
+        unfenced_bytes = 0;
+    }
+
+    void Upload_Ring::retire ()
+    {
+        while (!fences.empty ())
+        {
+            GLenum result = glClientWaitSync (fences.front ().sync, 0, 0);
+
+            if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) break;
+
+            glDeleteSync (fences.front ().sync);
+
+            used_bytes -= fences.front ().bytes;
+
+            fences.pop_front ();
+        }
+
+        // Con el anillo vacío se vuelve al principio para no partir la siguiente región:
+
+        if (used_bytes == 0) head = 0;
+    }
+
+}
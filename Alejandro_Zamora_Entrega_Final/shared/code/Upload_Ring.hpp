@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include <glad/gl.h>
+
+namespace udit
+{
+
+    // Anillo de memoria de subida en un pixel buffer object. Cada copia reserva una región
+    // a continuación de la anterior y la mapea sin sincronizar, así que escribir en ella no
+    // espera a que la GPU termine con las anteriores. fence() marca todo lo escrito desde la
+    // llamada previa y la región se recicla cuando la GPU ha pasado ese fence.
+    //
+    // OpenGL 3.3 no tiene buffers persistentes (ARB_buffer_storage), pero con mapeos sin
+    // sincronizar y fences se consigue lo mismo: el driver copia desde el PBO por DMA mientras
+    // la CPU rellena la siguiente región. Sólo se puede usar desde el hilo de OpenGL.
+
+    class Upload_Ring
+    {
+    public:
+
+        struct Statistics
+        {
+            size_t uploaded_bytes;                  // Bytes escritos en el anillo
+            size_t stall_count;                     // Reservas rechazadas porque la GPU no había terminado
+        };
+
+        static constexpr size_t default_capacity = 32 << 20;
+        static constexpr size_t alignment        = 64;
+
+    private:
+
+        struct Fence
+        {
+            GLsync sync;
+            size_t bytes;                           // Bytes que se liberan al pasar el fence
+        };
+
+        GLuint              buffer_id;
+        size_t              capacity;
+        size_t              head;                   // Siguiente byte libre
+        size_t              used_bytes;             // En uso por la GPU o pendientes de fence
+        size_t              unfenced_bytes;
+        std::deque< Fence > fences;
+        Statistics          statistics;
+
+    public:
+
+        explicit Upload_Ring(size_t capacity = default_capacity);
+       ~Upload_Ring();
+
+        Upload_Ring(const Upload_Ring & ) = delete;
+        Upload_Ring & operator = (const Upload_Ring & ) = delete;
+
+    public:
+
+        // Reserva size bytes y devuelve un puntero donde escribirlos. Nunca espera a la GPU: si
+        // no hay sitio devuelve nullptr y hay que reintentarlo más tarde. offset es la posición
+        // en el PBO que se pasa como puntero a glTexSubImage2D y similares.
+
+        uint8_t * map (size_t size, size_t & offset);
+
+        // Termina la escritura. El PBO queda enlazado a GL_PIXEL_UNPACK_BUFFER para que la
+        // siguiente llamada lea de él; el que llama debe desenlazarlo después.
+
+        void unmap ();
+
+        void fence ();
+
+        size_t get_capacity () const
+        {
+            return capacity;
+        }
+
+        const Statistics & get_statistics () const
+        {
+            return statistics;
+        }
+
+    private:
+
+        // Libera las regiones cuyo fence ya ha pasado la GPU, sin esperar a las demás:
+
+        void retire ();
+
+    };
+
+}
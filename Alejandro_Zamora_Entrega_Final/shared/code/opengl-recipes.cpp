@@ -3,6 +3,7 @@
 // angel.rodriguez@udit.es
 
 #include "opengl-recipes.hpp"
+#include "Program_Cache.hpp"
 
 #include <SDL3/SDL.h>
 
@@ -11,62 +12,16 @@ using namespace std;
 namespace udit
 {
 
-    GLuint compile_shaders (const string & vertex_shader_code, const string & fragment_shader_code)
+    GLuint compile_shaders (const string & vertex_shader_code, const string & fragment_shader_code, const string & defines)
     {
-        GLint succeeded = GL_FALSE;
+        // Los programas con el mismo cdigo se compilan una sola vez y se comparten:
 
-        // Se crean objetos para los shaders:
-
-        GLuint   vertex_shader_id = glCreateShader (GL_VERTEX_SHADER  );
-        GLuint fragment_shader_id = glCreateShader (GL_FRAGMENT_SHADER);
-
-        // Se carga el cdigo de los shaders:
-
-        const char *   vertex_shaders_code[] = {          vertex_shader_code.c_str () };
-        const char * fragment_shaders_code[] = {        fragment_shader_code.c_str () };
-        const GLint    vertex_shaders_size[] = { (GLint)  vertex_shader_code.size  () };
-        const GLint  fragment_shaders_size[] = { (GLint)fragment_shader_code.size  () };
-
-        glShaderSource  (  vertex_shader_id, 1,   vertex_shaders_code,   vertex_shaders_size);
-        glShaderSource  (fragment_shader_id, 1, fragment_shaders_code, fragment_shaders_size);
-
-        // Se compilan los shaders:
-
-        glCompileShader (  vertex_shader_id);
-        glCompileShader (fragment_shader_id);
-
-        // Se comprueba que si la compilacin ha tenido xito:
-
-        glGetShaderiv   (  vertex_shader_id, GL_COMPILE_STATUS, &succeeded);
-        if (!succeeded) show_compilation_error (  vertex_shader_id);
-
-        glGetShaderiv   (fragment_shader_id, GL_COMPILE_STATUS, &succeeded);
-        if (!succeeded) show_compilation_error (fragment_shader_id);
-
-        // Se crea un objeto para un programa:
-
-        GLuint program_id = glCreateProgram ();
-
-        // Se cargan los shaders compilados en el programa:
-
-        glAttachShader  (program_id,   vertex_shader_id);
-        glAttachShader  (program_id, fragment_shader_id);
-
-        // Se linkan los shaders:
-
-        glLinkProgram   (program_id);
-
-        // Se comprueba si el linkage ha tenido xito:
-
-        glGetProgramiv  (program_id, GL_LINK_STATUS, &succeeded);
-        if (!succeeded) show_linkage_error (program_id);
-
-        // Se liberan los shaders compilados una vez se han linkado:
-
-        glDeleteShader (  vertex_shader_id);
-        glDeleteShader (fragment_shader_id);
+        return Program_Cache::get_instance ().acquire (vertex_shader_code, fragment_shader_code, defines);
+    }
 
-        return program_id;
+    void release_program (GLuint program_id)
+    {
+        Program_Cache::get_instance ().release (program_id);
     }
 
     void show_compilation_error (GLuint shader_id)
@@ -6,6 +6,8 @@
 
 #include "Color.hpp"
 #include "Color_Buffer.hpp"
+#include "Image_File.hpp"
+#include "Mip_Chain.hpp"
 #include <glad/gl.h>
 #include <memory>
 #include <SOIL2.h>
@@ -14,7 +16,11 @@
 namespace udit
 {
 
-    GLuint compile_shaders        (const std::string & vertex_shader_code, const std::string & fragment_shader_code);
+    // compile_shaders devuelve un programa compartido (ver Program_Cache): cada llamada debe
+    // emparejarse con release_program en lugar de glDeleteProgram.
+
+    GLuint compile_shaders        (const std::string & vertex_shader_code, const std::string & fragment_shader_code, const std::string & defines = std::string());
+    void   release_program        (GLuint program_id);
     void   show_compilation_error (GLuint  shader_id);
     void   show_linkage_error     (GLuint program_id);
 
@@ -23,6 +29,27 @@ namespace udit
     template< typename COLOR_FORMAT >
     std::unique_ptr< Color_Buffer< COLOR_FORMAT > > load_image (const std::string & image_path)
     {
+        // Las imgenes cocinadas (.qoi o .raw) se decodifican directamente con los canales del
+        // formato de color, sin pasar por SOIL2:
+
+        if (Image_File::is_fast (image_path))
+        {
+            unsigned  width  = 0;
+            unsigned  height = 0;
+            uint8_t * pixels = Image_File::load (image_path, width, height, unsigned(sizeof(COLOR_FORMAT)));
+
+            if (!pixels) return nullptr;
+
+            return std::make_unique< Color_Buffer< COLOR_FORMAT > >
+            (
+                reinterpret_cast< COLOR_FORMAT * >(pixels),
+                width,
+                height,
+                width,
+                [] (COLOR_FORMAT * pixels) { Image_File::free_pixels (reinterpret_cast< uint8_t * >(pixels)); }
+            );
+        }
+
         // Se carga la imagen del archivo:
 
         int image_width    = 0;
@@ -42,22 +69,17 @@ namespace udit
 
         if (loaded_pixels)
         {
-            auto image = std::make_unique< Color_Buffer< COLOR_FORMAT > > (image_width, image_height);
-            
-            // Se copian los bytes de un buffer a otro directamente:
+            // El bfer se queda con la memoria que reserv SOIL2 en lugar de copiarla, y la
+            // libera con SOIL_free_image_data cuando se destruye:
 
-            std::copy_n
+            return std::make_unique< Color_Buffer< COLOR_FORMAT > >
             (
-                loaded_pixels, 
-                size_t(image_width) * size_t(image_height) * sizeof(COLOR_FORMAT),
-                reinterpret_cast< uint8_t * >(image->colors ())
+                reinterpret_cast< COLOR_FORMAT * >(loaded_pixels),
+                unsigned(image_width),
+                unsigned(image_height),
+                unsigned(image_width),
+                [] (COLOR_FORMAT * pixels) { SOIL_free_image_data (reinterpret_cast< uint8_t * >(pixels)); }
             );
-
-            // Se libera la memoria que reserv SOIL2 para cargar la imagen:
-
-            SOIL_free_image_data (loaded_pixels);
-
-            return image;
         }
 
         return nullptr;
@@ -72,6 +94,13 @@ namespace udit
 
         if (image)
         {
+            // Los mipmaps se calculan en la CPU. Una imagen de un solo canal (como el height
+            // map) guarda datos y no colores, as que se filtra sin correccin gamma:
+
+            Mip_Chain< COLOR_FORMAT > mips(std::move (*image));
+
+            mips.build (Mip_Filter::KAISER, sizeof(COLOR_FORMAT) >= 3);
+
             GLuint texture_id;
 
             glEnable      (GL_TEXTURE_2D );
@@ -83,20 +112,32 @@ namespace udit
             glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            glTexImage2D
-            (
-                GL_TEXTURE_2D,
-                0,
-                GL_R8,
-                image->get_width  (),
-                image->get_height (),
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                image->colors ()
-            );
+            glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,  GLint(mips.get_level_count ()) - 1);
+
+            // Las filas de los niveles pequeos no son mltiplo de 4 bytes:
+
+            glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+
+            for (size_t level = 0; level < mips.get_level_count (); ++level)
+            {
+                glPixelStorei (GL_UNPACK_ROW_LENGTH, GLint(mips.get_level (level).get_pitch ()));
+
+                glTexImage2D
+                (
+                    GL_TEXTURE_2D,
+                    GLint(level),
+                    GL_R8,
+                    mips.get_level (level).get_width  (),
+                    mips.get_level (level).get_height (),
+                    0,
+                    GL_RED,
+                    GL_UNSIGNED_BYTE,
+                    mips.get_level (level).colors ()
+                );
+            }
 
-            glGenerateMipmap (GL_TEXTURE_2D);
+            glPixelStorei (GL_UNPACK_ALIGNMENT,  4);
+            glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
 
             return texture_id;
         }